@@ -12,6 +12,8 @@ class PlayRecipe(ConanFile):
         self.requires("boost/[]", override=True)
         self.requires("folly/[]")
         self.requires("gtest/[^1]")
+        self.requires("benchmark/[^1]")
+        self.requires("onetbb/[^2021]")
 
     def layout(self):
         cmake_layout(self)
@@ -1,5 +1,57 @@
-#include <coroutine>
+#include <util/coro.h>
+#include <util/log.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using util::coro::Task;
+using util::coro::ThreadPool;
+
+using util::log::getLogger;
+
+struct main{};
+
+namespace {
+    /** Stands for some I/O: hops back onto the pool the way it would when its I/O completes */
+    Task<int> fetch(ThreadPool& pool, int id) {
+        co_await pool.schedule();
+        std::this_thread::sleep_for(std::chrono::microseconds{100});
+        co_await pool.schedule();
+        if (id == 999) {
+            throw std::runtime_error("fetch failed");
+        }
+        co_return id % 10;
+    }
+
+    Task<long> fetchAll(ThreadPool& pool, int count) {
+        std::vector<Task<int>> tasks;
+        for (int id = 0; id < count; ++id) {
+            tasks.push_back(fetch(pool, id));
+        }
+        long total = 0;
+        for (auto result: co_await util::coro::whenAll(std::move(tasks))) {
+            total += result;
+        }
+        co_return total;
+    }
+}
 
 int main() {
-    std::suspend_always a;
-}
\ No newline at end of file
+    util::log::suppressTracesAbove();
+    util::log::commonLoggingSetup();
+    util::log::logToConsole();
+
+    auto& logger = getLogger<struct main>();
+    ThreadPool pool{4};
+
+    logger.info("{} fetches on {} threads: total is {}", 999, pool.size(), util::coro::syncWait(fetchAll(pool, 999)));
+
+    try {
+        util::coro::syncWait(fetchAll(pool, 1000));
+    } catch (std::exception& e) {
+        logger.error("One of the fetches has failed", e);
+    }
+    return 0;
+}
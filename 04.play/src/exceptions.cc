@@ -1,9 +1,9 @@
 #include <iostream>
 #include <exception>
 #include <chrono>
-#include <future>
 
 #include <util/log.h>
+#include <util/pool.h>
 #include <boost/config.hpp>
 
 using std::string;
@@ -96,14 +96,16 @@ int main() {
         logger.errorWithCurrentException("Something went wrong again doing f1()");
     }*/
 
-    auto future = std::async(std::launch::async, f1);
+    util::pool::Pool pool{2};
+
+    auto future = pool.submit(f1);
     try {
         future.get();
     } catch (...) {
         logger.errorWithCurrentException("exception from future");
     }
 
-    auto future2 = std::async(std::launch::async, f1);
+    auto future2 = pool.submit(f1);
     std::optional<std::exception_ptr> exc;
     try {
         future2.get();
@@ -113,7 +115,7 @@ int main() {
     }
 
     if (exc.has_value() && exc.value()) {
-        std::async(std::launch::async, dealWithExcOnThatThread, exc.value()).get();
+        pool.submit([ptr = exc.value()] { dealWithExcOnThatThread(ptr); }).get();
     } else {
         logger.error("No exception to pay with");
     }
@@ -5,6 +5,8 @@
 #include <thread>
 #include <stop_token>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 using std::cout;
 using std::endl;
@@ -34,10 +36,18 @@ using std::stop_token;
 // Interestingly the code would compile if we wrote std::string&& instead;
 // std::string would be sitting in the structure jthread constructor allocates on the heap
 // just the same as with const string& but we'd be getting a mutable reference to it
+//
+// Rather than sleep_for() we wait on a condition_variable_any passing it the stop_token
+// so that request_stop() wakes us up right away instead of us noticing it up to 500ms later
+// There's nothing to notify us about other than stopping so the predicate is always false
 void runCooperative(stop_token stopToken, const string& threadName) {
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    std::unique_lock lock{mutex};
+
     while (!stopToken.stop_requested()) {
         cout << "thread " << threadName << " is running" << endl;
-        sleep_for(milliseconds(500));
+        cv.wait_for(lock, stopToken, milliseconds(500), [] { return false; });
     }
 
     cout << "thread " << threadName << " exiting" << endl;
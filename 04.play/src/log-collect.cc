@@ -0,0 +1,146 @@
+/**
+ * log-collect: the collector of a shared-memory log ring, writes the records of all workers of a host into one file
+ *
+ *     log-collect [--capacity BYTES] [--unlink] name file
+ *
+ * Workers open the ring with util::log_ring::Ring::open(name) and logToRing() it; see util/log_ring.h
+ * Runs until SIGINT or SIGTERM, then writes out what's left in the ring
+ */
+
+#include <util/log_ring.h>
+
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <fmt/core.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::string_view USAGE = R"(Usage: log-collect [options] name file
+
+Collects records written by workers to the shared-memory log ring 'name', e.g. /app-log, and appends them
+to 'file', or to stdout if it is -; the ring is created if there isn't one, otherwise we go on with what's in it
+Stops on SIGINT or SIGTERM once the records in the ring are written
+
+Options:
+  --capacity BYTES   size of the ring if it is to be created, a power of two; 16M by default
+  --unlink           remove the ring's name on the way out
+)";
+
+    constexpr std::size_t DEFAULT_CAPACITY = 16 << 20;
+
+    struct Arguments {
+        std::size_t capacity = DEFAULT_CAPACITY;
+        bool unlink = false;
+        std::string name;
+        std::string file;
+    };
+
+    Arguments parseArguments(int argc, char* argv[]) {
+        Arguments arguments;
+        int positional = 0;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "--capacity" && i + 1 < argc) {
+                arguments.capacity = std::stoull(argv[++i]);
+            } else if (arg == "--unlink") {
+                arguments.unlink = true;
+            } else if (arg.starts_with("--")) {
+                throw std::invalid_argument(fmt::format("Unknown option {}", arg));
+            } else if (positional++ == 0) {
+                arguments.name = arg;
+            } else if (positional == 2) {
+                arguments.file = arg;
+            } else {
+                throw std::invalid_argument("Too many arguments");
+            }
+        }
+        if (positional != 2) {
+            throw std::invalid_argument("Expected a ring name and a file");
+        }
+        return arguments;
+    }
+
+    int openOutput(const std::string& file) {
+        if (file == "-") {
+            return STDOUT_FILENO;
+        }
+        int fd = ::open(file.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + file);
+        }
+        return fd;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            fmt::print("{}", USAGE);
+            return 0;
+        }
+    }
+
+    try {
+        Arguments arguments;
+        try {
+            arguments = parseArguments(argc, argv);
+        } catch (const std::logic_error& e) {
+            fmt::print(stderr, "log-collect: {}\n{}", e.what(), USAGE);
+            return 2;
+        }
+
+        /* blocked before any thread starts so that the signals only ever come out of sigwait() below */
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        ::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        auto ring = util::log_ring::Ring::create(arguments.name, arguments.capacity);
+        int fd = openOutput(arguments.file);
+
+        std::exception_ptr failure;
+        {
+            std::jthread collector{[&](std::stop_token stopToken) {
+                try {
+                    util::log_ring::collect(stopToken, ring, fd);
+                } catch (...) {
+                    failure = std::current_exception();
+                    /* wake up main() */
+                    ::kill(::getpid(), SIGTERM);
+                }
+            }};
+            int signal;
+            ::sigwait(&signals, &signal);
+        }
+
+        if (arguments.unlink) {
+            util::log_ring::Ring::unlink(arguments.name);
+        }
+        if (ring.dropped() > 0 || ring.lost() > 0) {
+            fmt::print(stderr, "log-collect: {} records dropped by workers as the ring was full, {} lost\n",
+                    ring.dropped(), ring.lost());
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        if (fd != STDOUT_FILENO && ::close(fd) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Cannot close " + arguments.file);
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "log-collect: {}\n", e.what());
+        return 2;
+    }
+}
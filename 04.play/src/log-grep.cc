@@ -0,0 +1,236 @@
+/**
+ * log-grep: finds records in logs written by util::log
+ *
+ *     log-grep [options] [file...]
+ *
+ * Records matching all of the options given are printed whole, continuation lines included, in the order
+ * of the files and of the records within them; without files stdin is read
+ *
+ * Exit status is 0 if some records matched, 1 if none did and 2 on errors, same as with grep
+ *
+ * With --follow a single file is watched and records appended to it are printed as they come, see util/log_follow.h
+ */
+
+#include <util/log/records.h>
+#include <util/log_follow.h>
+#include <util/log_grep.h>
+#include <util/mapped_file.h>
+#include <util/pool.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace {
+    using util::log_grep::Filter;
+    using util::log_grep::parseSeverities;
+    using util::log_grep::parseTime;
+
+    constexpr std::string_view USAGE = R"(Usage: log-grep [options] [file...]
+
+Prints records of util::log logs, with their stack traces, which match all of the options given
+Reads stdin if there are no files
+
+Options:
+  -s, --severity LIST    comma-separated severities e.g. WARN,ERROR; "WARN+" means WARN and above
+  -c, --channel NAME     records of this channel; may be repeated
+  -e, --pattern TEXT     records containing TEXT anywhere; may be repeated, any of them will do
+      --since TIME       records at or after TIME, e.g. "2025-01-31 12:00" or "2025-01-31 12:00:00.5"
+      --until TIME       records before TIME
+  -j, --threads N        number of threads, all cores by default
+  -f, --follow           keep printing records appended to the file, as tail -F does; a single file only
+  -h, --help             this text
+)";
+
+    struct Options {
+        Filter filter;
+        std::size_t threads = std::thread::hardware_concurrency();
+        bool follow = false;
+        std::vector<std::string> files;
+    };
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (++i == argc) {
+                    throw std::invalid_argument(fmt::format("Option {} needs a value", arg));
+                }
+                return argv[i];
+            };
+
+            if (arg == "-h" || arg == "--help") {
+                fmt::print("{}", USAGE);
+                std::exit(0);
+            } else if (arg == "-s" || arg == "--severity") {
+                options.filter.severities = parseSeverities(value());
+            } else if (arg == "-c" || arg == "--channel") {
+                options.filter.channels.emplace_back(value());
+            } else if (arg == "-e" || arg == "--pattern") {
+                auto pattern = value();
+                if (pattern.empty()) {
+                    throw std::invalid_argument("Empty pattern");
+                }
+                options.filter.substrings.emplace_back(pattern);
+            } else if (arg == "--since") {
+                options.filter.since = parseTime(value());
+            } else if (arg == "--until") {
+                options.filter.until = parseTime(value());
+            } else if (arg == "-j" || arg == "--threads") {
+                options.threads = std::stoul(std::string{value()});
+            } else if (arg == "-f" || arg == "--follow") {
+                options.follow = true;
+            } else if (arg == "--") {
+                options.files.insert(options.files.end(), argv + i + 1, argv + argc);
+                break;
+            } else if (arg.starts_with('-') && arg != "-") {
+                throw std::invalid_argument(fmt::format("Unknown option {}", arg));
+            } else {
+                options.files.emplace_back(arg);
+            }
+        }
+        if (options.files.empty()) {
+            options.files.emplace_back("-");
+        }
+        if (options.follow && (options.files.size() != 1 || options.files.front() == "-")) {
+            throw std::invalid_argument("--follow takes a single file");
+        }
+        return options;
+    }
+
+    std::string readStdin() {
+        std::string result;
+        char chunk[1 << 16];
+        while (auto read = std::fread(chunk, 1, sizeof(chunk), stdin)) {
+            result.append(chunk, read);
+        }
+        if (std::ferror(stdin)) {
+            throw std::runtime_error("Cannot read stdin");
+        }
+        return result;
+    }
+
+    void writeOut(std::string_view text) {
+        if (std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) {
+            throw std::runtime_error("Cannot write to stdout");
+        }
+    }
+
+    /**
+     * Prints matching records of a followed file as their lines come in
+     *
+     * Without substrings to look for a record is decided on by its header, which is printed right away
+     * and so are its continuation lines; otherwise the record is held until the next header shows it is complete
+     */
+    class FollowPrinter {
+        const util::log_grep::Matcher& _matcher;
+        bool _byHeader;
+
+        /* the record being decided on by its header, or the held one */
+        bool _matching;
+        std::string _held;
+        std::size_t _heldFirstLine = 0;
+        bool _heldHasHeader = false;
+
+        void printLine(std::string_view line) {
+            writeOut(line);
+            writeOut("\n");
+        }
+    public:
+        explicit FollowPrinter(const util::log_grep::Matcher& matcher): _matcher(matcher),
+                _byHeader(matcher.filter().substrings.empty()), _matching(!matcher.filter().filtersHeaders()) {}
+
+        void line(std::string_view line) {
+            bool header = util::log::records::isHeader(line);
+            if (_byHeader) {
+                if (header) {
+                    _matching = _matcher.matches({line, line, true});
+                }
+                if (_matching) {
+                    printLine(line);
+                }
+            } else if (header || _held.empty()) {
+                flush();
+                _held = line;
+                _heldFirstLine = line.size();
+                _heldHasHeader = header;
+            } else {
+                _held += '\n';
+                _held += line;
+            }
+        }
+
+        /** The held record is complete, e.g. the file was rotated */
+        void flush() {
+            if (!_held.empty()) {
+                std::string_view held = _held;
+                if (_matcher.matches({held, held.substr(0, _heldFirstLine), _heldHasHeader})) {
+                    printLine(held);
+                }
+                _held.clear();
+            }
+            if (std::fflush(stdout) != 0) {
+                throw std::runtime_error("Cannot write to stdout");
+            }
+        }
+    };
+
+    void follow(const std::string& file, const util::log_grep::Matcher& matcher) {
+        util::log_follow::Follower follower{file};
+        FollowPrinter printer{matcher};
+        /* runs until the process is killed */
+        std::stop_source never;
+        follower.run(never.get_token(), [&printer](std::string_view line) {
+            printer.line(line);
+            if (std::fflush(stdout) != 0) {
+                throw std::runtime_error("Cannot write to stdout");
+            }
+        }, [&printer](util::log_follow::Change) {
+            printer.flush();
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        auto options = parseOptions(argc, argv);
+        util::log_grep::Matcher matcher{std::move(options.filter)};
+        if (options.follow) {
+            follow(options.files.front(), matcher);
+            return 0;
+        }
+
+        /* the writing thread is mostly waiting on futures so the workers get all of the cores */
+        util::pool::Pool pool{std::max<std::size_t>(options.threads, 1)};
+
+        static char buffer[1 << 20];
+        std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+        std::size_t matched = 0;
+        for (auto& file: options.files) {
+            if (file == "-") {
+                matched += util::log_grep::grep(pool, readStdin(), matcher, writeOut);
+            } else {
+                util::mapped_file::MappedFile mapped{file};
+                matched += util::log_grep::grep(pool, mapped.view(), matcher, writeOut);
+            }
+        }
+        if (std::fflush(stdout) != 0) {
+            throw std::runtime_error("Cannot write to stdout");
+        }
+        return matched != 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "log-grep: {}\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * log-index: keeps sidecar indexes of logs written by util::log and queries logs through them
+ *
+ *     log-index update file...
+ *     log-index query [options] file...
+ *
+ * See util/log_index.h; "update" is cheap when run again as the log grows, e.g. from cron or logrotate hooks
+ * Query takes the options of log-grep and prints the same records, reading only the blocks which may match
+ */
+
+#include <util/log_index.h>
+#include <util/mapped_file.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace {
+    using util::log_grep::Filter;
+    using util::log_grep::parseSeverities;
+    using util::log_grep::parseTime;
+    using util::log_index::Index;
+
+    constexpr std::string_view USAGE = R"(Usage: log-index update file...
+       log-index query [options] file...
+
+update  creates or brings up to date file.idx next to each file
+query   prints records matching all of the options given, as log-grep does, reading only the parts
+        of the files their indexes allow; files without an index are read in full
+
+Query options:
+  -s, --severity LIST    comma-separated severities e.g. WARN,ERROR; "WARN+" means WARN and above
+  -c, --channel NAME     records of this channel; may be repeated
+  -e, --pattern TEXT     records containing TEXT anywhere; may be repeated, any of them will do
+      --since TIME       records at or after TIME, e.g. "2025-01-31 12:00" or "2025-01-31 12:00:00.5"
+      --until TIME       records before TIME
+  -v, --verbose          tell on stderr how much of each file was read
+)";
+
+    struct Options {
+        Filter filter;
+        bool verbose = false;
+        std::vector<std::string> files;
+    };
+
+    Options parseQueryOptions(int argc, char* argv[], int first) {
+        Options options;
+        for (int i = first; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (++i == argc) {
+                    throw std::invalid_argument(fmt::format("Option {} needs a value", arg));
+                }
+                return argv[i];
+            };
+
+            if (arg == "-s" || arg == "--severity") {
+                options.filter.severities = parseSeverities(value());
+            } else if (arg == "-c" || arg == "--channel") {
+                options.filter.channels.emplace_back(value());
+            } else if (arg == "-e" || arg == "--pattern") {
+                auto pattern = value();
+                if (pattern.empty()) {
+                    throw std::invalid_argument("Empty pattern");
+                }
+                options.filter.substrings.emplace_back(pattern);
+            } else if (arg == "--since") {
+                options.filter.since = parseTime(value());
+            } else if (arg == "--until") {
+                options.filter.until = parseTime(value());
+            } else if (arg == "-v" || arg == "--verbose") {
+                options.verbose = true;
+            } else if (arg == "--") {
+                options.files.insert(options.files.end(), argv + i + 1, argv + argc);
+                break;
+            } else if (arg.starts_with('-')) {
+                throw std::invalid_argument(fmt::format("Unknown option {}", arg));
+            } else {
+                options.files.emplace_back(arg);
+            }
+        }
+        if (options.files.empty()) {
+            throw std::invalid_argument("No files given");
+        }
+        return options;
+    }
+
+    void writeOut(std::string_view text) {
+        if (std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) {
+            throw std::runtime_error("Cannot write to stdout");
+        }
+    }
+
+    void update(const std::string& file) {
+        util::mapped_file::MappedFile mapped{file};
+        auto path = Index::pathFor(file);
+        auto index = std::filesystem::exists(path) ? Index::load(path) : Index{};
+        auto before = index.covers(mapped.view()) ? index.indexedSize() : 0;
+        index.update(mapped.view());
+        index.save(path);
+        fmt::print("{}: {} blocks, {} new bytes indexed, {} left for the next update\n", file, index.blocks().size(),
+                index.indexedSize() - before, mapped.size() - index.indexedSize());
+    }
+
+    std::size_t query(const std::string& file, const util::log_grep::Matcher& matcher, bool verbose) {
+        util::mapped_file::MappedFile mapped{file, util::mapped_file::Access::RANDOM};
+        auto path = Index::pathFor(file);
+        auto index = std::filesystem::exists(path) ? Index::load(path) : Index{};
+        if (verbose) {
+            std::size_t read = 0;
+            for (auto [begin, end]: index.candidates(mapped.view(), matcher.filter())) {
+                read += end - begin;
+            }
+            fmt::print(stderr, "{}: reading {} of {} bytes{}\n", file, read, mapped.size(),
+                    index.covers(mapped.view()) ? "" : ", index is missing or stale");
+        }
+        return util::log_index::query(mapped.view(), index, matcher, writeOut);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        std::string_view command = argc > 1 ? argv[1] : "";
+        if (command == "-h" || command == "--help") {
+            fmt::print("{}", USAGE);
+            return 0;
+        }
+
+        if (command == "update" && argc > 2) {
+            for (int i = 2; i < argc; ++i) {
+                update(argv[i]);
+            }
+            return 0;
+        }
+
+        if (command == "query") {
+            auto options = parseQueryOptions(argc, argv, 2);
+            util::log_grep::Matcher matcher{std::move(options.filter)};
+
+            static char buffer[1 << 20];
+            std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+            std::size_t matched = 0;
+            for (auto& file: options.files) {
+                matched += query(file, matcher, options.verbose);
+            }
+            if (std::fflush(stdout) != 0) {
+                throw std::runtime_error("Cannot write to stdout");
+            }
+            return matched != 0 ? 0 : 1;
+        }
+
+        fmt::print(stderr, "{}", USAGE);
+        return 2;
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "log-index: {}\n", e.what());
+        return 2;
+    }
+}
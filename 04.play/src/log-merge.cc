@@ -0,0 +1,84 @@
+/**
+ * log-merge: interleaves logs written by util::log, e.g. by several instances of a service, by time
+ *
+ *     log-merge file...
+ *
+ * Records, stack traces and all, are written to stdout ordered by their timestamps; see util/log_merge.h
+ * Files are memory-mapped and the pages already merged are dropped as we go, so files of any size will do
+ */
+
+#include <util/log_merge.h>
+#include <util/mapped_file.h>
+
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace {
+    constexpr std::string_view USAGE = R"(Usage: log-merge file...
+
+Writes records of util::log logs to stdout ordered by time, stack traces stay with their records
+Each file has to be ordered by time on its own, records with equal times come in the order of the files
+)";
+
+    /** How much we merge between handing back pages of the inputs */
+    constexpr std::size_t DROP_EVERY = 64 << 20;
+
+    void writeOut(std::string_view text) {
+        if (std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) {
+            throw std::runtime_error("Cannot write to stdout");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        std::vector<util::mapped_file::MappedFile> files;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                fmt::print("{}", USAGE);
+                return 0;
+            }
+            files.emplace_back(argv[i]);
+        }
+        if (files.empty()) {
+            fmt::print(stderr, "{}", USAGE);
+            return 2;
+        }
+
+        std::vector<std::string_view> inputs;
+        for (auto& file: files) {
+            inputs.push_back(file.view());
+        }
+
+        static char buffer[1 << 20];
+        std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+        util::log_merge::Merger merger{inputs};
+        std::size_t sinceDrop = 0;
+        while (auto record = merger.next()) {
+            writeOut(record->text);
+            if (!record->text.ends_with('\n')) {
+                writeOut("\n");
+            }
+            if ((sinceDrop += record->text.size()) >= DROP_EVERY) {
+                for (std::size_t i = 0; i < files.size(); ++i) {
+                    files[i].dropBefore(merger.consumed(i));
+                }
+                sinceDrop = 0;
+            }
+        }
+        if (std::fflush(stdout) != 0) {
+            throw std::runtime_error("Cannot write to stdout");
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "log-merge: {}\n", e.what());
+        return 2;
+    }
+}
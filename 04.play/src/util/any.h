@@ -0,0 +1,311 @@
+#pragma once
+
+/**
+ * std::any look-alikes with an inline buffer of a size we choose
+ *
+ * libstdc++'s std::any keeps only values that fit into a single pointer inline, so anything bigger,
+ * like the std::array<char, 128> in variant.cc, is heap-allocated and every copy of the any allocates again
+ *
+ * SmallAny<N> keeps values of up to N bytes inline, provided they are nothrow-movable and not over-aligned,
+ * and falls back to the heap for the rest; UniqueAny<N> is the same but move-only so it can hold move-only values
+ *
+ * Operations are dispatched via a static table of function pointers per stored type rather than via RTTI:
+ * any_cast compares the table pointer with the one for the requested type, a single comparison;
+ * this relies on there being one copy of each table in the program, which holds unless the types are used
+ * across shared libraries that hide their symbols
+ *
+ * any_cast behaves like std::any_cast, including for std::reference_wrapper payloads: these are stored
+ * and cast to as they are, so any_cast<std::reference_wrapper<T>>(a).get() reaches the referenced object;
+ * failed casts throw std::bad_any_cast
+ *
+ * A moved-from any is empty
+ */
+
+#include <any>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace util::any {
+    namespace _detail {
+        struct VTable {
+            void (*destroy)(void* storage) noexcept;
+
+            /** Moves the value to uninitialized storage and destroys the original */
+            void (*relocate)(void* from, void* to) noexcept;
+
+            /** nullptr for UniqueAny */
+            void (*copy)(const void* from, void* to);
+
+            bool isInline;
+        };
+
+        template <typename T, std::size_t N>
+        constexpr bool FITS_INLINE = sizeof(T) <= N && alignof(T) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<T>;
+
+        template <typename T, bool Inline>
+        struct Manager {
+            static T* get(void* storage) noexcept {
+                if constexpr (Inline) {
+                    return std::launder(reinterpret_cast<T*>(storage));
+                } else {
+                    return static_cast<T*>(*static_cast<void**>(storage));
+                }
+            }
+
+            template <typename... Args>
+            static T& create(void* storage, Args&&... args) {
+                if constexpr (Inline) {
+                    return *new (storage) T(std::forward<Args>(args)...);
+                } else {
+                    auto value = new T(std::forward<Args>(args)...);
+                    *static_cast<void**>(storage) = value;
+                    return *value;
+                }
+            }
+
+            static void destroy(void* storage) noexcept {
+                if constexpr (Inline) {
+                    get(storage)->~T();
+                } else {
+                    delete get(storage);
+                }
+            }
+
+            static void relocate(void* from, void* to) noexcept {
+                if constexpr (Inline) {
+                    T* value = get(from);
+                    new (to) T(std::move(*value));
+                    value->~T();
+                } else {
+                    *static_cast<void**>(to) = *static_cast<void**>(from);
+                }
+            }
+
+            static void copy(const void* from, void* to) {
+                create(to, std::as_const(*get(const_cast<void*>(from))));
+            }
+        };
+
+        /* not a plain ?: as taking the address of copy() would instantiate it for move-only types */
+        template <typename T, bool Inline, bool Copyable>
+        constexpr auto copyFor() noexcept -> void (*)(const void*, void*) {
+            if constexpr (Copyable) {
+                return &Manager<T, Inline>::copy;
+            } else {
+                return nullptr;
+            }
+        }
+
+        template <typename T, bool Inline, bool Copyable>
+        inline constexpr VTable VTABLE{&Manager<T, Inline>::destroy, &Manager<T, Inline>::relocate,
+                copyFor<T, Inline, Copyable>(), Inline};
+
+        template <typename T>
+        struct IsInPlaceType: std::false_type {};
+
+        template <typename T>
+        struct IsInPlaceType<std::in_place_type_t<T>>: std::true_type {};
+    }
+
+    /** Use via the SmallAny and UniqueAny aliases */
+    template <std::size_t N, bool Copyable>
+    class BasicAny {
+        static constexpr std::size_t SIZE = N < sizeof(void*) ? sizeof(void*) : N;
+
+        alignas(std::max_align_t) std::byte _storage[SIZE];
+        const _detail::VTable* _vtable = nullptr;
+
+        template <typename T>
+        static constexpr bool ACCEPTS = Copyable ? std::is_copy_constructible_v<T> : std::is_move_constructible_v<T>;
+
+        template <typename T>
+        using Manager = _detail::Manager<T, _detail::FITS_INLINE<T, N>>;
+
+        template <typename T>
+        static constexpr const _detail::VTable* vtableFor() noexcept {
+            return &_detail::VTABLE<T, _detail::FITS_INLINE<T, N>, Copyable>;
+        }
+
+        template <typename T, typename... Args>
+        T& create(Args&&... args) {
+            auto& result = Manager<T>::create(_storage, std::forward<Args>(args)...);
+            _vtable = vtableFor<T>();
+            return result;
+        }
+
+        void moveFrom(BasicAny& other) noexcept {
+            if (other._vtable) {
+                other._vtable->relocate(other._storage, _storage);
+                _vtable = std::exchange(other._vtable, nullptr);
+            }
+        }
+    public:
+        BasicAny() noexcept = default;
+
+        BasicAny(const BasicAny& other) requires Copyable {
+            if (other._vtable) {
+                other._vtable->copy(other._storage, _storage);
+                _vtable = other._vtable;
+            }
+        }
+
+        BasicAny(BasicAny&& other) noexcept {
+            moveFrom(other);
+        }
+
+        template <typename T, typename V = std::decay_t<T>>
+            requires (!std::is_same_v<V, BasicAny> && !_detail::IsInPlaceType<V>::value && ACCEPTS<V>)
+        BasicAny(T&& value) {
+            create<V>(std::forward<T>(value));
+        }
+
+        template <typename T, typename... Args, typename V = std::decay_t<T>>
+            requires ACCEPTS<V>
+        explicit BasicAny(std::in_place_type_t<T>, Args&&... args) {
+            create<V>(std::forward<Args>(args)...);
+        }
+
+        template <typename T, typename U, typename... Args, typename V = std::decay_t<T>>
+            requires ACCEPTS<V>
+        explicit BasicAny(std::in_place_type_t<T>, std::initializer_list<U> list, Args&&... args) {
+            create<V>(list, std::forward<Args>(args)...);
+        }
+
+        ~BasicAny() {
+            reset();
+        }
+
+        BasicAny& operator=(const BasicAny& other) requires Copyable {
+            BasicAny(other).swap(*this);
+            return *this;
+        }
+
+        BasicAny& operator=(BasicAny&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        template <typename T, typename V = std::decay_t<T>>
+            requires (!std::is_same_v<V, BasicAny> && ACCEPTS<V>)
+        BasicAny& operator=(T&& value) {
+            BasicAny(std::forward<T>(value)).swap(*this);
+            return *this;
+        }
+
+        template <typename T, typename... Args, typename V = std::decay_t<T>>
+            requires ACCEPTS<V>
+        V& emplace(Args&&... args) {
+            reset();
+            return create<V>(std::forward<Args>(args)...);
+        }
+
+        template <typename T, typename U, typename... Args, typename V = std::decay_t<T>>
+            requires ACCEPTS<V>
+        V& emplace(std::initializer_list<U> list, Args&&... args) {
+            reset();
+            return create<V>(list, std::forward<Args>(args)...);
+        }
+
+        void reset() noexcept {
+            if (_vtable) {
+                _vtable->destroy(_storage);
+                _vtable = nullptr;
+            }
+        }
+
+        void swap(BasicAny& other) noexcept {
+            if (this != &other) {
+                BasicAny tmp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(tmp);
+            }
+        }
+
+        bool has_value() const noexcept {
+            return _vtable != nullptr;
+        }
+
+        /** What type() == typeid(T) tells for std::any */
+        template <typename T>
+        bool holds() const noexcept {
+            return _vtable == vtableFor<T>();
+        }
+
+        /** False if the value is on the heap or there's no value */
+        bool isInline() const noexcept {
+            return _vtable && _vtable->isInline;
+        }
+
+        /** Unchecked: the caller has made sure that holds<T>() */
+        template <typename T>
+        T* unsafeGet() noexcept {
+            return Manager<T>::get(_storage);
+        }
+
+        template <typename T>
+        const T* unsafeGet() const noexcept {
+            return Manager<T>::get(const_cast<std::byte*>(_storage));
+        }
+    };
+
+    template <std::size_t N = 32>
+    using SmallAny = BasicAny<N, true>;
+
+    template <std::size_t N = 32>
+    using UniqueAny = BasicAny<N, false>;
+
+    template <std::size_t N, bool Copyable>
+    void swap(BasicAny<N, Copyable>& a, BasicAny<N, Copyable>& b) noexcept {
+        a.swap(b);
+    }
+
+    /* the same overloads as std::any_cast; found by ADL so generic code can call any_cast unqualified */
+
+    template <typename T, std::size_t N, bool Copyable>
+    T* any_cast(BasicAny<N, Copyable>* any) noexcept {
+        static_assert(!std::is_reference_v<T>, "Pointer form of any_cast takes a value type");
+        if (!any || !any->template holds<std::remove_cv_t<T>>()) {
+            return nullptr;
+        }
+        return any->template unsafeGet<std::remove_cv_t<T>>();
+    }
+
+    template <typename T, std::size_t N, bool Copyable>
+    const T* any_cast(const BasicAny<N, Copyable>* any) noexcept {
+        return any_cast<T>(const_cast<BasicAny<N, Copyable>*>(any));
+    }
+
+    template <typename T, std::size_t N, bool Copyable>
+        requires std::is_constructible_v<T, const std::remove_cvref_t<T>&>
+    T any_cast(const BasicAny<N, Copyable>& any) {
+        if (auto value = any_cast<std::remove_cvref_t<T>>(&any)) {
+            return static_cast<T>(*value);
+        }
+        throw std::bad_any_cast{};
+    }
+
+    template <typename T, std::size_t N, bool Copyable>
+        requires std::is_constructible_v<T, std::remove_cvref_t<T>&>
+    T any_cast(BasicAny<N, Copyable>& any) {
+        if (auto value = any_cast<std::remove_cvref_t<T>>(&any)) {
+            return static_cast<T>(*value);
+        }
+        throw std::bad_any_cast{};
+    }
+
+    template <typename T, std::size_t N, bool Copyable>
+        requires std::is_constructible_v<T, std::remove_cvref_t<T>>
+    T any_cast(BasicAny<N, Copyable>&& any) {
+        if (auto value = any_cast<std::remove_cvref_t<T>>(&any)) {
+            return static_cast<T>(std::move(*value));
+        }
+        throw std::bad_any_cast{};
+    }
+}
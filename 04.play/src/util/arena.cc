@@ -0,0 +1,250 @@
+#include <util/arena.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace util::arena::_detail {
+    /** Header at the start of every block, the memory handed out follows it */
+    struct Block {
+        Block* next;
+        std::size_t size;   // including the header
+        bool mapped;        // came from mmap rather than malloc
+
+        static constexpr std::size_t HEADER = (sizeof(Block*) + sizeof(std::size_t) + sizeof(bool)
+                + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+        std::byte* begin() noexcept {
+            return reinterpret_cast<std::byte*>(this) + HEADER;
+        }
+
+        std::byte* end() noexcept {
+            return reinterpret_cast<std::byte*>(this) + size;
+        }
+    };
+}
+
+namespace {
+    using util::arena::_detail::Block;
+
+    constexpr std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+    constexpr std::size_t MIN_BLOCK = 4096;
+
+    /** Big allocations get blocks of their own rather than wasting the rest of the current block */
+    constexpr std::size_t LARGE_FRACTION = 4;
+
+    Block* initBlock(void* memory, std::size_t size, bool mapped) noexcept {
+        return new (memory) Block{nullptr, size, mapped};
+    }
+
+    /** Huge pages only get used for 2MiB aligned ranges, so we map a bit more and trim both ends */
+    Block* mapHugeBlock(std::size_t size) {
+        auto mapped = mmap(nullptr, size + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+        auto start = reinterpret_cast<std::uintptr_t>(mapped);
+        auto aligned = (start + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        if (aligned != start) {
+            munmap(mapped, aligned - start);
+        }
+        if (auto tail = start + size + HUGE_PAGE - (aligned + size)) {
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        /* just advice: if THP is disabled we get regular pages */
+        madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+        return initBlock(reinterpret_cast<void*>(aligned), size, true);
+    }
+
+    Block* allocateBlock(std::size_t size, bool hugePages) {
+        if (hugePages) {
+            return mapHugeBlock(size);
+        }
+        auto memory = std::malloc(size);
+        if (!memory) {
+            throw std::bad_alloc{};
+        }
+        return initBlock(memory, size, false);
+    }
+
+    void freeBlock(Block* block) noexcept {
+        if (block->mapped) {
+            munmap(block, block->size);
+        } else {
+            std::free(block);
+        }
+    }
+
+    void freeBlocks(Block* block) noexcept {
+        while (block) {
+            auto next = block->next;
+            freeBlock(block);
+            block = next;
+        }
+    }
+
+    /**
+     * Blocks of arenas destroyed on this thread, for the next arenas to pick up
+     * Arenas with different options may share the cache so blocks are matched on size and kind
+     */
+    struct BlockCache {
+        static constexpr std::size_t MAX_BLOCKS = 16;
+
+        Block* head = nullptr;
+        std::size_t count = 0;
+
+        ~BlockCache();
+
+        Block* take(std::size_t size, bool mapped) noexcept {
+            for (auto link = &head; *link; link = &(*link)->next) {
+                auto block = *link;
+                if (block->size == size && block->mapped == mapped) {
+                    *link = block->next;
+                    block->next = nullptr;
+                    --count;
+                    return block;
+                }
+            }
+            return nullptr;
+        }
+
+        bool put(Block* block) noexcept {
+            if (count == MAX_BLOCKS) {
+                return false;
+            }
+            block->next = head;
+            head = block;
+            ++count;
+            return true;
+        }
+    };
+
+    /* an arena that is itself thread_local may outlive the cache */
+    constinit thread_local bool cacheDestroyed = false;
+    thread_local BlockCache cache;
+
+    BlockCache::~BlockCache() {
+        cacheDestroyed = true;
+        freeBlocks(head);
+    }
+}
+
+namespace util::arena {
+    Arena::Arena(Options options): _options(options) {
+        _options.blockSize = std::max(_options.blockSize, MIN_BLOCK);
+        if (_options.hugePages) {
+            _options.blockSize = (_options.blockSize + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        }
+    }
+
+    Arena::~Arena() {
+        release();
+    }
+
+    _detail::Block* Arena::newBlock() {
+        if (_options.threadCache && !cacheDestroyed) {
+            if (auto block = cache.take(_options.blockSize, _options.hugePages)) {
+                return block;
+            }
+        }
+        return allocateBlock(_options.blockSize, _options.hugePages);
+    }
+
+    void Arena::useBlock(_detail::Block* block) noexcept {
+        if (_current) {
+            _usedElsewhere += static_cast<std::size_t>(_ptr - _current->begin());
+        }
+        _current = block;
+        _ptr = block->begin();
+        _end = block->end();
+    }
+
+    void* Arena::allocateSlow(std::size_t bytes, std::size_t alignment) {
+        auto capacity = _options.blockSize - _detail::Block::HEADER;
+        if (bytes + alignment > capacity / LARGE_FRACTION) {
+            return allocateLarge(bytes, alignment);
+        }
+
+        /* the fast path leaves exact fits and the very 1st allocation to us */
+        if (_current) {
+            auto ptr = reinterpret_cast<std::uintptr_t>(_ptr);
+            auto aligned = (ptr + alignment - 1) & ~(alignment - 1);
+            if (aligned - ptr + bytes <= static_cast<std::size_t>(_end - _ptr)) {
+                _ptr += aligned - ptr + bytes;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+
+        if (_current && _current->next) {
+            /* a spare block kept by reset() */
+            useBlock(_current->next);
+        } else {
+            auto block = newBlock();
+            if (_current) {
+                _current->next = block;
+            } else {
+                _first = block;
+            }
+            useBlock(block);
+        }
+
+        /* can't recurse more than once: the block is fresh and the allocation is small */
+        return allocate(bytes, alignment);
+    }
+
+    void* Arena::allocateLarge(std::size_t bytes, std::size_t alignment) {
+        auto block = allocateBlock(_detail::Block::HEADER + bytes + alignment, false);
+        block->next = _large;
+        _large = block;
+        _usedElsewhere += bytes;
+
+        auto start = reinterpret_cast<std::uintptr_t>(block->begin());
+        return reinterpret_cast<void*>((start + alignment - 1) & ~(alignment - 1));
+    }
+
+    void Arena::releaseLarge() noexcept {
+        freeBlocks(_large);
+        _large = nullptr;
+    }
+
+    void Arena::reset() noexcept {
+        releaseLarge();
+        _usedElsewhere = 0;
+        if (_first) {
+            _current = _first;
+            _ptr = _first->begin();
+            _end = _first->end();
+        }
+    }
+
+    void Arena::release() noexcept {
+        releaseLarge();
+        for (auto block = _first; block;) {
+            auto next = block->next;
+            if (!_options.threadCache || cacheDestroyed || !cache.put(block)) {
+                freeBlock(block);
+            }
+            block = next;
+        }
+        _first = _current = nullptr;
+        _ptr = _end = nullptr;
+        _usedElsewhere = 0;
+    }
+
+    std::size_t Arena::bytesUsed() const noexcept {
+        return _usedElsewhere + (_current ? static_cast<std::size_t>(_ptr - _current->begin()) : 0);
+    }
+
+    std::size_t Arena::bytesReserved() const noexcept {
+        std::size_t result = 0;
+        for (auto block = _first; block; block = block->next) {
+            result += block->size;
+        }
+        for (auto block = _large; block; block = block->next) {
+            result += block->size;
+        }
+        return result;
+    }
+}
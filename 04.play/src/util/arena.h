@@ -0,0 +1,124 @@
+#pragma once
+
+/**
+ * Bump-pointer arena for lots of short-lived allocations that die together, e.g. everything made
+ * while processing one request
+ *
+ * Allocating is a pointer increment in the common case; freeing individual allocations does nothing,
+ * reset() frees everything at once in O(1) by rewinding to the 1st block: blocks are kept for reuse
+ * so an arena that is reset after each request stops touching malloc after the 1st few requests
+ *
+ * Allocations bigger than a quarter of a block get a block of their own which reset() does give back,
+ * so reset() is O(1) plus O(number of such oversized allocations)
+ *
+ * Blocks can be backed by transparent huge pages which pays off for big arenas that get reused:
+ * fewer TLB misses; and when an arena is destroyed its blocks go to a small per-thread cache
+ * so that creating an arena per request doesn't go to malloc or mmap each time either
+ *
+ * An arena is meant to be used from one thread at a time
+ *
+ * ArenaResource adapts an arena to std::pmr::memory_resource so std::pmr containers can use it,
+ * as can fmt::basic_memory_buffer<char, N, std::pmr::polymorphic_allocator<char>> when formatting
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace util::arena {
+    struct Options {
+        /** Rounded up to a multiple of 2MiB when hugePages is set */
+        std::size_t blockSize = 64 * 1024;
+
+        /** Back blocks with mmap'ed memory advised to use transparent huge pages */
+        bool hugePages = false;
+
+        /** Take blocks from and give them back to the current thread's cache */
+        bool threadCache = true;
+    };
+
+    namespace _detail {
+        struct Block;
+    }
+
+    class Arena {
+        Options _options;
+
+        /* current block and the free space left in it */
+        _detail::Block* _current = nullptr;
+        std::byte* _ptr = nullptr;
+        std::byte* _end = nullptr;
+
+        /* blocks in the order they were put to use; those after _current are spare ones left by reset() */
+        _detail::Block* _first = nullptr;
+
+        /* oversized allocations */
+        _detail::Block* _large = nullptr;
+
+        /* bytes handed out from blocks other than _current, for bytesUsed() */
+        std::size_t _usedElsewhere = 0;
+
+        void* allocateSlow(std::size_t bytes, std::size_t alignment);
+        void* allocateLarge(std::size_t bytes, std::size_t alignment);
+        void useBlock(_detail::Block* block) noexcept;
+        _detail::Block* newBlock();
+        void releaseLarge() noexcept;
+    public:
+        explicit Arena(Options options = {});
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /** 'alignment' has to be a power of 2; throws std::bad_alloc if memory cannot be had */
+        void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+            auto ptr = reinterpret_cast<std::uintptr_t>(_ptr);
+            auto aligned = (ptr + alignment - 1) & ~(alignment - 1);
+            /* strictly less so that a fresh arena with no block doesn't hand out nullptr for 0 bytes */
+            if (aligned - ptr + bytes < static_cast<std::size_t>(_end - _ptr)) {
+                _ptr += aligned - ptr + bytes;
+                return reinterpret_cast<void*>(aligned);
+            }
+            return allocateSlow(bytes, alignment);
+        }
+
+        /** Uninitialized space for 'count' objects of type T */
+        template <typename T>
+        T* allocateArray(std::size_t count) {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        /** Makes all memory available again; nothing gets destroyed */
+        void reset() noexcept;
+
+        /** Like reset() but also gives the blocks back */
+        void release() noexcept;
+
+        /** Bytes handed out since the last reset() including padding for alignment */
+        std::size_t bytesUsed() const noexcept;
+
+        /** Bytes in the blocks the arena holds on to */
+        std::size_t bytesReserved() const noexcept;
+    };
+
+    /** Allocates from an arena; deallocate() is a no-op, memory comes back when the arena is reset */
+    class ArenaResource final: public std::pmr::memory_resource {
+        Arena& _arena;
+    public:
+        explicit ArenaResource(Arena& arena) noexcept: _arena(arena) {}
+
+        Arena& arena() const noexcept {
+            return _arena;
+        }
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            return _arena.allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+}
@@ -0,0 +1,53 @@
+#include <util/coro.h>
+
+#include <optional>
+
+namespace util::coro {
+    ThreadPool::ThreadPool(std::size_t threads) {
+        if (threads == 0) {
+            threads = 1; // hardware_concurrency() is allowed to return 0 if it doesn't know
+        }
+        _threads.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            _threads.emplace_back([this](std::stop_token stopToken) { run(stopToken); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        /* asking all threads to stop first so that they wind down in parallel */
+        for (auto& thread: _threads) {
+            thread.request_stop();
+        }
+        for (auto& thread: _threads) {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::post(std::coroutine_handle<> coro) {
+        auto context = util::log::context::capture();
+        {
+            std::lock_guard lock{_mutex};
+            _queue.push_back({coro, std::move(context)});
+        }
+        _cv.notify_one();
+    }
+
+    void ThreadPool::run(std::stop_token stopToken) {
+        for (;;) {
+            std::optional<Posted> posted;
+            {
+                std::unique_lock lock{_mutex};
+                _cv.wait(lock, stopToken, [this] { return !_queue.empty(); });
+
+                /* once asked to stop we still drain the queue so that no coroutine is left hanging */
+                if (_queue.empty()) {
+                    return;
+                }
+                posted.emplace(std::move(_queue.front()));
+                _queue.pop_front();
+            }
+            util::log::context::Adopt adopt{posted->context.get()};
+            posted->coro.resume();
+        }
+    }
+}
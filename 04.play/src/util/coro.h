@@ -0,0 +1,471 @@
+#pragma once
+
+/**
+ * Minimal coroutine runtime: lazy Task<T>, syncWait(), whenAll() and a ThreadPool to resume coroutines on
+ *
+ * Task<T> doesn't start until it is co_awaited; the awaiting coroutine is resumed when the task completes
+ * via symmetric transfer so long chains of co_await don't grow the stack - as long as the compiler turns it into
+ * a tail call which gcc does when optimizing but not with -O0 or sanitizers
+ *
+ * A coroutine moves itself onto the pool with "co_await pool.schedule()"; this way thousands of operations
+ * can be in flight while only a handful of threads exist, each operation only holding a thread while it's running
+ *
+ * Exceptions escaping a task are kept as std::exception_ptr and rethrown in the awaiter by std::rethrow_exception
+ * This rethrows the very same exception object rather than a copy, so the stack trace boost::stacktrace has
+ * attached to it when it was thrown is still there and util::log can print it just like for a synchronous call
+ */
+
+#include <util/log/context.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace util::coro {
+    template <typename T = void> class Task;
+
+    namespace _detail {
+        /** Resumes whoever awaited the task once it completes, or nobody if it has been started some other way */
+        struct FinalAwaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coro) noexcept {
+                auto continuation = coro.promise().continuation();
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        class PromiseBase {
+            std::coroutine_handle<> _continuation;
+        public:
+            std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() const noexcept {
+                return {};
+            }
+
+            std::coroutine_handle<> continuation() const noexcept {
+                return _continuation;
+            }
+
+            void setContinuation(std::coroutine_handle<> continuation) noexcept {
+                _continuation = continuation;
+            }
+        };
+
+        template <typename T>
+        class Promise: public PromiseBase {
+            std::variant<std::monostate, T, std::exception_ptr> _result;
+        public:
+            Task<T> get_return_object() noexcept;
+
+            template <typename U>
+            requires std::is_convertible_v<U&&, T>
+            void return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>) {
+                _result.template emplace<1>(std::forward<U>(value));
+            }
+
+            void unhandled_exception() noexcept {
+                _result.template emplace<2>(std::current_exception());
+            }
+
+            T result() {
+                if (_result.index() == 2) {
+                    std::rethrow_exception(std::get<2>(_result));
+                }
+                return std::move(std::get<1>(_result));
+            }
+        };
+
+        template <>
+        class Promise<void>: public PromiseBase {
+            std::exception_ptr _exception;
+        public:
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() noexcept {
+                _exception = std::current_exception();
+            }
+
+            void result() {
+                if (_exception) {
+                    std::rethrow_exception(_exception);
+                }
+            }
+        };
+
+        /**
+         * Awaits a task without fetching its result: used by syncWait() and whenAll() which want all their tasks
+         * to complete first and only then look at the results
+         */
+        template <typename Signal>
+        class Notifier {
+        public:
+            struct promise_type {
+                Signal* _signal = nullptr;
+
+                Notifier get_return_object() noexcept {
+                    return Notifier{std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+
+                std::suspend_always initial_suspend() const noexcept {
+                    return {};
+                }
+
+                /* signalling from final_suspend means that the frame can be safely destroyed by whoever we wake up */
+                auto final_suspend() const noexcept {
+                    struct Awaiter {
+                        bool await_ready() const noexcept {
+                            return false;
+                        }
+
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coro) noexcept {
+                            return coro.promise()._signal->arrive();
+                        }
+
+                        void await_resume() const noexcept {}
+                    };
+                    return Awaiter{};
+                }
+
+                void return_void() const noexcept {}
+
+                /* Task keeps exceptions to itself so nothing can get here */
+                void unhandled_exception() const noexcept {
+                    std::terminate();
+                }
+            };
+
+            Notifier(Notifier&& other) noexcept: _coro(std::exchange(other._coro, {})) {}
+
+            Notifier& operator=(Notifier&&) = delete;
+
+            ~Notifier() {
+                if (_coro) {
+                    _coro.destroy();
+                }
+            }
+
+            void start(Signal& signal) {
+                _coro.promise()._signal = &signal;
+                /* the task may move to another thread keeping scopes it has entered here open, we keep ours */
+                util::log::context::Adopt keep{util::log::context::current()};
+                _coro.resume();
+            }
+        private:
+            explicit Notifier(std::coroutine_handle<promise_type> coro): _coro(coro) {}
+            std::coroutine_handle<promise_type> _coro;
+        };
+
+        template <typename Signal, typename T>
+        Notifier<Signal> notifyWhenReady(Task<T>& task) {
+            co_await task._whenReady();
+        }
+
+        /** Lets a thread block until a coroutine completes */
+        class Event {
+            std::mutex _mutex;
+            std::condition_variable _cv;
+            bool _set = false;
+        public:
+            std::coroutine_handle<> arrive() noexcept {
+                /* notifying under the lock so that the waiter can't destroy us before we're done */
+                std::lock_guard lock{_mutex};
+                _set = true;
+                _cv.notify_one();
+                return std::noop_coroutine();
+            }
+
+            void wait() {
+                std::unique_lock lock{_mutex};
+                _cv.wait(lock, [this] { return _set; });
+            }
+        };
+
+        /** Resumes the awaiting coroutine once all the tasks have completed */
+        class Latch {
+            /* one extra count for the awaiting coroutine itself so that it can't be resumed before it has suspended */
+            std::atomic<std::size_t> _count;
+            std::coroutine_handle<> _continuation;
+        public:
+            explicit Latch(std::size_t count): _count(count + 1) {}
+
+            std::coroutine_handle<> arrive() noexcept {
+                if (_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return _continuation;
+                }
+                return std::noop_coroutine();
+            }
+
+            /** Returns false if all tasks are already done and the caller should not suspend */
+            bool suspend(std::coroutine_handle<> continuation) noexcept {
+                _continuation = continuation;
+                return _count.fetch_sub(1, std::memory_order_acq_rel) > 1;
+            }
+        };
+
+        template <typename T>
+        using NonVoid = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        template <typename T>
+        NonVoid<T> takeResult(Task<T>& task) {
+            if constexpr (std::is_void_v<T>) {
+                task._result();
+                return {};
+            } else {
+                return task._result();
+            }
+        }
+
+        /** Starts all the notifiers and suspends the awaiting coroutine until they are all done */
+        template <typename Notifiers>
+        class AllReady {
+            Latch _latch;
+            Notifiers& _notifiers;
+        public:
+            AllReady(Notifiers& notifiers): _latch(std::size(notifiers)), _notifiers(notifiers) {}
+
+            bool await_ready() const noexcept {
+                return std::size(_notifiers) == 0;
+            }
+
+            bool await_suspend(std::coroutine_handle<> continuation) {
+                for (auto& notifier: _notifiers) {
+                    notifier.start(_latch);
+                }
+                return _latch.suspend(continuation);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        template <typename Notifiers>
+        AllReady(Notifiers&) -> AllReady<Notifiers>;
+    }
+
+    /**
+     * Lazily started coroutine producing a T; owns the coroutine frame
+     *
+     * Can only be co_awaited once and only as an rvalue: "co_await std::move(task)" or "co_await makeTask()"
+     */
+    template <typename T>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = _detail::Promise<T>;
+        using value_type = T;
+
+        Task() = default;
+
+        Task(Task&& other) noexcept: _coro(std::exchange(other._coro, {})) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (_coro) {
+                    _coro.destroy();
+                }
+                _coro = std::exchange(other._coro, {});
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (_coro) {
+                _coro.destroy();
+            }
+        }
+
+        bool isReady() const noexcept {
+            return !_coro || _coro.done();
+        }
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> _coro;
+
+                bool await_ready() const noexcept {
+                    return _coro.done();
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    _coro.promise().setContinuation(awaiting);
+                    return _coro;
+                }
+
+                T await_resume() {
+                    return _coro.promise().result();
+                }
+            };
+            return Awaiter{checked()};
+        }
+
+        /** Not a part of public API: awaits completion without fetching the result, see syncWait() and whenAll() */
+        auto _whenReady() noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> _coro;
+
+                bool await_ready() const noexcept {
+                    return _coro.done();
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    _coro.promise().setContinuation(awaiting);
+                    return _coro;
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{checked()};
+        }
+
+        /** Not a part of public API: result of a completed task, rethrows the exception if the task has failed */
+        T _result() {
+            return checked().promise().result();
+        }
+    private:
+        friend promise_type;
+        explicit Task(std::coroutine_handle<promise_type> coro) noexcept: _coro(coro) {}
+
+        std::coroutine_handle<promise_type> checked() const {
+            if (!_coro) {
+                throw std::logic_error("Task is empty, it has been moved from");
+            }
+            return _coro;
+        }
+
+        std::coroutine_handle<promise_type> _coro;
+    };
+
+    namespace _detail {
+        template <typename T>
+        Task<T> Promise<T>::get_return_object() noexcept {
+            return Task<T>{std::coroutine_handle<Promise>::from_promise(*this)};
+        }
+
+        inline Task<void> Promise<void>::get_return_object() noexcept {
+            return Task<void>{std::coroutine_handle<Promise>::from_promise(*this)};
+        }
+    }
+
+    /** Runs the task to completion blocking the calling thread; the task may well be resumed on other threads */
+    template <typename T>
+    T syncWait(Task<T> task) {
+        _detail::Event done;
+        auto notifier = _detail::notifyWhenReady<_detail::Event>(task);
+        notifier.start(done);
+        done.wait();
+        return task._result();
+    }
+
+    /**
+     * Starts all tasks and completes once they all have; void results are represented by std::monostate
+     *
+     * Tasks are started one by one on the awaiting thread and run until their 1st suspension point;
+     * to get them running in parallel they have to "co_await pool.schedule()" themselves
+     *
+     * If several tasks fail the exception from the leftmost one gets thrown
+     */
+    template <typename... Ts>
+    requires (sizeof...(Ts) > 0)
+    Task<std::tuple<_detail::NonVoid<Ts>...>> whenAll(Task<Ts>... tasks) {
+        std::array notifiers{_detail::notifyWhenReady<_detail::Latch>(tasks)...};
+        co_await _detail::AllReady{notifiers};
+        co_return std::tuple<_detail::NonVoid<Ts>...>{_detail::takeResult(tasks)...};
+    }
+
+    template <typename T>
+    Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> whenAll(std::vector<Task<T>> tasks) {
+        std::vector<_detail::Notifier<_detail::Latch>> notifiers;
+        notifiers.reserve(tasks.size());
+        for (auto& task: tasks) {
+            notifiers.push_back(_detail::notifyWhenReady<_detail::Latch>(task));
+        }
+        co_await _detail::AllReady{notifiers};
+
+        if constexpr (std::is_void_v<T>) {
+            for (auto& task: tasks) {
+                task._result();
+            }
+        } else {
+            std::vector<T> results;
+            results.reserve(tasks.size());
+            for (auto& task: tasks) {
+                results.push_back(task._result());
+            }
+            co_return results;
+        }
+    }
+
+    /**
+     * Fixed number of threads resuming coroutines in FIFO order
+     * A coroutine gets resumed with the log context of the thread which has posted it
+     *
+     * On destruction the pool resumes whatever has already been scheduled and then joins its threads
+     * so nothing gets lost, but a coroutine scheduling itself once the destructor has started is an error
+     */
+    class ThreadPool {
+        std::mutex _mutex;
+        std::condition_variable_any _cv;
+        struct Posted {
+            std::coroutine_handle<> coro;
+            std::unique_ptr<util::log::context::Context> context;
+        };
+
+        std::deque<Posted> _queue;
+        std::vector<std::jthread> _threads;
+
+        void run(std::stop_token stopToken);
+    public:
+        explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        std::size_t size() const noexcept {
+            return _threads.size();
+        }
+
+        /** Queues the coroutine to be resumed on one of the pool threads */
+        void post(std::coroutine_handle<> coro);
+
+        /** "co_await pool.schedule()" continues the coroutine on one of the pool threads */
+        auto schedule() noexcept {
+            struct Awaiter {
+                ThreadPool& _pool;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> coro) {
+                    _pool.post(coro);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{*this};
+        }
+    };
+}
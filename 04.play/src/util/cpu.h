@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Which optional instruction sets the CPU we're running on has
+ *
+ * The build targets baseline x86-64, that is SSE2, so code using anything newer compiles its kernels
+ * with __attribute__((target(...))) and picks them at runtime after asking here
+ * When the build itself enables an instruction set, e.g. with -march=native, the answer is known at compile time
+ */
+
+namespace util::cpu {
+    /** pshufb and friends; false on anything but x86 */
+    inline bool hasSsse3() noexcept {
+#if defined(__SSSE3__)
+        return true;
+#elif defined(__x86_64__) || defined(__i386__)
+        static const bool result = __builtin_cpu_supports("ssse3");
+        return result;
+#else
+        return false;
+#endif
+    }
+}
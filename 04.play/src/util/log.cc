@@ -1,4 +1,5 @@
 #include <util/log.h>
+#include <util/log/context.h>
 
 #include <iterator>
 #include <ranges>
@@ -236,6 +237,35 @@ namespace util::log {
     BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp, "TimeStamp", boost::posix_time::ptime)
     BOOST_LOG_ATTRIBUTE_KEYWORD(severity, "Severity", severity_level)
     BOOST_LOG_ATTRIBUTE_KEYWORD(channel, "Channel", std::string)
+    BOOST_LOG_ATTRIBUTE_KEYWORD(mdc, "Context", context::Context)
+
+    namespace context {
+        /** "{key=value, key=value} " for the formatter to put in front of the message */
+        std::ostream& operator<<(std::ostream& os, const Context& context) {
+            const char* separator = "{";
+            for (auto& attribute: context.attributes()) {
+                os << separator << attribute.key << '=' << attribute.view();
+                separator = ", ";
+            }
+            return os << "} ";
+        }
+
+        /** Copy of the context of the thread opening the record; no value at all if the context is empty */
+        class ContextAttribute: public boost::log::attribute {
+            class Impl: public boost::log::attribute::impl {
+            public:
+                boost::log::attribute_value get_value() override {
+                    auto& current = context::current();
+                    if (current.empty()) {
+                        return {};
+                    }
+                    return boost::log::attributes::make_attribute_value(current);
+                }
+            };
+        public:
+            ContextAttribute(): boost::log::attribute(new Impl) {}
+        };
+    }
 
     void suppressTracesAbove(std::size_t levelsAbove) {
         stacktrace trace{levelsAbove + 1, 1};
@@ -262,6 +292,10 @@ namespace util::log {
             dans::thread_id(),
             attrs::current_thread_id());
 
+        pCore->add_global_attribute(
+            mdc_type::get_name(),
+            context::ContextAttribute());
+
         std::set_terminate(handleTerminate);
     }
 
@@ -274,13 +308,18 @@ namespace util::log {
     namespace attrs = boost::log::attributes;
     namespace exprs = boost::log::expressions;
 
-    void setStandardLogFormat(boost::shared_ptr<synchronous_sink<text_ostream_backend>> ptr) {
-        ptr -> set_formatter(exprs::stream
+    boost::log::formatter standardLogFormatter() {
+        return exprs::stream
                 << exprs::format_date_time(timestamp, "%Y-%m-%d %H:%M:%S.%f")
                 << " #" << std::setw(5) << std::left
                 << severity << std::setw(0)
                 << " [" << channel << "] "
-                << exprs::smessage);
+                << mdc
+                << exprs::smessage;
+    }
+
+    void setStandardLogFormat(boost::shared_ptr<synchronous_sink<text_ostream_backend>> ptr) {
+        ptr -> set_formatter(standardLogFormatter());
     }
 
     void logToConsole() {
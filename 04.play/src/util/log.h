@@ -5,6 +5,7 @@
 #include <fmt/ostream.h>
 
 #include <boost/log/attributes.hpp>
+#include <boost/log/expressions/formatter.hpp>
 #include <boost/log/sinks.hpp>
 #include <boost/log/sources/severity_channel_logger.hpp>
 #include <boost/log/sources/record_ostream.hpp>
@@ -17,6 +18,7 @@
  *
  * Presently all logging is going to the console
  * Logging can be directed to a file using regular Boost log facilities
+ * Worker processes of a host can share one file through util::log_ring::logToRing() and a collector
  *
  * When passing arguments to std::format all values after format string go in as const& - seems good enough for now
  */
@@ -259,6 +261,7 @@ namespace util::log {
 
     /**
      * Invokes boost::log::add_common_attributes() and adds timestamps and levels
+     * as well as the thread's util::log::context attributes, see util/log/context.h
      */
     void commonLoggingSetup();
 
@@ -267,6 +270,9 @@ namespace util::log {
      */
     void logToConsole();
 
+    /** Timestamp, severity, channel, context and message; for sinks other than the console to write what it does */
+    boost::log::formatter standardLogFormatter();
+
     void setStandardLogFormat(boost::shared_ptr<boost::log::sinks::synchronous_sink<
             boost::log::sinks::text_ostream_backend>>);
 }
@@ -0,0 +1,184 @@
+#pragma once
+
+/**
+ * Context attributes, aka MDC: key-value pairs which every record logged by the thread carries along
+ *
+ *     void handle(const Request& request) {
+ *         util::log::context::Scope requestId{"requestId", request.id};
+ *         util::log::context::Scope tenant{"tenant", request.tenant};
+ *         logger.info("Handling");   // 2025-01-31 12:34:56.123456 #INFO  [main] {requestId=42, tenant=acme} Handling
+ *     }
+ *
+ * commonLoggingSetup() registers a "Context" attribute reading them and standardLogFormatter() prints it
+ * between the channel and the message, so sinks using the standard format, log_ring included, get them for free
+ *
+ * The context lives in fixed-size thread-local slots so a Scope costs a copy of its value and no allocation;
+ * keys are not copied and should be string literals, values longer than VALUE_CAPACITY are cut short,
+ * scopes beyond MAX_ATTRIBUTES are ignored
+ *
+ * Work handed over to another thread takes the context along: util::pool tasks run with the context of the thread
+ * that has submitted them, and a coroutine moving onto a util::coro::ThreadPool with schedule() keeps its own
+ * A Scope may thus be left on a different thread than the one it was entered on, and that is fine:
+ * leaving it drops its attribute and whatever has been pushed after it from the current thread's context
+ *
+ * This is deliberately not a part of log.h so that pool.h and coro.h can include it without pulling in Boost.Log
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace util::log::context {
+    constexpr std::size_t MAX_ATTRIBUTES = 8;
+
+    /** Chosen for an Attribute to take exactly one cache line */
+    constexpr std::size_t VALUE_CAPACITY = 55;
+
+    struct Attribute {
+        const char* key;
+        std::uint8_t length;
+        std::array<char, VALUE_CAPACITY> value;
+
+        std::string_view view() const noexcept {
+            return {value.data(), length};
+        }
+    };
+
+    static_assert(sizeof(Attribute) == 64);
+
+    /**
+     * Attributes of one thread, in the order they've been pushed
+     *
+     * All the slots make it over half a kilobyte, copies only take the slots in use;
+     * to carry it along with a task use capture() which doesn't copy an empty one at all
+     */
+    class Context {
+        std::array<Attribute, MAX_ATTRIBUTES> _attributes;
+        std::size_t _size;
+    public:
+        constexpr Context() noexcept: _attributes{}, _size(0) {}
+
+        Context(const Context& other) noexcept: _size(other._size) {
+            std::copy_n(other._attributes.begin(), _size, _attributes.begin());
+        }
+
+        Context& operator=(const Context& other) noexcept {
+            _size = other._size;
+            std::copy_n(other._attributes.begin(), _size, _attributes.begin());
+            return *this;
+        }
+
+        std::size_t size() const noexcept {
+            return _size;
+        }
+
+        bool empty() const noexcept {
+            return _size == 0;
+        }
+
+        std::span<const Attribute> attributes() const noexcept {
+            return {_attributes.data(), _size};
+        }
+
+        /** Value of the innermost attribute with this key, empty if there is none */
+        std::string_view find(std::string_view key) const noexcept {
+            for (auto i = _size; i-- > 0;) {
+                if (_attributes[i].key == key) {
+                    return _attributes[i].view();
+                }
+            }
+            return {};
+        }
+
+        /** Returns false if all the slots are taken */
+        bool push(const char* key, std::string_view value) noexcept {
+            if (_size == MAX_ATTRIBUTES) {
+                return false;
+            }
+            auto& attribute = _attributes[_size++];
+            attribute.key = key;
+            attribute.length = static_cast<std::uint8_t>(std::min(value.size(), VALUE_CAPACITY));
+            std::copy_n(value.data(), attribute.length, attribute.value.data());
+            return true;
+        }
+
+        /** Drops the attributes from 'size' on */
+        void truncate(std::size_t size) noexcept {
+            _size = std::min(_size, size);
+        }
+    };
+
+    namespace _detail {
+        /* constant-initialized so accessing it doesn't go through a TLS wrapper function */
+        inline thread_local Context current;
+    }
+
+    inline const Context& current() noexcept {
+        return _detail::current;
+    }
+
+    /** Copy of the current thread's context for a task to take along, null if it is empty */
+    inline std::unique_ptr<Context> capture() {
+        return _detail::current.empty() ? nullptr : std::make_unique<Context>(_detail::current);
+    }
+
+    /** Adds an attribute to the context of the current thread for its lifetime */
+    class Scope {
+        std::size_t _index;
+    public:
+        Scope(const char* key, std::string_view value) noexcept: _index(_detail::current.size()) {
+            _detail::current.push(key, value);
+        }
+
+        template <std::integral T>
+        requires (!std::same_as<T, bool>)
+        Scope(const char* key, T value) noexcept: _index(_detail::current.size()) {
+            std::array<char, 24> text;
+            auto end = std::to_chars(text.data(), text.data() + text.size(), value).ptr;
+            _detail::current.push(key, {text.data(), end});
+        }
+
+        ~Scope() {
+            _detail::current.truncate(_index);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /**
+     * Replaces the context of the current thread for its lifetime and then puts the previous one back
+     *
+     * For whoever runs tasks or resumes coroutines on behalf of others, so that they neither see
+     * the context of the thread they run on nor leave theirs behind
+     */
+    class Adopt {
+        Context _previous;
+    public:
+        explicit Adopt(const Context& context) noexcept: _previous(_detail::current) {
+            _detail::current = context;
+        }
+
+        /** Adopts what capture() has returned: null is an empty context */
+        explicit Adopt(const Context* context) noexcept: _previous(_detail::current) {
+            if (context) {
+                _detail::current = *context;
+            } else {
+                _detail::current.truncate(0);
+            }
+        }
+
+        ~Adopt() {
+            _detail::current = _previous;
+        }
+
+        Adopt(const Adopt&) = delete;
+        Adopt& operator=(const Adopt&) = delete;
+    };
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+/**
+ * Reading back what setStandardLogFormat() in util/log.cc writes, without pulling in Boost.Log
+ *
+ * Each record starts with a header line
+ *     2025-01-31 12:34:56.123456 #ERROR [channel] message
+ * that is a timestamp, severity padded to 5 chars and the channel in square brackets
+ * Context attributes, if any, are written as "{key=value, key=value} " in front of the message
+ * and are kept a part of it
+ *
+ * Exceptions logged via util::log add more lines: stack frames "\t@ ...", nested exceptions "\tcaused by ..."
+ * and "--stacktrace-converges-with-this-thread--" markers, all of them indented with tabs
+ * A message may also contain line breaks of its own; so rather than looking for tabs we say that
+ * every line which doesn't look like a header continues the record above it
+ *
+ * RecordsView walks the records of a chunk of text already in memory; lines come from LinesSplitView
+ * so "\r\n" is handled the same way, and each record is a single string_view into the input spanning
+ * its header and all of its continuation lines
+ *
+ * If the text doesn't start with a header, e.g. it is a piece cut out of the middle of a file,
+ * the lines before the 1st header make up a record of their own which has no header
+ */
+
+#include <util/str_split.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string_view>
+
+namespace util::log::records {
+    /** Same as util::log::severity_level, UNKNOWN stands for anything else found in a header */
+    enum class Severity: std::uint8_t {
+        DEBUG, INFO, WARN, ERROR, UNKNOWN
+    };
+
+    constexpr std::size_t SEVERITY_COUNT = 5;
+
+    constexpr std::array<std::string_view, SEVERITY_COUNT> SEVERITY_NAMES{"DEBUG", "INFO", "WARN", "ERROR", "UKNWN"};
+
+    constexpr std::string_view name(Severity severity) {
+        return SEVERITY_NAMES[static_cast<std::size_t>(severity)];
+    }
+
+    /** Exact name as written to the log, e.g. "WARN"; "UKNWN" parses as UNKNOWN */
+    constexpr std::optional<Severity> parseSeverity(std::string_view name) {
+        for (std::size_t i = 0; i < SEVERITY_COUNT; ++i) {
+            if (SEVERITY_NAMES[i] == name) {
+                return static_cast<Severity>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    namespace _detail {
+        constexpr bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        constexpr int digits(std::string_view s, std::size_t pos, std::size_t count) {
+            int result = 0;
+            for (auto i = pos; i < pos + count; ++i) {
+                result = result * 10 + (s[i] - '0');
+            }
+            return result;
+        }
+    }
+
+    /** "YYYY-MM-DD HH:MM:SS." - the fractional part is 6 digits with Boost's microsecond clock but may be 1 to 9 */
+    constexpr std::size_t TIMESTAMP_PREFIX = 20;
+
+    /** Length of the timestamp at the start of 'line' or 0 if the line doesn't start with one */
+    constexpr std::size_t timestampLength(std::string_view line) {
+        if (line.size() <= TIMESTAMP_PREFIX) {
+            return 0;
+        }
+        constexpr std::string_view shape = "0000-00-00 00:00:00.";
+        for (std::size_t i = 0; i < TIMESTAMP_PREFIX; ++i) {
+            if (shape[i] == '0' ? !_detail::isDigit(line[i]) : line[i] != shape[i]) {
+                return 0;
+            }
+        }
+        auto end = TIMESTAMP_PREFIX;
+        while (end < line.size() && end < TIMESTAMP_PREFIX + 9 && _detail::isDigit(line[end])) {
+            ++end;
+        }
+        return end == TIMESTAMP_PREFIX ? 0 : end;
+    }
+
+    /** Does the line start a new record? Only the timestamp is looked at, that is what tells records apart */
+    constexpr bool isHeader(std::string_view line) {
+        return timestampLength(line) != 0;
+    }
+
+    /**
+     * Microseconds since 1970-01-01 00:00:00 of the timestamp at the start of 'text', taking it as UTC
+     * Logs are written in local time so this is only good for comparing timestamps with each other
+     * and with times given in the same local time; digits past microseconds are ignored
+     */
+    constexpr std::optional<std::int64_t> parseTimestamp(std::string_view text) {
+        using _detail::digits;
+        auto length = timestampLength(text);
+        if (length == 0) {
+            return std::nullopt;
+        }
+        std::chrono::year_month_day date{std::chrono::year{digits(text, 0, 4)},
+                std::chrono::month(digits(text, 5, 2)), std::chrono::day(digits(text, 8, 2))};
+        std::int64_t days = std::chrono::sys_days{date}.time_since_epoch().count();
+        std::int64_t seconds = days * 86400 + digits(text, 11, 2) * 3600 + digits(text, 14, 2) * 60
+                + digits(text, 17, 2);
+        std::int64_t micros = 0;
+        for (std::size_t i = 0; i < 6; ++i) {
+            micros = micros * 10 + (TIMESTAMP_PREFIX + i < length ? text[TIMESTAMP_PREFIX + i] - '0' : 0);
+        }
+        return seconds * 1'000'000 + micros;
+    }
+
+    struct Header {
+        std::string_view timestamp;
+        Severity severity;
+        std::string_view channel;
+
+        /** Rest of the header line, the record's continuation lines are not included */
+        std::string_view message;
+    };
+
+    /**
+     * Splits a header line into its parts; returns nullopt if it is not a header or doesn't follow the format
+     * An unrecognized severity name is returned as UNKNOWN
+     */
+    constexpr std::optional<Header> parseHeader(std::string_view line) {
+        auto length = timestampLength(line);
+        if (length == 0) {
+            return std::nullopt;
+        }
+        Header header{line.substr(0, length), Severity::UNKNOWN, {}, {}};
+
+        auto rest = line.substr(length);
+        if (!rest.starts_with(" #")) {
+            return std::nullopt;
+        }
+        rest.remove_prefix(2);
+        auto space = rest.find(' ');
+        if (space == std::string_view::npos) {
+            return std::nullopt;
+        }
+        header.severity = parseSeverity(rest.substr(0, space)).value_or(Severity::UNKNOWN);
+
+        /* names shorter than 5 chars are padded with spaces */
+        auto bracket = rest.find_first_not_of(' ', space);
+        if (bracket == std::string_view::npos || rest[bracket] != '[') {
+            return std::nullopt;
+        }
+        rest.remove_prefix(bracket + 1);
+
+        /* the message comes after "] ", channels are type names which may well contain ']' of their own */
+        auto close = rest.find("] ");
+        if (close == std::string_view::npos) {
+            if (!rest.ends_with(']')) {
+                return std::nullopt;
+            }
+            close = rest.size() - 1;
+        }
+        header.channel = rest.substr(0, close);
+        header.message = rest.substr(std::min(close + 2, rest.size()));
+        return header;
+    }
+
+    struct Record {
+        /** Header line and continuation lines; the line break after the last line is not included */
+        std::string_view text;
+
+        /** Header line, or just the 1st line for a record without a header */
+        std::string_view firstLine;
+
+        bool hasHeader;
+    };
+
+    /**
+     * Offset of the 1st line starting at or after 'from' which is a header or text.size() if there is none;
+     * this is where a chunk of a file should start so that no record is cut in two
+     */
+    inline std::size_t findRecordStart(std::string_view text, std::size_t from) {
+        if (from == 0 || from > text.size()) {
+            return std::min(from, text.size());
+        }
+        auto pos = from;
+        if (text[pos - 1] != '\n') {
+            auto found = std::memchr(text.data() + pos, '\n', text.size() - pos);
+            if (!found) {
+                return text.size();
+            }
+            pos = static_cast<const char*>(found) - text.data() + 1;
+        }
+        for (;;) {
+            if (isHeader(text.substr(pos))) {
+                return pos;
+            }
+            auto found = std::memchr(text.data() + pos, '\n', text.size() - pos);
+            if (!found) {
+                return text.size();
+            }
+            pos = static_cast<const char*>(found) - text.data() + 1;
+        }
+    }
+
+    /** Forward view over the records of a chunk of text; records are string_views into the text */
+    class RecordsView: public std::ranges::view_interface<RecordsView> {
+        using Lines = str_split::LinesSplitView<std::string_view>;
+
+        std::string_view _text;
+    public:
+        class Iterator {
+            std::ranges::iterator_t<const Lines> _line;
+            std::ranges::sentinel_t<const Lines> _end;
+            Record _record{};
+            bool _done = true;
+
+            void load() {
+                _done = _line == _end;
+                if (_done) {
+                    return;
+                }
+                auto first = *_line;
+                auto last = first;
+                while (++_line != _end && !isHeader(*_line)) {
+                    last = *_line;
+                }
+                _record = Record{std::string_view(first.data(), last.data() + last.size()), first, isHeader(first)};
+            }
+        public:
+            using value_type = Record;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(const Lines& lines): _line(lines.begin()), _end(lines.end()) {
+                load();
+            }
+
+            const Record& operator*() const {
+                return _record;
+            }
+
+            const Record* operator->() const {
+                return &_record;
+            }
+
+            Iterator& operator++() {
+                load();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const Iterator& other) const {
+                return _done == other._done && (_done || _record.text.data() == other._record.text.data());
+            }
+
+            bool operator==(std::default_sentinel_t) const {
+                return _done;
+            }
+        };
+
+        constexpr RecordsView() = default;
+        constexpr explicit RecordsView(std::string_view text): _text(text) {}
+
+        Iterator begin() const {
+            return Iterator{Lines{_text}};
+        }
+
+        std::default_sentinel_t end() const {
+            return std::default_sentinel;
+        }
+    };
+
+    static_assert(std::forward_iterator<RecordsView::Iterator>);
+    static_assert(std::ranges::forward_range<RecordsView>);
+}
@@ -0,0 +1,268 @@
+#include <util/log_columns.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace util::log_columns {
+    namespace records = log::records;
+
+    ChannelId Channels::intern(std::string_view name) {
+        if (auto found = _ids.find(name); found != _ids.end()) {
+            return found->second;
+        }
+        auto id = static_cast<ChannelId>(_names.size());
+        _ids.emplace(_names.emplace_back(name), id);
+        return id;
+    }
+
+    std::optional<ChannelId> Channels::find(std::string_view name) const {
+        if (auto found = _ids.find(name); found != _ids.end()) {
+            return found->second;
+        }
+        return std::nullopt;
+    }
+
+    std::size_t RecordStore::append(std::string_view text) {
+        std::size_t added = 0;
+        std::optional<ChannelId> lastChannel;
+        for (auto& record: records::RecordsView{text}) {
+            if (!record.hasHeader) {
+                continue;
+            }
+            auto header = records::parseHeader(record.firstLine);
+            if (!header) {
+                continue;
+            }
+
+            /* channels mostly repeat, the last one saves us hashing the name */
+            if (!lastChannel || _channelNames.name(*lastChannel) != header->channel) {
+                lastChannel = _channelNames.intern(header->channel);
+            }
+            _timestamps.push_back(*records::parseTimestamp(header->timestamp));
+            _severities.push_back(static_cast<std::uint8_t>(header->severity));
+            _channels.push_back(*lastChannel);
+
+            auto messageEnd = record.text.data() + record.text.size();
+            _arena.append(header->message.data(), messageEnd);
+            _messageOffsets.push_back(_arena.size());
+            ++added;
+        }
+        return added;
+    }
+
+    void RecordStore::push(std::int64_t timestamp, Severity severity, std::string_view channel,
+            std::string_view message) {
+        _timestamps.push_back(timestamp);
+        _severities.push_back(static_cast<std::uint8_t>(severity));
+        _channels.push_back(_channelNames.intern(channel));
+        _arena.append(message);
+        _messageOffsets.push_back(_arena.size());
+    }
+
+    void RecordStore::reserve(std::size_t records, std::size_t messageBytes) {
+        _timestamps.reserve(size() + records);
+        _severities.reserve(size() + records);
+        _channels.reserve(size() + records);
+        _messageOffsets.reserve(_messageOffsets.size() + records);
+        _arena.reserve(_arena.size() + messageBytes);
+    }
+
+    void selectTime(std::span<const std::int64_t> timestamps, std::int64_t since, std::int64_t until,
+            std::span<std::uint8_t> mask) {
+        if (since >= until) {
+            std::ranges::fill(mask, 0);
+            return;
+        }
+        /* a single unsigned compare does for both ends; the subtractions wrap around without being UB */
+        auto base = static_cast<std::uint64_t>(since);
+        auto width = static_cast<std::uint64_t>(until) - base;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        /*
+         * SSE2 has no 64-bit compares: x < width is taken from the 32-bit halves, unsigned by flipping sign bits,
+         * as high(x) < high(width) || (high(x) == high(width) && low(x) < low(width))
+         */
+        auto flip = _mm_set1_epi32(INT32_MIN);
+        auto baseVector = _mm_set1_epi64x(static_cast<long long>(base));
+        auto widthFlipped = _mm_xor_si128(_mm_set1_epi64x(static_cast<long long>(width)), flip);
+        auto below = [&](std::size_t at) {
+            auto x = _mm_sub_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(timestamps.data() + at)),
+                    baseVector);
+            x = _mm_xor_si128(x, flip);
+            auto less = _mm_cmpgt_epi32(widthFlipped, x);
+            auto equal = _mm_cmpeq_epi32(widthFlipped, x);
+            auto high = _mm_or_si128(less, _mm_and_si128(equal, _mm_slli_epi64(less, 32)));
+            return _mm_castsi128_ps(high);
+        };
+        /* the high halves of 2 x 2 results make 4 ints of 0 or -1 */
+        auto four = [&](std::size_t at) {
+            return _mm_castps_si128(_mm_shuffle_ps(below(at), below(at + 2), _MM_SHUFFLE(3, 1, 3, 1)));
+        };
+        for (; i + 16 <= timestamps.size(); i += 16) {
+            auto low = _mm_packs_epi32(four(i), four(i + 4));
+            auto high = _mm_packs_epi32(four(i + 8), four(i + 12));
+            auto hit = _mm_packs_epi16(low, high);
+            auto target = reinterpret_cast<__m128i*>(mask.data() + i);
+            _mm_storeu_si128(target, _mm_and_si128(_mm_loadu_si128(target), hit));
+        }
+#endif
+        for (; i < timestamps.size(); ++i) {
+            mask[i] &= static_cast<std::uint8_t>(static_cast<std::uint64_t>(timestamps[i]) - base < width);
+        }
+    }
+
+    void selectSeverities(std::span<const std::uint8_t> severities, Severities wanted, std::span<std::uint8_t> mask) {
+        auto bits = wanted.to_ulong();
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        __m128i values[SEVERITY_COUNT];
+        std::size_t valueCount = 0;
+        for (std::size_t k = 0; k < SEVERITY_COUNT; ++k) {
+            if (wanted[k]) {
+                values[valueCount++] = _mm_set1_epi8(static_cast<char>(k));
+            }
+        }
+        for (; i + 16 <= severities.size(); i += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(severities.data() + i));
+            auto hit = _mm_setzero_si128();
+            for (std::size_t k = 0; k < valueCount; ++k) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, values[k]));
+            }
+            auto target = reinterpret_cast<__m128i*>(mask.data() + i);
+            _mm_storeu_si128(target, _mm_and_si128(_mm_loadu_si128(target), hit));
+        }
+#endif
+        for (; i < severities.size(); ++i) {
+            mask[i] &= static_cast<std::uint8_t>(bits >> severities[i] & 1);
+        }
+    }
+
+    void selectChannel(std::span<const ChannelId> channels, ChannelId channel, std::span<std::uint8_t> mask) {
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        auto value = _mm_set1_epi32(static_cast<int>(channel));
+        auto compare = [&](std::size_t at) {
+            return _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(channels.data() + at)), value);
+        };
+        for (; i + 16 <= channels.size(); i += 16) {
+            /* 0 and -1 survive saturation, so 4 x 4 ints pack into 16 bytes of 0 or 0xff */
+            auto low = _mm_packs_epi32(compare(i), compare(i + 4));
+            auto high = _mm_packs_epi32(compare(i + 8), compare(i + 12));
+            auto hit = _mm_packs_epi16(low, high);
+            auto target = reinterpret_cast<__m128i*>(mask.data() + i);
+            _mm_storeu_si128(target, _mm_and_si128(_mm_loadu_si128(target), hit));
+        }
+#endif
+        for (; i < channels.size(); ++i) {
+            mask[i] &= static_cast<std::uint8_t>(channels[i] == channel);
+        }
+    }
+
+    std::size_t count(std::span<const std::uint8_t> mask) {
+        std::size_t result = 0;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        /* psadbw against zero sums 8 bytes at a time into 64-bit lanes which never overflow */
+        auto sums = _mm_setzero_si128();
+        for (; i + 16 <= mask.size(); i += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data() + i));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(block, _mm_setzero_si128()));
+        }
+        result = static_cast<std::size_t>(_mm_cvtsi128_si64(sums))
+                + static_cast<std::size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+        for (; i < mask.size(); ++i) {
+            result += mask[i];
+        }
+        return result;
+    }
+
+    void countBySeverity(std::span<const std::uint8_t> severities, std::span<const std::uint8_t> mask,
+            std::span<std::size_t, SEVERITY_COUNT> counts) {
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        /* few severities: a compare and a psadbw each per 16 records beats scattered increments */
+        __m128i sums[SEVERITY_COUNT];
+        std::ranges::fill(sums, _mm_setzero_si128());
+        for (; i + 16 <= severities.size(); i += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(severities.data() + i));
+            auto selected = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data() + i));
+            for (std::size_t k = 0; k < SEVERITY_COUNT; ++k) {
+                auto hit = _mm_and_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(k))), selected);
+                sums[k] = _mm_add_epi64(sums[k], _mm_sad_epu8(hit, _mm_setzero_si128()));
+            }
+        }
+        for (std::size_t k = 0; k < SEVERITY_COUNT; ++k) {
+            counts[k] += static_cast<std::size_t>(_mm_cvtsi128_si64(sums[k]))
+                    + static_cast<std::size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums[k], sums[k])));
+        }
+#endif
+        for (; i < severities.size(); ++i) {
+            counts[severities[i]] += mask[i];
+        }
+    }
+
+    void countByChannel(std::span<const ChannelId> channels, std::span<const std::uint8_t> mask,
+            std::span<std::size_t> counts) {
+        /*
+         * Runs of the same channel would make each increment wait for the previous one to the same counter;
+         * 4 sets of counters taking turns keep 4 increments in flight
+         */
+        constexpr std::size_t WAYS = 4;
+        auto channelCount = counts.size();
+        std::vector<std::size_t> partial(WAYS * channelCount);
+        std::size_t i = 0;
+        for (; i + WAYS <= channels.size(); i += WAYS) {
+            for (std::size_t way = 0; way < WAYS; ++way) {
+                partial[way * channelCount + channels[i + way]] += mask[i + way];
+            }
+        }
+        for (; i < channels.size(); ++i) {
+            partial[channels[i]] += mask[i];
+        }
+        for (std::size_t way = 0; way < WAYS; ++way) {
+            for (std::size_t channel = 0; channel < channelCount; ++channel) {
+                counts[channel] += partial[way * channelCount + channel];
+            }
+        }
+    }
+
+    void countByInterval(std::span<const std::int64_t> timestamps, std::span<const std::uint8_t> mask,
+            std::int64_t origin, std::int64_t width, std::span<std::size_t> counts) {
+        if (counts.empty() || width <= 0) {
+            return;
+        }
+        auto uwidth = static_cast<std::uint64_t>(width);
+        auto span = uwidth * counts.size();
+
+        /*
+         * Dividing by 'width' per record would cost more than everything else here put together
+         * Logs are mostly in time order so we remember the interval of the last record
+         * and only divide when a record falls outside of it; the records of the current interval
+         * are added up in a register as incrementing counts[] each time would wait for the previous store
+         */
+        std::size_t current = 0;
+        std::size_t run = 0;
+        auto currentStart = static_cast<std::uint64_t>(origin);
+        for (std::size_t i = 0; i < timestamps.size(); ++i) {
+            auto fromStart = static_cast<std::uint64_t>(timestamps[i]) - currentStart;
+            if (fromStart >= uwidth) [[unlikely]] {
+                auto fromOrigin = static_cast<std::uint64_t>(timestamps[i]) - static_cast<std::uint64_t>(origin);
+                if (timestamps[i] < origin || fromOrigin >= span) {
+                    continue;
+                }
+                counts[current] += run;
+                current = fromOrigin / uwidth;
+                currentStart = static_cast<std::uint64_t>(origin) + current * uwidth;
+                run = 0;
+            }
+            run += mask[i];
+        }
+        counts[current] += run;
+    }
+}
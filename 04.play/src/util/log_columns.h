@@ -0,0 +1,144 @@
+#pragma once
+
+/**
+ * Column-oriented store of log records for analysing logs in-process
+ *
+ * A std::vector of structs holding strings drags every message through the cache when all we want
+ * is, say, the number of ERRORs per channel per minute; here each field lives in an array of its own
+ * - timestamps: int64 microseconds as returned by log::records::parseTimestamp()
+ * - severities: a byte per record, log::records::Severity
+ * - channels: ids interned by Channels, 0, 1, 2... in the order channels are first seen
+ * - messages: offsets into a single contiguous arena holding all messages back to back
+ *
+ * so a kernel looking at timestamps reads 8 bytes per record and nothing else
+ *
+ * RecordStore::append() fills the columns straight from text: records come from log::records::RecordsView
+ * which is LinesSplitView underneath; a message is the rest of the header line plus the continuation lines
+ * Records without a header, e.g. the tail of a record cut off at the start of a chunk, are skipped
+ *
+ * Kernels work on spans of the columns and a Mask - a byte per record, 1 if selected:
+ * select...() functions AND their condition into the mask and count...() functions add to the counts given,
+ * so a big store can be cut into pieces processed on separate threads and the counts simply added up;
+ * running all kernels of a query over one piece of some 16K records before going to the next one
+ * reads each column from memory once
+ * Selection is branch-free and compares 16 records at a time with SSE2 where the compiler won't do it on its own
+ */
+
+#include <util/log/records.h>
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace util::log_columns {
+    using log::records::Severity;
+    using log::records::SEVERITY_COUNT;
+
+    /** Bit per Severity */
+    using Severities = std::bitset<SEVERITY_COUNT>;
+
+    using ChannelId = std::uint32_t;
+
+    /** Byte per record, 1 if selected and 0 if not */
+    using Mask = std::vector<std::uint8_t>;
+
+    /** Interns channel names; ids are dense so they can index arrays of counts */
+    class Channels {
+        /* deque so that string_views into the names stay valid as we add more */
+        std::deque<std::string> _names;
+        std::unordered_map<std::string_view, ChannelId> _ids;
+    public:
+        ChannelId intern(std::string_view name);
+
+        std::optional<ChannelId> find(std::string_view name) const;
+
+        std::string_view name(ChannelId id) const {
+            return _names[id];
+        }
+
+        std::size_t size() const noexcept {
+            return _names.size();
+        }
+    };
+
+    class RecordStore {
+        std::vector<std::int64_t> _timestamps;
+        std::vector<std::uint8_t> _severities;
+        std::vector<ChannelId> _channels;
+
+        /* message i is _arena[_messageOffsets[i], _messageOffsets[i + 1]) */
+        std::vector<std::uint64_t> _messageOffsets{0};
+        std::string _arena;
+
+        Channels _channelNames;
+    public:
+        /** Adds the records of 'text' which have headers, returns how many were added */
+        std::size_t append(std::string_view text);
+
+        void push(std::int64_t timestamp, Severity severity, std::string_view channel, std::string_view message);
+
+        /** For 'records' more records with 'messageBytes' more bytes of messages */
+        void reserve(std::size_t records, std::size_t messageBytes);
+
+        std::size_t size() const noexcept {
+            return _timestamps.size();
+        }
+
+        std::span<const std::int64_t> timestamps() const noexcept {
+            return _timestamps;
+        }
+
+        std::span<const std::uint8_t> severities() const noexcept {
+            return _severities;
+        }
+
+        std::span<const ChannelId> channels() const noexcept {
+            return _channels;
+        }
+
+        std::string_view message(std::size_t i) const {
+            return std::string_view(_arena).substr(_messageOffsets[i], _messageOffsets[i + 1] - _messageOffsets[i]);
+        }
+
+        const Channels& channelNames() const noexcept {
+            return _channelNames;
+        }
+
+        /** All records selected */
+        Mask selectAll() const {
+            return Mask(size(), 1);
+        }
+    };
+
+    /** Keeps records with since <= timestamp < until */
+    void selectTime(std::span<const std::int64_t> timestamps, std::int64_t since, std::int64_t until,
+            std::span<std::uint8_t> mask);
+
+    void selectSeverities(std::span<const std::uint8_t> severities, Severities wanted, std::span<std::uint8_t> mask);
+
+    void selectChannel(std::span<const ChannelId> channels, ChannelId channel, std::span<std::uint8_t> mask);
+
+    std::size_t count(std::span<const std::uint8_t> mask);
+
+    /** counts[severity] += number of selected records of that severity */
+    void countBySeverity(std::span<const std::uint8_t> severities, std::span<const std::uint8_t> mask,
+            std::span<std::size_t, SEVERITY_COUNT> counts);
+
+    /** counts[channel] += number of selected records of that channel; counts must have a slot for every channel */
+    void countByChannel(std::span<const ChannelId> channels, std::span<const std::uint8_t> mask,
+            std::span<std::size_t> counts);
+
+    /**
+     * Histogram over time: counts[k] += number of selected records with origin + k * width <= timestamp
+     * < origin + (k + 1) * width; records outside of [origin, origin + counts.size() * width) are not counted
+     */
+    void countByInterval(std::span<const std::int64_t> timestamps, std::span<const std::uint8_t> mask,
+            std::int64_t origin, std::int64_t width, std::span<std::size_t> counts);
+}
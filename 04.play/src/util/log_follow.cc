@@ -0,0 +1,198 @@
+#include <util/log_follow.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace util::log_follow {
+    namespace {
+        [[noreturn]] void fail(const std::filesystem::path& path, const char* what) {
+            throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path.string());
+        }
+
+        constexpr std::uint32_t FILE_EVENTS = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+
+        /* a new file under the name shows up as one of these in the directory */
+        constexpr std::uint32_t DIRECTORY_EVENTS = IN_CREATE | IN_MOVED_TO;
+
+        constexpr std::size_t BUFFER_SIZE = 1 << 16;
+    }
+
+    Follower::Follower(std::filesystem::path path, Options options): _path(std::move(path)), _buffer(BUFFER_SIZE) {
+        _inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_inotify < 0) {
+            fail(_path, "Cannot create inotify instance for");
+        }
+        _wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeup < 0) {
+            auto error = errno;
+            ::close(_inotify);
+            errno = error;
+            fail(_path, "Cannot create eventfd for");
+        }
+
+        auto directory = _path.parent_path().empty() ? std::filesystem::path{"."} : _path.parent_path();
+        if (::inotify_add_watch(_inotify, directory.c_str(), DIRECTORY_EVENTS) < 0) {
+            auto error = errno;
+            ::close(_inotify);
+            ::close(_wakeup);
+            errno = error;
+            fail(directory, "Cannot watch");
+        }
+
+        try {
+            open(!options.fromStart);
+        } catch (...) {
+            ::close(_inotify);
+            ::close(_wakeup);
+            throw;
+        }
+    }
+
+    Follower::~Follower() {
+        close();
+        ::close(_wakeup);
+        ::close(_inotify);
+    }
+
+    bool Follower::open(bool fromEnd) {
+        int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return false;
+            }
+            fail(_path, "Cannot open");
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(_path, "Cannot stat");
+        }
+
+        /*
+         * If the name gets another file between open() and here we watch the wrong one;
+         * switchIfRotated() then sees the inodes differ and opens the name again
+         * Same if the name is gone by now: the directory watch tells us when it's back
+         * Any other failure, e.g. ENOSPC once the limit of watches is reached, would leave run() blind to appends
+         */
+        _fileWatch = ::inotify_add_watch(_inotify, _path.c_str(), FILE_EVENTS);
+        if (_fileWatch < 0 && errno != ENOENT) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(_path, "Cannot watch");
+        }
+        _file = fd;
+        _device = st.st_dev;
+        _inode = st.st_ino;
+        _offset = fromEnd ? st.st_size : 0;
+        return true;
+    }
+
+    void Follower::close() noexcept {
+        if (_file >= 0) {
+            /* fails harmlessly if the file is gone and the kernel has dropped the watch already */
+            ::inotify_rm_watch(_inotify, _fileWatch);
+            ::close(_file);
+            _file = -1;
+        }
+    }
+
+    void Follower::readAppended(const std::function<void(std::string_view)>& onLine,
+            const std::function<void(Change)>& onChange) {
+        struct stat st;
+        if (::fstat(_file, &st) != 0) {
+            fail(_path, "Cannot stat");
+        }
+        if (st.st_size < _offset) {
+            _lines.finish(onLine);
+            if (onChange) {
+                onChange(Change::TRUNCATED);
+            }
+            _offset = 0;
+        }
+
+        for (;;) {
+            auto read = ::pread(_file, _buffer.data(), _buffer.size(), _offset);
+            if (read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(_path, "Cannot read");
+            }
+            if (read == 0) {
+                return;
+            }
+            _offset += read;
+            _lines.feed(std::string_view(_buffer.data(), static_cast<std::size_t>(read)), onLine);
+        }
+    }
+
+    bool Follower::switchIfRotated(const std::function<void(std::string_view)>& onLine,
+            const std::function<void(Change)>& onChange) {
+        struct stat st;
+        if (::stat(_path.c_str(), &st) != 0) {
+            if (errno == ENOENT) {
+                /* renamed or deleted and no new file yet: the writer may still be appending to the old one */
+                return false;
+            }
+            fail(_path, "Cannot stat");
+        }
+        if (st.st_dev == _device && st.st_ino == _inode) {
+            return false;
+        }
+
+        readAppended(onLine, onChange);
+        _lines.finish(onLine);
+        close();
+        if (onChange) {
+            onChange(Change::ROTATED);
+        }
+        open(false);
+        return true;
+    }
+
+    void Follower::run(std::stop_token stopToken, const std::function<void(std::string_view)>& onLine,
+            const std::function<void(Change)>& onChange) {
+        std::stop_callback wake{stopToken, [this] {
+            std::uint64_t one = 1;
+            /* can only fail if the counter is about to overflow, which wakes us up just as well */
+            [[maybe_unused]] auto written = ::write(_wakeup, &one, sizeof(one));
+        }};
+
+        alignas(inotify_event) char events[4096];
+        while (!stopToken.stop_requested()) {
+            if (_file < 0 && open(false)) {
+                continue;
+            }
+            if (_file >= 0) {
+                readAppended(onLine, onChange);
+                if (switchIfRotated(onLine, onChange)) {
+                    continue;
+                }
+            }
+
+            pollfd fds[2] = {{_inotify, POLLIN, 0}, {_wakeup, POLLIN, 0}};
+            if (::poll(fds, 2, -1) < 0 && errno != EINTR) {
+                fail(_path, "Cannot poll inotify for");
+            }
+            /* which events came doesn't matter, we check the file itself; just empty the queue */
+            while (::read(_inotify, events, sizeof(events)) > 0) {
+            }
+        }
+
+        std::uint64_t count;
+        [[maybe_unused]] auto read = ::read(_wakeup, &count, sizeof(count));
+    }
+}
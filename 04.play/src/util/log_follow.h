@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * tail -F for our tools: delivers lines appended to a log file as soon as they are written
+ *
+ * We block in poll() on an inotify descriptor, so there's no polling interval to wait out: the kernel wakes us
+ * on every write and we pread() just the bytes past what we've already read; a write is typically delivered
+ * within tens of microseconds
+ *
+ * Lines come out of str_split::incremental::IncrementalLines so a line the writer hasn't finished yet,
+ * or a "\r\n" cut between two writes, is held back until it is complete
+ *
+ * What file sinks do to their files is detected as well
+ * - truncation: the file got shorter than what we've read, we start over from its beginning
+ * - rotation: the name now refers to another file, we read what was left in the old one and go on with the new one
+ *   from its beginning; while the name refers to no file at all we keep reading the old one as the writer
+ *   may not have switched over yet
+ * The last line of the old content is delivered even if it has no line break, then onChange() is called
+ *
+ * The file doesn't have to exist when we start, we pick it up from its beginning once it is created
+ */
+
+#include <util/str_split/incremental.h>
+
+#include <filesystem>
+#include <functional>
+#include <stop_token>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace util::log_follow {
+    enum class Change {
+        TRUNCATED, ROTATED
+    };
+
+    struct Options {
+        /** Start with what is already in the file, rather than at its end as tail -f does */
+        bool fromStart = false;
+    };
+
+    class Follower {
+        std::filesystem::path _path;
+
+        int _inotify = -1;
+        int _wakeup = -1;
+
+        int _file = -1;
+        int _fileWatch = -1;
+        dev_t _device = 0;
+        ino_t _inode = 0;
+        off_t _offset = 0;
+
+        str_split::incremental::IncrementalLines _lines;
+        std::vector<char> _buffer;
+
+        bool open(bool fromEnd);
+        void close() noexcept;
+        void readAppended(const std::function<void(std::string_view)>& onLine,
+                const std::function<void(Change)>& onChange);
+        bool switchIfRotated(const std::function<void(std::string_view)>& onLine,
+                const std::function<void(Change)>& onChange);
+    public:
+        /** Throws std::system_error if inotify is not available or 'path' or its directory can't be watched */
+        explicit Follower(std::filesystem::path path, Options options = {});
+        ~Follower();
+
+        Follower(const Follower&) = delete;
+        Follower& operator=(const Follower&) = delete;
+
+        /**
+         * Calls onLine() with each line appended to the file until 'stopToken' is stopped, on the calling thread;
+         * a stop request wakes us right away. May be called again after it returns, to go on from where it was
+         */
+        void run(std::stop_token stopToken, const std::function<void(std::string_view)>& onLine,
+                const std::function<void(Change)>& onChange = {});
+    };
+}
@@ -0,0 +1,223 @@
+#include <util/log_grep.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/core.h>
+
+namespace util::log_grep {
+    namespace records = log::records;
+
+    namespace {
+        constexpr auto UNKNOWN = static_cast<std::size_t>(Severity::UNKNOWN);
+
+        /** Where the line holding text[pos] starts */
+        std::size_t lineStart(std::string_view text, std::size_t pos) {
+            auto newline = text.substr(0, pos).rfind('\n');
+            return newline == std::string_view::npos ? 0 : newline + 1;
+        }
+
+        /** Start of the record holding text[pos]: the closest header line at or before it, or the start of the text */
+        std::size_t recordStart(std::string_view text, std::size_t pos) {
+            for (auto start = lineStart(text, pos); start != 0; start = lineStart(text, start - 1)) {
+                if (records::isHeader(text.substr(start))) {
+                    return start;
+                }
+            }
+            return 0;
+        }
+
+        /** Drops the line break after the last line of a record the same way LinesSplitView would */
+        std::string_view trimLineBreak(std::string_view record) {
+            if (record.ends_with('\n')) {
+                record.remove_suffix(1);
+            }
+            if (record.ends_with('\r')) {
+                record.remove_suffix(1);
+            }
+            return record;
+        }
+
+        std::size_t append(const records::Record& record, std::string& out) {
+            out.append(record.text);
+            out.push_back('\n');
+            return 1;
+        }
+    }
+
+    Severities parseSeverities(std::string_view list) {
+        auto parse = [](std::string_view name) {
+            if (auto severity = records::parseSeverity(name)) {
+                return static_cast<std::size_t>(*severity);
+            }
+            throw std::invalid_argument(fmt::format("Unknown severity '{}'", name));
+        };
+
+        Severities result;
+        while (!list.empty()) {
+            auto comma = list.find(',');
+            auto item = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+            if (item.ends_with('+')) {
+                item.remove_suffix(1);
+                for (auto i = parse(item); i < records::SEVERITY_COUNT; ++i) {
+                    result.set(i);
+                }
+            } else {
+                result.set(parse(item));
+            }
+        }
+        return result;
+    }
+
+    std::int64_t parseTime(std::string_view text) {
+        constexpr std::string_view midnight = "0000-00-00 00:00:00.0";
+        std::string full{text};
+        if (full.size() < midnight.size() && full.size() >= 10) {
+            /* "2025-01-31 12:00" is completed with ":00.0" */
+            full += midnight.substr(full.size());
+        }
+        if (auto time = records::parseTimestamp(full); time && records::timestampLength(full) == full.size()) {
+            return *time;
+        }
+        throw std::invalid_argument(fmt::format("Cannot parse time '{}'", text));
+    }
+
+    Matcher::Matcher(Filter filter): _filter(std::move(filter)), _filtersHeaders(_filter.filtersHeaders()) {
+        if (_filter.substrings.size() == 1) {
+            _searcher.emplace(_filter.substrings.front());
+        } else if (!_filter.substrings.empty()) {
+            _multiSearcher.emplace(std::span<const std::string>(_filter.substrings));
+        } else if (_filter.severities.count() == 1 && !_filter.severities.test(UNKNOWN)) {
+            auto severity = records::name(static_cast<Severity>(std::countr_zero(_filter.severities.to_ulong())));
+            /* severity is padded to 5 chars, see setStandardLogFormat() */
+            _anchor.emplace(fmt::format("#{:<5} [", severity));
+        } else if (_filter.channels.size() == 1) {
+            _anchor.emplace(fmt::format(" [{}] ", _filter.channels.front()));
+        }
+    }
+
+    bool Matcher::matchesHeader(std::string_view line) const {
+        auto header = records::parseHeader(line);
+        if (!header) {
+            return false;
+        }
+        if (!_filter.severities.test(static_cast<std::size_t>(header->severity))) {
+            return false;
+        }
+        auto& channels = _filter.channels;
+        if (!channels.empty() && std::ranges::find(channels, header->channel) == channels.end()) {
+            return false;
+        }
+        if (_filter.since || _filter.until) {
+            /* parseHeader() has checked the timestamp already */
+            auto time = *records::parseTimestamp(header->timestamp);
+            if ((_filter.since && time < *_filter.since) || (_filter.until && time >= *_filter.until)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Matcher::matches(const records::Record& record) const {
+        if (_filtersHeaders && (!record.hasHeader || !matchesHeader(record.firstLine))) {
+            return false;
+        }
+        return findSubstring(record.text, 0) != text::npos;
+    }
+
+    std::size_t Matcher::findSubstring(std::string_view text, std::size_t from) const {
+        if (_searcher) {
+            return _searcher->find(text, from);
+        }
+        if (_multiSearcher) {
+            auto match = _multiSearcher->find(text, from);
+            return match ? match->position : text::npos;
+        }
+        return from;
+    }
+
+    std::size_t grepChunk(std::string_view text, const Matcher& matcher, std::string& out) {
+        std::size_t count = 0;
+        if (!matcher.jumps()) {
+            for (auto& record: records::RecordsView{text}) {
+                if (matcher.matches(record)) {
+                    count += append(record, out);
+                }
+            }
+            return count;
+        }
+
+        /* jump from hit to hit and only look for record boundaries around them */
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            auto hit = matcher.findCandidate(text, pos);
+            if (hit == text::npos) {
+                break;
+            }
+            auto start = recordStart(text, hit);
+            auto end = records::findRecordStart(text, hit + 1);
+            auto firstLine = text.substr(start, text.find('\n', start) - start);
+            if (firstLine.ends_with('\r')) {
+                firstLine.remove_suffix(1);
+            }
+            records::Record record{trimLineBreak(text.substr(start, end - start)), firstLine,
+                    records::isHeader(firstLine)};
+            /* a hit spanning two records doesn't count, matches() looks for one inside the record */
+            if (matcher.matches(record)) {
+                count += append(record, out);
+            }
+            pos = end;
+        }
+        return count;
+    }
+
+    std::size_t grep(pool::Pool& pool, std::string_view text, const Matcher& matcher,
+            const std::function<void(std::string_view)>& write, std::size_t chunkSize) {
+        struct Output {
+            std::string text;
+            std::size_t count = 0;
+        };
+
+        /* enough chunks for every thread to have the next one ready while we are writing out the current one */
+        auto window = 2 * (pool.size() + 1);
+        std::deque<pool::Future<Output>> inFlight;
+        std::size_t begin = 0;
+        std::size_t total = 0;
+
+        try {
+            while (begin < text.size() || !inFlight.empty()) {
+                while (begin < text.size() && inFlight.size() < window) {
+                    auto end = records::findRecordStart(text, begin + std::max<std::size_t>(chunkSize, 1));
+                    inFlight.push_back(pool.submit([chunk = text.substr(begin, end - begin), &matcher] {
+                        Output output;
+                        output.count = grepChunk(chunk, matcher, output.text);
+                        return output;
+                    }));
+                    begin = end;
+                }
+
+                auto output = inFlight.front().get();
+                inFlight.pop_front();
+                total += output.count;
+                write(output.text);
+            }
+        } catch (...) {
+            /* the chunks refer to 'matcher' and 'text' so they have to be done before we leave */
+            for (auto& future: inFlight) {
+                try {
+                    future.wait();
+                } catch (...) {
+                }
+            }
+            throw;
+        }
+        return total;
+    }
+}
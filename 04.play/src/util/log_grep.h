@@ -0,0 +1,124 @@
+#pragma once
+
+/**
+ * Finding records in logs written by util::log - the library part of the log-grep tool
+ *
+ * A record is its header line together with its continuation lines, see util/log/records.h,
+ * so a matching exception comes out with its whole stack trace and its "caused by" chain
+ *
+ * Filter says what we are looking for: severities, channels, a time range and substrings;
+ * a record has to pass all of the criteria which are set, and for substrings it is enough to contain any one of them
+ * Substrings are looked for in the whole record, continuation lines included
+ *
+ * grep() cuts the text into chunks of a few MB at record boundaries and greps them on a util::pool::Pool;
+ * results are handed out strictly in the order of the input while later chunks are still being worked on,
+ * and only a bounded number of chunks is in flight so memory use doesn't grow with the size of the input
+ *
+ * When there are substrings to look for we don't split the text into lines at all: the searcher runs
+ * over the whole chunk and we only find the boundaries of the records around the hits
+ * That's what lets us keep up with the disk when the hits are rare; the same is done for a single severity
+ * or a single channel by looking for "#ERROR [" or " [channel] ", otherwise records are walked with RecordsView
+ */
+
+#include <util/log/records.h>
+#include <util/pool.h>
+#include <util/text.h>
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::log_grep {
+    using Severity = log::records::Severity;
+    using Severities = std::bitset<log::records::SEVERITY_COUNT>;
+
+    struct Filter {
+        /** Bit per Severity, all of them by default */
+        Severities severities = Severities{}.set();
+
+        /** Exact channel names, any of them will do; empty means any channel */
+        std::vector<std::string> channels;
+
+        /** Microseconds as returned by log::records::parseTimestamp(), 'since' is inclusive and 'until' is not */
+        std::optional<std::int64_t> since;
+        std::optional<std::int64_t> until;
+
+        /** Any of them will do; empty means any record */
+        std::vector<std::string> substrings;
+
+        /** Does it look at headers at all? Records without a header only pass filters which don't */
+        bool filtersHeaders() const {
+            return !severities.all() || !channels.empty() || since || until;
+        }
+    };
+
+    /** "WARN,ERROR" or "WARN+" for WARN and above, as taken by log-grep; throws std::invalid_argument */
+    Severities parseSeverities(std::string_view list);
+
+    /**
+     * Time as in the log, e.g. "2025-01-31 12:00:00.5", or a prefix of it down to the date alone,
+     * in the microseconds of log::records::parseTimestamp(); throws std::invalid_argument
+     */
+    std::int64_t parseTime(std::string_view text);
+
+    class Matcher {
+        Filter _filter;
+        bool _filtersHeaders;
+
+        /* Searcher is faster than MultiSearcher for a single substring */
+        std::optional<text::Searcher> _searcher;
+        std::optional<text::MultiSearcher> _multiSearcher;
+
+        /* when there are no substrings: a piece of the header every matching record has */
+        std::optional<text::Searcher> _anchor;
+
+        bool matchesHeader(std::string_view line) const;
+    public:
+        explicit Matcher(Filter filter);
+
+        const Filter& filter() const noexcept {
+            return _filter;
+        }
+
+        bool matches(const log::records::Record& record) const;
+
+        /** Offset of the 1st hit of any of the substrings at or after 'from' or npos; 'from' if there are none */
+        std::size_t findSubstring(std::string_view text, std::size_t from) const;
+
+        /** Can matching records be found by looking for candidates rather than by walking all of the records? */
+        bool jumps() const noexcept {
+            return _searcher || _multiSearcher || _anchor;
+        }
+
+        /**
+         * Offset of the 1st place at or after 'from' which may belong to a matching record, npos if there is none
+         * Only for when jumps(); the record around it still has to be checked with matches()
+         */
+        std::size_t findCandidate(std::string_view text, std::size_t from) const {
+            return _anchor ? _anchor->find(text, from) : findSubstring(text, from);
+        }
+    };
+
+    /**
+     * Appends each matching record of 'text' to 'out' followed by '\n', returns the number of them
+     * 'text' should start at a record boundary, otherwise its 1st lines are taken for a record without a header
+     */
+    std::size_t grepChunk(std::string_view text, const Matcher& matcher, std::string& out);
+
+    constexpr std::size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+
+    /**
+     * Greps 'text' in chunks on 'pool'; 'write' is called on the calling thread with the output of each chunk,
+     * in order, possibly with an empty string_view
+     *
+     * Returns the number of matching records; exceptions from 'write' or from the workers are rethrown
+     * once the chunks in flight are done with
+     */
+    std::size_t grep(pool::Pool& pool, std::string_view text, const Matcher& matcher,
+            const std::function<void(std::string_view)>& write, std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+}
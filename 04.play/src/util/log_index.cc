@@ -0,0 +1,234 @@
+#include <util/log_index.h>
+#include <util/log/records.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+namespace util::log_index {
+    namespace records = log::records;
+
+    namespace {
+        constexpr char MAGIC[8] = {'L', 'O', 'G', 'I', 'D', 'X', '\r', '\n'};
+        constexpr std::uint32_t VERSION = 1;
+
+        /** How much of the start of the log we hash to recognize it */
+        constexpr std::size_t FINGERPRINT_SIZE = 4096;
+
+        struct FileHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t blockSize;
+            std::uint64_t indexedSize;
+            std::uint64_t fingerprint;
+            std::uint64_t fingerprintSize;
+            std::uint64_t blockCount;
+        };
+
+        static_assert(sizeof(Block) == 72, "Block is written to the index file as it is");
+
+        /** FNV-1a, stable across runs and builds unlike std::hash */
+        std::uint64_t hash(std::string_view data) {
+            std::uint64_t result = 0xcbf29ce484222325;
+            for (auto c: data) {
+                result = (result ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+            }
+            return result;
+        }
+
+        /** Bits of a channel in the Bloom filter, by double hashing */
+        template <typename F>
+        void forEachBit(std::uint64_t channelHash, F&& f) {
+            auto h2 = (channelHash >> 32) | 1;
+            for (std::uint64_t i = 0; i < 3; ++i) {
+                auto bit = (channelHash + i * h2) % 256;
+                f(bit / 64, std::uint64_t{1} << (bit % 64));
+            }
+        }
+
+        bool mayHaveChannel(const Block& block, std::uint64_t channelHash) {
+            bool result = true;
+            forEachBit(channelHash, [&](std::size_t word, std::uint64_t mask) {
+                result = result && (block.channels[word] & mask) != 0;
+            });
+            return result;
+        }
+
+        Block emptyBlock(std::size_t begin) {
+            return Block{begin, begin, std::numeric_limits<std::int64_t>::max(),
+                    std::numeric_limits<std::int64_t>::min(), 0, 0, {}};
+        }
+    }
+
+    bool Block::mayMatch(const log_grep::Filter& filter, std::span<const std::uint64_t> channelHashes) const {
+        if ((severities & filter.severities.to_ulong()) == 0) {
+            return false;
+        }
+        if ((filter.since && maxTime < *filter.since) || (filter.until && minTime >= *filter.until)) {
+            return false;
+        }
+        return channelHashes.empty() || std::ranges::any_of(channelHashes, [this](std::uint64_t channelHash) {
+            return mayHaveChannel(*this, channelHash);
+        });
+    }
+
+    Index Index::load(const std::filesystem::path& path) {
+        std::ifstream in{path, std::ios::binary};
+        if (!in) {
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+        }
+        FileHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+                || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            throw std::runtime_error(path.string() + " is not a log index");
+        }
+
+        Index index{Options{header.blockSize}};
+        index._indexedSize = header.indexedSize;
+        index._fingerprint = header.fingerprint;
+        index._fingerprintSize = header.fingerprintSize;
+        index._blocks.resize(header.blockCount);
+        if (!in.read(reinterpret_cast<char*>(index._blocks.data()), header.blockCount * sizeof(Block))) {
+            throw std::runtime_error(path.string() + " is truncated");
+        }
+        return index;
+    }
+
+    void Index::save(const std::filesystem::path& path) const {
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.blockSize = static_cast<std::uint32_t>(_options.blockSize);
+        header.indexedSize = _indexedSize;
+        header.fingerprint = _fingerprint;
+        header.fingerprintSize = _fingerprintSize;
+        header.blockCount = _blocks.size();
+
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(_blocks.data()), _blocks.size() * sizeof(Block));
+            if (!out.flush()) {
+                throw std::system_error(errno, std::generic_category(), "Cannot write " + temporary.string());
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    }
+
+    std::filesystem::path Index::pathFor(const std::filesystem::path& log) {
+        auto result = log;
+        result += ".idx";
+        return result;
+    }
+
+    bool Index::covers(std::string_view log) const {
+        return log.size() >= _indexedSize && hash(log.substr(0, _fingerprintSize)) == _fingerprint;
+    }
+
+    void Index::update(std::string_view log) {
+        if (!covers(log)) {
+            _blocks.clear();
+            indexFrom(log, 0);
+        } else if (!_blocks.empty() && _blocks.back().end - _blocks.back().begin < _options.blockSize) {
+            /* the block still being filled is redone from its start */
+            auto begin = _blocks.back().begin;
+            _blocks.pop_back();
+            indexFrom(log, begin);
+        } else {
+            indexFrom(log, _indexedSize);
+        }
+        _fingerprintSize = std::min(_indexedSize, FINGERPRINT_SIZE);
+        _fingerprint = hash(log.substr(0, _fingerprintSize));
+    }
+
+    void Index::indexFrom(std::string_view log, std::size_t offset) {
+        bool open = false;
+        std::string_view lastChannel;
+        std::uint64_t lastChannelHash = 0;
+
+        auto pos = offset;
+        for (;;) {
+            auto next = records::findRecordStart(log, pos + 1);
+            if (next == log.size()) {
+                /* the last record may not be complete yet */
+                break;
+            }
+            if (!open) {
+                _blocks.push_back(emptyBlock(pos));
+                open = true;
+            }
+            auto& block = _blocks.back();
+
+            auto firstLine = log.substr(pos, next - pos);
+            firstLine = firstLine.substr(0, firstLine.find('\n'));
+            if (firstLine.ends_with('\r')) {
+                firstLine.remove_suffix(1);
+            }
+            /* records without a proper header never match filters on headers, see log_grep::Matcher */
+            if (auto header = records::parseHeader(firstLine)) {
+                auto time = *records::parseTimestamp(header->timestamp);
+                block.minTime = std::min(block.minTime, time);
+                block.maxTime = std::max(block.maxTime, time);
+                block.severities |= 1 << static_cast<unsigned>(header->severity);
+                if (header->channel != lastChannel) {
+                    lastChannel = header->channel;
+                    lastChannelHash = hash(lastChannel);
+                }
+                forEachBit(lastChannelHash, [&block](std::size_t word, std::uint64_t mask) {
+                    block.channels[word] |= mask;
+                });
+            }
+            ++block.records;
+            block.end = next;
+            open = block.end - block.begin < _options.blockSize;
+            pos = next;
+        }
+        _indexedSize = pos;
+    }
+
+    std::vector<Range> Index::candidates(std::string_view log, const log_grep::Filter& filter) const {
+        if (!covers(log) || !filter.filtersHeaders()) {
+            return {Range{0, log.size()}};
+        }
+
+        std::vector<std::uint64_t> channelHashes;
+        for (auto& channel: filter.channels) {
+            channelHashes.push_back(hash(channel));
+        }
+
+        std::vector<Range> result;
+        auto add = [&result](std::size_t begin, std::size_t end) {
+            if (!result.empty() && result.back().second == begin) {
+                result.back().second = end;
+            } else {
+                result.emplace_back(begin, end);
+            }
+        };
+        for (auto& block: _blocks) {
+            if (block.mayMatch(filter, channelHashes)) {
+                add(block.begin, block.end);
+            }
+        }
+        if (_indexedSize < log.size()) {
+            add(_indexedSize, log.size());
+        }
+        return result;
+    }
+
+    std::size_t query(std::string_view log, const Index& index, const log_grep::Matcher& matcher,
+            const std::function<void(std::string_view)>& write) {
+        std::size_t count = 0;
+        std::string out;
+        for (auto [begin, end]: index.candidates(log, matcher.filter())) {
+            out.clear();
+            count += log_grep::grepChunk(log.substr(begin, end - begin), matcher, out);
+            write(out);
+        }
+        return count;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * Sidecar index for logs written by util::log so that queries don't have to read the whole log
+ *
+ * The log is cut into blocks of about Options::blockSize bytes at record boundaries; for each block we keep
+ * where it is, the earliest and the latest timestamp in it, a bitmap of the severities present
+ * and a Bloom filter of its channels. A query given as a log_grep::Filter then only reads the blocks which
+ * may hold a match - the ones overlapping the time range, having one of the severities and maybe one of
+ * the channels - and greps those; substrings aren't indexed, they are checked on the blocks which remain
+ *
+ * The index is small, 72 bytes per block, and lives next to the log, "app.log" gets "app.log.idx"
+ *
+ * update() picks up where the last one stopped: the block still being filled is redone and the rest is appended
+ * The last record of the log is never indexed as its writer may still be adding stack frames to it;
+ * the part of the log past the indexed size is always read in full by queries so they never miss anything
+ *
+ * A log which has been rotated or truncated since is recognized by its size or by a hash of its beginning
+ * and indexed from scratch; until then queries just read all of it
+ */
+
+#include <util/log_grep.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util::log_index {
+    struct Options {
+        std::size_t blockSize = 64 << 10;
+    };
+
+    /** Layout of the index file, so plain data of fixed size */
+    struct Block {
+        std::uint64_t begin;
+        std::uint64_t end;
+
+        /* microseconds as returned by log::records::parseTimestamp(); min > max if no record has a header */
+        std::int64_t minTime;
+        std::int64_t maxTime;
+
+        std::uint32_t records;
+
+        /** Bit per log::records::Severity */
+        std::uint8_t severities;
+
+        /** Bloom filter of channel names, 3 bits per channel */
+        std::array<std::uint64_t, 4> channels;
+
+        /** Can there be records matching the header part of 'filter' in this block? */
+        bool mayMatch(const log_grep::Filter& filter, std::span<const std::uint64_t> channelHashes) const;
+    };
+
+    /** Byte range of a log, [first, second) */
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    class Index {
+        Options _options;
+        std::uint64_t _indexedSize = 0;
+
+        /* hash of the 1st _fingerprintSize bytes of the log */
+        std::uint64_t _fingerprint = 0;
+        std::uint64_t _fingerprintSize = 0;
+
+        std::vector<Block> _blocks;
+
+        /** Indexes records from 'offset' on, the blocks before it are kept */
+        void indexFrom(std::string_view log, std::size_t offset);
+    public:
+        explicit Index(Options options = {}): _options(options) {}
+
+        /** Throws std::runtime_error if the file isn't an index */
+        static Index load(const std::filesystem::path& path);
+
+        /** Writes to a temporary file next to 'path' and renames it over 'path' so readers never see half of it */
+        void save(const std::filesystem::path& path) const;
+
+        /** "app.log" -> "app.log.idx" */
+        static std::filesystem::path pathFor(const std::filesystem::path& log);
+
+        /** Brings the index up to date with 'log'; starts from scratch if the log is not the one indexed before */
+        void update(std::string_view log);
+
+        /** Was the index built for this log, maybe before it grew? */
+        bool covers(std::string_view log) const;
+
+        std::size_t indexedSize() const noexcept {
+            return _indexedSize;
+        }
+
+        const std::vector<Block>& blocks() const noexcept {
+            return _blocks;
+        }
+
+        /**
+         * Parts of 'log' which may hold records matching 'filter', in order, starting and ending at record boundaries;
+         * adjacent blocks are joined and the unindexed tail is always included; all of the log if !covers(log)
+         */
+        std::vector<Range> candidates(std::string_view log, const log_grep::Filter& filter) const;
+    };
+
+    /**
+     * Greps the candidates() of 'log' with 'matcher' calling 'write' with the matching records, in order;
+     * gives the same as log_grep::grepChunk() over all of the log, returns the number of matching records
+     */
+    std::size_t query(std::string_view log, const Index& index, const log_grep::Matcher& matcher,
+            const std::function<void(std::string_view)>& write);
+}
@@ -0,0 +1,49 @@
+#include <util/log_merge.h>
+#include <util/log/records.h>
+
+#include <limits>
+
+namespace util::log_merge {
+    namespace records = log::records;
+
+    namespace {
+        /** Lines before the 1st header of an input have no time of their own, they go 1st */
+        constexpr auto BEFORE_ALL = std::numeric_limits<std::int64_t>::min();
+    }
+
+    std::optional<std::int64_t> Merger::load(Cursor& cursor) {
+        if (cursor.begin == cursor.text.size()) {
+            return std::nullopt;
+        }
+        cursor.end = records::findRecordStart(cursor.text, cursor.begin + 1);
+        return records::parseTimestamp(cursor.text.substr(cursor.begin)).value_or(BEFORE_ALL);
+    }
+
+    std::vector<std::optional<std::int64_t>> Merger::start(std::span<const std::string_view> inputs) {
+        _cursors.resize(inputs.size());
+        std::vector<std::optional<std::int64_t>> times;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            _cursors[i].text = inputs[i];
+            times.push_back(load(_cursors[i]));
+        }
+        return times;
+    }
+
+    Merger::Merger(std::span<const std::string_view> inputs): _tree(start(inputs)) {}
+
+    std::optional<MergedRecord> Merger::next() {
+        if (_tree.done()) {
+            return std::nullopt;
+        }
+        auto input = _tree.winner();
+        auto& cursor = _cursors[input];
+        MergedRecord result{cursor.text.substr(cursor.begin, cursor.end - cursor.begin), input};
+        cursor.begin = cursor.end;
+        if (auto time = load(cursor)) {
+            _tree.replay(*time);
+        } else {
+            _tree.retire();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * Interleaving logs of several processes by time - the library part of the log-merge tool
+ *
+ * Every input is a log in the setStandardLogFormat() layout, typically a memory-mapped file; records,
+ * that is header lines together with their continuation lines (see util/log/records.h), are ordered
+ * by the timestamp at the start of the header and a record is never split
+ *
+ * Merger is a streaming k-way merge: next() returns records one at a time and only keeps a cursor per input,
+ * so memory use doesn't depend on the sizes of the inputs; with memory-mapped files the pages we're done with
+ * can be handed back with MappedFile::dropBefore(consumed(input))
+ *
+ * The inputs are expected to be ordered by time each; if one isn't, its records still come out in their
+ * original order and the merge goes on with what it has, it doesn't reorder records within an input
+ * Records with equal timestamps come out in the order of the inputs; lines before the 1st header of an input
+ * go before everything else
+ *
+ * The next record is chosen with a loser tree: a tournament tree remembering the loser of each match,
+ * so replacing the winner takes log2(k) comparisons along a single path to the root, half as many as
+ * with a binary heap which has to compare with both children on its way down
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util::log_merge {
+    /**
+     * Tournament tree over k players 0..k-1, each with a key; the winner is the player with the smallest key
+     * by 'less', ties go to the player with the smaller index so merging with it is stable
+     *
+     * Keys are kept in the tree so that a replay compares keys sitting next to each other, rather than
+     * chasing the players' data; the winner goes on with a new key via replay() or drops out via retire()
+     */
+    template <typename Key, typename Less = std::less<>>
+    class LoserTree {
+        struct Entry {
+            Key key;
+            std::size_t player;
+            bool out;
+        };
+
+        /* _nodes[0] is the winner, _nodes[1..k-1] are losers of the matches at the inner nodes of the tree;
+         * player i is the leaf k + i of the implicit tree where node n's parent is n / 2 */
+        std::vector<Entry> _nodes;
+        [[no_unique_address]] Less _less;
+
+        bool beats(const Entry& a, const Entry& b) const {
+            if (a.out || b.out) {
+                return !a.out && b.out;
+            }
+            if (_less(a.key, b.key)) {
+                return true;
+            }
+            return !_less(b.key, a.key) && a.player < b.player;
+        }
+
+        /** Plays out the subtree under 'node', returns its winner */
+        Entry build(std::size_t node, std::span<const std::optional<Key>> keys) {
+            auto k = keys.size();
+            if (node >= k) {
+                auto& key = keys[node - k];
+                return Entry{key.value_or(Key{}), node - k, !key};
+            }
+            auto left = build(2 * node, keys);
+            auto right = build(2 * node + 1, keys);
+            if (beats(right, left)) {
+                std::swap(left, right);
+            }
+            _nodes[node] = std::move(right);
+            return left;
+        }
+
+        void replay() {
+            auto winner = std::move(_nodes[0]);
+            for (auto node = (winner.player + _nodes.size()) / 2; node != 0; node /= 2) {
+                if (beats(_nodes[node], winner)) {
+                    std::swap(_nodes[node], winner);
+                }
+            }
+            _nodes[0] = std::move(winner);
+        }
+    public:
+        /** A player whose key is nullopt is out from the start */
+        explicit LoserTree(std::span<const std::optional<Key>> keys, Less less = {}): _less(std::move(less)) {
+            if (!keys.empty()) {
+                _nodes.resize(keys.size(), Entry{Key{}, 0, true});
+                _nodes[0] = build(1, keys);
+            }
+        }
+
+        /** True when all players are out */
+        bool done() const noexcept {
+            return _nodes.empty() || _nodes[0].out;
+        }
+
+        /** Only when !done() */
+        std::size_t winner() const noexcept {
+            return _nodes[0].player;
+        }
+
+        const Key& winnerKey() const noexcept {
+            return _nodes[0].key;
+        }
+
+        /** The winner goes on with a new key */
+        void replay(Key key) {
+            _nodes[0].key = std::move(key);
+            replay();
+        }
+
+        /** The winner drops out */
+        void retire() {
+            _nodes[0].out = true;
+            replay();
+        }
+    };
+
+    struct MergedRecord {
+        /** The record as it is in the input, with its line breaks; the last one of an input may lack the last break */
+        std::string_view text;
+        std::size_t input;
+    };
+
+    class Merger {
+        struct Cursor {
+            std::string_view text;
+
+            /* the current record is [begin, end) */
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        std::vector<Cursor> _cursors;
+        LoserTree<std::int64_t> _tree;
+
+        /** Finds where the record at cursor.begin ends and returns its time, nullopt if the input is done */
+        static std::optional<std::int64_t> load(Cursor& cursor);
+
+        /** Loads the 1st records of the inputs and returns their times */
+        std::vector<std::optional<std::int64_t>> start(std::span<const std::string_view> inputs);
+    public:
+        explicit Merger(std::span<const std::string_view> inputs);
+
+        /** The next record by time or nullopt when all inputs are done */
+        std::optional<MergedRecord> next();
+
+        /** How much of the input has been returned by next() so far, in bytes */
+        std::size_t consumed(std::size_t input) const noexcept {
+            return _cursors[input].begin;
+        }
+    };
+}
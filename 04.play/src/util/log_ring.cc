@@ -0,0 +1,501 @@
+#include <util/log_ring.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <boost/log/core.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/unlocked_frontend.hpp>
+#include <boost/make_shared.hpp>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace util::log_ring {
+    namespace _detail {
+        /** At the start of the segment, followed by the records at HEADER_SIZE */
+        struct Header {
+            std::atomic<std::uint64_t> magic;
+            std::uint64_t capacity;
+
+            /* each on a cache line of its own: producers hammer the head, the collector moves the tail */
+            alignas(64) std::atomic<std::uint64_t> head;
+            std::atomic<std::uint64_t> dropped;
+
+            alignas(64) std::atomic<std::uint64_t> tail;
+            std::atomic<std::uint64_t> lost;
+
+            /* futex word the collector sleeps on and whether it does, read by producers on every write */
+            alignas(64) std::atomic<std::uint32_t> wakeups;
+            std::atomic<std::uint32_t> sleeping;
+        };
+    }
+
+    namespace {
+        using _detail::Header;
+
+        /* the segment is shared by processes so the atomics have to work by address alone */
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+        constexpr std::uint64_t MAGIC = 0x474e4952474f4c01; // "\1LOGRING"
+
+        /* a page so that records start page-aligned */
+        constexpr std::size_t HEADER_SIZE = 4096;
+        static_assert(sizeof(Header) <= HEADER_SIZE);
+
+        constexpr std::size_t MIN_CAPACITY = 4096;
+        constexpr std::size_t MAX_CAPACITY = std::size_t{1} << 32;
+
+        enum State: std::uint32_t {
+            WRITING, COMMITTED, PADDING
+        };
+
+        /** Records and so their headers are aligned to this, and so the room left before the end of the ring is */
+        constexpr std::uint64_t ALIGNMENT = 16;
+
+        /** Precedes each record; the text follows, then padding to ALIGNMENT */
+        struct RecordHeader {
+            /*
+             * Position of the record plus one, stored once the fields below are filled in
+             * Whatever an earlier lap of the ring left here holds a smaller value, so we can tell
+             * a header which is there from stale bytes and from bytes never written, which are zeroes
+             */
+            std::atomic<std::uint64_t> ticket;
+            std::atomic<std::uint32_t> state;
+            std::uint32_t size;
+
+            /* padding only has the fields above, which fit into the least room there may be left */
+            std::uint32_t length;
+            std::int32_t pid;
+        };
+        static_assert(offsetof(RecordHeader, length) == ALIGNMENT);
+
+        [[noreturn]] void fail(const std::string& name, const char* what) {
+            throw std::system_error(errno, std::generic_category(), std::string(what) + " " + name);
+        }
+
+        void checkCapacity(std::size_t capacity) {
+            if (capacity < MIN_CAPACITY || capacity > MAX_CAPACITY || !std::has_single_bit(capacity)) {
+                throw std::invalid_argument("Log ring capacity must be a power of two from 4096 to 2^32");
+            }
+        }
+
+        void initialize(int fd, std::size_t capacity, const std::string& name) {
+            if (::ftruncate(fd, static_cast<off_t>(HEADER_SIZE + capacity)) != 0) {
+                fail(name, "Cannot size shared memory");
+            }
+            auto memory = ::mmap(nullptr, HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (memory == MAP_FAILED) {
+                fail(name, "Cannot map shared memory");
+            }
+            /* the memory is zeroes, all that's left is to say what it is */
+            auto header = new (memory) Header{};
+            header->capacity = capacity;
+            header->magic.store(MAGIC, std::memory_order_release);
+            ::munmap(memory, HEADER_SIZE);
+        }
+
+        /*
+         * getpid() is a syscall, glibc doesn't cache it; we do, and forget it in a child after fork()
+         * 0 is never a pid we'd write
+         */
+        std::atomic<pid_t> cachedPid{0};
+
+        pid_t currentPid() noexcept {
+            static const bool registered = ::pthread_atfork(nullptr, nullptr, [] {
+                cachedPid.store(0, std::memory_order_relaxed);
+            }) == 0;
+            (void)registered;
+
+            auto pid = cachedPid.load(std::memory_order_relaxed);
+            if (pid == 0) {
+                pid = ::getpid();
+                cachedPid.store(pid, std::memory_order_relaxed);
+            }
+            return pid;
+        }
+
+        bool isGone(pid_t pid) noexcept {
+            return ::kill(pid, 0) != 0 && errno == ESRCH;
+        }
+
+        /* not FUTEX_PRIVATE: sleeper and wakers are in different processes */
+        void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout) {
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            timespec relative{static_cast<time_t>(seconds.count()),
+                    static_cast<long>(std::chrono::nanoseconds(timeout - seconds).count())};
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+        }
+
+        void futexWakeAll(std::atomic<std::uint32_t>& word) {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        std::uint64_t alignUp(std::uint64_t size) {
+            return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+
+        void writeAll(int fd, std::string_view text) {
+            while (!text.empty()) {
+                auto written = ::write(fd, text.data(), text.size());
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    fail("log", "Cannot write");
+                }
+                text.remove_prefix(static_cast<std::size_t>(written));
+            }
+        }
+
+        /** Writes formatted records into the ring with no locking of its own */
+        class RingBackend: public boost::log::sinks::basic_formatted_sink_backend<char,
+                boost::log::sinks::concurrent_feeding> {
+            std::shared_ptr<Ring> _ring;
+        public:
+            explicit RingBackend(std::shared_ptr<Ring> ring): _ring(std::move(ring)) {}
+
+            void consume(const boost::log::record_view&, const string_type& formatted) {
+                _ring->write(formatted);
+            }
+        };
+    }
+
+    Ring::Ring(int fd, const std::string& what): _fd(fd) {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(what, "Cannot stat shared memory");
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        auto memory = size > HEADER_SIZE ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : nullptr;
+        if (memory == MAP_FAILED) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(what, "Cannot map shared memory");
+        }
+        auto header = static_cast<Header*>(memory);
+        if (!header || header->magic.load(std::memory_order_acquire) != MAGIC
+                || header->capacity != size - HEADER_SIZE) {
+            if (memory) {
+                ::munmap(memory, size);
+            }
+            ::close(fd);
+            throw std::runtime_error("Not a log ring: " + what);
+        }
+        _header = header;
+        _data = static_cast<char*>(memory) + HEADER_SIZE;
+        _mappedSize = size;
+    }
+
+    Ring Ring::create(const std::string& name, std::size_t capacity) {
+        checkCapacity(capacity);
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            fail(name, "Cannot create shared memory");
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(name, "Cannot stat shared memory");
+        }
+        if (st.st_size == 0) {
+            try {
+                initialize(fd, capacity, name);
+            } catch (...) {
+                ::close(fd);
+                throw;
+            }
+        }
+        return Ring{fd, name};
+    }
+
+    Ring Ring::open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            fail(name, "Cannot open shared memory");
+        }
+        return Ring{fd, name};
+    }
+
+    void Ring::unlink(const std::string& name) {
+        if (::shm_unlink(name.c_str()) != 0) {
+            fail(name, "Cannot unlink shared memory");
+        }
+    }
+
+    Ring Ring::anonymous(std::size_t capacity) {
+        checkCapacity(capacity);
+        /* no MFD_CLOEXEC: workers may as well exec() and attach() to the descriptor they inherit */
+        int fd = ::memfd_create("log_ring", 0);
+        if (fd < 0) {
+            fail("log_ring", "Cannot create memfd");
+        }
+        try {
+            initialize(fd, capacity, "memfd");
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        return Ring{fd, "memfd"};
+    }
+
+    Ring Ring::attach(int fd) {
+        return Ring{fd, "descriptor " + std::to_string(fd)};
+    }
+
+    Ring::Ring(Ring&& other) noexcept: _fd(std::exchange(other._fd, -1)),
+            _header(std::exchange(other._header, nullptr)), _data(std::exchange(other._data, nullptr)),
+            _mappedSize(std::exchange(other._mappedSize, 0)) {}
+
+    Ring& Ring::operator=(Ring&& other) noexcept {
+        if (this != &other) {
+            this->~Ring();
+            new (this) Ring(std::move(other));
+        }
+        return *this;
+    }
+
+    Ring::~Ring() {
+        if (_header) {
+            ::munmap(_header, _mappedSize);
+        }
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+
+    std::size_t Ring::capacity() const noexcept {
+        return _header->capacity;
+    }
+
+    bool Ring::write(std::string_view record) noexcept {
+        auto& header = *_header;
+        auto capacity = header.capacity;
+
+        /* a record of at most a half of the ring plus padding before it always fits into an empty ring */
+        auto length = std::min<std::uint64_t>(record.size(), capacity / 2 - sizeof(RecordHeader));
+        auto size = alignUp(sizeof(RecordHeader) + length);
+
+        std::uint64_t head = header.head.load(std::memory_order_relaxed);
+        std::uint64_t padding;
+        for (;;) {
+            auto offset = head & (capacity - 1);
+            padding = offset + size > capacity ? capacity - offset : 0;
+
+            /* acquire: the collector is done reading what it has given back */
+            auto tail = header.tail.load(std::memory_order_acquire);
+            if (tail > head) {
+                /* we've been asleep and 'head' is stale */
+                head = header.head.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head + padding + size - tail > capacity) {
+                header.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (header.head.compare_exchange_weak(head, head + padding + size, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        auto at = [&](std::uint64_t position) -> RecordHeader& {
+            return *reinterpret_cast<RecordHeader*>(_data + (position & (capacity - 1)));
+        };
+        if (padding) {
+            auto& paddingHeader = at(head);
+            paddingHeader.size = static_cast<std::uint32_t>(padding);
+            paddingHeader.state.store(PADDING, std::memory_order_relaxed);
+            paddingHeader.ticket.store(head + 1, std::memory_order_release);
+        }
+        auto position = head + padding;
+        auto& recordHeader = at(position);
+        recordHeader.size = static_cast<std::uint32_t>(size);
+        recordHeader.length = static_cast<std::uint32_t>(length);
+        recordHeader.pid = currentPid();
+        /* whatever an earlier lap left here must not pass for committed */
+        recordHeader.state.store(WRITING, std::memory_order_relaxed);
+        recordHeader.ticket.store(position + 1, std::memory_order_release);
+        std::memcpy(reinterpret_cast<char*>(&recordHeader + 1), record.data(), length);
+        recordHeader.state.store(COMMITTED, std::memory_order_release);
+
+        /* pairs with the fence in Collector::drain(): either it sees the record or we see it sleeping */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (header.sleeping.load(std::memory_order_relaxed)) {
+            wake();
+        }
+        return true;
+    }
+
+    std::uint64_t Ring::dropped() const noexcept {
+        return _header->dropped.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t Ring::lost() const noexcept {
+        return _header->lost.load(std::memory_order_relaxed);
+    }
+
+    void Ring::wake() noexcept {
+        _header->wakeups.fetch_add(1, std::memory_order_release);
+        futexWakeAll(_header->wakeups);
+    }
+
+    bool Collector::skipStalled(std::uint64_t tail, std::uint64_t head) {
+        auto now = std::chrono::steady_clock::now();
+        if (_stalledAt != tail) {
+            _stalledAt = tail;
+            _stalledHead = head;
+            _stalledSince = now;
+            return false;
+        }
+        if (now - _stalledSince < _options.stallTimeout) {
+            return false;
+        }
+
+        auto& header = *_ring._header;
+        auto mask = header.capacity - 1;
+        auto at = [&](std::uint64_t position) -> RecordHeader& {
+            return *reinterpret_cast<RecordHeader*>(_ring._data + (position & mask));
+        };
+
+        std::uint64_t next;
+        auto& stalled = at(tail);
+        if (stalled.ticket.load(std::memory_order_acquire) == tail + 1) {
+            if (!isGone(stalled.pid)) {
+                /* just slow, look again after another timeout */
+                _stalledSince = now;
+                return false;
+            }
+            next = tail + stalled.size;
+        } else {
+            /* no header so no size: the next record is the first header past here which is there */
+            next = tail + ALIGNMENT;
+            while (next < head && at(next).ticket.load(std::memory_order_acquire) != next + 1) {
+                next += ALIGNMENT;
+            }
+            /*
+             * With no header to be found the records past 'tail' may just have been reserved and be
+             * about to get theirs; only if nothing was reserved all the while are they all abandoned
+             */
+            if (next == head && head != _stalledHead) {
+                _stalledHead = head;
+                _stalledSince = now;
+                return false;
+            }
+        }
+
+        header.lost.fetch_add(1, std::memory_order_relaxed);
+        header.tail.store(next, std::memory_order_release);
+        _stalledAt = ~std::uint64_t{0};
+        return true;
+    }
+
+    std::size_t Collector::drain(const std::function<void(std::string_view)>& onRecord,
+            std::chrono::milliseconds wait) {
+        auto& header = *_ring._header;
+        auto mask = header.capacity - 1;
+
+        auto ready = [&](std::uint64_t tail) {
+            auto& recordHeader = *reinterpret_cast<RecordHeader*>(_ring._data + (tail & mask));
+            return tail != header.head.load(std::memory_order_acquire)
+                    && recordHeader.ticket.load(std::memory_order_acquire) == tail + 1
+                    && recordHeader.state.load(std::memory_order_acquire) != WRITING;
+        };
+
+        auto deliver = [&] {
+            std::size_t delivered = 0;
+            for (;;) {
+                auto tail = header.tail.load(std::memory_order_relaxed);
+                auto head = header.head.load(std::memory_order_acquire);
+                if (tail == head) {
+                    return delivered;
+                }
+                if (!ready(tail)) {
+                    if (skipStalled(tail, head)) {
+                        continue;
+                    }
+                    return delivered;
+                }
+
+                auto& recordHeader = *reinterpret_cast<RecordHeader*>(_ring._data + (tail & mask));
+                if (recordHeader.state.load(std::memory_order_relaxed) == COMMITTED) {
+                    onRecord(std::string_view(reinterpret_cast<const char*>(&recordHeader + 1), recordHeader.length));
+                    ++delivered;
+                }
+                /* release: we are done reading the record, producers may overwrite it */
+                header.tail.store(tail + recordHeader.size, std::memory_order_release);
+                _stalledAt = ~std::uint64_t{0};
+            }
+        };
+
+        auto delivered = deliver();
+        if (delivered > 0 || wait <= std::chrono::milliseconds::zero()) {
+            return delivered;
+        }
+
+        auto wakeups = header.wakeups.load(std::memory_order_acquire);
+        header.sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready(header.tail.load(std::memory_order_relaxed))) {
+            futexWait(header.wakeups, wakeups, wait);
+        }
+        header.sleeping.store(0, std::memory_order_relaxed);
+        return deliver();
+    }
+
+    void collect(std::stop_token stopToken, Ring& ring, int fd, Options options) {
+        /* records are handed back to producers once in the buffer, so we don't hold on to them for long */
+        constexpr std::size_t FLUSH_AT = 1 << 16;
+
+        Collector collector{ring, options};
+        std::string buffer;
+        auto onRecord = [&](std::string_view record) {
+            buffer.append(record);
+            buffer.push_back('\n');
+            if (buffer.size() >= FLUSH_AT) {
+                writeAll(fd, buffer);
+                buffer.clear();
+            }
+        };
+
+        std::stop_callback wake{stopToken, [&ring] { ring.wake(); }};
+        while (!stopToken.stop_requested()) {
+            collector.drain(onRecord, options.stallTimeout);
+            writeAll(fd, buffer);
+            buffer.clear();
+        }
+        while (collector.drain(onRecord, std::chrono::milliseconds::zero()) > 0) {
+        }
+        writeAll(fd, buffer);
+    }
+
+    void logToRing(std::shared_ptr<Ring> ring) {
+        using boost::log::sinks::unlocked_sink;
+
+        auto sink = boost::make_shared<unlocked_sink<RingBackend>>(boost::make_shared<RingBackend>(std::move(ring)));
+        sink -> set_formatter(log::standardLogFormatter());
+        boost::log::core::get() -> add_sink(sink);
+    }
+}
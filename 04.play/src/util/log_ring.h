@@ -0,0 +1,138 @@
+#pragma once
+
+/**
+ * Log records of several processes on one host collected into one file through shared memory
+ *
+ * Each worker process used to logToConsole() on its own: records of different processes interleave mid-line
+ * when their output ends up in one place and every process needs its own file handle; instead workers
+ * logToRing() and a single collector, log-collect or a thread of some process, drains the ring into the file
+ *
+ * The ring is a shared memory segment: either named, shm_open() by the collector and the workers alike,
+ * or anonymous, memfd_create() by a parent which forks the workers
+ *
+ * Writing is lock-free for any number of producers in any number of processes
+ * - a producer reserves room for its record by advancing the head with a compare-and-swap,
+ *   then fills in the record header and the text and marks the record committed
+ * - the collector delivers committed records in the order they were reserved and moves the tail past them,
+ *   which gives the room back to producers
+ * - a record which would straddle the end of the ring is preceded by padding up to the end
+ * Producers never wait: if the ring is full the record is dropped and counted
+ * The collector sleeps on a futex in the segment when there is nothing to do, producers only make
+ * the wake-up syscall when it actually sleeps
+ *
+ * Records are in shared memory rather than in a process, so a worker which crashes loses nothing it had written;
+ * a named segment outlives the collector as well, a collector started anew picks up where the old one stopped
+ * A worker dying halfway through writing a record would hold up the collector forever, so
+ * - a record reserved but not committed is skipped once its process is gone
+ * - if a producer died after reserving but before even writing the record header we don't know how long
+ *   the record is; after Options::stallTimeout we look for the next record header past it
+ * Either way the record is counted as lost
+ *
+ * Process ids in the ring are those of the writers' pid namespace, everyone is expected to share one
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <string_view>
+
+namespace util::log_ring {
+    namespace _detail {
+        struct Header;
+    }
+
+    struct Options {
+        /** How long a record may stay uncommitted before we look into whether its writer is still there */
+        std::chrono::milliseconds stallTimeout{1000};
+    };
+
+    /** A mapping of a ring; cheap to create, several in one process map the same ring independently */
+    class Ring {
+        int _fd = -1;
+        _detail::Header* _header = nullptr;
+        char* _data = nullptr;
+        std::size_t _mappedSize = 0;
+
+        Ring(int fd, const std::string& what);
+    public:
+        /**
+         * Shared memory object 'name', e.g. "/app-log", for the collector; maps the ring which is there already
+         * if any, with its own capacity, otherwise makes a ring of 'capacity' bytes which is a power of two
+         */
+        static Ring create(const std::string& name, std::size_t capacity);
+
+        /** Ring created by the collector under 'name', for workers */
+        static Ring open(const std::string& name);
+
+        /** Removes the name; mappings stay valid until they are gone */
+        static void unlink(const std::string& name);
+
+        /** Ring without a name, its fd() is inherited by children forked afterwards */
+        static Ring anonymous(std::size_t capacity);
+
+        /** Maps the ring of descriptor 'fd' of anonymous() in a child, takes the descriptor over */
+        static Ring attach(int fd);
+
+        Ring(Ring&& other) noexcept;
+        Ring& operator=(Ring&& other) noexcept;
+        ~Ring();
+
+        int fd() const noexcept {
+            return _fd;
+        }
+
+        /** Bytes of records and their headers the ring holds */
+        std::size_t capacity() const noexcept;
+
+        /**
+         * Adds a record, false if it was dropped as the ring is full; never blocks
+         * Records longer than a half of the capacity are cut short to fit
+         */
+        bool write(std::string_view record) noexcept;
+
+        /** Records dropped by write() since the ring was created */
+        std::uint64_t dropped() const noexcept;
+
+        /** Records given up on by the collector since the ring was created, see above */
+        std::uint64_t lost() const noexcept;
+
+        /** Wakes the collector waiting in Collector::drain() */
+        void wake() noexcept;
+
+        friend class Collector;
+    };
+
+    /** Reading side of a ring; there must be only one Collector per ring at a time */
+    class Collector {
+        Ring& _ring;
+        Options _options;
+
+        /* position where we last saw a record reserved and not committed, the head then and since when */
+        std::uint64_t _stalledAt = ~std::uint64_t{0};
+        std::uint64_t _stalledHead = 0;
+        std::chrono::steady_clock::time_point _stalledSince;
+
+        bool skipStalled(std::uint64_t tail, std::uint64_t head);
+    public:
+        explicit Collector(Ring& ring, Options options = {}): _ring(ring), _options(options) {}
+
+        /**
+         * Calls onRecord() with each committed record in order; the view is only valid in the call
+         * If there are none yet waits up to 'wait' for some, returns the number of records delivered
+         */
+        std::size_t drain(const std::function<void(std::string_view)>& onRecord, std::chrono::milliseconds wait);
+    };
+
+    /**
+     * Drains 'ring' into 'fd' a line per record until 'stopToken' is stopped, then delivers what's left
+     * Meant for a std::jthread of the collector; throws std::system_error if writing fails
+     */
+    void collect(std::stop_token stopToken, Ring& ring, int fd, Options options = {});
+
+    /** Activate logging to 'ring', in the standard format of logToConsole(), instead of logging to console */
+    void logToRing(std::shared_ptr<Ring> ring);
+}
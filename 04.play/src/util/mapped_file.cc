@@ -0,0 +1,89 @@
+#include <util/mapped_file.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace util::mapped_file {
+    namespace {
+        [[noreturn]] void fail(const std::filesystem::path& path, const char* what) {
+            throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path.string());
+        }
+
+        int adviceFor(Access access) {
+            switch (access) {
+                case Access::SEQUENTIAL: return MADV_SEQUENTIAL;
+                case Access::RANDOM: return MADV_RANDOM;
+                default: return MADV_NORMAL;
+            }
+        }
+    }
+
+    MappedFile::MappedFile(const std::filesystem::path& path, Access access) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fail(path, "Cannot open");
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto error = errno;
+            ::close(fd);
+            errno = error;
+            fail(path, "Cannot stat");
+        }
+
+        auto size = static_cast<std::size_t>(st.st_size);
+        if (size != 0) {
+            void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                auto error = errno;
+                ::close(fd);
+                errno = error;
+                fail(path, "Cannot mmap");
+            }
+            /* only a hint, not worth failing over */
+            ::madvise(data, size, adviceFor(access));
+            _data = static_cast<const char*>(data);
+            _size = size;
+        }
+        /* the mapping keeps the file alive */
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+    }
+
+    void MappedFile::dropBefore(std::size_t offset) noexcept {
+        static const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        /* _data is page-aligned; the page holding 'offset' itself may still be in use */
+        auto length = std::min(offset, _size) / pageSize * pageSize;
+        if (length != 0) {
+            ::madvise(const_cast<char*>(_data), length, MADV_DONTNEED);
+        }
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept: _data(std::exchange(other._data, nullptr)),
+            _size(std::exchange(other._size, 0)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            if (_data) {
+                ::munmap(const_cast<char*>(_data), _size);
+            }
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * Read-only memory mapping of a whole file, to look at it as one string_view
+ *
+ * Nothing is read upfront: pages come in from the page cache as they are touched, and with Access::SEQUENTIAL
+ * the kernel reads ahead aggressively and may drop pages soon after we've gone past them
+ *
+ * An empty file is not mapped at all and gives an empty view
+ * Errors are reported via std::system_error carrying errno and the path
+ */
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace util::mapped_file {
+    /** Expected access pattern, passed on to madvise() */
+    enum class Access {
+        NORMAL, SEQUENTIAL, RANDOM
+    };
+
+    class MappedFile {
+        const char* _data = nullptr;
+        std::size_t _size = 0;
+    public:
+        MappedFile() noexcept = default;
+        explicit MappedFile(const std::filesystem::path& path, Access access = Access::SEQUENTIAL);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        std::string_view view() const noexcept {
+            return {_data, _size};
+        }
+
+        std::size_t size() const noexcept {
+            return _size;
+        }
+
+        /**
+         * Tells the kernel we are done with the pages before 'offset' so that they don't count towards our memory
+         * any more; reading them later is fine, they are simply read from the file again
+         */
+        void dropBefore(std::size_t offset) noexcept;
+    };
+}
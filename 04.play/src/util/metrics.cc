@@ -0,0 +1,167 @@
+#include <util/metrics.h>
+#include <util/log.h>
+#include <util/shards.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace util::metrics::_detail {
+    struct alignas(64) Shard {
+        std::array<std::atomic<std::uint64_t>, BUCKETS> counts{};
+        std::atomic<std::uint64_t> total = 0;
+        std::atomic<std::uint64_t> max = 0;
+    };
+
+    /** Lives as long as the program does so that Sites may keep raw pointers to it */
+    struct SiteData {
+        std::string name;
+        util::shards::Sharded<Shard> shards;
+
+        /* report()'s: the merged histogram as of the previous report */
+        Histogram reported{};
+    };
+}
+
+namespace {
+    using util::metrics::BUCKETS;
+    using util::metrics::Histogram;
+    using util::metrics::SiteStats;
+    using util::metrics::_detail::Shard;
+    using util::metrics::_detail::SiteData;
+
+    struct Registry {
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<SiteData>, std::less<>> sites;
+        std::mutex reportMutex;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    SiteStats merge(const SiteData& site) {
+        SiteStats stats{.name = site.name};
+        site.shards.forEach([&stats](const Shard& shard) {
+            for (std::size_t i = 0; i < BUCKETS; ++i) {
+                stats.histogram[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+            stats.total += std::chrono::nanoseconds{shard.total.load(std::memory_order_relaxed)};
+            stats.max = std::max(stats.max, std::chrono::nanoseconds{shard.max.load(std::memory_order_relaxed)});
+        });
+        for (auto count: stats.histogram) {
+            stats.count += count;
+        }
+        return stats;
+    }
+
+    std::vector<SiteData*> allSites() {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        std::vector<SiteData*> sites;
+        for (auto& [name, site]: reg.sites) {
+            sites.push_back(site.get());
+        }
+        return sites;
+    }
+
+    template <typename Duration>
+    double toMicros(Duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+}
+
+namespace util::metrics {
+    Site::Site(std::string_view name) {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        auto it = reg.sites.find(name);
+        if (it == reg.sites.end()) {
+            auto data = std::make_unique<SiteData>();
+            data->name = name;
+            it = reg.sites.emplace(std::string{name}, std::move(data)).first;
+        }
+        _data = it->second.get();
+    }
+
+    void Site::record(std::chrono::nanoseconds duration) noexcept {
+        auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+        auto shard = _data->shards.local();
+        if (!shard) {
+            return;
+        }
+
+        shard->counts[_detail::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        shard->total.fetch_add(ns, std::memory_order_relaxed);
+        auto max = shard->max.load(std::memory_order_relaxed);
+        while (ns > max && !shard->max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+    }
+
+    std::chrono::nanoseconds quantile(const Histogram& histogram, double q) {
+        std::uint64_t total = 0;
+        for (auto count: histogram) {
+            total += count;
+        }
+        if (total == 0) {
+            return std::chrono::nanoseconds{0};
+        }
+
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += histogram[i];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds{_detail::bucketUpperBound(i)};
+            }
+        }
+        return std::chrono::nanoseconds{_detail::bucketUpperBound(BUCKETS - 1)};
+    }
+
+    std::vector<SiteStats> snapshot() {
+        std::vector<SiteStats> result;
+        for (auto site: allSites()) {
+            auto stats = merge(*site);
+            if (stats.count > 0) {
+                result.push_back(std::move(stats));
+            }
+        }
+        std::ranges::sort(result, std::ranges::greater{}, &SiteStats::count);
+        return result;
+    }
+
+    void report() {
+        auto& logger = util::log::getLogger<metrics>();
+        std::lock_guard lock{registry().reportMutex};
+
+        std::vector<SiteStats> recent;
+        for (auto site: allSites()) {
+            auto stats = merge(*site);
+            SiteStats delta{.name = stats.name};
+            for (std::size_t i = 0; i < BUCKETS; ++i) {
+                delta.histogram[i] = stats.histogram[i] - site->reported[i];
+                delta.count += delta.histogram[i];
+            }
+            site->reported = stats.histogram;
+            if (delta.count > 0) {
+                recent.push_back(std::move(delta));
+            }
+        }
+        if (recent.empty()) {
+            logger.info("Nothing timed since the last report");
+            return;
+        }
+
+        std::ranges::sort(recent, std::ranges::greater{}, &SiteStats::count);
+        for (auto& site: recent) {
+            auto& h = site.histogram;
+            logger.info("{}: {} timed, p50/p90/p99/p999/max {:.1f}/{:.1f}/{:.1f}/{:.1f}/{:.1f}us",
+                    site.name, site.count, toMicros(quantile(h, 0.5)), toMicros(quantile(h, 0.9)),
+                    toMicros(quantile(h, 0.99)), toMicros(quantile(h, 0.999)), toMicros(quantile(h, 1.0)));
+        }
+    }
+
+    std::unique_ptr<util::worker::PeriodicWorker> reportPeriodically(std::chrono::steady_clock::duration period) {
+        return std::make_unique<util::worker::PeriodicWorker>("metrics-report", period, [] { report(); });
+    }
+}
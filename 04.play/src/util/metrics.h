@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * Always-on latency statistics of places in the code, reported through util::log
+ *
+ *     void handle(const Request& request) {
+ *         static util::metrics::Site site{"handle"};
+ *         util::metrics::Timer timer{site};
+ *         ...
+ *     }
+ *
+ * Where profiled_mutex has log2 buckets, good to a factor of two, a Site keeps an HDR-style histogram:
+ * each power of two is cut into 32 linear sub-buckets, so quantiles are good to about 3% from 1ns to 18 minutes
+ *
+ * Recording doesn't share cache lines between threads: each thread records into a shard of its own,
+ * allocated the first time the thread uses the site, with relaxed atomic increments nobody else writes to
+ * Reading merges the shards with relaxed loads while threads go on recording, nobody waits for anybody
+ * A Site is a handle to statistics registered under its name, so the static above is looked up just once;
+ * sites with the same name share statistics
+ *
+ * report() logs the quantiles of what's been recorded since the last report on the getLogger<metrics>() channel,
+ * reportPeriodically() does that on a background worker
+ */
+
+#include <util/worker.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::metrics {
+    /** Marker for the logger channel reports go to */
+    struct metrics {};
+
+    namespace _detail {
+        constexpr unsigned SUB_BUCKET_BITS = 5;
+
+        /** Durations from 2^MAX_BITS ns, some 18 minutes, on are counted as that */
+        constexpr unsigned MAX_BITS = 40;
+
+        /**
+         * Values below 64 have a bucket each; above, the bucket of value v with bit_width(v) == 6 + k
+         * is v >> k, from 32 to 63, plus 32 * k
+         */
+        constexpr std::size_t bucketOf(std::uint64_t ns) noexcept {
+            ns = std::min(ns, (std::uint64_t{1} << MAX_BITS) - 1);
+            auto width = static_cast<unsigned>(std::bit_width(ns));
+            auto shift = std::max(width, SUB_BUCKET_BITS + 1) - SUB_BUCKET_BITS - 1;
+            return (std::size_t{shift} << SUB_BUCKET_BITS) + static_cast<std::size_t>(ns >> shift);
+        }
+
+        /** Largest value which goes into bucket 'i' */
+        constexpr std::uint64_t bucketUpperBound(std::size_t i) noexcept {
+            if (i < (std::size_t{2} << SUB_BUCKET_BITS)) {
+                return i;
+            }
+            auto shift = (i >> SUB_BUCKET_BITS) - 1;
+            auto mantissa = i - (shift << SUB_BUCKET_BITS);
+            return ((std::uint64_t{mantissa} + 1) << shift) - 1;
+        }
+
+        struct SiteData;
+    }
+
+    constexpr std::size_t BUCKETS = _detail::bucketOf((std::uint64_t{1} << _detail::MAX_BITS) - 1) + 1;
+
+    using Histogram = std::array<std::uint64_t, BUCKETS>;
+
+    /** Upper bound of the bucket containing the given quantile, 0 if there is no data */
+    std::chrono::nanoseconds quantile(const Histogram& histogram, double q);
+
+    /** Point-in-time merge of the shards of one site */
+    struct SiteStats {
+        std::string name;
+        std::uint64_t count = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+        Histogram histogram{};
+    };
+
+    class Site {
+        _detail::SiteData* _data;
+    public:
+        explicit Site(std::string_view name);
+
+        void record(std::chrono::nanoseconds duration) noexcept;
+    };
+
+    /** Records the time from its construction to its destruction */
+    class Timer {
+        Site& _site;
+        std::chrono::steady_clock::time_point _start;
+    public:
+        explicit Timer(Site& site) noexcept: _site(site), _start(std::chrono::steady_clock::now()) {}
+
+        ~Timer() {
+            _site.record(std::chrono::steady_clock::now() - _start);
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+    };
+
+    /** Statistics of all sites with anything recorded since the program started, busiest first */
+    std::vector<SiteStats> snapshot();
+
+    /**
+     * Logs count and p50/p90/p99/p999/max of each site for what's been recorded since the previous report;
+     * max here is the upper bound of the highest bucket, as precise as the quantiles
+     */
+    void report();
+
+    /** Calls report() every 'period' until the returned worker is destroyed */
+    std::unique_ptr<util::worker::PeriodicWorker> reportPeriodically(std::chrono::steady_clock::duration period);
+}
@@ -0,0 +1,8 @@
+#include <util/parallel.h>
+
+namespace util::parallel {
+    pool::Pool& defaultPool() {
+        static pool::Pool pool;
+        return pool;
+    }
+}
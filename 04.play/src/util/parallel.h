@@ -0,0 +1,249 @@
+#pragma once
+
+/**
+ * Data-parallel loops over spans on a util::pool::Pool, instead of splitting spans into head and tail by hand
+ *
+ * parallelFor(data, grain, fn) calls fn for every element - or for sub-spans if fn takes a std::span -
+ * parallelTransform() writes fn(in[i]) to out[i] and parallelReduce() folds the elements into one value
+ *
+ * Load balancing is adaptive: the calling thread and up to pool.size() tasks grab chunks from a shared cursor,
+ * each chunk being a fraction of what's left (guided self-scheduling), so early chunks are big and cheap
+ * to hand out while the small ones at the end even out the differences between threads
+ * No chunk is smaller than 'grain' elements, except for the last one; grain 0 picks a size on its own
+ *
+ * Chunk boundaries fall on cache line boundaries of the span being written to so that no two threads write
+ * to the same cache line
+ *
+ * If fn throws, chunks not yet started are skipped and the 1st exception is rethrown to the caller
+ *
+ * Functions without a Pool argument run on defaultPool(), shared by the whole process
+ * Calling them from a task already running on the pool is fine: waiting there runs other pool tasks
+ */
+
+#include <util/pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util::parallel {
+    /** Pool with hardware_concurrency() threads created on first use */
+    pool::Pool& defaultPool();
+
+    namespace _detail {
+        constexpr std::size_t CACHE_LINE = 64;
+
+        /** Hands out [begin, end) chunks of an index range to the threads working on it */
+        class Partitioner {
+            alignas(CACHE_LINE) std::atomic<std::size_t> _next = 0;
+            std::atomic<bool> _cancelled = false;
+
+            std::size_t _size;
+            std::size_t _grain;
+            std::size_t _participants;
+
+            /* chunks start at _head + k * _line so that they begin on a cache line */
+            std::size_t _head;
+            std::size_t _line;
+
+            std::size_t alignUp(std::size_t index) const noexcept {
+                if (index <= _head) {
+                    return _head;
+                }
+                return _head + (index - _head + _line - 1) / _line * _line;
+            }
+        public:
+            Partitioner(std::size_t size, std::size_t grain, std::size_t participants, const void* data,
+                    std::size_t elementSize) noexcept: _size(size), _grain(grain), _participants(participants) {
+                _line = std::max<std::size_t>(1, CACHE_LINE / elementSize);
+                auto misalignment = reinterpret_cast<std::uintptr_t>(data) % CACHE_LINE;
+                _head = misalignment == 0 ? 0 : (CACHE_LINE - misalignment) / elementSize % _line;
+            }
+
+            /** Returns an empty chunk when there is nothing left */
+            std::pair<std::size_t, std::size_t> claim() noexcept {
+                auto begin = _next.load(std::memory_order_relaxed);
+                while (begin < _size && !_cancelled.load(std::memory_order_relaxed)) {
+                    auto remaining = _size - begin;
+                    auto end = alignUp(begin + std::max(_grain, remaining / (2 * _participants)));
+                    /* no crumbs at the end */
+                    if (end >= _size || _size - end < _grain) {
+                        end = _size;
+                    }
+                    if (_next.compare_exchange_weak(begin, end, std::memory_order_relaxed)) {
+                        return {begin, end};
+                    }
+                }
+                return {_size, _size};
+            }
+
+            void cancel() noexcept {
+                _cancelled.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        inline std::size_t chooseGrain(std::size_t size, std::size_t grain, std::size_t threads) {
+            if (grain != 0) {
+                return grain;
+            }
+            /* about 8 chunks per thread if each got the same; guided scheduling makes fewer */
+            return std::max<std::size_t>(1, size / (threads * 8));
+        }
+
+        /**
+         * Runs body(chunk, state) on the calling thread and on helper tasks until all chunks are done
+         * State is what each participant accumulates, e.g. a partial sum; all states are returned
+         * in no particular order
+         */
+        template <typename State, typename Body>
+        std::vector<State> run(pool::Pool& pool, std::size_t size, std::size_t grain, const void* data,
+                std::size_t elementSize, const State& init, Body& body) {
+            grain = chooseGrain(size, grain, pool.size() + 1);
+            auto chunks = (size + grain - 1) / grain;
+            auto helpers = std::min(pool.size(), chunks > 0 ? chunks - 1 : 0);
+
+            Partitioner partitioner{size, grain, helpers + 1, data, elementSize};
+            auto participate = [&partitioner, &body, &init] {
+                State state = init;
+                try {
+                    for (;;) {
+                        auto [begin, end] = partitioner.claim();
+                        if (begin == end) {
+                            break;
+                        }
+                        body(begin, end, state);
+                    }
+                } catch (...) {
+                    partitioner.cancel();
+                    throw;
+                }
+                return state;
+            };
+
+            std::vector<pool::Future<State>> futures;
+            futures.reserve(helpers);
+            for (std::size_t i = 0; i < helpers; ++i) {
+                futures.push_back(pool.submit(participate));
+            }
+
+            std::vector<State> states;
+            states.reserve(helpers + 1);
+            std::exception_ptr error;
+            try {
+                states.push_back(participate());
+            } catch (...) {
+                error = std::current_exception();
+            }
+            /* helpers refer to our locals so all of them have to finish before we can leave, even after an error */
+            for (auto& future: futures) {
+                try {
+                    states.push_back(future.get());
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return states;
+        }
+
+        /** States for loops that don't accumulate anything */
+        struct Nothing {};
+    }
+
+    /** fn(T&) for each element, or fn(std::span<T>) for each chunk */
+    template <typename T, typename F>
+        requires std::invocable<F&, std::span<T>> || std::invocable<F&, T&>
+    void parallelFor(pool::Pool& pool, std::span<T> data, std::size_t grain, F&& fn) {
+        auto body = [&data, &fn](std::size_t begin, std::size_t end, _detail::Nothing&) {
+            if constexpr (std::invocable<F&, std::span<T>>) {
+                fn(data.subspan(begin, end - begin));
+            } else {
+                for (auto i = begin; i != end; ++i) {
+                    fn(data[i]);
+                }
+            }
+        };
+        _detail::run(pool, data.size(), grain, data.data(), sizeof(T), _detail::Nothing{}, body);
+    }
+
+    template <typename T, typename F>
+        requires std::invocable<F&, std::span<T>> || std::invocable<F&, T&>
+    void parallelFor(std::span<T> data, std::size_t grain, F&& fn) {
+        parallelFor(defaultPool(), data, grain, std::forward<F>(fn));
+    }
+
+    /** out[i] = fn(in[i]); 'in' and 'out' have to be of the same size */
+    template <typename In, typename Out, typename F>
+        requires std::is_assignable_v<Out&, std::invoke_result_t<F&, In&>>
+    void parallelTransform(pool::Pool& pool, std::span<In> in, std::span<Out> out, std::size_t grain, F&& fn) {
+        if (in.size() != out.size()) {
+            throw std::invalid_argument("parallelTransform() input and output sizes differ");
+        }
+        auto body = [&in, &out, &fn](std::size_t begin, std::size_t end, _detail::Nothing&) {
+            for (auto i = begin; i != end; ++i) {
+                out[i] = fn(in[i]);
+            }
+        };
+        _detail::run(pool, in.size(), grain, out.data(), sizeof(Out), _detail::Nothing{}, body);
+    }
+
+    template <typename In, typename Out, typename F>
+        requires std::is_assignable_v<Out&, std::invoke_result_t<F&, In&>>
+    void parallelTransform(std::span<In> in, std::span<Out> out, std::size_t grain, F&& fn) {
+        parallelTransform(defaultPool(), in, out, grain, std::forward<F>(fn));
+    }
+
+    /**
+     * Folds elements with accumulate(R, T&) -> R starting from 'identity' in each thread, then folds
+     * the partial results with combine(R, R) -> R; like with std::reduce, elements and partial results
+     * are folded in no particular order so both have to be associative and commutative
+     */
+    template <typename T, typename R, typename Accumulate, typename Combine>
+        requires std::is_convertible_v<std::invoke_result_t<Accumulate&, R, T&>, R>
+            && std::is_convertible_v<std::invoke_result_t<Combine&, R, R>, R>
+    R parallelReduce(pool::Pool& pool, std::span<T> data, std::size_t grain, R identity, Accumulate&& accumulate,
+            Combine&& combine) {
+        auto body = [&data, &accumulate](std::size_t begin, std::size_t end, R& state) {
+            for (auto i = begin; i != end; ++i) {
+                state = accumulate(std::move(state), data[i]);
+            }
+        };
+        /* vector of the states rather than an array written to by all threads: no false sharing */
+        auto states = _detail::run(pool, data.size(), grain, data.data(), sizeof(T), identity, body);
+        /* there's always at least the calling thread's state */
+        auto result = std::move(states.front());
+        for (std::size_t i = 1; i < states.size(); ++i) {
+            result = combine(std::move(result), std::move(states[i]));
+        }
+        return result;
+    }
+
+    template <typename T, typename R, typename Accumulate, typename Combine>
+        requires std::is_convertible_v<std::invoke_result_t<Accumulate&, R, T&>, R>
+            && std::is_convertible_v<std::invoke_result_t<Combine&, R, R>, R>
+    R parallelReduce(std::span<T> data, std::size_t grain, R identity, Accumulate&& accumulate, Combine&& combine) {
+        return parallelReduce(defaultPool(), data, grain, std::move(identity), std::forward<Accumulate>(accumulate),
+                std::forward<Combine>(combine));
+    }
+
+    /** When one operation does for both, e.g. std::plus<>{} */
+    template <typename T, typename R, typename Op>
+        requires std::is_convertible_v<std::invoke_result_t<Op&, R, T&>, R>
+            && std::is_convertible_v<std::invoke_result_t<Op&, R, R>, R>
+    R parallelReduce(std::span<T> data, std::size_t grain, R identity, Op&& op) {
+        return parallelReduce(defaultPool(), data, grain, std::move(identity), op, op);
+    }
+}
@@ -0,0 +1,126 @@
+#include <util/pool.h>
+
+#include <string>
+
+#include <pthread.h>
+
+namespace {
+    /* lets submit() and Future::get() know if they're called on one of the pool threads, and on which one */
+    thread_local const util::pool::Pool* currentPool = nullptr;
+    thread_local std::size_t currentIndex = util::pool::Pool::npos;
+}
+
+namespace util::pool {
+    Pool::Pool(std::size_t threads) {
+        if (threads == 0) {
+            threads = 1; // hardware_concurrency() is allowed to return 0 if it doesn't know
+        }
+
+        /* all workers have to exist before any of them may start stealing */
+        _workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            _workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < threads; ++i) {
+            _workers[i]->thread = std::jthread([this, i](std::stop_token stopToken) { run(i, stopToken); });
+        }
+    }
+
+    Pool::~Pool() {
+        for (auto& worker: _workers) {
+            worker->thread.request_stop();
+        }
+        for (auto& worker: _workers) {
+            worker->thread.join();
+        }
+    }
+
+    std::size_t Pool::currentWorker() const noexcept {
+        return currentPool == this ? currentIndex : npos;
+    }
+
+    void Pool::enqueue(_detail::Job* job) {
+        auto index = currentWorker();
+        if (index != npos) {
+            _workers[index]->deque.push(job);
+        } else {
+            std::lock_guard lock{_injectedMutex};
+            _injected.push_back(job);
+            _injectedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify();
+    }
+
+    void Pool::notify() {
+        /* pairs with the sleeper incrementing _sleepers and then re-checking _signal, both seq_cst */
+        _signal.fetch_add(1, std::memory_order_seq_cst);
+        if (_sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard lock{_sleepMutex};
+            _wakeUp.notify_one();
+        }
+    }
+
+    _detail::Job* Pool::findJob(std::size_t index) {
+        if (auto job = _workers[index]->deque.pop()) {
+            return *job;
+        }
+
+        if (_injectedCount.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock{_injectedMutex};
+            if (!_injected.empty()) {
+                auto job = _injected.front();
+                _injected.pop_front();
+                _injectedCount.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        /* starting with the next worker rather than the 1st one so that thieves spread out */
+        for (std::size_t i = 1; i < _workers.size(); ++i) {
+            if (auto job = _workers[(index + i) % _workers.size()]->deque.steal()) {
+                return *job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Pool::_runPending() {
+        auto index = currentWorker();
+        if (index == npos) {
+            return false;
+        }
+        auto job = findJob(index);
+        if (!job) {
+            return false;
+        }
+        job->run();
+        return true;
+    }
+
+    void Pool::run(std::size_t index, std::stop_token stopToken) {
+        currentPool = this;
+        currentIndex = index;
+        /* shows up in top -H, gdb and traces */
+        pthread_setname_np(pthread_self(), ("pool-" + std::to_string(index)).c_str());
+
+        for (;;) {
+            auto signal = _signal.load(std::memory_order_seq_cst);
+            if (auto job = findJob(index)) {
+                job->run();
+                continue;
+            }
+
+            /* we only quit once there's nothing left to do so that no submitted task gets lost */
+            if (stopToken.stop_requested()) {
+                return;
+            }
+
+            std::unique_lock lock{_sleepMutex};
+            _sleepers.fetch_add(1, std::memory_order_seq_cst);
+            _wakeUp.wait(lock, stopToken, [this, signal] {
+                return _signal.load(std::memory_order_seq_cst) != signal;
+            });
+            _sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+}
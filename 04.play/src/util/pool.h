@@ -0,0 +1,322 @@
+#pragma once
+
+/**
+ * Work-stealing thread pool for fine-grained tasks; a replacement for std::async(std::launch::async, ...)
+ * which starts a brand new thread for every call
+ *
+ * Each worker owns a Chase-Lev deque: it pushes and pops tasks at the bottom (LIFO, good for locality
+ * when tasks spawn subtasks) while idle workers steal from the top (FIFO, oldest and likely largest tasks first)
+ * Tasks submitted from threads outside of the pool go into a shared mutex-protected queue
+ * Tasks run with the util::log::context of the thread which has submitted them
+ *
+ * submit() returns a Future; if the task throws, Future::get() rethrows the very same exception object
+ * so the stack trace boost::stacktrace has captured at the throw site can still be logged via util::log
+ *
+ * Calling Future::get() on a pool thread doesn't block the thread: it keeps running other tasks until
+ * the result is ready, so tasks may freely submit subtasks and wait for them
+ */
+
+#include <util/log/context.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace util::pool {
+    namespace _detail {
+        /**
+         * Chase-Lev work-stealing deque of pointers, following "Correct and Efficient Work-Stealing for Weak
+         * Memory Models" (Lê, Pop, Cohen, Zappa Nardelli)
+         *
+         * push() and pop() may only be called by the owner thread, steal() by anyone
+         * The paper's standalone fences are folded into seq_cst loads and stores: same cost on x86-64
+         * where the store in pop() becomes an xchg either way, and unlike fences TSan understands them
+         * The buffer grows as needed; old buffers are kept until the deque is destroyed since a thief may still be
+         * reading from them - the total is bounded by twice the largest buffer so this is fine
+         */
+        template <typename T>
+        class WorkDeque {
+            static_assert(std::is_pointer_v<T>, "elements have to fit into a lock-free atomic");
+
+            struct Buffer {
+                std::int64_t capacity;
+                std::unique_ptr<std::atomic<T>[]> slots;
+
+                explicit Buffer(std::int64_t capacity): capacity(capacity), slots(new std::atomic<T>[capacity]) {}
+
+                T get(std::int64_t i) const noexcept {
+                    return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+                }
+
+                void put(std::int64_t i, T value) noexcept {
+                    slots[i & (capacity - 1)].store(value, std::memory_order_relaxed);
+                }
+            };
+
+            /* top and bottom are on separate cache lines: thieves hammer the former, the owner the latter */
+            alignas(64) std::atomic<std::int64_t> _top = 0;
+            alignas(64) std::atomic<std::int64_t> _bottom = 0;
+            std::atomic<Buffer*> _buffer;
+            std::vector<std::unique_ptr<Buffer>> _buffers;
+
+            Buffer* grow(Buffer* old, std::int64_t top, std::int64_t bottom) {
+                auto bigger = std::make_unique<Buffer>(old->capacity * 2);
+                for (auto i = top; i != bottom; ++i) {
+                    bigger->put(i, old->get(i));
+                }
+                auto result = bigger.get();
+                _buffers.push_back(std::move(bigger));
+                _buffer.store(result, std::memory_order_release);
+                return result;
+            }
+        public:
+            explicit WorkDeque(std::int64_t capacity = 256) {
+                _buffers.push_back(std::make_unique<Buffer>(capacity));
+                _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+            }
+
+            WorkDeque(const WorkDeque&) = delete;
+            WorkDeque& operator=(const WorkDeque&) = delete;
+
+            void push(T value) {
+                auto bottom = _bottom.load(std::memory_order_relaxed);
+                auto top = _top.load(std::memory_order_acquire);
+                auto buffer = _buffer.load(std::memory_order_relaxed);
+                if (bottom - top > buffer->capacity - 1) {
+                    buffer = grow(buffer, top, bottom);
+                }
+                buffer->put(bottom, value);
+                _bottom.store(bottom + 1, std::memory_order_release);
+            }
+
+            std::optional<T> pop() {
+                auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+                auto buffer = _buffer.load(std::memory_order_relaxed);
+                _bottom.store(bottom, std::memory_order_seq_cst);
+                auto top = _top.load(std::memory_order_seq_cst);
+
+                if (top > bottom) {
+                    _bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return std::nullopt;
+                }
+
+                auto value = buffer->get(bottom);
+                if (top == bottom) {
+                    /* last element: race against thieves for it */
+                    bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                            std::memory_order_relaxed);
+                    _bottom.store(bottom + 1, std::memory_order_relaxed);
+                    if (!won) {
+                        return std::nullopt;
+                    }
+                }
+                return value;
+            }
+
+            std::optional<T> steal() {
+                auto top = _top.load(std::memory_order_seq_cst);
+                auto bottom = _bottom.load(std::memory_order_seq_cst);
+                if (top >= bottom) {
+                    return std::nullopt;
+                }
+
+                auto value = _buffer.load(std::memory_order_acquire)->get(top);
+                if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return std::nullopt;
+                }
+                return value;
+            }
+
+            /** Approximate, only good as a hint */
+            bool empty() const noexcept {
+                return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed);
+            }
+        };
+
+        /** Type-erased task; run() executes it and deletes it */
+        class Job {
+        public:
+            virtual void run() noexcept = 0;
+            virtual ~Job() = default;
+        };
+
+        template <typename T>
+        class SharedState {
+            std::atomic<bool> _ready = false;
+            std::variant<std::monostate, std::conditional_t<std::is_void_v<T>, std::monostate, T>, std::exception_ptr> _result;
+        public:
+            template <typename F>
+            void complete(F& f) noexcept {
+                try {
+                    if constexpr (std::is_void_v<T>) {
+                        std::invoke(f);
+                        _result.template emplace<1>();
+                    } else {
+                        _result.template emplace<1>(std::invoke(f));
+                    }
+                } catch (...) {
+                    _result.template emplace<2>(std::current_exception());
+                }
+                _ready.store(true, std::memory_order_release);
+                _ready.notify_all();
+            }
+
+            bool isReady() const noexcept {
+                return _ready.load(std::memory_order_acquire);
+            }
+
+            void wait() const noexcept {
+                _ready.wait(false, std::memory_order_acquire);
+            }
+
+            T take() {
+                if (_result.index() == 2) {
+                    std::rethrow_exception(std::get<2>(_result));
+                }
+                if constexpr (!std::is_void_v<T>) {
+                    return std::move(std::get<1>(_result));
+                }
+            }
+        };
+
+        /** Runs the function with the log context of the thread which has submitted it */
+        template <typename F, typename T>
+        class FunctionJob: public Job {
+            F _f;
+            std::shared_ptr<SharedState<T>> _state;
+            std::unique_ptr<util::log::context::Context> _context;
+        public:
+            FunctionJob(F&& f, std::shared_ptr<SharedState<T>> state): _f(std::move(f)), _state(std::move(state)),
+                    _context(util::log::context::capture()) {}
+
+            void run() noexcept override {
+                {
+                    util::log::context::Adopt adopt{_context.get()};
+                    _state->complete(_f);
+                }
+                delete this;
+            }
+        };
+    }
+
+    class Pool;
+
+    /**
+     * Result of a task submitted to the Pool; get() can only be called once, like with std::future
+     *
+     * Dropping a Future doesn't cancel or wait for the task, it simply runs to completion unobserved
+     */
+    template <typename T>
+    class Future {
+        friend class Pool;
+
+        std::shared_ptr<_detail::SharedState<T>> _state;
+        Pool* _pool = nullptr;
+
+        Future(std::shared_ptr<_detail::SharedState<T>> state, Pool& pool): _state(std::move(state)), _pool(&pool) {}
+    public:
+        Future() = default;
+
+        bool valid() const noexcept {
+            return _state != nullptr;
+        }
+
+        bool isReady() const {
+            return checked().isReady();
+        }
+
+        /** On a pool thread runs other tasks while waiting, elsewhere blocks */
+        void wait() const;
+
+        /** Waits for the result; rethrows the exception if the task has thrown one */
+        T get() {
+            wait();
+            auto state = std::move(_state);
+            return state->take();
+        }
+    private:
+        _detail::SharedState<T>& checked() const {
+            if (!_state) {
+                throw std::logic_error("Future has no state, get() already called or default-constructed");
+            }
+            return *_state;
+        }
+    };
+
+    class Pool {
+        struct Worker {
+            _detail::WorkDeque<_detail::Job*> deque;
+            std::jthread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> _workers;
+
+        /* tasks submitted from outside of the pool */
+        std::mutex _injectedMutex;
+        std::deque<_detail::Job*> _injected;
+        std::atomic<std::size_t> _injectedCount = 0;
+
+        /* idle workers sleep on the condvar; _signal changes every time new work appears */
+        std::mutex _sleepMutex;
+        std::condition_variable_any _wakeUp;
+        std::atomic<std::uint64_t> _signal = 0;
+        std::atomic<std::size_t> _sleepers = 0;
+
+        void run(std::size_t index, std::stop_token stopToken);
+        void enqueue(_detail::Job* job);
+        void notify();
+        _detail::Job* findJob(std::size_t index);
+
+        /** Index of the calling thread among our workers or npos if it is not one of ours */
+        std::size_t currentWorker() const noexcept;
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        explicit Pool(std::size_t threads = std::thread::hardware_concurrency());
+
+        /** Waits for all tasks already submitted, including ones they submit in turn, and then joins the threads */
+        ~Pool();
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        std::size_t size() const noexcept {
+            return _workers.size();
+        }
+
+        template <typename F>
+        auto submit(F&& f) -> Future<std::invoke_result_t<std::decay_t<F>&>> {
+            using T = std::invoke_result_t<std::decay_t<F>&>;
+            auto state = std::make_shared<_detail::SharedState<T>>();
+            enqueue(new _detail::FunctionJob<std::decay_t<F>, T>(std::decay_t<F>(std::forward<F>(f)), state));
+            return Future<T>{std::move(state), *this};
+        }
+
+        /** Runs one pending task on the calling pool thread; returns false if there was nothing to run */
+        bool _runPending();
+    };
+
+    template <typename T>
+    void Future<T>::wait() const {
+        auto& state = checked();
+        while (!state.isReady()) {
+            if (!_pool->_runPending()) {
+                state.wait();
+                return;
+            }
+        }
+    }
+}
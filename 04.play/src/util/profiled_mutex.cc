@@ -0,0 +1,237 @@
+#include <util/profiled_mutex.h>
+#include <util/log.h>
+#include <util/shards.h>
+
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <tuple>
+
+namespace util::profiled_mutex {
+    struct report_log{};
+
+    namespace _detail {
+        /** Counters of the threads sharing one slot; only they write to it, so its cache line stays with them */
+        struct alignas(64) Shard {
+            std::atomic<std::uint64_t> acquisitions = 0;
+            std::atomic<std::uint64_t> contended = 0;
+            std::atomic<std::uint64_t> totalWait = 0;
+            std::atomic<std::uint64_t> totalHold = 0;
+            std::atomic<std::uint64_t> maxWait = 0;
+            std::array<std::atomic<std::uint64_t>, BUCKETS> waits{};
+            std::array<std::atomic<std::uint64_t>, BUCKETS> holds{};
+        };
+
+        struct Site {
+            std::string name;
+            std::string location;
+            std::string function;
+            util::shards::Sharded<Shard> shards;
+        };
+    }
+}
+
+namespace {
+    using util::profiled_mutex::BUCKETS;
+    using util::profiled_mutex::_detail::Shard;
+    using util::profiled_mutex::_detail::Site;
+
+    /**
+     * Sites live as long as the program does so that mutexes may keep raw pointers to them
+     * There are as many of them as there are places constructing mutexes in the source code so this is bounded
+     */
+    struct Registry {
+        std::mutex mutex;
+        std::map<std::tuple<std::string, std::uint_least32_t, std::string>, std::unique_ptr<Site>> sites;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    Site* findSite(std::string_view name, const std::source_location& where) {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        auto& site = reg.sites[{where.file_name(), where.line(), std::string{name}}];
+        if (!site) {
+            site = std::make_unique<Site>();
+            site->name = name;
+            site->location = std::string{where.file_name()} + ":" + std::to_string(where.line());
+            site->function = where.function_name();
+        }
+        return site.get();
+    }
+
+    std::uint64_t nanos(std::chrono::steady_clock::duration d) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    void record(std::array<std::atomic<std::uint64_t>, BUCKETS>& histogram, std::uint64_t ns) noexcept {
+        auto bucket = std::min<std::size_t>(std::bit_width(ns), BUCKETS - 1);
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add(util::profiled_mutex::Histogram& to, const std::array<std::atomic<std::uint64_t>, BUCKETS>& histogram) {
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            to[i] += histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t load(const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    util::profiled_mutex::SiteStats merge(const Site& site) {
+        util::profiled_mutex::SiteStats stats{.name = site.name, .location = site.location, .function = site.function};
+        site.shards.forEach([&stats](const Shard& shard) {
+            stats.acquisitions += load(shard.acquisitions);
+            stats.contended += load(shard.contended);
+            stats.totalWait += std::chrono::nanoseconds{load(shard.totalWait)};
+            stats.totalHold += std::chrono::nanoseconds{load(shard.totalHold)};
+            stats.maxWait = std::max(stats.maxWait, std::chrono::nanoseconds{load(shard.maxWait)});
+            add(stats.waits, shard.waits);
+            add(stats.holds, shard.holds);
+        });
+        return stats;
+    }
+
+    template <typename Duration>
+    double toMicros(Duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+}
+
+namespace util::profiled_mutex {
+    ProfiledMutex::ProfiledMutex(std::source_location where): _site(findSite({}, where)) {}
+
+    ProfiledMutex::ProfiledMutex(std::string_view name, std::source_location where): _site(findSite(name, where)) {}
+
+    void ProfiledMutex::lock() {
+        auto start = std::chrono::steady_clock::now();
+        if (_mutex.try_lock()) {
+            acquired(start, false);
+            return;
+        }
+        _mutex.lock();
+        acquired(start, true);
+    }
+
+    bool ProfiledMutex::try_lock() noexcept {
+        auto start = std::chrono::steady_clock::now();
+        if (!_mutex.try_lock()) {
+            return false;
+        }
+        acquired(start, false);
+        return true;
+    }
+
+    void ProfiledMutex::acquired(std::chrono::steady_clock::time_point start, bool contended) noexcept {
+        _lockedAt = std::chrono::steady_clock::now();
+        auto shard = _site->shards.local();
+        if (!shard) {
+            return;
+        }
+        shard->acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (contended) {
+            auto wait = nanos(_lockedAt - start);
+            shard->contended.fetch_add(1, std::memory_order_relaxed);
+            shard->totalWait.fetch_add(wait, std::memory_order_relaxed);
+            record(shard->waits, wait);
+
+            auto max = shard->maxWait.load(std::memory_order_relaxed);
+            while (wait > max && !shard->maxWait.compare_exchange_weak(max, wait, std::memory_order_relaxed)) {}
+        } else {
+            shard->waits[0].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void ProfiledMutex::unlock() noexcept {
+        /* reading _lockedAt while still holding the lock, it's only ever written by the owner */
+        auto hold = nanos(std::chrono::steady_clock::now() - _lockedAt);
+        _mutex.unlock();
+        if (auto shard = _site->shards.local()) {
+            shard->totalHold.fetch_add(hold, std::memory_order_relaxed);
+            record(shard->holds, hold);
+        }
+    }
+
+    std::chrono::nanoseconds quantile(const Histogram& histogram, double q) {
+        std::uint64_t total = 0;
+        for (auto count: histogram) {
+            total += count;
+        }
+        if (total == 0) {
+            return std::chrono::nanoseconds{0};
+        }
+
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += histogram[i];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds{i == 0 ? 0 : (std::int64_t{1} << i) - 1};
+            }
+        }
+        return std::chrono::nanoseconds{(std::int64_t{1} << (BUCKETS - 1)) - 1};
+    }
+
+    std::vector<SiteStats> snapshot() {
+        std::vector<SiteStats> result;
+        auto& reg = registry();
+        {
+            std::lock_guard lock{reg.mutex};
+            for (auto& [key, site]: reg.sites) {
+                auto stats = merge(*site);
+                if (stats.acquisitions > 0) {
+                    result.push_back(std::move(stats));
+                }
+            }
+        }
+        std::ranges::sort(result, std::ranges::greater{}, &SiteStats::totalWait);
+        return result;
+    }
+
+    void reset() {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        for (auto& [key, site]: reg.sites) {
+            site->shards.forEach([](Shard& shard) {
+                for (auto counter: {&shard.acquisitions, &shard.contended, &shard.totalWait, &shard.totalHold,
+                        &shard.maxWait}) {
+                    counter->store(0, std::memory_order_relaxed);
+                }
+                for (std::size_t i = 0; i < BUCKETS; ++i) {
+                    shard.waits[i].store(0, std::memory_order_relaxed);
+                    shard.holds[i].store(0, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    void report(std::size_t top) {
+        auto& logger = util::log::getLogger<report_log>();
+        auto stats = snapshot();
+        std::erase_if(stats, [](const SiteStats& site) { return site.contended == 0; });
+        if (stats.empty()) {
+            logger.info("No lock contention");
+            return;
+        }
+
+        stats.resize(std::min(stats.size(), top));
+        for (auto& site: stats) {
+            logger.info("{} {} in {}: {} acquisitions, {} contended ({:.1f}%), waited {:.1f}us total, "
+                    "p50/p99/max wait {:.1f}/{:.1f}/{:.1f}us, p50/p99 hold {:.1f}/{:.1f}us",
+                    site.name.empty() ? "lock" : site.name, site.location, site.function,
+                    site.acquisitions, site.contended, 100.0 * site.contended / site.acquisitions,
+                    toMicros(site.totalWait),
+                    toMicros(quantile(site.waits, 0.5)), toMicros(quantile(site.waits, 0.99)), toMicros(site.maxWait),
+                    toMicros(quantile(site.holds, 0.5)), toMicros(quantile(site.holds, 0.99)));
+        }
+    }
+
+    std::unique_ptr<util::worker::PeriodicWorker> reportPeriodically(std::chrono::steady_clock::duration period,
+            std::size_t top) {
+        return std::make_unique<util::worker::PeriodicWorker>("lock-report", period, [top] { report(top); });
+    }
+}
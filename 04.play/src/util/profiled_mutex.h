@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * Drop-in replacement for std::mutex which keeps track of how contended it is
+ *
+ * Statistics are kept per site rather than per mutex instance: a site is the place in the source code where
+ * the mutex gets constructed, so e.g. a mutex member of a class that has thousands of instances is still
+ * reported as one lock; for a data member the site is the constructor of the enclosing class
+ * A name can be given explicitly to make reports easier to read
+ *
+ * For each site we count acquisitions, how many of them had to wait, and keep log2 histograms of time
+ * spent waiting for the lock and holding it; the counters are relaxed atomics sharded per thread with util::shards,
+ * so threads taking the same lock don't also fight over the cache line with its statistics, and snapshot() adds
+ * the shards up
+ * An uncontended lock()/unlock() pair costs a try_lock(), three steady_clock reads and a handful of relaxed
+ * increments of the calling thread's shard on top of std::mutex
+ *
+ * report() logs the hottest sites via util::log, reportPeriodically() does that on a background worker
+ */
+
+#include <util/worker.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::profiled_mutex {
+    /** Bucket i counts durations d with bit_width(d in nanoseconds) == i, i.e. from 2^(i-1) to 2^i - 1 ns */
+    constexpr std::size_t BUCKETS = 48;
+
+    using Histogram = std::array<std::uint64_t, BUCKETS>;
+
+    namespace _detail {
+        struct Site;
+    }
+
+    /** Point-in-time copy of the statistics of one site */
+    struct SiteStats {
+        std::string name;
+        std::string location;   // file:line
+        std::string function;
+        std::uint64_t acquisitions = 0;
+        std::uint64_t contended = 0;
+        std::chrono::nanoseconds totalWait{0};
+        std::chrono::nanoseconds totalHold{0};
+        std::chrono::nanoseconds maxWait{0};
+        Histogram waits{};
+        Histogram holds{};
+    };
+
+    /** Upper bound of the bucket containing the given quantile, 0 if there is no data */
+    std::chrono::nanoseconds quantile(const Histogram& histogram, double q);
+
+    class ProfiledMutex {
+        std::mutex _mutex;
+        _detail::Site* _site;
+        std::chrono::steady_clock::time_point _lockedAt;
+
+        void acquired(std::chrono::steady_clock::time_point start, bool contended) noexcept;
+    public:
+        explicit ProfiledMutex(std::source_location where = std::source_location::current());
+        explicit ProfiledMutex(std::string_view name, std::source_location where = std::source_location::current());
+
+        ProfiledMutex(const ProfiledMutex&) = delete;
+        ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+        void lock();
+        bool try_lock() noexcept;
+        void unlock() noexcept;
+    };
+
+    /** Statistics of all sites that have been used at least once, hottest first: sorted by total wait time */
+    std::vector<SiteStats> snapshot();
+
+    /** Zeroes all counters, e.g. to only see what's been happening since the last report */
+    void reset();
+
+    /** Logs 'top' hottest sites at INFO level; sites that have never been contended are left out */
+    void report(std::size_t top = 10);
+
+    /** Calls report() every 'period' until the returned worker is destroyed */
+    std::unique_ptr<util::worker::PeriodicWorker> reportPeriodically(std::chrono::steady_clock::duration period,
+            std::size_t top = 10);
+}
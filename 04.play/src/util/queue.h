@@ -0,0 +1,487 @@
+#pragma once
+
+/**
+ * Bounded lock-free queues for handing data between threads
+ *
+ * SpscQueue is a ring buffer for exactly one producer and one consumer thread; each side keeps
+ * a cached copy of the other side's index so that most operations don't touch the other side's cache line
+ *
+ * MpmcQueue is Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence number telling
+ * producers and consumers which lap of the ring it's ready for, so a push or a pop is one CAS on
+ * the shared index plus a store to the cell
+ *
+ * Both have batch versions of push and pop; for MpmcQueue a batch claims all of its cells with a single CAS
+ *
+ * tryPush() only moves from its argument if it succeeds, so a failed push can be retried with the same value
+ *
+ * BlockingQueue wraps either of them to wait for space or data; waiting can be interrupted via std::stop_token
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace util::queue {
+    /**
+     * Not std::hardware_destructive_interference_size: gcc warns about using it in headers as its value
+     * depends on -mtune; 64 is right for x86_64 and most arm64 chips
+     */
+    constexpr std::size_t CACHE_LINE = 64;
+
+    namespace _detail {
+        inline std::size_t roundUpCapacity(std::size_t capacity) {
+            if (capacity == 0 || capacity > (std::size_t{1} << (sizeof(std::size_t) * 8 - 2))) {
+                throw std::invalid_argument("Queue capacity must be positive and sane");
+            }
+            return std::bit_ceil(capacity);
+        }
+
+        /** Raw storage for a T that we construct and destroy by hand */
+        template <typename T>
+        struct alignas(T) Storage {
+            std::byte bytes[sizeof(T)];
+
+            T* get() noexcept {
+                return std::launder(reinterpret_cast<T*>(bytes));
+            }
+
+            template <typename... Args>
+            void construct(Args&&... args) {
+                new (bytes) T(std::forward<Args>(args)...);
+            }
+
+            /** Moves the value out and destroys it */
+            T take() noexcept {
+                T* value = get();
+                T result(std::move(*value));
+                value->~T();
+                return result;
+            }
+        };
+
+        /**
+         * Lets blocked threads sleep until something happens without making the non-blocking path take a lock
+         *
+         * A waiter registers itself, re-checks the queue and only then sleeps until the epoch changes;
+         * a notifier does an RMW on the same word after changing the queue: the RMWs are totally ordered,
+         * so either the waiter's re-check sees the change or the notifier sees the waiter and bumps the epoch
+         */
+        class EventCount {
+            static constexpr std::uint32_t WAITER = 1;
+            static constexpr std::uint32_t WAITERS = (1u << 16) - 1;
+            static constexpr std::uint32_t EPOCH = 1u << 16;
+
+            std::atomic<std::uint32_t> _state = 0;
+
+            void wakeAll() noexcept {
+                _state.fetch_add(EPOCH, std::memory_order_release);
+                _state.notify_all();
+            }
+        public:
+            void notify() noexcept {
+                if ((_state.fetch_add(0, std::memory_order_acq_rel) & WAITERS) != 0) {
+                    wakeAll();
+                }
+            }
+
+            /** Returns the key to pass to wait() or cancelWait() after re-checking the condition */
+            std::uint32_t prepareWait() noexcept {
+                return _state.fetch_add(WAITER, std::memory_order_acq_rel) + WAITER;
+            }
+
+            void cancelWait() noexcept {
+                _state.fetch_sub(WAITER, std::memory_order_relaxed);
+            }
+
+            /** Sleeps until somebody calls notify() after prepareWait() returned 'key' or until stop is requested */
+            void wait(std::uint32_t key, std::stop_token stopToken) {
+                std::stop_callback onStop{stopToken, [this] { wakeAll(); }};
+                for (auto state = _state.load(std::memory_order_acquire);
+                        (state & ~WAITERS) == (key & ~WAITERS) && !stopToken.stop_requested();
+                        state = _state.load(std::memory_order_acquire)) {
+                    _state.wait(state, std::memory_order_acquire);
+                }
+                cancelWait();
+            }
+        };
+    }
+
+    template <typename T>
+    class SpscQueue {
+        using Storage = _detail::Storage<T>;
+
+        const std::size_t _mask;
+        const std::unique_ptr<Storage[]> _cells;
+
+        /* consumer's side */
+        alignas(CACHE_LINE) std::atomic<std::size_t> _head = 0;
+        std::size_t _cachedTail = 0;
+
+        /* producer's side */
+        alignas(CACHE_LINE) std::atomic<std::size_t> _tail = 0;
+        std::size_t _cachedHead = 0;
+
+        /** Free cells for the producer, refreshing its copy of _head only when that shows fewer than 'wanted' */
+        std::size_t freeCells(std::size_t tail, std::size_t wanted) noexcept {
+            if (_mask + 1 - (tail - _cachedHead) < wanted) {
+                _cachedHead = _head.load(std::memory_order_acquire);
+            }
+            return _mask + 1 - (tail - _cachedHead);
+        }
+
+        std::size_t readyCells(std::size_t head, std::size_t wanted) noexcept {
+            if (_cachedTail - head < wanted) {
+                _cachedTail = _tail.load(std::memory_order_acquire);
+            }
+            return _cachedTail - head;
+        }
+    public:
+        using value_type = T;
+
+        /** Capacity gets rounded up to a power of 2 */
+        explicit SpscQueue(std::size_t capacity): _mask(_detail::roundUpCapacity(capacity) - 1),
+                _cells(std::make_unique_for_overwrite<Storage[]>(_mask + 1)) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        ~SpscQueue() {
+            for (auto i = _head.load(std::memory_order_relaxed); i != _tail.load(std::memory_order_relaxed); ++i) {
+                _cells[i & _mask].get()->~T();
+            }
+        }
+
+        template <typename... Args>
+        bool tryEmplace(Args&&... args) {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            if (freeCells(tail, 1) == 0) {
+                return false;
+            }
+            _cells[tail & _mask].construct(std::forward<Args>(args)...);
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPush(const T& value) {
+            return tryEmplace(value);
+        }
+
+        bool tryPush(T&& value) {
+            return tryEmplace(std::move(value));
+        }
+
+        std::optional<T> tryPop() {
+            auto head = _head.load(std::memory_order_relaxed);
+            if (readyCells(head, 1) == 0) {
+                return std::nullopt;
+            }
+            std::optional<T> result{_cells[head & _mask].take()};
+            _head.store(head + 1, std::memory_order_release);
+            return result;
+        }
+
+        /** Moves as many items as fit from the front of 'items', returns how many that was */
+        std::size_t tryPushBatch(std::span<T> items) {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            auto count = std::min(items.size(), freeCells(tail, items.size()));
+            for (std::size_t i = 0; i < count; ++i) {
+                _cells[(tail + i) & _mask].construct(std::move(items[i]));
+            }
+            _tail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        /** Pops up to 'max' items into 'out', returns how many */
+        template <std::output_iterator<T> Out>
+        std::size_t tryPopBatch(Out out, std::size_t max) {
+            auto head = _head.load(std::memory_order_relaxed);
+            auto count = std::min(max, readyCells(head, max));
+            for (std::size_t i = 0; i < count; ++i) {
+                *out++ = _cells[(head + i) & _mask].take();
+            }
+            _head.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        std::size_t capacity() const noexcept {
+            return _mask + 1;
+        }
+
+        /** Exact when called from the producer or the consumer while the other side is idle */
+        std::size_t sizeApprox() const noexcept {
+            /* in this order so that we never see _head ahead of _tail */
+            auto head = _head.load(std::memory_order_acquire);
+            return _tail.load(std::memory_order_acquire) - head;
+        }
+    };
+
+    template <typename T>
+    class MpmcQueue {
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            _detail::Storage<T> storage;
+        };
+
+        const std::size_t _mask;
+        const std::unique_ptr<Cell[]> _cells;
+
+        alignas(CACHE_LINE) std::atomic<std::size_t> _enqueuePos = 0;
+        alignas(CACHE_LINE) std::atomic<std::size_t> _dequeuePos = 0;
+
+        /**
+         * Claims up to 'max' consecutive cells for which the sequence equals position + 'lag':
+         * lag 0 means free cells for producers, 1 means filled cells for consumers
+         *
+         * A cell's sequence only moves forward and only the owner of its position moves it,
+         * so cells checked before a successful CAS on 'pos' are still ready after it
+         */
+        std::pair<std::size_t, std::size_t> claim(std::atomic<std::size_t>& pos, std::size_t lag, std::size_t max) {
+            auto start = pos.load(std::memory_order_relaxed);
+            for (;;) {
+                std::size_t count = 0;
+                while (count < max) {
+                    auto& cell = _cells[(start + count) & _mask];
+                    auto diff = static_cast<std::ptrdiff_t>(cell.sequence.load(std::memory_order_acquire)
+                            - (start + count + lag));
+                    if (diff != 0) {
+                        if (diff > 0 && count == 0) {
+                            /* somebody got this position before us, catch up */
+                            start = pos.load(std::memory_order_relaxed);
+                            continue;
+                        }
+                        break;
+                    }
+                    ++count;
+                }
+                if (count == 0) {
+                    return {start, 0}; // full or empty
+                }
+                if (pos.compare_exchange_weak(start, start + count, std::memory_order_relaxed)) {
+                    return {start, count};
+                }
+            }
+        }
+    public:
+        using value_type = T;
+
+        /**
+         * Capacity gets rounded up to a power of 2 and to at least 2: with a single cell
+         * the sequence of a filled cell would look the same as that of a free cell on the next lap
+         */
+        explicit MpmcQueue(std::size_t capacity):
+                _mask(std::max<std::size_t>(_detail::roundUpCapacity(capacity), 2) - 1),
+                _cells(std::make_unique<Cell[]>(_mask + 1)) {
+            for (std::size_t i = 0; i <= _mask; ++i) {
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        ~MpmcQueue() {
+            auto end = _enqueuePos.load(std::memory_order_relaxed);
+            for (auto i = _dequeuePos.load(std::memory_order_relaxed); i != end; ++i) {
+                _cells[i & _mask].storage.get()->~T();
+            }
+        }
+
+        template <typename... Args>
+        bool tryEmplace(Args&&... args) {
+            auto [pos, count] = claim(_enqueuePos, 0, 1);
+            if (count == 0) {
+                return false;
+            }
+            auto& cell = _cells[pos & _mask];
+            cell.storage.construct(std::forward<Args>(args)...);
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPush(const T& value) {
+            return tryEmplace(value);
+        }
+
+        bool tryPush(T&& value) {
+            return tryEmplace(std::move(value));
+        }
+
+        std::optional<T> tryPop() {
+            auto [pos, count] = claim(_dequeuePos, 1, 1);
+            if (count == 0) {
+                return std::nullopt;
+            }
+            auto& cell = _cells[pos & _mask];
+            std::optional<T> result{cell.storage.take()};
+            cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+            return result;
+        }
+
+        /** Moves as many items as there are consecutive free cells from the front of 'items', returns how many */
+        std::size_t tryPushBatch(std::span<T> items) {
+            auto [pos, count] = claim(_enqueuePos, 0, items.size());
+            for (std::size_t i = 0; i < count; ++i) {
+                auto& cell = _cells[(pos + i) & _mask];
+                cell.storage.construct(std::move(items[i]));
+                cell.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            return count;
+        }
+
+        /** Pops up to 'max' items into 'out', returns how many */
+        template <std::output_iterator<T> Out>
+        std::size_t tryPopBatch(Out out, std::size_t max) {
+            auto [pos, count] = claim(_dequeuePos, 1, max);
+            for (std::size_t i = 0; i < count; ++i) {
+                auto& cell = _cells[(pos + i) & _mask];
+                *out++ = cell.storage.take();
+                cell.sequence.store(pos + i + _mask + 1, std::memory_order_release);
+            }
+            return count;
+        }
+
+        std::size_t capacity() const noexcept {
+            return _mask + 1;
+        }
+
+        /** May be off while pushes and pops are in flight */
+        std::size_t sizeApprox() const noexcept {
+            auto head = _dequeuePos.load(std::memory_order_acquire);
+            auto tail = _enqueuePos.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+    };
+
+    /**
+     * Adds waiting to SpscQueue or MpmcQueue; the non-blocking tryXxx() methods of the queue remain available
+     * via queue() but pushing that way won't wake up blocked consumers and vice versa
+     *
+     * Each operation pays for an extra RMW on a shared word to check for sleeping threads, so prefer
+     * the batch methods when throughput matters
+     *
+     * Blocking methods return early when stop is requested via the std::stop_token they are given:
+     * push() returns false leaving its argument alone, pop() returns std::nullopt
+     */
+    template <typename Queue>
+    class BlockingQueue {
+        using T = typename Queue::value_type;
+
+        Queue _queue;
+        _detail::EventCount _notEmpty;
+        _detail::EventCount _notFull;
+
+        /** Attempts made yielding the CPU in between before going to sleep; the other side is often just about done */
+        static constexpr int YIELDS = 16;
+
+        /** Calls 'attempt' until it returns a truthy value or stop is requested, sleeping on 'event' in between */
+        template <typename Attempt>
+        auto await(_detail::EventCount& event, std::stop_token& stopToken, Attempt&& attempt)
+                -> decltype(attempt()) {
+            for (int yields = 0;; ++yields) {
+                if (auto result = attempt()) {
+                    return result;
+                }
+                if (stopToken.stop_requested()) {
+                    return {};
+                }
+                if (yields < YIELDS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                auto key = event.prepareWait();
+                if (auto result = attempt()) {
+                    event.cancelWait();
+                    return result;
+                }
+                event.wait(key, stopToken);
+            }
+        }
+    public:
+        using value_type = T;
+
+        explicit BlockingQueue(std::size_t capacity): _queue(capacity) {}
+
+        Queue& queue() noexcept {
+            return _queue;
+        }
+
+        bool tryPush(T&& value) {
+            if (!_queue.tryPush(std::move(value))) {
+                return false;
+            }
+            _notEmpty.notify();
+            return true;
+        }
+
+        std::optional<T> tryPop() {
+            auto result = _queue.tryPop();
+            if (result) {
+                _notFull.notify();
+            }
+            return result;
+        }
+
+        bool push(T&& value, std::stop_token stopToken = {}) {
+            bool pushed = await(_notFull, stopToken, [&] { return _queue.tryPush(std::move(value)); });
+            if (pushed) {
+                _notEmpty.notify();
+            }
+            return pushed;
+        }
+
+        bool push(const T& value, std::stop_token stopToken = {}) {
+            T copy{value};
+            return push(std::move(copy), std::move(stopToken));
+        }
+
+        std::optional<T> pop(std::stop_token stopToken = {}) {
+            auto result = await(_notEmpty, stopToken, [&] { return _queue.tryPop(); });
+            if (result) {
+                _notFull.notify();
+            }
+            return result;
+        }
+
+        /** Pushes all of 'items' waiting for space as needed; returns how many were pushed before stop got requested */
+        std::size_t pushBatch(std::span<T> items, std::stop_token stopToken = {}) {
+            std::size_t pushed = 0;
+            while (pushed < items.size()) {
+                auto count = await(_notFull, stopToken, [&] { return _queue.tryPushBatch(items.subspan(pushed)); });
+                if (count == 0) {
+                    break;
+                }
+                pushed += count;
+                _notEmpty.notify();
+            }
+            return pushed;
+        }
+
+        /** Waits for at least one item and pops up to 'max'; returns 0 only if stop has been requested */
+        template <std::output_iterator<T> Out>
+        std::size_t popBatch(Out out, std::size_t max, std::stop_token stopToken = {}) {
+            auto count = await(_notEmpty, stopToken, [&] { return _queue.tryPopBatch(out, max); });
+            if (count != 0) {
+                _notFull.notify();
+            }
+            return count;
+        }
+    };
+
+    template <typename T>
+    using BlockingSpscQueue = BlockingQueue<SpscQueue<T>>;
+
+    template <typename T>
+    using BlockingMpmcQueue = BlockingQueue<MpmcQueue<T>>;
+}
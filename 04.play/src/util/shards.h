@@ -0,0 +1,133 @@
+#pragma once
+
+/**
+ * Per-thread shards of counters which many threads bump all the time, so that they don't fight over one cache line
+ *
+ *     struct alignas(64) Counters { std::atomic<std::uint64_t> hits = 0; };
+ *     util::shards::Sharded<Counters> counters;
+ *     if (auto shard = counters.local()) shard->hits.fetch_add(1, std::memory_order_relaxed);
+ *     std::uint64_t hits = 0;
+ *     counters.forEach([&](const Counters& shard) { hits += shard.hits.load(std::memory_order_relaxed); });
+ *
+ * Every thread gets a slot, the same in all Sharded objects, and gives it back when it exits for a new thread
+ * to take over; beyond MAX_SHARDS threads they share slots, so shard fields still need to be atomics
+ * A shard is allocated the first time a thread uses the Sharded object and lives as long as the object does
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace util::shards {
+    /** Threads with shards of their own; more threads than that share them */
+    constexpr std::size_t MAX_SHARDS = 64;
+
+    namespace _detail {
+        constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+        struct Slots {
+            std::mutex mutex;
+            /* slots of threads which have exited, for new threads to take over */
+            std::vector<std::size_t> free;
+            std::size_t next = 0;
+
+            Slots() {
+                free.reserve(MAX_SHARDS);
+            }
+        };
+
+        inline Slots& slots() {
+            static Slots instance;
+            return instance;
+        }
+
+        /* a plain constant-initialized thread_local so that reading it is cheap */
+        inline thread_local std::size_t currentSlot = NO_SLOT;
+
+        /** Gives the slot back when the thread exits */
+        struct SlotOwner {
+            std::size_t slot = NO_SLOT;
+
+            ~SlotOwner() {
+                if (slot != NO_SLOT) {
+                    auto& s = slots();
+                    std::lock_guard lock{s.mutex};
+                    s.free.push_back(slot);
+                }
+            }
+        };
+
+        inline thread_local SlotOwner slotOwner;
+
+        inline std::size_t takeSlot() noexcept {
+            auto& s = slots();
+            std::lock_guard lock{s.mutex};
+            if (!s.free.empty()) {
+                currentSlot = slotOwner.slot = s.free.back();
+                s.free.pop_back();
+            } else if (s.next < MAX_SHARDS) {
+                currentSlot = slotOwner.slot = s.next++;
+            } else {
+                /* all taken: share one, never to be given back */
+                currentSlot = s.next++ % MAX_SHARDS;
+            }
+            return currentSlot;
+        }
+    }
+
+    /** Index of the calling thread's shard */
+    inline std::size_t slot() noexcept {
+        auto slot = _detail::currentSlot;
+        return slot != _detail::NO_SLOT ? slot : _detail::takeSlot();
+    }
+
+    template <typename Shard>
+    class Sharded {
+        std::array<std::atomic<Shard*>, MAX_SHARDS> _shards{};
+
+        Shard* add(std::size_t slot) noexcept {
+            auto shard = new (std::nothrow) Shard;
+            if (!shard) {
+                return nullptr;
+            }
+            Shard* expected = nullptr;
+            if (!_shards[slot].compare_exchange_strong(expected, shard, std::memory_order_acq_rel)) {
+                /* another thread sharing the slot was first */
+                delete shard;
+                return expected;
+            }
+            return shard;
+        }
+    public:
+        Sharded() = default;
+
+        ~Sharded() {
+            for (auto& shard: _shards) {
+                delete shard.load(std::memory_order_relaxed);
+            }
+        }
+
+        Sharded(const Sharded&) = delete;
+        Sharded& operator=(const Sharded&) = delete;
+
+        /** The calling thread's shard; nullptr if there is none and allocating one has failed */
+        Shard* local() noexcept {
+            auto slot = shards::slot();
+            auto shard = _shards[slot].load(std::memory_order_acquire);
+            return shard ? shard : add(slot);
+        }
+
+        /** Calls f with every shard allocated so far */
+        template <typename F>
+        void forEach(F&& f) const {
+            for (auto& slot: _shards) {
+                if (auto shard = slot.load(std::memory_order_acquire)) {
+                    f(*shard);
+                }
+            }
+        }
+    };
+}
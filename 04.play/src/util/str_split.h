@@ -19,40 +19,259 @@
  *
  * Trailing '\r' is treated as if it was '\r\n'
  * Otherwise '\r' not followed by '\n' is returned as part of the fragment
+ *
+ * When the underlying iterator is bidirectional so is LinesSplitIterator
+ * This makes std::views::reverse(LinesSplitView{...}) work: we walk backwards from the end
+ * producing exactly the same fragments as a forward pass would but in reverse order
+ *
+ * Going backwards we only ever look at the characters of the fragments we actually visit
+ * so taking last N lines of a memory-mapped file only touches the last few pages of it
+ *
+ * The machinery is actually more general: SplitView splits on any set of single-char delimiters fixed at compile time
+ * e.g. split<'\t'>(line) or split<',', '|'>(line); LinesSplitView is simply SplitView<View, LineBreaks>
+ *
+ * What happens to "\r\n" and to the trailing empty fragment is decided by a policy
+ * - Plain: every delimiter separates two fragments and nothing is dropped, same as std::views::split on a single char
+ * - CollapseCrLf: the line rules described above
+ *
+ * Since the delimiter set is known at compile time the scanner compares 16 bytes at a time against it with SSE2
+ * when the underlying sequence is contiguous; for larger sets we use nibble lookup tables with pshufb if the CPU
+ * has SSSE3, which is checked for at runtime as the build targets plain x86-64
+ * A single delimiter goes to memchr, which is what LinesSplitView ends up using: it looks for '\n' alone and peeks back for '\r'
+ *
+ * If lines also need to be checked for valid UTF-8 see ValidatingLinesView in util/str_split/utf8.h
  */
 
+#include <util/cpu.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <memory>
 #include <ranges>
 #include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace util::str_split {
-    /** We're defining LinesSplitView after this class */
-    template<std::forward_iterator BeginIter, typename EndIter>
+    /** Every delimiter char separates two fragments, trailing empty fragment is kept - like std::views::split */
+    struct Plain {
+        static constexpr bool collapseCrLf = false;
+        static constexpr bool dropTrailingEmpty = false;
+    };
+
+    /** "\r\n" counts as a single '\n', trailing '\r' counts as "\r\n", trailing empty fragment is dropped */
+    struct CollapseCrLf {
+        static constexpr bool collapseCrLf = true;
+        static constexpr bool dropTrailingEmpty = true;
+    };
+
+    namespace _detail {
+        /**
+         * Set of chars we scan for; everything is computed at compile time
+         * so that the SIMD loop boils down to a handful of compares per 16 bytes
+         */
+        template <char... Chars>
+        struct CharSet {
+            static_assert(sizeof...(Chars) > 0, "need at least one char to look for");
+
+            static constexpr bool contains(char c) {
+                return ((c == Chars) || ...);
+            }
+
+            /** Returns the first position in [from, to) holding a char from the set or 'to' if there is none */
+            template <typename Iter, typename Sentinel>
+            static constexpr Iter find(Iter from, Sentinel to) {
+                if constexpr (std::contiguous_iterator<Iter> && std::sized_sentinel_for<Sentinel, Iter>) {
+                    if (!std::is_constant_evaluated()) {
+                        const char* p = std::to_address(from);
+                        return from + (scan(p, p + (to - from)) - p);
+                    }
+                }
+                while (from != to && !contains(*from)) {
+                    ++from;
+                }
+                return from;
+            }
+
+            /** True if scanning looks the chars up in nibble tables with pshufb rather than comparing with each */
+            static bool nibbleLookup() noexcept {
+#if defined(__SSE2__)
+                return sizeof...(Chars) > 3 && sizeof...(Chars) <= 8 && cpu::hasSsse3();
+#else
+                return false;
+#endif
+            }
+
+        private:
+            static const char* scan(const char* p, const char* stop) noexcept {
+                if constexpr (sizeof...(Chars) == 1) {
+                    /* libc's memchr is already vectorized as well as anything we could write here */
+                    auto found = std::memchr(p, static_cast<unsigned char>(Chars)..., stop - p);
+                    return found ? static_cast<const char*>(found) : stop;
+                } else {
+#if defined(__SSE2__)
+                    return nibbleLookup() ? scanSsse3(p, stop) : scanChunks<Compare>(p, stop);
+#else
+                    while (p != stop && !contains(*p)) {
+                        ++p;
+                    }
+                    return p;
+#endif
+                }
+            }
+
+#if defined(__SSE2__)
+            template <typename Matcher>
+            __attribute__((always_inline))
+            static const char* scanChunks(const char* p, const char* stop) noexcept {
+                for (; stop - p >= 16; p += 16) {
+                    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    if (auto mask = _mm_movemask_epi8(Matcher::matches(chunk))) {
+                        return p + std::countr_zero(static_cast<unsigned>(mask));
+                    }
+                }
+                while (p != stop && !contains(*p)) {
+                    ++p;
+                }
+                return p;
+            }
+
+            /**
+             * Each char of the set gets its own bit; a byte matches when both its low and its high nibble
+             * select that same bit, so as long as there are at most 8 chars in the set there are no false positives
+             */
+            struct NibbleTables {
+                std::array<std::uint8_t, 16> low{};
+                std::array<std::uint8_t, 16> high{};
+            };
+
+            static constexpr NibbleTables nibbleTables = []{
+                NibbleTables tables;
+                std::uint8_t bit = 1;
+                for (char c: {Chars...}) {
+                    auto u = static_cast<std::uint8_t>(c);
+                    tables.low[u & 0x0F] |= bit;
+                    tables.high[u >> 4] |= bit;
+                    bit <<= 1;
+                }
+                return tables;
+            }();
+
+            /* matches() returns 0xFF in each byte which is in the set and 0x00 elsewhere */
+
+            struct Compare {
+                static __m128i matches(__m128i chunk) noexcept {
+                    auto hits = _mm_setzero_si128();
+                    ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Chars)))), ...);
+                    return hits;
+                }
+            };
+
+            struct Lookup {
+                __attribute__((target("ssse3")))
+                static __m128i matches(__m128i chunk) noexcept {
+                    auto lowNibbles = _mm_and_si128(chunk, _mm_set1_epi8(0x0F));
+                    auto highNibbles = _mm_and_si128(_mm_srli_epi16(chunk, 4), _mm_set1_epi8(0x0F));
+                    auto low = _mm_shuffle_epi8(_mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(nibbleTables.low.data())), lowNibbles);
+                    auto high = _mm_shuffle_epi8(_mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(nibbleTables.high.data())), highNibbles);
+                    auto zero = _mm_setzero_si128();
+                    return _mm_xor_si128(_mm_cmpeq_epi8(_mm_and_si128(low, high), zero), _mm_set1_epi8(-1));
+                }
+            };
+
+            /** The whole loop is compiled for SSSE3 so that the lookup gets inlined into it */
+            __attribute__((target("ssse3")))
+            static const char* scanSsse3(const char* p, const char* stop) noexcept {
+                return scanChunks<Lookup>(p, stop);
+            }
+#endif
+        };
+    }
+
+    /**
+     * Compile-time set of delimiter chars together with the policy deciding on "\r\n" and the trailing empty fragment
+     *
+     * When collapsing "\r\n" over a forward-only sequence we also need to stop at each '\r' while scanning, hence 'ScanSet'
+     * If we can step back we only scan for 'DelimiterSet' and then check if there's a '\r' in front of the '\n'
+     */
+    template <typename Policy, char... Chars>
+    struct Delimiters {
+        static_assert(!Policy::collapseCrLf || (((Chars == '\n') || ...) && ((Chars != '\r') && ...)),
+                "collapsing \\r\\n only makes sense when splitting on \\n and not on \\r");
+
+        using policy = Policy;
+        using DelimiterSet = _detail::CharSet<Chars...>;
+        using ScanSet = std::conditional_t<Policy::collapseCrLf,
+                _detail::CharSet<Chars..., '\r'>, _detail::CharSet<Chars...>>;
+
+        static constexpr bool isDelimiter(char c) {
+            return ((c == Chars) || ...);
+        }
+    };
+
+    using LineBreaks = Delimiters<CollapseCrLf, '\n'>;
+
+    /** We're defining SplitView after this class */
+    template<std::forward_iterator BeginIter, typename EndIter, typename Delims>
     requires std::is_same_v<std::iter_value_t<BeginIter>, char>
             && std::sentinel_for<EndIter, BeginIter>
-    class LinesSplitIterator {
+    class SplitIterator {
     public:
         using value_type = std::string_view;
         using difference_type = ptrdiff_t;
-        using iterator_category = std::forward_iterator_tag;
+        using iterator_category = std::conditional_t<std::bidirectional_iterator<BeginIter>,
+                std::bidirectional_iterator_tag, std::forward_iterator_tag>;
     private:
+        using Policy = typename Delims::policy;
+
+        /** We only need to remember where the underlying sequence starts in order to support operator-- */
+        BeginIter _underlyingStart;
         BeginIter _start;
         EndIter _underlyingStop;
         BeginIter _next;
         BeginIter _stop;
+
+        /**
+         * With Plain policy "a," has got a trailing empty fragment which starts and stops at the very end
+         * just like the end iterator does; this flag tells them apart, it's always false with CollapseCrLf
+         */
+        bool _trailing = false;
+
+        /** Does the sequence finish on a separator? Only ever called with _underlyingStart != _underlyingStop */
+        bool endsOnSeparator(BeginIter last) const {
+            return Delims::isDelimiter(*last) || (Policy::collapseCrLf && *last == '\r');
+        }
     public:
 
-        LinesSplitIterator() {}
-        LinesSplitIterator(const LinesSplitIterator&) = default;
-        LinesSplitIterator& operator=(const LinesSplitIterator&) = default;
+        SplitIterator() {}
+        SplitIterator(const SplitIterator&) = default;
+        SplitIterator& operator=(const SplitIterator&) = default;
 
-        LinesSplitIterator(BeginIter start, EndIter stop): _start(start), _underlyingStop(stop), _next(start), _stop(start) {
+        SplitIterator(BeginIter start, EndIter stop): _underlyingStart(start), _start(start),
+                _underlyingStop(stop), _next(start), _stop(start) {
             /* this iterator is actually safe to ++ even when it's done, it just does nothing then */
             ++*this;
         }
 
-        bool operator==(const LinesSplitIterator& other) const {
-            return _start == other._start && _stop == other._stop;
+        /**
+         * Creates an iterator positioned past the last fragment which still knows where the sequence starts
+         * so that it can be decremented; this is what SplitView::end() returns for common ranges
+         */
+        SplitIterator(BeginIter start, EndIter stop, std::default_sentinel_t)
+        requires std::is_same_v<BeginIter, EndIter>
+        : _underlyingStart(start), _start(stop), _underlyingStop(stop), _next(stop), _stop(stop) {}
+
+        bool operator==(const SplitIterator& other) const {
+            return _start == other._start && _stop == other._stop && _trailing == other._trailing;
         }
 
         /**
@@ -64,57 +283,151 @@ namespace util::str_split {
          * Note: C++20 allows us to omit defining this operator in reverse direction, this operator alone is sufficient
          */
         bool operator==(const std::default_sentinel_t&) const {
-            return _start == _underlyingStop;
+            return _start == _underlyingStop && !_trailing;
         }
 
         std::string_view operator*() const {
             // this check is in-sync with operator==(std::default_sentinel_t&)
-            if (_start == _underlyingStop) {
+            if (_start == _underlyingStop && !_trailing) {
                 throw std::out_of_range("Iterator past the end");
             }
             return std::string_view(_start, _stop);
         }
 
-        LinesSplitIterator& operator++() {
+        SplitIterator& operator++() {
             _start = _next;
             if (_next == _underlyingStop) {
+                if constexpr (!Policy::dropTrailingEmpty) {
+                    /* previous fragment was followed by a separator right at the end - so there's one more empty fragment */
+                    _trailing = _stop != _next;
+                }
                 _stop = _next; // so that we compare as equal to end iterator
                 return *this;
             }
 
+            if constexpr (Policy::collapseCrLf && std::bidirectional_iterator<BeginIter>) {
+                /*
+                 * We can afford to only look for delimiters and then peek at the char before each one
+                 * which lets the scanner look for a single char, typically just '\n' - and that's what memchr does best
+                 */
+                _next = Delims::DelimiterSet::find(_next, _underlyingStop);
+                _stop = _next;
+                if (_next != _underlyingStop) {
+                    ++_next;
+                    if (*_stop != '\n') {
+                        return *this;
+                    }
+                }
+                /* both '\r' before '\n' and trailing '\r' belong to the separator */
+                if (_stop != _start && *std::prev(_stop) == '\r') {
+                    --_stop;
+                }
+                return *this;
+            }
+
             for (;;) {
-                switch (*_next) {
-                    case '\r':
-                        _stop = _next;
+                _next = Delims::ScanSet::find(_next, _underlyingStop);
+                _stop = _next;
+                if (_next == _underlyingStop) {
+                    /* sequence ending not on a separator */
+                    return *this;
+                }
 
-                        ++_next;
-                        if (_next == _underlyingStop) {
-                            /* there will be no next, but there is a current item */
-                            return *this;
-                        }
-
-                        if (*_next == '\n') {
-                            /* setup for the next item - maybe there's one, maybe not */
-                            ++_next;
-                            return *this;
-                        }
-                        /* okay false alarm, we got \r followed by smth other than a \n, could be another \r */
-                        break;
-                    case '\n':
-                        /* okay it's not preceeded by a \r */
-                        _stop = _next;
-                        ++_next;
+                if (Policy::collapseCrLf && *_next == '\r') {
+                    ++_next;
+                    if (_next == _underlyingStop) {
+                        /* there will be no next, but there is a current item */
                         return *this;
-                    default:
-                        /* not \r or \n, notice we don't get here if we saw an \r followed by something else */
+                    }
+
+                    if (*_next == '\n') {
+                        /* setup for the next item - maybe there's one, maybe not */
                         ++_next;
-                        if (_next == _underlyingStop) {
-                            /* sequence ending not on \r or \n */
-                            _stop = _next;
-                            return *this;
-                        }
+                        return *this;
+                    }
+                    /* okay false alarm, we got \r followed by smth other than a \n, could be another \r */
+                    continue;
+                }
+
+                /* a delimiter, with CollapseCrLf it's a '\n' not preceeded by a \r */
+                ++_next;
+                return *this;
+            }
+        }
+
+        SplitIterator operator++(int) {
+            SplitIterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        /**
+         * Steps back to the previous fragment; as usual decrementing an iterator pointing at the 1st fragment is UB
+         *
+         * Every fragment other than the 1st one starts right after a delimiter so the char preceeding _start
+         * is always a delimiter unless we are positioned at the very end of the sequence
+         *
+         * At the very end the sequence may also finish on a dangling '\r' or on no separator at all
+         * this is where the rules for the trailing empty fragment are taken care of
+         */
+        SplitIterator& operator--() requires std::bidirectional_iterator<BeginIter> {
+            if constexpr (!Policy::dropTrailingEmpty) {
+                if (!_trailing && _start == _underlyingStop && _start != _underlyingStart
+                        && endsOnSeparator(std::prev(_start))) {
+                    /* stepping back from the end onto the trailing empty fragment */
+                    _trailing = true;
+                    return *this;
                 }
+                _trailing = false;
             }
+
+            _next = _start;
+            _stop = _start;
+
+            if (_stop != _underlyingStart) {
+                auto prev = std::prev(_stop);
+                if (Delims::isDelimiter(*prev)) {
+                    _stop = prev;
+                    if (Policy::collapseCrLf && *prev == '\n' && _stop != _underlyingStart && *std::prev(_stop) == '\r') {
+                        --_stop;
+                    }
+                } else if (Policy::collapseCrLf && *prev == '\r') {
+                    /* can only happen at the very end: trailing '\r' is treated as if it was '\r\n' */
+                    _stop = prev;
+                }
+                /* otherwise we are at the very end and the sequence doesn't finish on a separator */
+            }
+
+            /* with CollapseCrLf '\r' not followed by '\n' is part of the fragment so looking for delimiters alone is enough */
+            _start = std::find_if(std::reverse_iterator(_stop), std::reverse_iterator(_underlyingStart),
+                    Delims::isDelimiter).base();
+            return *this;
+        }
+
+        SplitIterator operator--(int) requires std::bidirectional_iterator<BeginIter> {
+            SplitIterator copy = *this;
+            --*this;
+            return copy;
+        }
+    };
+
+    /* let's make sure std::ranges algorithms will be happy to accept this */
+    static_assert(std::forward_iterator<SplitIterator<char*, char*, LineBreaks>>);
+    static_assert(std::bidirectional_iterator<SplitIterator<char*, char*, LineBreaks>>);
+
+    /**
+     * Iterator over lines; like LinesSplitView below a class of its own rather than an alias
+     * so that it can have a deduction guide
+     */
+    template <typename BeginIter, typename EndIter>
+    class LinesSplitIterator: public SplitIterator<BeginIter, EndIter, LineBreaks> {
+        using Base = SplitIterator<BeginIter, EndIter, LineBreaks>;
+    public:
+        using Base::Base;
+
+        LinesSplitIterator& operator++() {
+            Base::operator++();
+            return *this;
         }
 
         LinesSplitIterator operator++(int) {
@@ -122,19 +435,29 @@ namespace util::str_split {
             ++*this;
             return copy;
         }
+
+        LinesSplitIterator& operator--() requires std::bidirectional_iterator<BeginIter> {
+            Base::operator--();
+            return *this;
+        }
+
+        LinesSplitIterator operator--(int) requires std::bidirectional_iterator<BeginIter> {
+            LinesSplitIterator copy = *this;
+            --*this;
+            return copy;
+        }
     };
 
-    /* let's make sure std::ranges algorithms will be happy to accept this */
     static_assert(std::forward_iterator<LinesSplitIterator<char*, char*>>);
+    static_assert(std::bidirectional_iterator<LinesSplitIterator<char*, char*>>);
 
-    /* since it appears preferable to compile with -Wctad-maybe-unsupported let's provide a deduction guide */
     template <typename A, typename B>
     LinesSplitIterator(A, B) -> LinesSplitIterator<A, B>;
 
-    template <std::ranges::view View>
+    template <std::ranges::view View, typename Delims>
     requires std::ranges::input_range<View>
             && std::is_same_v<std::ranges::range_value_t<View>, char>
-    class LinesSplitView: public std::ranges::view_interface<LinesSplitView<View>> {
+    class SplitView: public std::ranges::view_interface<SplitView<View, Delims>> {
         View _subview;
     public:
         /**
@@ -169,33 +492,62 @@ namespace util::str_split {
          *
          * However in this regard the class is following the example of standard library
          */
-        constexpr LinesSplitView(View&& v)
+        constexpr SplitView(View&& v)
         noexcept(std::is_nothrow_move_constructible_v<View>)
         : _subview(std::move(v)) {};
 
-        constexpr LinesSplitView(const View& v)
+        constexpr SplitView(const View& v)
         noexcept(std::is_nothrow_copy_constructible_v<View>)
         : _subview(v) {};
 
         constexpr auto begin() const {
-            return LinesSplitIterator(_subview.begin(), _subview.end()); 
+            return SplitIterator<std::ranges::iterator_t<const View>, std::ranges::sentinel_t<const View>, Delims>(
+                    _subview.begin(), _subview.end());
         }
         constexpr auto end() const {
-            /* hmm could return std::default_sentinel here */
-            auto stop = _subview.end();
-            return LinesSplitIterator(stop, stop);
+            if constexpr (std::ranges::common_range<const View>) {
+                /* we need to know where the sequence starts to be able to walk back from the end */
+                return SplitIterator<std::ranges::iterator_t<const View>, std::ranges::sentinel_t<const View>, Delims>(
+                        _subview.begin(), _subview.end(), std::default_sentinel);
+            } else {
+                return std::default_sentinel;
+            }
         }
     };
 
+    /**
+     * Delimiter set can't be deduced from constructor arguments so LinesSplitView is a class of its own
+     * rather than an alias; this way it keeps its deduction guide below
+     */
+    template <std::ranges::view View>
+    requires std::ranges::input_range<View>
+            && std::is_same_v<std::ranges::range_value_t<View>, char>
+    class LinesSplitView: public SplitView<View, LineBreaks> {
+    public:
+        using SplitView<View, LineBreaks>::SplitView;
+    };
+
     static_assert(std::ranges::view<LinesSplitView<std::string_view>>);
     static_assert(std::ranges::input_range<LinesSplitView<std::string_view>>);
+    static_assert(std::ranges::bidirectional_range<LinesSplitView<std::string_view>>);
+    static_assert(std::ranges::common_range<LinesSplitView<std::string_view>>);
 
     /* Deduction guide to allow us to use owned_view */
     template <typename V>
     LinesSplitView(V&&) -> LinesSplitView<std::ranges::views::all_t<V>>;
 
+    /**
+     * Splits on any of Chars with Plain policy e.g. split<'\t'>(line) - think std::views::split(line, '\t')
+     * The range is wrapped into ref_view or owning_view in the same way LinesSplitView does it
+     */
+    template <char... Chars, std::ranges::viewable_range R>
+    constexpr auto split(R&& r) {
+        return SplitView<std::ranges::views::all_t<R>, Delimiters<Plain, Chars...>>(
+                std::views::all(std::forward<R>(r)));
+    }
+
     /*
      * We could define a range closure object too, but for now it will suffice to have the view class
      * Besides it seems custom view objects cannot be chained via | operator with view adapters from standard library anyway
      */
-}
\ No newline at end of file
+}
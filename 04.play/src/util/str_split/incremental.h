@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * Line splitting for text which arrives in pieces, e.g. read() from a pipe or from a file being written to
+ *
+ * LinesSplitView wants the whole text in memory; IncrementalLines is fed one piece at a time and calls back
+ * with every line completed so far, producing exactly the lines LinesSplitView would produce
+ * on all of the pieces glued together - provided finish() is called at the end
+ *
+ * A line cut in two by the end of a piece is held until the rest of it arrives; so is a '\r' at the very end
+ * of a piece as we can't yet tell "\r\n" from a lone '\r' which belongs to the line
+ * finish() says there is no more input: the partial line, if any, is delivered as the last one
+ * and a trailing '\r' on it is dropped, same as LinesSplitView treats a trailing '\r'
+ *
+ * Lines lying entirely within a piece are passed on as string_views into that piece without copying;
+ * only the partial line is copied into a buffer of our own, which is reused
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace util::str_split::incremental {
+    class IncrementalLines {
+        std::string _partial;
+
+        template <typename F>
+        static void deliver(std::string_view line, F& onLine) {
+            if (line.ends_with('\r')) {
+                line.remove_suffix(1);
+            }
+            onLine(line);
+        }
+    public:
+        /** Calls onLine(std::string_view) for each line completed by 'piece'; the views are only valid in the call */
+        template <typename F>
+        void feed(std::string_view piece, F&& onLine) {
+            std::size_t pos = 0;
+            while (pos < piece.size()) {
+                auto found = std::memchr(piece.data() + pos, '\n', piece.size() - pos);
+                if (!found) {
+                    break;
+                }
+                auto end = static_cast<std::size_t>(static_cast<const char*>(found) - piece.data());
+                if (_partial.empty()) {
+                    deliver(piece.substr(pos, end - pos), onLine);
+                } else {
+                    _partial.append(piece, pos, end - pos);
+                    deliver(_partial, onLine);
+                    _partial.clear();
+                }
+                pos = end + 1;
+            }
+            _partial.append(piece, pos);
+        }
+
+        /** End of input: delivers the partial line if there is one */
+        template <typename F>
+        void finish(F&& onLine) {
+            if (!_partial.empty()) {
+                deliver(_partial, onLine);
+                _partial.clear();
+            }
+        }
+
+        /** Forgets the partial line, e.g. when the input is replaced by another one */
+        void reset() noexcept {
+            _partial.clear();
+        }
+
+        /** Bytes held back waiting for the end of their line */
+        std::string_view partial() const noexcept {
+            return _partial;
+        }
+    };
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+/**
+ * Zero-copy reader for CSV/TSV-like data already in memory, layered on top of LinesSplitView
+ *
+ * Records are lines as LinesSplitView sees them, so "\r\n", trailing '\r' and the trailing empty line
+ * are treated exactly the same way; fields within a record are separated by the Delimiter
+ *
+ * RFC 4180 quoting is supported: a field starting with the Quote char runs until the matching closing quote,
+ * may contain delimiters and line breaks, and a doubled quote inside it stands for a single quote char
+ * When a quoted field spans several lines we simply keep pulling lines from LinesSplitView - since all lines
+ * live in the same contiguous chunk of memory the field remains a single string_view into the input
+ *
+ * Nothing is allocated per record: fields of the current record are kept in a vector which is reused
+ * A field is only ever copied if it contains doubled quotes and its unescaped value is requested
+ *
+ * Unquoted fields are found with memchr; we've tried classifying 16 bytes at a time with SSE2 and emitting all fields
+ * ending in the chunk but that was slower than memchr for fields of 16+ bytes and no faster for shorter ones
+ *
+ * An empty line is a record with a single empty field; a quote char inside an unquoted field is taken literally
+ * Unterminated quoted field and garbage after a closing quote are reported via MalformedRecord exception
+ */
+
+#include <util/str_split.h>
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::str_split::records {
+    class MalformedRecord: public std::runtime_error {
+        using runtime_error::runtime_error;
+    };
+
+    template <char Quote>
+    class Field {
+        std::string_view _raw;
+        bool _escaped;
+    public:
+        constexpr Field(std::string_view raw, bool escaped): _raw(raw), _escaped(escaped) {}
+
+        /** Field text without surrounding quotes; doubled quotes inside are still doubled */
+        constexpr std::string_view raw() const {
+            return _raw;
+        }
+
+        /** True if there are doubled quotes inside so that value() has to copy */
+        constexpr bool needsUnescaping() const {
+            return _escaped;
+        }
+
+        /**
+         * Unescaped value of the field; 'buffer' is only touched if the field needs unescaping
+         * The result is valid as long as both the input and the buffer are
+         */
+        std::string_view value(std::string& buffer) const {
+            if (!_escaped) {
+                return _raw;
+            }
+
+            buffer.clear();
+            for (auto p = _raw.begin(); p != _raw.end(); ++p) {
+                buffer += *p;
+                if (*p == Quote) {
+                    ++p; // skip the 2nd quote of the pair, parser guarantees it is there
+                }
+            }
+            return buffer;
+        }
+
+        std::string str() const {
+            if (!_escaped) {
+                return std::string{_raw};
+            }
+            std::string buffer;
+            value(buffer);
+            return buffer;
+        }
+    };
+
+    /**
+     * Pull-style parser: call next() then look at fields(); the span returned by fields() is only valid until next call to next()
+     *
+     * Can also be used in a range-for loop, then each element is the span of fields of a record
+     */
+    template <char Delimiter = ',', char Quote = '"'>
+    class RecordReader {
+        static_assert(Delimiter != Quote && Delimiter != '\n' && Delimiter != '\r' && Quote != '\n' && Quote != '\r',
+                "delimiter and quote must differ from each other and from line breaks");
+
+        using Lines = LinesSplitView<std::string_view>;
+        using LinesIter = std::ranges::iterator_t<const Lines>;
+
+        Lines _lines;
+        LinesIter _line;
+        LinesIter _linesEnd;
+
+        std::vector<Field<Quote>> _fields;
+        std::size_t _recordNo = 0;
+
+        [[noreturn]] void fail(const char* what) const {
+            throw MalformedRecord(std::string{what} + " in record #" + std::to_string(_recordNo));
+        }
+    public:
+        explicit RecordReader(std::string_view input): _lines(input), _line(_lines.begin()), _linesEnd(_lines.end()) {}
+
+        std::span<const Field<Quote>> fields() const {
+            return _fields;
+        }
+
+        /** Number of records parsed so far, starting with 1 for the 1st record */
+        std::size_t recordNo() const {
+            return _recordNo;
+        }
+
+        /** Parses the next record; returns false if there are no more records */
+        bool next() {
+            _fields.clear();
+            if (_line == _linesEnd) {
+                return false;
+            }
+            ++_recordNo;
+
+            std::string_view line = *_line++;
+            const char* p = line.data();
+            const char* stop = p + line.size();
+
+            for (;;) {
+                if (p != stop && *p == Quote) {
+                    const char* open = p + 1;
+                    const char* q = open;
+                    bool escaped = false;
+                    for (;;) {
+                        q = _detail::CharSet<Quote>::find(q, stop);
+                        if (q == stop) {
+                            /* quoted field goes on on the next line, line break between them is part of the field */
+                            if (_line == _linesEnd) {
+                                fail("unterminated quoted field");
+                            }
+                            line = *_line++;
+                            stop = line.data() + line.size();
+                            continue;
+                        }
+                        if (q + 1 != stop && q[1] == Quote) {
+                            escaped = true;
+                            q += 2;
+                            continue;
+                        }
+                        break;
+                    }
+
+                    _fields.emplace_back(std::string_view(open, q - open), escaped);
+                    p = q + 1;
+                    if (p == stop) {
+                        return true;
+                    }
+                    if (*p != Delimiter) {
+                        fail("unexpected char after closing quote");
+                    }
+                    ++p;
+                } else {
+                    const char* d = _detail::CharSet<Delimiter>::find(p, stop);
+                    _fields.emplace_back(std::string_view(p, d - p), false);
+                    if (d == stop) {
+                        return true;
+                    }
+                    p = d + 1;
+                }
+            }
+        }
+
+        class Iterator {
+            RecordReader* _reader = nullptr;
+        public:
+            using value_type = std::span<const Field<Quote>>;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            explicit Iterator(RecordReader& reader): _reader(&reader) {}
+
+            value_type operator*() const {
+                return _reader->fields();
+            }
+
+            Iterator& operator++() {
+                if (!_reader->next()) {
+                    _reader = nullptr;
+                }
+                return *this;
+            }
+
+            void operator++(int) {
+                ++*this;
+            }
+
+            bool operator==(const std::default_sentinel_t&) const {
+                return _reader == nullptr;
+            }
+        };
+
+        /** Single pass: begin() parses the 1st record not yet consumed */
+        Iterator begin() {
+            Iterator iter{*this};
+            return ++iter;
+        }
+
+        std::default_sentinel_t end() const {
+            return std::default_sentinel;
+        }
+    };
+
+    static_assert(std::input_iterator<RecordReader<>::Iterator>);
+
+    template <char Quote = '"'>
+    using CsvReader = RecordReader<',', Quote>;
+
+    template <char Quote = '"'>
+    using TsvReader = RecordReader<'\t', Quote>;
+}
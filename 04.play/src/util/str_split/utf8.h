@@ -0,0 +1,353 @@
+#pragma once
+
+/**
+ * Splitting text into lines and validating them as UTF-8 in the same pass
+ *
+ * ValidatingLinesView yields the same lines LinesSplitView would (see util/str_split.h for the rules)
+ * but each of them comes together with the offset of its 1st invalid UTF-8 sequence, if there is one
+ *
+ * Each line is walked 16 bytes at a time; for every chunk we both look for '\n' and run the lookup-table validator
+ * from "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser, Lemire) which is what simdutf does
+ * The validator needs pshufb: it is compiled for SSSE3 and used whenever the CPU has it, see vectorValidation()
+ * On an x86-64 CPU without SSSE3 we settle for checking if the chunk is pure ASCII which covers the vast majority
+ * of logs anyway
+ *
+ * The vector pass only tells us if a line may be invalid: in that case we rescan that line with validate()
+ * to find the exact offset; this is the rare path, valid lines are never looked at again
+ *
+ * Validation state is reset at the start of each line so every line is validated on its own:
+ * a multi-byte sequence cut short by the line break makes its line invalid
+ */
+
+#include <util/cpu.h>
+#include <util/str_split.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace util::str_split::utf8 {
+    constexpr std::size_t npos = std::string_view::npos;
+
+    /** Returns the offset of the 1st byte of the 1st invalid UTF-8 sequence in 'text' or npos if 'text' is valid */
+    constexpr std::size_t validate(std::string_view text) {
+        std::size_t i = 0;
+        while (i < text.size()) {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c < 0x80) {
+                ++i;
+                continue;
+            }
+
+            /* allowed range for the 1st continuation byte excludes overlongs, surrogates and anything above U+10FFFF */
+            std::size_t length;
+            unsigned char low = 0x80, high = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) {
+                length = 2;
+            } else if (c == 0xE0) {
+                length = 3;
+                low = 0xA0;
+            } else if (c == 0xED) {
+                length = 3;
+                high = 0x9F;
+            } else if (c >= 0xE1 && c <= 0xEF) {
+                length = 3;
+            } else if (c == 0xF0) {
+                length = 4;
+                low = 0x90;
+            } else if (c == 0xF4) {
+                length = 4;
+                high = 0x8F;
+            } else if (c >= 0xF1 && c <= 0xF3) {
+                length = 4;
+            } else {
+                return i;
+            }
+
+            if (text.size() - i < length) {
+                return i;
+            }
+            auto c1 = static_cast<unsigned char>(text[i + 1]);
+            if (c1 < low || c1 > high) {
+                return i;
+            }
+            for (std::size_t k = 2; k < length; ++k) {
+                if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80) {
+                    return i;
+                }
+            }
+            i += length;
+        }
+        return npos;
+    }
+
+    /**
+     * True if lines are validated by the SSSE3 kernel as they're split; otherwise lines with any non-ASCII bytes
+     * are looked at once more by validate()
+     */
+    inline bool vectorValidation() noexcept {
+#if defined(__SSE2__)
+        return cpu::hasSsse3();
+#else
+        return false;
+#endif
+    }
+
+    struct ValidatedLine {
+        std::string_view text;
+
+        /** Offset within 'text' of the 1st invalid sequence, npos if the line is valid */
+        std::size_t invalidAt = npos;
+
+        bool valid() const {
+            return invalidAt == npos;
+        }
+
+        bool operator==(const ValidatedLine&) const = default;
+    };
+
+    namespace _detail {
+        /** Where the '\n' terminating the line is (or the end of the input) and whether the line needs a closer look */
+        struct ScanResult {
+            const char* lineBreak;
+            bool suspicious;
+        };
+
+#if defined(__SSE2__)
+        /* Each bit of these tables stands for one kind of error; see the paper for the details */
+        constexpr std::uint8_t TOO_SHORT = 1 << 0;
+        constexpr std::uint8_t TOO_LONG = 1 << 1;
+        constexpr std::uint8_t OVERLONG_3 = 1 << 2;
+        constexpr std::uint8_t TOO_LARGE = 1 << 3;
+        constexpr std::uint8_t SURROGATE = 1 << 4;
+        constexpr std::uint8_t OVERLONG_2 = 1 << 5;
+        constexpr std::uint8_t TOO_LARGE_1000 = 1 << 6;
+        constexpr std::uint8_t OVERLONG_4 = 1 << 6;
+        constexpr std::uint8_t TWO_CONTS = 1 << 7;
+        constexpr std::uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        /** Indexed by high nibble of the previous byte */
+        alignas(16) constexpr std::array<std::uint8_t, 16> BYTE_1_HIGH{
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+
+        /** Indexed by low nibble of the previous byte */
+        alignas(16) constexpr std::array<std::uint8_t, 16> BYTE_1_LOW{
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY,
+            CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000};
+
+        /** Indexed by high nibble of the current byte */
+        alignas(16) constexpr std::array<std::uint8_t, 16> BYTE_2_HIGH{
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT};
+
+        __attribute__((target("ssse3")))
+        inline __m128i lookup(const std::array<std::uint8_t, 16>& table, __m128i nibbles) {
+            return _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(table.data())), nibbles);
+        }
+
+        /** Non-zero bytes mark errors; 'prev' is the previous chunk of the same line or zeros at the start of a line */
+        __attribute__((target("ssse3")))
+        inline __m128i chunkErrors(__m128i input, __m128i prev) {
+            auto nibble = _mm_set1_epi8(0x0F);
+            auto prev1 = _mm_alignr_epi8(input, prev, 15);
+            auto byte1High = lookup(BYTE_1_HIGH, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+            auto byte1Low = lookup(BYTE_1_LOW, _mm_and_si128(prev1, nibble));
+            auto byte2High = lookup(BYTE_2_HIGH, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+            auto special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+            /* 3rd and 4th bytes of a sequence must be continuations; those are the only two-continuation cases allowed */
+            auto isThird = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+            auto isFourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+            auto must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8(static_cast<char>(0x80)));
+            return _mm_xor_si128(must23, special);
+        }
+
+        /** Bit i set if byte i of the chunk may be (part of) an invalid sequence */
+        struct Ssse3Kernel {
+            __attribute__((target("ssse3")))
+            static unsigned suspiciousBytes(__m128i input, __m128i prev) {
+                /* nothing can go wrong in an ASCII chunk unless a sequence from the previous one carries over */
+                if (_mm_movemask_epi8(_mm_or_si128(input, prev)) == 0) {
+                    return 0;
+                }
+                auto errors = chunkErrors(input, prev);
+                return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128()))) ^ 0xFFFFu;
+            }
+        };
+
+        /** Without pshufb we can only tell pure ASCII chunks apart, anything else is looked at by validate() */
+        struct AsciiKernel {
+            static unsigned suspiciousBytes(__m128i input, __m128i) {
+                return static_cast<unsigned>(_mm_movemask_epi8(input));
+            }
+        };
+
+        /**
+         * Finds the '\n' terminating the line starting at 'p' and checks the bytes up to and including it
+         *
+         * The '\n' itself gets checked too: a sequence cut short by the line break is reported at the '\n'
+         * When there is no '\n' we look at the zero padding past the end of input for the same reason
+         */
+        template <typename Kernel>
+        __attribute__((always_inline))
+        inline ScanResult scanChunks(const char* p, const char* stop) {
+            auto newline = _mm_set1_epi8('\n');
+            auto prev = _mm_setzero_si128();
+            bool suspicious = false;
+
+            for (; stop - p >= 16; p += 16) {
+                auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                auto suspects = Kernel::suspiciousBytes(chunk, prev);
+                if (auto newlines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))) {
+                    auto at = std::countr_zero(newlines);
+                    suspicious |= (suspects & ((2u << at) - 1)) != 0;
+                    return {p + at, suspicious};
+                }
+                suspicious |= suspects != 0;
+                prev = chunk;
+            }
+
+            alignas(16) char tail[16] = {};
+            std::memcpy(tail, p, stop - p);
+            auto chunk = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+            auto suspects = Kernel::suspiciousBytes(chunk, prev);
+            auto newlines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+            if (newlines) {
+                auto at = std::countr_zero(newlines);
+                return {p + at, suspicious || (suspects & ((2u << at) - 1)) != 0};
+            }
+            return {stop, suspicious || suspects != 0};
+        }
+
+        /** The whole loop is compiled for SSSE3 so that the kernel gets inlined into it */
+        __attribute__((target("ssse3")))
+        inline ScanResult scanLineSsse3(const char* p, const char* stop) {
+            return scanChunks<Ssse3Kernel>(p, stop);
+        }
+#endif
+
+        inline ScanResult scanLine(const char* p, const char* stop) {
+#if defined(__SSE2__)
+            return vectorValidation() ? scanLineSsse3(p, stop) : scanChunks<AsciiKernel>(p, stop);
+#else
+            auto found = static_cast<const char*>(std::memchr(p, '\n', stop - p));
+            return {found ? found : stop, true};
+#endif
+        }
+    }
+
+    /** Same rules as LinesSplitIterator; only works on contiguous memory */
+    class ValidatingLinesIterator {
+        const char* _start = nullptr;
+        const char* _stop = nullptr;
+        const char* _next = nullptr;
+        const char* _underlyingStop = nullptr;
+        std::size_t _invalidAt = npos;
+    public:
+        using value_type = ValidatedLine;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        ValidatingLinesIterator() = default;
+
+        ValidatingLinesIterator(const char* start, const char* stop): _start(start), _stop(start), _next(start),
+                _underlyingStop(stop) {
+            ++*this;
+        }
+
+        bool operator==(const ValidatingLinesIterator& other) const {
+            return _start == other._start && _stop == other._stop;
+        }
+
+        bool operator==(const std::default_sentinel_t&) const {
+            return _start == _underlyingStop;
+        }
+
+        ValidatedLine operator*() const {
+            if (_start == _underlyingStop) {
+                throw std::out_of_range("Iterator past the end");
+            }
+            return {std::string_view(_start, _stop - _start), _invalidAt};
+        }
+
+        ValidatingLinesIterator& operator++() {
+            _start = _next;
+            if (_next == _underlyingStop) {
+                _stop = _next; // so that we compare as equal to end iterator
+                return *this;
+            }
+
+            auto [lineBreak, suspicious] = _detail::scanLine(_next, _underlyingStop);
+            _stop = lineBreak;
+            _next = lineBreak == _underlyingStop ? lineBreak : lineBreak + 1;
+
+            /* both '\r' before '\n' and trailing '\r' belong to the separator */
+            if (_stop != _start && _stop[-1] == '\r') {
+                --_stop;
+            }
+
+            _invalidAt = suspicious ? validate(std::string_view(_start, _stop - _start)) : npos;
+            return *this;
+        }
+
+        ValidatingLinesIterator operator++(int) {
+            ValidatingLinesIterator copy = *this;
+            ++*this;
+            return copy;
+        }
+    };
+
+    static_assert(std::forward_iterator<ValidatingLinesIterator>);
+
+    /** Non-owning, takes anything a string_view can be made of */
+    class ValidatingLinesView: public std::ranges::view_interface<ValidatingLinesView> {
+        std::string_view _text;
+    public:
+        constexpr ValidatingLinesView(std::string_view text) noexcept: _text(text) {}
+
+        ValidatingLinesIterator begin() const {
+            return {_text.data(), _text.data() + _text.size()};
+        }
+
+        ValidatingLinesIterator end() const {
+            auto stop = _text.data() + _text.size();
+            return {stop, stop};
+        }
+    };
+
+    static_assert(std::ranges::view<ValidatingLinesView>);
+    static_assert(std::ranges::forward_range<ValidatingLinesView>);
+}
@@ -0,0 +1,126 @@
+#include <util/sync.h>
+
+#include <climits>
+#include <thread>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace util::sync {
+    namespace _detail {
+        /* std::atomic<std::uint32_t> is laid out as a plain uint32_t which is what the kernel wants */
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+        void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+            /* returns right away if the word is no longer 'expected'; spurious wake-ups are fine for all callers */
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+                    nullptr, nullptr, 0);
+        }
+
+        void futexWake(std::atomic<std::uint32_t>& word, int count) noexcept {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count,
+                    nullptr, nullptr, 0);
+        }
+
+        int spinRounds() noexcept {
+            static const int rounds = std::thread::hardware_concurrency() > 1 ? 10 : 0;
+            return rounds;
+        }
+    }
+
+    void Mutex::lockSlow() noexcept {
+        _detail::Backoff backoff;
+        while (backoff.spin()) {
+            /* only attempting the CAS when it has a chance of succeeding keeps the cache line shared */
+            auto state = _state.load(std::memory_order_relaxed);
+            if (state == UNLOCKED && _state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire,
+                    std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        /*
+         * Parking: we don't know whether we're the only waiter so we take the lock as SLEEPERS
+         * which makes our unlock() wake up the next one; at worst that's one syscall too many
+         */
+        while (_state.exchange(SLEEPERS, std::memory_order_acquire) != UNLOCKED) {
+            _detail::futexWait(_state, SLEEPERS);
+        }
+    }
+
+    void SharedMutex::lockSharedSlow() noexcept {
+        _detail::Backoff backoff;
+        for (;;) {
+            auto state = _state.load(std::memory_order_relaxed);
+            if ((state & WRITER) == 0) {
+                if (_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                        std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            if (backoff.spin()) {
+                continue;
+            }
+
+            /* announcing ourselves so that the writer's unlock() makes the syscall; then sleeping till it does */
+            if ((state & SLEEPERS) == 0 && !_state.compare_exchange_weak(state, state | SLEEPERS,
+                    std::memory_order_relaxed)) {
+                continue;
+            }
+            _detail::futexWait(_state, state | SLEEPERS);
+        }
+    }
+
+    bool SharedMutex::try_lock_shared() noexcept {
+        auto state = _state.load(std::memory_order_relaxed);
+        while ((state & WRITER) == 0) {
+            if (_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                    std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void SharedMutex::lock() noexcept {
+        _writers.lock();
+        _state.fetch_or(WRITER, std::memory_order_acquire);
+        waitForReaders();
+    }
+
+    void SharedMutex::waitForReaders() noexcept {
+        _detail::Backoff backoff;
+        for (;;) {
+            /* reading _drained first: if the last reader leaves after we've looked at _state we won't sleep */
+            auto drained = _drained.load(std::memory_order_acquire);
+            if ((_state.load(std::memory_order_acquire) & READERS) == 0) {
+                return;
+            }
+            if (!backoff.spin()) {
+                _detail::futexWait(_drained, drained);
+            }
+        }
+    }
+
+    bool SharedMutex::try_lock() noexcept {
+        if (!_writers.try_lock()) {
+            return false;
+        }
+        std::uint32_t expected = 0;
+        if (!_state.compare_exchange_strong(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+            _writers.unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void SharedMutex::unlock() noexcept {
+        /* no reader can have got in while WRITER was set so the count is 0 */
+        if ((_state.exchange(0, std::memory_order_release) & SLEEPERS) != 0) {
+            _detail::futexWake(_state, INT_MAX);
+        }
+        _writers.unlock();
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+/**
+ * Locks for very short critical sections: bumping a counter, looking something up in a small map
+ *
+ * Under contention std::mutex goes to the kernel almost right away, yet the owner is likely to be done
+ * in less time than a futex syscall takes; so here we first spin for a bounded number of rounds,
+ * executing 'pause' 1, 2, 4, ... times between attempts so as not to hammer the cache line,
+ * and only then park the thread on a futex
+ *
+ * Mutex satisfies Lockable and SharedMutex satisfies SharedLockable, so both work with std::lock_guard,
+ * std::unique_lock, std::shared_lock, std::scoped_lock and std::condition_variable_any
+ *
+ * Linux only since we talk to futex(2) directly
+ */
+
+#include <atomic>
+#include <cstdint>
+
+namespace util::sync {
+    namespace _detail {
+        void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept;
+        void futexWake(std::atomic<std::uint32_t>& word, int count) noexcept;
+
+        inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+
+        /** How many rounds to spin before parking; 0 on a single CPU where the owner can't run while we spin */
+        int spinRounds() noexcept;
+
+        /**
+         * Exponential backoff for the spinning phase: spin() executes 1, 2, 4, ... up to MAX_PAUSES pauses
+         * and returns false once the budget of spinRounds() calls has been used up, meaning it's time to park
+         */
+        class Backoff {
+            static constexpr int MAX_PAUSES = 64;
+
+            int _rounds = spinRounds();
+            int _pauses = 1;
+        public:
+            bool spin() noexcept {
+                if (_rounds <= 0) {
+                    return false;
+                }
+                --_rounds;
+                for (int i = 0; i < _pauses; ++i) {
+                    cpuRelax();
+                }
+                if (_pauses < MAX_PAUSES) {
+                    _pauses *= 2;
+                }
+                return true;
+            }
+        };
+    }
+
+    /**
+     * Spin-then-park mutex; the futex word is 0 when unlocked, 1 when locked and 2 when locked and somebody
+     * may be sleeping on it, so that unlock() only makes a syscall if there might be someone to wake up
+     */
+    class Mutex {
+        static constexpr std::uint32_t UNLOCKED = 0;
+        static constexpr std::uint32_t LOCKED = 1;
+        static constexpr std::uint32_t SLEEPERS = 2;
+
+        std::atomic<std::uint32_t> _state = UNLOCKED;
+
+        void lockSlow() noexcept;
+    public:
+        Mutex() = default;
+        Mutex(const Mutex&) = delete;
+        Mutex& operator=(const Mutex&) = delete;
+
+        void lock() noexcept {
+            auto expected = UNLOCKED;
+            if (!_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                    std::memory_order_relaxed)) {
+                lockSlow();
+            }
+        }
+
+        bool try_lock() noexcept {
+            auto expected = UNLOCKED;
+            return _state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                    std::memory_order_relaxed);
+        }
+
+        void unlock() noexcept {
+            if (_state.exchange(UNLOCKED, std::memory_order_release) == SLEEPERS) {
+                _detail::futexWake(_state, 1);
+            }
+        }
+    };
+
+    /**
+     * Writer-preferring reader-writer lock: as soon as a writer shows up new readers have to wait,
+     * so a steady stream of readers cannot starve writers
+     *
+     * Writers queue up on a Mutex among themselves; the one at the front sets WRITER in the state word
+     * and waits for the readers already inside to drain; readers count themselves in the low bits of the word
+     *
+     * The writer sleeps on a futex word of its own, _drained, so that the last reader out only wakes it
+     * rather than all the readers parked on _state
+     */
+    class SharedMutex {
+        static constexpr std::uint32_t WRITER = 1u << 31;
+        static constexpr std::uint32_t SLEEPERS = 1u << 30;    // readers are parked waiting for the writer
+        static constexpr std::uint32_t READERS = SLEEPERS - 1;
+
+        Mutex _writers;
+        std::atomic<std::uint32_t> _state = 0;
+        std::atomic<std::uint32_t> _drained = 0;
+
+        void lockSharedSlow() noexcept;
+        void waitForReaders() noexcept;
+    public:
+        SharedMutex() = default;
+        SharedMutex(const SharedMutex&) = delete;
+        SharedMutex& operator=(const SharedMutex&) = delete;
+
+        void lock() noexcept;
+        bool try_lock() noexcept;
+        void unlock() noexcept;
+
+        void lock_shared() noexcept {
+            auto state = _state.load(std::memory_order_relaxed);
+            if ((state & WRITER) != 0 || !_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                    std::memory_order_relaxed)) {
+                lockSharedSlow();
+            }
+        }
+
+        bool try_lock_shared() noexcept;
+
+        void unlock_shared() noexcept {
+            auto state = _state.fetch_sub(1, std::memory_order_release);
+            if ((state & WRITER) != 0 && (state & READERS) == 1) {
+                /* last reader out, the writer is waiting for us */
+                _drained.fetch_add(1, std::memory_order_release);
+                _detail::futexWake(_drained, 1);
+            }
+        }
+    };
+}
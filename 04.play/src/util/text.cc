@@ -0,0 +1,558 @@
+#include <util/text.h>
+#include <util/cpu.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * How common a byte is in log text, the higher the more common: lowercase letters, digits, spaces and
+     * the punctuation of timestamps and paths; only the order matters, the numbers are rough guesses
+     */
+    constexpr std::array<std::uint8_t, 256> BYTE_FREQUENCY = []{
+        std::array<std::uint8_t, 256> result{};
+        for (int c = 0x20; c < 0x7F; ++c) {
+            result[c] = 40;
+        }
+        for (int c = 'A'; c <= 'Z'; ++c) {
+            result[c] = 60;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            result[c] = 150;
+        }
+        for (int c = 'a'; c <= 'z'; ++c) {
+            result[c] = 100;
+        }
+        /* roughly English letter frequencies on top */
+        constexpr std::string_view commonLetters = "etaoinsrhldcu";
+        for (std::size_t i = 0; i < commonLetters.size(); ++i) {
+            result[static_cast<unsigned char>(commonLetters[i])] = static_cast<std::uint8_t>(200 - i * 5);
+        }
+        for (char c: {' ', ':', '.', '-', '/', '0', '1', '2'}) {
+            result[static_cast<unsigned char>(c)] = 230;
+        }
+        result[' '] = 255;
+        return result;
+    }();
+
+    bool matchesAt(std::string_view haystack, std::size_t position, std::string_view pattern) noexcept {
+        return haystack.size() - position >= pattern.size()
+                && std::memcmp(haystack.data() + position, pattern.data(), pattern.size()) == 0;
+    }
+}
+
+namespace util::text {
+    Searcher::Searcher(std::string_view needle): _needle(needle) {
+        if (needle.size() < 2) {
+            return;
+        }
+        auto frequency = [&needle](std::size_t i) {
+            return BYTE_FREQUENCY[static_cast<unsigned char>(needle[i])];
+        };
+        for (std::size_t i = 1; i < needle.size(); ++i) {
+            if (frequency(i) < frequency(_rare1)) {
+                _rare1 = i;
+            }
+        }
+        /* a different byte value filters out more than the same byte at another offset */
+        _rare2 = _rare1 == 0 ? 1 : 0;
+        for (std::size_t i = 0; i < needle.size(); ++i) {
+            if (i == _rare1) {
+                continue;
+            }
+            bool differs = needle[i] != needle[_rare1], bestDiffers = needle[_rare2] != needle[_rare1];
+            if ((differs && !bestDiffers) || (differs == bestDiffers && frequency(i) < frequency(_rare2))) {
+                _rare2 = i;
+            }
+        }
+        if (_rare1 > _rare2) {
+            std::swap(_rare1, _rare2);
+        }
+    }
+
+    std::size_t Searcher::find(std::string_view haystack, std::size_t from) const noexcept {
+        auto size = haystack.size(), length = _needle.size();
+        if (from > size || size - from < length) {
+            return npos;
+        }
+        if (length == 0) {
+            return from;
+        }
+        const char* base = haystack.data();
+        if (length == 1) {
+            auto found = std::memchr(base + from, static_cast<unsigned char>(_needle[0]), size - from);
+            return found ? static_cast<const char*>(found) - base : npos;
+        }
+
+        auto last = size - length;
+        auto p = from;
+#if defined(__SSE2__)
+        auto rare1 = _mm_set1_epi8(_needle[_rare1]);
+        auto rare2 = _mm_set1_epi8(_needle[_rare2]);
+        for (; p + _rare2 + 16 <= size && p <= last; p += 16) {
+            auto chunk1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + p + _rare1));
+            auto chunk2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + p + _rare2));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(chunk1, rare1), _mm_cmpeq_epi8(chunk2, rare2))));
+            for (; mask != 0; mask &= mask - 1) {
+                auto position = p + std::countr_zero(mask);
+                if (position > last) {
+                    return npos;
+                }
+                if (std::memcmp(base + position, _needle.data(), length) == 0) {
+                    return position;
+                }
+            }
+        }
+        /* the rest with one more chunk overlapping the last one rather than byte by byte */
+        if (p <= last && size >= _rare2 + 16) {
+            auto q = size - 16 - _rare2;
+            auto chunk1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + q + _rare1));
+            auto chunk2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + q + _rare2));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(chunk1, rare1), _mm_cmpeq_epi8(chunk2, rare2))));
+            for (mask &= ~0u << (p - q); mask != 0; mask &= mask - 1) {
+                auto position = q + std::countr_zero(mask);
+                if (position > last) {
+                    return npos;
+                }
+                if (std::memcmp(base + position, _needle.data(), length) == 0) {
+                    return position;
+                }
+            }
+            return npos;
+        }
+#endif
+        for (; p <= last; ++p) {
+            if (base[p + _rare1] == _needle[_rare1] && base[p + _rare2] == _needle[_rare2]
+                    && std::memcmp(base + p, _needle.data(), length) == 0) {
+                return p;
+            }
+        }
+        return npos;
+    }
+
+    namespace _detail {
+        /* the engines don't keep a reference to the patterns as MultiSearcher may be moved */
+        using Patterns = std::vector<std::string>;
+
+        /** Keeps whichever of the matches starts first and of those starting together the longest one */
+        void keepBest(std::optional<Match>& best, const Match& candidate) noexcept {
+            if (!best || candidate.position < best->position
+                    || (candidate.position == best->position && candidate.length > best->length)) {
+                best = candidate;
+            }
+        }
+
+        class Teddy {
+            static constexpr std::size_t BUCKETS = 8;
+
+            std::array<std::vector<std::uint32_t>, BUCKETS> _buckets;
+
+            /* fingerprint: this many leading bytes of every pattern, 1 to 3 */
+            std::size_t _prefix;
+
+            /* for each byte of the fingerprint which buckets may have the given low or high nibble there */
+            alignas(16) std::array<std::array<std::uint8_t, 16>, 3> _low{};
+            alignas(16) std::array<std::array<std::uint8_t, 16>, 3> _high{};
+
+            std::uint8_t bucketsAt(const char* p) const noexcept {
+                std::uint8_t result = 0xFF;
+                for (std::size_t k = 0; k < _prefix; ++k) {
+                    auto c = static_cast<unsigned char>(p[k]);
+                    result &= _low[k][c & 0x0F] & _high[k][c >> 4];
+                }
+                return result;
+            }
+
+#if defined(__SSE2__)
+            /** Bucket bits for each of the 16 positions starting at p */
+            template <std::size_t Prefix>
+            __attribute__((target("ssse3")))
+            __m128i candidatesAt(const char* p) const noexcept {
+                auto nibbleMask = _mm_set1_epi8(0x0F);
+                auto candidates = _mm_set1_epi8(-1);
+                for (std::size_t k = 0; k < Prefix; ++k) {
+                    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+                    auto low = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(_low[k].data())),
+                            _mm_and_si128(chunk, nibbleMask));
+                    auto high = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(_high[k].data())),
+                            _mm_and_si128(_mm_srli_epi16(chunk, 4), nibbleMask));
+                    candidates = _mm_and_si128(candidates, _mm_and_si128(low, high));
+                }
+                return candidates;
+            }
+
+            /** 'mask' selects which of the 16 positions to look at */
+            template <typename OnCandidate>
+            static bool report(std::size_t p, __m128i candidates, unsigned mask, OnCandidate& onCandidate) {
+                mask &= static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(candidates, _mm_setzero_si128())))
+                        ^ 0xFFFF;
+                if (mask == 0) {
+                    return false;
+                }
+                alignas(16) std::array<std::uint8_t, 16> buckets;
+                _mm_store_si128(reinterpret_cast<__m128i*>(buckets.data()), candidates);
+                for (; mask != 0; mask &= mask - 1) {
+                    auto i = std::countr_zero(mask);
+                    if (onCandidate(p + i, buckets[i])) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * 16 positions per step while there are 16 of them left, the rest with one more chunk overlapping
+             * the last one rather than byte by byte; returns where scan() carries on byte by byte from,
+             * which is the end of the haystack unless the haystack is shorter than a chunk
+             *
+             * Compiled for SSSE3 on its own as the build targets plain x86-64, MultiSearcher checks the CPU has it
+             */
+            template <std::size_t Prefix, typename OnCandidate>
+            __attribute__((target("ssse3")))
+            std::size_t scanChunks(std::string_view haystack, std::size_t p, OnCandidate& onCandidate) const {
+                const char* base = haystack.data();
+                auto size = haystack.size();
+                constexpr std::size_t SPAN = Prefix - 1 + 16;
+                for (; p + SPAN <= size; p += 16) {
+                    if (report(p, candidatesAt<Prefix>(base + p), 0xFFFF, onCandidate)) {
+                        return size;
+                    }
+                }
+                if (p + Prefix <= size && size >= SPAN) {
+                    auto last = size - SPAN;
+                    report(last, candidatesAt<Prefix>(base + last), 0xFFFFu << (p - last), onCandidate);
+                    return size;
+                }
+                return p;
+            }
+#endif
+
+            /**
+             * Calls onCandidate(position, buckets) for positions where patterns of some buckets may start,
+             * in increasing order of positions, until it returns true
+             */
+            template <std::size_t Prefix, typename OnCandidate>
+            void scan(std::string_view haystack, std::size_t from, OnCandidate& onCandidate) const {
+                const char* base = haystack.data();
+                auto size = haystack.size();
+                if (size < Prefix) {
+                    return;
+                }
+                auto p = from;
+#if defined(__SSE2__)
+                p = scanChunks<Prefix>(haystack, p, onCandidate);
+#endif
+                for (; p + Prefix <= size; ++p) {
+                    if (auto buckets = bucketsAt(base + p); buckets != 0 && onCandidate(p, buckets)) {
+                        return;
+                    }
+                }
+            }
+
+            template <typename OnCandidate>
+            void scan(std::string_view haystack, std::size_t from, OnCandidate&& onCandidate) const {
+                switch (_prefix) {
+                    case 1:
+                        return scan<1>(haystack, from, onCandidate);
+                    case 2:
+                        return scan<2>(haystack, from, onCandidate);
+                    default:
+                        return scan<3>(haystack, from, onCandidate);
+                }
+            }
+
+            template <typename F>
+            void forEachVerified(const Patterns& patterns, std::string_view haystack, std::size_t position,
+                    std::uint8_t buckets, F&& f) const {
+                for (; buckets != 0; buckets &= buckets - 1) {
+                    for (auto pattern: _buckets[std::countr_zero(buckets)]) {
+                        if (matchesAt(haystack, position, patterns[pattern])) {
+                            f(Match{pattern, position, patterns[pattern].size()});
+                        }
+                    }
+                }
+            }
+        public:
+            static constexpr std::size_t MAX_PATTERNS = 16;
+
+            explicit Teddy(const Patterns& patterns): _prefix(3) {
+                for (auto& pattern: patterns) {
+                    _prefix = std::min(_prefix, pattern.size());
+                }
+                for (std::uint32_t i = 0; i < patterns.size(); ++i) {
+                    auto bucket = i % BUCKETS;
+                    _buckets[bucket].push_back(i);
+                    for (std::size_t k = 0; k < _prefix; ++k) {
+                        auto c = static_cast<unsigned char>(patterns[i][k]);
+                        _low[k][c & 0x0F] |= 1u << bucket;
+                        _high[k][c >> 4] |= 1u << bucket;
+                    }
+                }
+            }
+
+            std::optional<Match> find(const Patterns& patterns, std::string_view haystack, std::size_t from) const {
+                std::optional<Match> best;
+                scan(haystack, from, [&](std::size_t position, std::uint8_t buckets) {
+                    forEachVerified(patterns, haystack, position, buckets, [&best](const Match& match) {
+                        keepBest(best, match);
+                    });
+                    return best.has_value();
+                });
+                return best;
+            }
+
+            void forEachMatch(const Patterns& patterns, std::string_view haystack,
+                    const std::function<void(const Match&)>& f) const {
+                scan(haystack, 0, [&](std::size_t position, std::uint8_t buckets) {
+                    forEachVerified(patterns, haystack, position, buckets, f);
+                    return false;
+                });
+            }
+        };
+
+        /**
+         * Deterministic automaton: failure links are resolved while building so that matching does exactly
+         * one transition per byte; bytes are mapped to classes first, bytes found in no pattern sharing class 0,
+         * which keeps the table at (number of distinct bytes + 1) entries per state
+         *
+         * Table entries are the target state's offset in the table, so that a step is a single load,
+         * with the MATCH bit set if some pattern ends in the target state
+         */
+        class AhoCorasick {
+            static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+            static constexpr std::uint32_t MATCH = 1u << 31;
+
+            std::array<std::uint16_t, 256> _classes{};
+            std::size_t _stride = 1;
+            std::size_t _maxLength = 0;
+
+            std::vector<std::uint32_t> _table;
+
+            /* per state: the longest pattern ending here, the patterns ending exactly here and the nearest
+               state down the failure chain where some pattern ends */
+            std::vector<std::uint32_t> _longest;
+            std::vector<std::vector<std::uint32_t>> _own;
+            std::vector<std::uint32_t> _outputLink;
+
+            /* bytes patterns start with, if there are few enough of them to skip to with SIMD from the root */
+            std::array<char, 3> _startBytes{};
+            std::size_t _startCount = 0;
+            bool _skipsFromRoot = false;
+
+            std::uint32_t step(std::uint32_t entry, char c) const noexcept {
+                return _table[(entry & ~MATCH) + _classes[static_cast<unsigned char>(c)]];
+            }
+
+            std::uint32_t stateOf(std::uint32_t entry) const noexcept {
+                return static_cast<std::uint32_t>((entry & ~MATCH) / _stride);
+            }
+
+            /** Offset of the 1st byte at or after 'i' some pattern starts with */
+            std::size_t skipToStart(std::string_view haystack, std::size_t i) const noexcept {
+                const char* base = haystack.data();
+                auto size = haystack.size();
+                if (_startCount == 1) {
+                    auto found = std::memchr(base + i, static_cast<unsigned char>(_startBytes[0]), size - i);
+                    return found ? static_cast<const char*>(found) - base : size;
+                }
+#if defined(__SSE2__)
+                auto start0 = _mm_set1_epi8(_startBytes[0]);
+                auto start1 = _mm_set1_epi8(_startBytes[1]);
+                auto start2 = _mm_set1_epi8(_startBytes[_startCount - 1]);
+                for (; i + 16 <= size; i += 16) {
+                    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+                    auto hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, start0), _mm_cmpeq_epi8(chunk, start1)),
+                            _mm_cmpeq_epi8(chunk, start2));
+                    if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits))) {
+                        return i + std::countr_zero(mask);
+                    }
+                }
+#endif
+                auto starts = _startBytes.begin(), startsEnd = starts + _startCount;
+                for (; i < size && std::find(starts, startsEnd, base[i]) == startsEnd; ++i) {}
+                return i;
+            }
+
+            /** Calls onMatchState(i, state) for every position where some pattern ends, until it returns true */
+            template <typename OnMatchState>
+            void scan(std::string_view haystack, std::size_t from, OnMatchState&& onMatchState) const {
+                std::uint32_t entry = 0;
+                for (auto i = from; i < haystack.size(); ++i) {
+                    if (entry == 0 && _skipsFromRoot && (i = skipToStart(haystack, i)) == haystack.size()) {
+                        return;
+                    }
+                    entry = step(entry, haystack[i]);
+                    if ((entry & MATCH) && onMatchState(i, stateOf(entry))) {
+                        return;
+                    }
+                }
+            }
+        public:
+            explicit AhoCorasick(const Patterns& patterns) {
+                std::array<bool, 256> starts{};
+                for (auto& pattern: patterns) {
+                    starts[static_cast<unsigned char>(pattern[0])] = true;
+                    _maxLength = std::max(_maxLength, pattern.size());
+                    for (char c: pattern) {
+                        auto& byteClass = _classes[static_cast<unsigned char>(c)];
+                        if (byteClass == 0) {
+                            byteClass = static_cast<std::uint16_t>(_stride++);
+                        }
+                    }
+                }
+                for (int c = 0; c < 256; ++c) {
+                    if (starts[c] && _startCount++ < _startBytes.size()) {
+                        _startBytes[_startCount - 1] = static_cast<char>(c);
+                    }
+                }
+                _skipsFromRoot = _startCount > 0 && _startCount <= _startBytes.size();
+
+                /* trie; NONE marks missing edges until the failure links fill them in */
+                std::vector<std::uint32_t> next;
+                auto edge = [&next, this](std::uint32_t state, std::size_t byteClass) -> std::uint32_t& {
+                    return next[state * _stride + byteClass];
+                };
+                auto addState = [&next, this] {
+                    next.resize(next.size() + _stride, NONE);
+                    _longest.push_back(NONE);
+                    _own.emplace_back();
+                    _outputLink.push_back(NONE);
+                    return static_cast<std::uint32_t>(_longest.size() - 1);
+                };
+                addState();
+                for (std::uint32_t i = 0; i < patterns.size(); ++i) {
+                    std::uint32_t state = 0;
+                    for (char c: patterns[i]) {
+                        auto byteClass = _classes[static_cast<unsigned char>(c)];
+                        if (edge(state, byteClass) == NONE) {
+                            auto added = addState();
+                            edge(state, byteClass) = added;
+                        }
+                        state = edge(state, byteClass);
+                    }
+                    _own[state].push_back(i);
+                    if (_longest[state] == NONE) {
+                        _longest[state] = i;
+                    }
+                }
+                if (_longest.size() * _stride >= MATCH) {
+                    throw std::length_error("Too many patterns for MultiSearcher");
+                }
+
+                /* breadth-first so that the failure target of a state is always complete before the state itself */
+                std::vector<std::uint32_t> fail(_longest.size(), 0);
+                std::deque<std::uint32_t> queue;
+                for (std::size_t byteClass = 0; byteClass < _stride; ++byteClass) {
+                    auto& target = edge(0, byteClass);
+                    if (target == NONE) {
+                        target = 0;
+                    } else {
+                        queue.push_back(target);
+                    }
+                }
+                while (!queue.empty()) {
+                    auto state = queue.front();
+                    queue.pop_front();
+
+                    auto failure = fail[state];
+                    _outputLink[state] = _own[failure].empty() ? _outputLink[failure] : failure;
+                    if (_longest[state] == NONE) {
+                        _longest[state] = _longest[failure];
+                    }
+                    for (std::size_t byteClass = 0; byteClass < _stride; ++byteClass) {
+                        auto& target = edge(state, byteClass);
+                        if (target == NONE) {
+                            target = edge(failure, byteClass);
+                        } else {
+                            fail[target] = edge(failure, byteClass);
+                            queue.push_back(target);
+                        }
+                    }
+                }
+
+                _table.resize(next.size());
+                for (std::size_t i = 0; i < next.size(); ++i) {
+                    _table[i] = static_cast<std::uint32_t>(next[i] * _stride) | (_longest[next[i]] != NONE ? MATCH : 0);
+                }
+            }
+
+            std::optional<Match> find(const Patterns& patterns, std::string_view haystack, std::size_t from) const {
+                std::optional<Match> best;
+                scan(haystack, from, [&](std::size_t i, std::uint32_t state) {
+                    auto pattern = _longest[state];
+                    auto length = patterns[pattern].size();
+                    keepBest(best, Match{pattern, i + 1 - length, length});
+                    /* nothing ending later can start before the best match */
+                    return i + 1 >= best->position + _maxLength;
+                });
+                return best;
+            }
+
+            void forEachMatch(const Patterns& patterns, std::string_view haystack,
+                    const std::function<void(const Match&)>& f) const {
+                scan(haystack, 0, [&](std::size_t i, std::uint32_t state) {
+                    for (auto output = _own[state].empty() ? _outputLink[state] : state; output != NONE;
+                            output = _outputLink[output]) {
+                        for (auto pattern: _own[output]) {
+                            auto length = patterns[pattern].size();
+                            f(Match{pattern, i + 1 - length, length});
+                        }
+                    }
+                    return false;
+                });
+            }
+        };
+    }
+
+    MultiSearcher::MultiSearcher(std::span<const std::string_view> patterns):
+            _patterns(patterns.begin(), patterns.end()) {
+        for (auto& pattern: _patterns) {
+            if (pattern.empty()) {
+                throw std::invalid_argument("MultiSearcher patterns must not be empty");
+            }
+        }
+#if defined(__SSE2__)
+        if (cpu::hasSsse3() && !_patterns.empty() && _patterns.size() <= _detail::Teddy::MAX_PATTERNS) {
+            _teddy = std::make_unique<_detail::Teddy>(_patterns);
+            return;
+        }
+#endif
+        _ahoCorasick = std::make_unique<_detail::AhoCorasick>(_patterns);
+    }
+
+    MultiSearcher::MultiSearcher(std::span<const std::string> patterns):
+            MultiSearcher(std::vector<std::string_view>(patterns.begin(), patterns.end())) {}
+
+    MultiSearcher::MultiSearcher(std::initializer_list<std::string_view> patterns):
+            MultiSearcher(std::span<const std::string_view>(patterns.begin(), patterns.size())) {}
+
+    MultiSearcher::~MultiSearcher() = default;
+    MultiSearcher::MultiSearcher(MultiSearcher&&) noexcept = default;
+    MultiSearcher& MultiSearcher::operator=(MultiSearcher&&) noexcept = default;
+
+    std::optional<Match> MultiSearcher::find(std::string_view haystack, std::size_t from) const {
+        if (from > haystack.size() || _patterns.empty()) {
+            return std::nullopt;
+        }
+        return _teddy ? _teddy->find(_patterns, haystack, from) : _ahoCorasick->find(_patterns, haystack, from);
+    }
+
+    void MultiSearcher::forEachMatch(std::string_view haystack, const std::function<void(const Match&)>& f) const {
+        if (_teddy) {
+            _teddy->forEachMatch(_patterns, haystack, f);
+        } else {
+            _ahoCorasick->forEachMatch(_patterns, haystack, f);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * Substring search in log lines: one needle with Searcher, many of them at once with MultiSearcher
+ *
+ * Both work on plain string_views so lines coming out of LinesSplitView can be passed as they are
+ * Searchers are built once and then used to look through any number of lines, also from several threads at a time
+ *
+ * Searcher picks the two rarest bytes of the needle, by a fixed frequency table of bytes typical for logs,
+ * and compares 16 positions at a time against both of them with SSE2; only positions where both match
+ * are verified with memcmp, so for most haystacks we never verify anything but the actual matches
+ * A single-byte needle goes to memchr
+ *
+ * MultiSearcher finds the leftmost match of any of the patterns; of the patterns matching there it reports
+ * the longest one. Up to 16 patterns are looked for with Teddy, the SIMD algorithm from Hyperscan:
+ * the first 1 to 3 bytes of the patterns are turned into nibble lookup tables assigning patterns to 8 buckets
+ * and pshufb finds the positions where some bucket's prefix may start, 16 positions per step;
+ * Teddy needs SSSE3, which is checked for at runtime, so without it and for larger sets we use an Aho-Corasick
+ * automaton with full transition tables over byte classes: one table lookup per byte of the haystack however many
+ * patterns there are
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util::text {
+    constexpr std::size_t npos = std::string_view::npos;
+
+    class Searcher {
+        std::string _needle;
+
+        /* offsets of the two rarest bytes of the needle, _rare1 < _rare2 unless the needle is 1 byte long */
+        std::size_t _rare1 = 0;
+        std::size_t _rare2 = 0;
+    public:
+        explicit Searcher(std::string_view needle);
+
+        std::string_view needle() const noexcept {
+            return _needle;
+        }
+
+        /** Offset of the 1st occurrence of the needle at or after 'from' or npos; an empty needle is found at 'from' */
+        std::size_t find(std::string_view haystack, std::size_t from = 0) const noexcept;
+
+        bool contains(std::string_view haystack) const noexcept {
+            return find(haystack) != npos;
+        }
+    };
+
+    struct Match {
+        std::size_t pattern;    // index in the list MultiSearcher was built from
+        std::size_t position;
+        std::size_t length;
+
+        bool operator==(const Match&) const = default;
+    };
+
+    namespace _detail {
+        class Teddy;
+        class AhoCorasick;
+    }
+
+    class MultiSearcher {
+        std::vector<std::string> _patterns;
+        std::unique_ptr<_detail::Teddy> _teddy;
+        std::unique_ptr<_detail::AhoCorasick> _ahoCorasick;
+    public:
+        /** Empty patterns are not allowed, duplicates are */
+        explicit MultiSearcher(std::span<const std::string_view> patterns);
+        explicit MultiSearcher(std::span<const std::string> patterns);
+        MultiSearcher(std::initializer_list<std::string_view> patterns);
+        ~MultiSearcher();
+
+        MultiSearcher(MultiSearcher&&) noexcept;
+        MultiSearcher& operator=(MultiSearcher&&) noexcept;
+
+        const std::vector<std::string>& patterns() const noexcept {
+            return _patterns;
+        }
+
+        /** True if Teddy is used rather than Aho-Corasick */
+        bool usesTeddy() const noexcept {
+            return _teddy != nullptr;
+        }
+
+        /** Leftmost match starting at or after 'from', the longest one if several patterns match there */
+        std::optional<Match> find(std::string_view haystack, std::size_t from = 0) const;
+
+        bool contains(std::string_view haystack) const {
+            return find(haystack).has_value();
+        }
+
+        /** Calls 'f' for every occurrence of every pattern, overlapping ones included, in no particular order */
+        void forEachMatch(std::string_view haystack, const std::function<void(const Match&)>& f) const;
+    };
+}
@@ -0,0 +1,284 @@
+#include <util/trace.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace {
+    using util::trace::_detail::Phase;
+
+    struct Event {
+        std::uint64_t start;
+        std::uint64_t value;
+        const char* name;
+        Phase phase;
+    };
+
+    /**
+     * Single-producer single-consumer ring: the owner thread appends at the head,
+     * the session's flush takes from the tail
+     */
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events;
+        std::uint64_t mask;
+        pid_t tid;
+        std::string name;
+
+        /* producer's: the head and what it last knew of the tail, so it needn't read the consumer's line */
+        alignas(64) std::atomic<std::uint64_t> head = 0;
+        std::uint64_t knownTail = 0;
+        std::atomic<std::uint64_t> dropped = 0;
+
+        alignas(64) std::atomic<std::uint64_t> tail = 0;
+        /* the thread has exited: once drained the buffer can go */
+        std::atomic<bool> finished = false;
+        /* id of the session which has written out our name */
+        std::uint64_t announcedIn = 0;
+
+        ThreadBuffer(std::size_t capacity, pid_t tid, std::string name): events(new Event[capacity]),
+                mask(capacity - 1), tid(tid), name(std::move(name)) {}
+    };
+
+    /** Buffers of all threads which have recorded events and are alive or haven't been drained yet */
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::size_t bufferEvents = util::trace::Options{}.bufferEvents;
+        std::uint64_t lastSession = 0;
+        bool active = false;
+        /* dropped by the threads whose buffers are gone */
+        std::uint64_t dropped = 0;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    /* plain pointer for the hot path, a thread_local with a destructor has to be checked for initialization */
+    thread_local ThreadBuffer* current = nullptr;
+    /* set once the Owner is gone: events recorded by destructors of thread_locals which outlive it are dropped */
+    thread_local bool exited = false;
+
+    /** Lets the flush know when the thread has exited */
+    struct Owner {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~Owner() {
+            /* the flush may free the buffer as soon as it's finished and drained */
+            current = nullptr;
+            exited = true;
+            if (buffer) {
+                buffer->finished.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local Owner owner;
+
+    ThreadBuffer* registerThread() noexcept {
+        /* registering again would store the buffer into a destroyed Owner and never mark it finished */
+        if (exited) {
+            return nullptr;
+        }
+        try {
+            char name[16] = {};
+            ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+            auto& reg = registry();
+            std::lock_guard lock{reg.mutex};
+            auto buffer = std::make_shared<ThreadBuffer>(reg.bufferEvents, ::gettid(), name);
+            reg.buffers.push_back(buffer);
+            owner.buffer = buffer;
+            current = buffer.get();
+            return current;
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void appendEscaped(std::string& out, std::string_view text) {
+        for (char c: text) {
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+}
+
+namespace util::trace {
+    void _detail::record(Phase phase, const char* name, std::uint64_t start, std::uint64_t value) noexcept {
+        auto buffer = current ? current : registerThread();
+        if (!buffer) {
+            return;
+        }
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->knownTail > buffer->mask) {
+            buffer->knownTail = buffer->tail.load(std::memory_order_acquire);
+            if (head - buffer->knownTail > buffer->mask) {
+                buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        buffer->events[head & buffer->mask] = {start, value, name, phase};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    Session::Session(std::filesystem::path path, Options options): _path(std::move(path)) {
+        if (options.bufferEvents < 2 || (options.bufferEvents & (options.bufferEvents - 1)) != 0) {
+            throw std::invalid_argument("Trace buffer size must be a power of two");
+        }
+        auto& reg = registry();
+        {
+            std::lock_guard lock{reg.mutex};
+            if (reg.active) {
+                throw std::logic_error("A trace session is active already");
+            }
+            _file = std::fopen(_path.c_str(), "w");
+            if (!_file) {
+                throw std::system_error(errno, std::generic_category(), "Cannot create " + _path.string());
+            }
+            reg.active = true;
+            reg.bufferEvents = options.bufferEvents;
+            _id = ++reg.lastSession;
+            reg.dropped = 0;
+
+            /* leftovers of an earlier session, e.g. spans which were open when it ended */
+            for (auto& buffer: reg.buffers) {
+                buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+                buffer->dropped.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::fputs("[\n", _file);
+        _startTime = std::chrono::steady_clock::now();
+        _startTicks = _detail::now();
+        _detail::enabled.store(true, std::memory_order_relaxed);
+        _flusher = std::make_unique<util::worker::PeriodicWorker>("trace-flush", options.flushPeriod, [this] {
+            flush();
+        });
+    }
+
+    Session::~Session() {
+        _detail::enabled.store(false, std::memory_order_relaxed);
+        _flusher.reset();
+        flush();
+        std::fputs("\n]\n", _file);
+        std::fclose(_file);
+
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        reg.active = false;
+    }
+
+    void Session::calibrate() {
+        /* a millisecond gives us the rate to 1e-5 or so, good enough for timestamps within a trace */
+        constexpr auto MIN_ELAPSED = std::chrono::milliseconds{1};
+
+        auto elapsed = std::chrono::steady_clock::now() - _startTime;
+        if (elapsed < MIN_ELAPSED && _ticksPerMicro == 0) {
+            std::this_thread::sleep_for(MIN_ELAPSED - elapsed);
+        }
+        auto ticks = _detail::now();
+        elapsed = std::chrono::steady_clock::now() - _startTime;
+        _ticksPerMicro = static_cast<double>(ticks - _startTicks)
+                / std::chrono::duration<double, std::micro>(elapsed).count();
+    }
+
+    void Session::flush() {
+        std::lock_guard lock{_mutex};
+        calibrate();
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            auto& reg = registry();
+            std::lock_guard registryLock{reg.mutex};
+            buffers = reg.buffers;
+        }
+
+        auto pid = ::getpid();
+        auto micros = [this](std::uint64_t ticks) {
+            return static_cast<double>(static_cast<std::int64_t>(ticks)) / _ticksPerMicro;
+        };
+        std::string out;
+        auto next = [&] {
+            out += _first ? "" : ",\n";
+            _first = false;
+        };
+
+        for (auto& buffer: buffers) {
+            auto tail = buffer->tail.load(std::memory_order_relaxed);
+            auto head = buffer->head.load(std::memory_order_acquire);
+            if (buffer->announcedIn != _id && head != tail) {
+                next();
+                fmt::format_to(std::back_inserter(out),
+                        R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":")", pid, buffer->tid);
+                appendEscaped(out, buffer->name);
+                out += "\"}}";
+                buffer->announcedIn = _id;
+            }
+
+            for (; tail != head; ++tail) {
+                auto& event = buffer->events[tail & buffer->mask];
+                next();
+                out += R"({"name":")";
+                appendEscaped(out, event.name);
+                auto ts = micros(event.start - _startTicks);
+                switch (event.phase) {
+                case Phase::COMPLETE:
+                    fmt::format_to(std::back_inserter(out), R"(","ph":"X","ts":{:.3f},"dur":{:.3f})", ts,
+                            static_cast<double>(event.value) / _ticksPerMicro);
+                    break;
+                case Phase::INSTANT:
+                    fmt::format_to(std::back_inserter(out), R"(","ph":"i","s":"t","ts":{:.3f})", ts);
+                    break;
+                case Phase::COUNTER:
+                    fmt::format_to(std::back_inserter(out), R"(","ph":"C","ts":{:.3f},"args":{{"value":{}}})", ts,
+                            static_cast<std::int64_t>(event.value));
+                    break;
+                }
+                fmt::format_to(std::back_inserter(out), R"(,"pid":{},"tid":{}}})", pid, buffer->tid);
+            }
+            /* release: we're done reading the events, the owner may overwrite them */
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+        std::fwrite(out.data(), 1, out.size(), _file);
+        std::fflush(_file);
+
+        auto& reg = registry();
+        std::lock_guard registryLock{reg.mutex};
+        std::erase_if(reg.buffers, [&reg](const std::shared_ptr<ThreadBuffer>& buffer) {
+            auto gone = buffer->finished.load(std::memory_order_acquire)
+                    && buffer->tail.load(std::memory_order_relaxed) == buffer->head.load(std::memory_order_acquire);
+            if (gone) {
+                reg.dropped += buffer->dropped.load(std::memory_order_relaxed);
+            }
+            return gone;
+        });
+    }
+
+    std::uint64_t Session::dropped() const {
+        auto& reg = registry();
+        std::lock_guard lock{reg.mutex};
+        auto total = reg.dropped;
+        for (auto& buffer: reg.buffers) {
+            total += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+}
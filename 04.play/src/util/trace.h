@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * Tracing: where the time goes inside a request, viewed on a timeline in chrome://tracing or ui.perfetto.dev
+ *
+ *     void handle(const Request& request) {
+ *         util::trace::Span span{"handle"};
+ *         ...
+ *         util::trace::counter("queue depth", queue.size());
+ *     }
+ *
+ * Span records a complete event from its construction to its destruction, instant() a point in time
+ * and counter() a value to be plotted; names must be string literals or otherwise live for as long as the program,
+ * we only keep the pointer
+ *
+ * Nothing is recorded unless a Session is active; then
+ * - timestamps are read from the TSC, a few ns, and converted to microseconds only when written out
+ * - each thread has a buffer of its own, a single-producer ring which is written without locks or atomic
+ *   read-modify-writes; a span costs two TSC reads and storing a 32-byte event, tens of ns in all
+ *   If the ring is full because the flush couldn't keep up the event is dropped and counted
+ * - a PeriodicWorker of util::worker drains all buffers into the file in Chrome Trace Event JSON format
+ *
+ * Threads are listed under their names as set by pthread_setname_np() at the time they record the first event:
+ * util::worker names its threads after the workers, util::pool names its threads pool-0, pool-1...
+ */
+
+#include <util/worker.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace util::trace {
+    namespace _detail {
+        enum class Phase: std::uint8_t {
+            COMPLETE, INSTANT, COUNTER
+        };
+
+        inline std::atomic<bool> enabled{false};
+
+        /** Ticks of the TSC, or nanoseconds where there isn't one */
+        inline std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        /** 'value' is the duration in ticks for COMPLETE, the value for COUNTER */
+        void record(Phase phase, const char* name, std::uint64_t start, std::uint64_t value) noexcept;
+    }
+
+    inline bool enabled() noexcept {
+        return _detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    /** Complete event spanning the lifetime of the object */
+    class Span {
+        const char* _name;
+        /* 0 if there was no session when we started */
+        std::uint64_t _start;
+    public:
+        explicit Span(const char* name) noexcept: _name(name), _start(enabled() ? _detail::now() : 0) {}
+
+        ~Span() {
+            if (_start) {
+                _detail::record(_detail::Phase::COMPLETE, _name, _start, _detail::now() - _start);
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    };
+
+    inline void instant(const char* name) noexcept {
+        if (enabled()) {
+            _detail::record(_detail::Phase::INSTANT, name, _detail::now(), 0);
+        }
+    }
+
+    inline void counter(const char* name, std::int64_t value) noexcept {
+        if (enabled()) {
+            _detail::record(_detail::Phase::COUNTER, name, _detail::now(), static_cast<std::uint64_t>(value));
+        }
+    }
+
+    struct Options {
+        std::chrono::milliseconds flushPeriod{100};
+
+        /** Size of the buffer of each thread which records its 1st event during the session, a power of two */
+        std::size_t bufferEvents = 1 << 13;
+    };
+
+    /** Records events into a file from construction to destruction; there may be one session at a time */
+    class Session {
+        std::mutex _mutex;
+        std::FILE* _file;
+        std::filesystem::path _path;
+        bool _first = true;
+        std::uint64_t _id;
+
+        /* TSC at the start, against the steady clock at the start and at the latest flush */
+        std::uint64_t _startTicks;
+        std::chrono::steady_clock::time_point _startTime;
+        double _ticksPerMicro = 0;
+
+        std::unique_ptr<util::worker::PeriodicWorker> _flusher;
+
+        void calibrate();
+    public:
+        /** Throws std::system_error if the file can't be created, std::logic_error if a session is active */
+        explicit Session(std::filesystem::path path, Options options = {});
+
+        /** Stops recording, writes what's left and completes the file */
+        ~Session();
+
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        /** Writes the events recorded so far; done every Options::flushPeriod on a worker thread anyway */
+        void flush();
+
+        /** Events dropped since the session started as buffers were full */
+        std::uint64_t dropped() const;
+    };
+}
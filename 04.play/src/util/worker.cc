@@ -0,0 +1,280 @@
+#include <util/worker.h>
+#include <util/log.h>
+
+#include <algorithm>
+
+#include <pthread.h>
+
+namespace util::worker {
+    struct worker_log{};
+}
+
+namespace {
+    using util::worker::Clock;
+
+    void runLogged(const std::string& name, const std::function<void()>& job) {
+        auto& logger = util::log::getLogger<util::worker::worker_log>();
+        try {
+            job();
+        } catch (const std::exception& e) {
+            logger.error("{} has thrown", name, e);
+        } catch (...) {
+            logger.errorWithCurrentException("Job has thrown something which is not an std::exception");
+        }
+    }
+
+    /** Shows up in top -H, gdb etc; Linux only allows 15 chars */
+    void nameThread(const std::string& name) {
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+
+    /** 1st point of the 'start' + k * 'period' schedule that is strictly after 'now' */
+    Clock::time_point nextOnSchedule(Clock::time_point start, Clock::duration period, Clock::time_point now) {
+        if (start > now) {
+            return start;
+        }
+        return start + ((now - start) / period + 1) * period;
+    }
+}
+
+namespace util::worker {
+    PeriodicWorker::PeriodicWorker(std::string name, Clock::duration period, std::function<void()> job):
+            _name(std::move(name)), _period(period), _job(std::move(job)),
+            _thread([this](std::stop_token stopToken) { run(stopToken); }) {}
+
+    void PeriodicWorker::trigger() {
+        {
+            std::lock_guard lock{_mutex};
+            _triggered = true;
+        }
+        _cv.notify_one();
+    }
+
+    void PeriodicWorker::stop() {
+        _thread.request_stop();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void PeriodicWorker::run(std::stop_token stopToken) {
+        nameThread(_name);
+        auto next = Clock::now() + _period;
+        for (;;) {
+            {
+                std::unique_lock lock{_mutex};
+                bool triggered = _cv.wait_until(lock, stopToken, next, [this] { return _triggered; });
+                if (stopToken.stop_requested()) {
+                    return;
+                }
+                if (triggered) {
+                    _triggered = false;
+                } else {
+                    next = nextOnSchedule(next, _period, Clock::now());
+                }
+            }
+            runLogged(_name, _job);
+        }
+    }
+
+    EventWorker::EventWorker(std::string name, std::function<void()> job): _name(std::move(name)), _job(std::move(job)),
+            _thread([this](std::stop_token stopToken) { run(stopToken); }) {}
+
+    void EventWorker::notify() {
+        {
+            std::lock_guard lock{_mutex};
+            _pending = true;
+        }
+        _cv.notify_one();
+    }
+
+    void EventWorker::stop() {
+        _thread.request_stop();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void EventWorker::run(std::stop_token stopToken) {
+        nameThread(_name);
+        for (;;) {
+            {
+                std::unique_lock lock{_mutex};
+                if (!_cv.wait(lock, stopToken, [this] { return _pending; })) {
+                    return; // stop requested
+                }
+                _pending = false;
+            }
+            runLogged(_name, _job);
+        }
+    }
+
+    namespace _detail {
+        void Wheel::insert(std::uint64_t id, std::uint64_t expiry) {
+            place({id, std::max(expiry, _now + 1)});
+            ++_size;
+        }
+
+        void Wheel::place(const Entry& entry) {
+            auto delta = entry.expiry - _now;
+            for (std::size_t level = 0; level < LEVELS; ++level) {
+                if (delta < std::uint64_t{1} << (BITS * (level + 1))) {
+                    _slots[level][(entry.expiry >> (BITS * level)) & (SLOTS - 1)].push_back(entry);
+                    ++_levelSizes[level];
+                    return;
+                }
+            }
+
+            /* too far away: park in the top level slot which comes round last, that's the one for the current block */
+            constexpr auto top = LEVELS - 1;
+            _slots[top][(_now >> (BITS * top)) & (SLOTS - 1)].push_back(entry);
+            ++_levelSizes[top];
+        }
+
+        void Wheel::cascade() {
+            for (std::size_t level = 1; level < LEVELS; ++level) {
+                if ((_now & ((std::uint64_t{1} << (BITS * level)) - 1)) != 0) {
+                    return;
+                }
+                auto& slot = _slots[level][(_now >> (BITS * level)) & (SLOTS - 1)];
+                if (slot.empty()) {
+                    continue;
+                }
+                auto entries = std::move(slot);
+                slot.clear();
+                _levelSizes[level] -= entries.size();
+                for (auto& entry: entries) {
+                    place(entry);
+                }
+            }
+        }
+
+        std::optional<std::uint64_t> Wheel::nextEvent() const noexcept {
+            if (_size == 0) {
+                return std::nullopt;
+            }
+
+            /* if there's anything on upper levels we need to wake up for the next cascade */
+            std::optional<std::uint64_t> result;
+            if (_size != _levelSizes[0]) {
+                result = (_now | (SLOTS - 1)) + 1;
+            }
+
+            if (_levelSizes[0] != 0) {
+                for (auto tick = _now + 1; tick <= _now + SLOTS; ++tick) {
+                    if (!_slots[0][tick & (SLOTS - 1)].empty()) {
+                        return result ? std::min(*result, tick) : tick;
+                    }
+                }
+            }
+            return result;
+        }
+    }
+
+    TimerWheel::TimerWheel(Clock::duration resolution): _resolution(resolution), _start(Clock::now()),
+            _thread([this](std::stop_token stopToken) { run(stopToken); }) {}
+
+    TimerWheel::~TimerWheel() {
+        _thread.request_stop();
+        _thread.join();
+    }
+
+    std::uint64_t TimerWheel::ticksAt(Clock::time_point time) const {
+        return static_cast<std::uint64_t>((time - _start) / _resolution);
+    }
+
+    TimerWheel::TimerId TimerWheel::add(Clock::duration delay, std::function<void()> callback,
+            std::uint64_t periodTicks) {
+        TimerId id;
+        {
+            std::lock_guard lock{_mutex};
+            id = ++_lastId;
+
+            /* rounding up so that the timer never fires early */
+            auto due = Clock::now() - _start + delay;
+            auto expiry = static_cast<std::uint64_t>((due + _resolution - Clock::duration{1}) / _resolution);
+
+            _timers.emplace(id, Timer{std::make_shared<std::function<void()>>(std::move(callback)), periodTicks});
+            _wheel.insert(id, expiry);
+            _changed = true;
+        }
+        _cv.notify_one();
+        return id;
+    }
+
+    TimerWheel::TimerId TimerWheel::schedule(Clock::duration delay, std::function<void()> callback) {
+        return add(delay, std::move(callback), 0);
+    }
+
+    TimerWheel::TimerId TimerWheel::schedulePeriodic(Clock::duration period, std::function<void()> callback) {
+        auto periodTicks = std::max<std::uint64_t>(1, (period + _resolution - Clock::duration{1}) / _resolution);
+        return add(period, std::move(callback), periodTicks);
+    }
+
+    bool TimerWheel::cancel(TimerId id) {
+        std::lock_guard lock{_mutex};
+        return _timers.erase(id) != 0;
+    }
+
+    std::size_t TimerWheel::size() const {
+        std::lock_guard lock{_mutex};
+        return _timers.size();
+    }
+
+    void TimerWheel::run(std::stop_token stopToken) {
+        nameThread("timer-wheel");
+
+        std::vector<std::pair<TimerId, std::shared_ptr<std::function<void()>>>> due;
+        std::vector<_detail::Wheel::Entry> periodic;
+
+        std::unique_lock lock{_mutex};
+        while (!stopToken.stop_requested()) {
+            _wheel.advance(ticksAt(Clock::now()), [&](const _detail::Wheel::Entry& entry) {
+                auto timer = _timers.find(entry.id);
+                if (timer == _timers.end()) {
+                    return; // cancelled, we don't bother removing those from the wheel
+                }
+                due.emplace_back(entry.id, timer->second.callback);
+                if (auto period = timer->second.periodTicks) {
+                    /* skipping the runs we've missed if we're late but keeping the phase */
+                    auto next = entry.expiry + period;
+                    if (next <= _wheel.now()) {
+                        next += ((_wheel.now() - next) / period + 1) * period;
+                    }
+                    periodic.push_back({entry.id, next});
+                }
+            });
+
+            if (!due.empty()) {
+                for (auto& entry: periodic) {
+                    _wheel.insert(entry.id, entry.expiry);
+                }
+                periodic.clear();
+
+                for (auto& [id, callback]: due) {
+                    /* one of the callbacks we've just run may have cancelled this one */
+                    auto timer = _timers.find(id);
+                    if (timer == _timers.end()) {
+                        continue;
+                    }
+                    if (timer->second.periodTicks == 0) {
+                        _timers.erase(timer);
+                    }
+                    lock.unlock();
+                    runLogged("timer callback", *callback);
+                    lock.lock();
+                }
+                due.clear();
+                continue; // time has moved on while the callbacks were running
+            }
+
+            _changed = false;
+            auto next = _wheel.nextEvent();
+            if (!next) {
+                _cv.wait(lock, stopToken, [this] { return _changed; });
+            } else {
+                _cv.wait_until(lock, stopToken, _start + *next * _resolution, [this] { return _changed; });
+            }
+        }
+    }
+}
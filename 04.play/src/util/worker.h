@@ -0,0 +1,210 @@
+#pragma once
+
+/**
+ * Background workers which stop immediately when asked to, and a timer wheel to run many timers on one thread
+ *
+ * All waiting is done with std::condition_variable_any::wait*() overloads taking a std::stop_token,
+ * so request_stop() - which jthread's destructor calls - wakes the worker right away instead of the worker
+ * noticing it after its next sleep_for() comes to an end
+ *
+ * Callbacks throwing exceptions don't kill the worker: exceptions are logged via util::log and the worker goes on
+ *
+ * PeriodicWorker and EventWorker own a thread each, which is fine for a few long-lived jobs;
+ * for hundreds of small periodic jobs (flushes, metrics, rotation) use TimerWheel which runs them all on one thread
+ */
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace util::worker {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Runs 'job' every 'period', 1st time one period after construction
+     *
+     * If a run takes longer than the period the missed runs are skipped rather than run back to back
+     */
+    class PeriodicWorker {
+        std::string _name;
+        Clock::duration _period;
+        std::function<void()> _job;
+
+        std::mutex _mutex;
+        std::condition_variable_any _cv;
+        bool _triggered = false;
+
+        /* last member so that the thread is stopped and joined before the rest goes away */
+        std::jthread _thread;
+
+        void run(std::stop_token stopToken);
+    public:
+        PeriodicWorker(std::string name, Clock::duration period, std::function<void()> job);
+
+        /** Requests an extra run as soon as possible, e.g. to flush on demand; doesn't shift the schedule */
+        void trigger();
+
+        /** Stops and joins the thread; if the job is running right now waits for it to complete */
+        void stop();
+    };
+
+    /**
+     * Runs 'job' whenever notified; notifications arriving while the job runs are coalesced into one more run
+     * so the job is guaranteed to start at least once after each notify()
+     */
+    class EventWorker {
+        std::string _name;
+        std::function<void()> _job;
+
+        std::mutex _mutex;
+        std::condition_variable_any _cv;
+        bool _pending = false;
+
+        std::jthread _thread;
+
+        void run(std::stop_token stopToken);
+    public:
+        EventWorker(std::string name, std::function<void()> job);
+
+        void notify();
+
+        void stop();
+    };
+
+    namespace _detail {
+        /**
+         * Hierarchical timing wheel, only deals with ticks and timer ids and doesn't know about threads or clocks
+         *
+         * Level 0 has a slot for each of the next 64 ticks, level 1 - for each of the next 64 blocks of 64 ticks
+         * and so on; when a block on level N begins its timers are redistributed over the lower levels
+         * This way inserting is O(1) and each timer is moved at most LEVELS - 1 times before it expires
+         *
+         * Timers further away than 64^LEVELS ticks are parked in the farthest slot and looked at again from there
+         */
+        class Wheel {
+        public:
+            static constexpr unsigned BITS = 6;
+            static constexpr std::size_t SLOTS = 1 << BITS;
+            static constexpr std::size_t LEVELS = 4;
+
+            struct Entry {
+                std::uint64_t id;
+                std::uint64_t expiry;
+            };
+
+            /** Current tick; starts at 0 */
+            std::uint64_t now() const noexcept {
+                return _now;
+            }
+
+            std::size_t size() const noexcept {
+                return _size;
+            }
+
+            /** Timer is going to expire at tick 'expiry', or at the next tick if 'expiry' is not in the future */
+            void insert(std::uint64_t id, std::uint64_t expiry);
+
+            /** Moves current tick forward up to 'target' calling onExpired(const Entry&) for each expired timer */
+            template <typename OnExpired>
+            void advance(std::uint64_t target, OnExpired&& onExpired) {
+                while (_now < target) {
+                    if (_size == 0) {
+                        _now = target;
+                        return;
+                    }
+                    ++_now;
+                    cascade();
+                    auto& slot = _slots[0][_now & (SLOTS - 1)];
+                    if (!slot.empty()) {
+                        auto expired = std::move(slot);
+                        slot.clear();
+                        _levelSizes[0] -= expired.size();
+                        _size -= expired.size();
+                        for (auto& entry: expired) {
+                            onExpired(entry);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * The earliest tick at which advance() may have something to do, nullopt if there are no timers
+             * Empty ticks in between can be slept through
+             */
+            std::optional<std::uint64_t> nextEvent() const noexcept;
+        private:
+            std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> _slots;
+            std::array<std::size_t, LEVELS> _levelSizes{};
+            std::uint64_t _now = 0;
+            std::size_t _size = 0;
+
+            void place(const Entry& entry);
+            void cascade();
+        };
+    }
+
+    /**
+     * Runs any number of one-shot and periodic timers on a single thread
+     *
+     * Resolution is the tick length: timers never fire early but may fire up to one tick late
+     * The thread only wakes up when a timer is due or at most once per 64 ticks otherwise
+     */
+    class TimerWheel {
+    public:
+        using TimerId = std::uint64_t;
+
+        explicit TimerWheel(Clock::duration resolution = std::chrono::milliseconds{1});
+
+        /** Stops the thread; timers that haven't fired by now never will */
+        ~TimerWheel();
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        TimerId schedule(Clock::duration delay, std::function<void()> callback);
+
+        /** 1st run one period from now; stays on its original schedule even if some runs were late */
+        TimerId schedulePeriodic(Clock::duration period, std::function<void()> callback);
+
+        /**
+         * Returns false if the timer has already fired (one-shot) or has already been cancelled
+         * Once this returns the callback won't be started again, though it may be running right now
+         */
+        bool cancel(TimerId id);
+
+        /** Number of timers scheduled and not yet fired or cancelled */
+        std::size_t size() const;
+    private:
+        struct Timer {
+            std::shared_ptr<std::function<void()>> callback;
+            std::uint64_t periodTicks; // 0 for one-shot timers
+        };
+
+        Clock::duration _resolution;
+        Clock::time_point _start;
+
+        mutable std::mutex _mutex;
+        std::condition_variable_any _cv;
+        bool _changed = false;
+        _detail::Wheel _wheel;
+        std::unordered_map<TimerId, Timer> _timers;
+        TimerId _lastId = 0;
+
+        std::jthread _thread;
+
+        std::uint64_t ticksAt(Clock::time_point time) const;
+        TimerId add(Clock::duration delay, std::function<void()> callback, std::uint64_t periodTicks);
+        void run(std::stop_token stopToken);
+    };
+}
@@ -8,6 +8,7 @@
 #include <concepts>
 #include <memory>
 
+#include <util/any.h>
 #include <util/log.h>
 #include <boost/type_index.hpp>
 
@@ -134,6 +135,14 @@ int main() {
     any any_a3{std::move(any_a2)};
     cout << "any_a2.has_value()=" << any_a2.has_value() << endl;
 
+    // same with an inline buffer big enough for a_t: no heap allocations on construction, copies or moves
+    util::any::SmallAny<sizeof(a_t)> small_a1{std::ref(a0)};
+    util::any::SmallAny<sizeof(a_t)> small_a2{a0};
+    any_cast<reference_wrapper<a_t>>(small_a1).get()[0] = 's';
+    any_cast<a_t&>(small_a2)[0] = 'q';
+    cout << "a0[0]=" << a0[0] << " small_a2[0]=" << any_cast<a_t&>(small_a2)[0]
+            << " small_a2.isInline()=" << small_a2.isInline() << endl;
+
     /*cout << "any_a2[0]=" << any_cast<a_t&>(any_a2)[0] << endl;
     cout << "any_a3[0]=" << any_cast<a_t&>(any_a3)[0] << endl;
     any_cast<a_t&>(any_a2)[0] = 'Q';
@@ -0,0 +1,71 @@
+#include <util/allocation_counter.h>
+#include <gtest/gtest.h>
+#include <gtest/gtest-spi.h>
+
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using util::allocation_counter::AllocationCounts;
+using util::allocation_counter::AllocationScope;
+
+namespace {
+    struct alignas(64) Overaligned {
+        char data[64];
+    };
+
+    /** The compiler is allowed to elide a new/delete pair if the pointer doesn't go anywhere */
+    template <typename T>
+    T* escape(T* ptr) {
+        asm volatile("" : : "g"(ptr) : "memory");
+        return ptr;
+    }
+}
+
+TEST(allocation_counter, countsAllForms) {
+    AllocationScope scope;
+    delete escape(new int{1});
+    delete[] escape(new char[100]);
+    delete escape(new Overaligned{});
+    delete escape(new (std::nothrow) long{2});
+    EXPECT_EQ(scope.counts(), (AllocationCounts{.allocations = 4, .frees = 4,
+            .bytes = sizeof(int) + 100 + sizeof(Overaligned) + sizeof(long)}));
+}
+
+TEST(allocation_counter, countsLibraryAllocations) {
+    AllocationScope scope;
+    std::string longString(100, 'x');
+    std::vector<int> vector(10);
+    auto shared = std::make_shared<int>(3);
+    EXPECT_EQ(scope.allocations(), 3u);
+    EXPECT_GE(scope.bytes(), 100u + 10 * sizeof(int));
+}
+
+TEST(allocation_counter, perThread) {
+    AllocationScope scope;
+    std::thread{[] {
+        auto allocated = std::make_unique<std::vector<int>>(1000);
+        EXPECT_GE(util::allocation_counter::threadCounts().allocations, 2u);
+    }}.join();
+
+    /* std::thread itself allocates its state on this thread but nothing of what the thread did is counted here */
+    EXPECT_LT(scope.bytes(), 1000 * sizeof(int));
+}
+
+TEST(allocation_counter, noAllocations) {
+    std::vector<int> reserved;
+    reserved.reserve(10);
+    EXPECT_NO_ALLOCATIONS({
+        for (int i = 0; i < 10; ++i) {
+            reserved.push_back(i);
+        }
+        std::string shortString{"short"};
+    });
+    ASSERT_NO_ALLOCATIONS(reserved.clear());
+}
+
+TEST(allocation_counter, failureIsReported) {
+    EXPECT_NONFATAL_FAILURE(EXPECT_NO_ALLOCATIONS(std::vector<int> v(1, 2)), "allocations made by");
+}
@@ -0,0 +1,130 @@
+#include <util/allocation_counter.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    using util::allocation_counter::AllocationCounts;
+
+    /* constinit: must not need dynamic initialization as it's used from within operator new */
+    constinit thread_local AllocationCounts counts;
+
+    void* allocate(std::size_t size) noexcept {
+        ++counts.allocations;
+        counts.bytes += size;
+        /* operator new(0) must return a unique pointer while malloc(0) is allowed to return nullptr */
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept {
+        ++counts.allocations;
+        counts.bytes += size;
+        void* result = nullptr;
+        if (posix_memalign(&result, std::max(static_cast<std::size_t>(alignment), sizeof(void*)),
+                size == 0 ? 1 : size) != 0) {
+            return nullptr;
+        }
+        return result;
+    }
+
+    void* orThrow(void* allocated) {
+        if (!allocated) {
+            throw std::bad_alloc{};
+        }
+        return allocated;
+    }
+
+    void release(void* ptr) noexcept {
+        if (ptr) {
+            ++counts.frees;
+            std::free(ptr);
+        }
+    }
+}
+
+namespace util::allocation_counter {
+    AllocationCounts threadCounts() noexcept {
+        return counts;
+    }
+}
+
+void* operator new(std::size_t size) {
+    return orThrow(allocate(size));
+}
+
+void* operator new[](std::size_t size) {
+    return orThrow(allocate(size));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return orThrow(allocateAligned(size, alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return orThrow(allocateAligned(size, alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+/*
+    This file contains another testing utility, a sibling of memory_counter.h
+
+    memory_counter.h lets a test count operations on a container that imitates allocating memory;
+    this one counts real heap allocations: allocation_counter.cc replaces global operator new and operator delete
+    in every binary that links util::allocation_counter, that is tests and benchmarks
+
+    Counts are kept per thread in plain thread_local variables so counting costs next to nothing
+    and allocations made by other threads, e.g. gtest's or a logging backend's, don't get in the way
+
+    AllocationScope takes a snapshot of the current thread's counts when constructed
+    and tells how many allocations have been made since
+
+    EXPECT_NO_ALLOCATIONS({ ... }) and ASSERT_NO_ALLOCATIONS({ ... }) run the given statements
+    and check that they haven't allocated; they are meant for gtest tests which include this file
+
+    Only operator new is seen; memory obtained directly via malloc() is not counted
+*/
+
+namespace util::allocation_counter {
+    struct AllocationCounts {
+        std::uint64_t allocations = 0;
+        std::uint64_t frees = 0;
+        std::uint64_t bytes = 0;    // allocated, frees don't subtract
+
+        AllocationCounts operator-(const AllocationCounts& other) const {
+            return {allocations - other.allocations, frees - other.frees, bytes - other.bytes};
+        }
+
+        bool operator==(const AllocationCounts&) const = default;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const AllocationCounts& counts) {
+        os << "{allocations=" << counts.allocations << ", frees=" << counts.frees
+                << ", bytes=" << counts.bytes << '}';
+        return os;
+    }
+
+    /** Totals for the calling thread since it started */
+    AllocationCounts threadCounts() noexcept;
+
+    class AllocationScope {
+        AllocationCounts _start = threadCounts();
+    public:
+        /** What the calling thread has allocated since this scope was created */
+        AllocationCounts counts() const noexcept {
+            return threadCounts() - _start;
+        }
+
+        std::uint64_t allocations() const noexcept {
+            return counts().allocations;
+        }
+
+        std::uint64_t bytes() const noexcept {
+            return counts().bytes;
+        }
+    };
+}
+
+#define _ALLOCATION_COUNTER_CHECK_NONE(ASSERTION, ...) \
+    do { \
+        ::util::allocation_counter::AllocationScope _allocationScope; \
+        __VA_ARGS__; \
+        auto _allocations = _allocationScope.counts(); \
+        ASSERTION(_allocations.allocations, 0u) << "allocations made by " #__VA_ARGS__ ": " << _allocations; \
+    } while (false)
+
+/* variadic so that commas inside the braces don't split the statement into several macro arguments */
+#define EXPECT_NO_ALLOCATIONS(...) _ALLOCATION_COUNTER_CHECK_NONE(EXPECT_EQ, __VA_ARGS__)
+#define ASSERT_NO_ALLOCATIONS(...) _ALLOCATION_COUNTER_CHECK_NONE(ASSERT_EQ, __VA_ARGS__)
@@ -0,0 +1,148 @@
+#include <util/any.h>
+#include <benchmark/benchmark.h>
+
+#include <any>
+#include <array>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+/*
+ * Message payloads of three types, 8, 32 and 128 bytes, kept in std::any, util::any::SmallAny<128>
+ * and std::variant; the last one is the baseline as it knows all the types upfront
+ *
+ * BM_Store* fill a vector with payloads, BM_Visit* sum a field of every payload, BM_Copy* copy the vector
+ *
+ * std::any only keeps the smallest payload inline so storing and copying the others goes to the heap;
+ * SmallAny<128> keeps all of them inline
+ *
+ * Results are reported in payloads/s
+ */
+
+namespace {
+    constexpr int PAYLOADS = 1024;
+
+    struct Ping {
+        std::uint64_t id;
+    };
+
+    struct Quote {
+        double bid;
+        double ask;
+        std::array<char, 16> symbol;
+    };
+
+    struct Blob {
+        std::array<char, 128> bytes;
+    };
+
+    using Variant = std::variant<Ping, Quote, Blob>;
+    using SmallAny = util::any::SmallAny<128>;
+
+    template <typename Payload>
+    void store(std::vector<Payload>& payloads) {
+        payloads.clear();
+        for (int i = 0; i < PAYLOADS; ++i) {
+            switch (i % 3) {
+                case 0:
+                    payloads.emplace_back(Ping{static_cast<std::uint64_t>(i)});
+                    break;
+                case 1:
+                    payloads.emplace_back(Quote{1.0 * i, 1.0 * i + 1, {'A', 'B', 'C'}});
+                    break;
+                default:
+                    payloads.emplace_back(Blob{{static_cast<char>(i)}});
+            }
+        }
+    }
+
+    std::uint64_t value(const Ping& ping) {
+        return ping.id;
+    }
+
+    std::uint64_t value(const Quote& quote) {
+        return static_cast<std::uint64_t>(quote.bid);
+    }
+
+    std::uint64_t value(const Blob& blob) {
+        return static_cast<std::uint64_t>(blob.bytes[0]);
+    }
+
+    /* any_cast is found by ADL for SmallAny and via the using-declaration for std::any */
+    template <typename Any>
+    std::uint64_t visitAny(const Any& any) {
+        using std::any_cast;
+        if (auto ping = any_cast<Ping>(&any)) {
+            return value(*ping);
+        }
+        if (auto quote = any_cast<Quote>(&any)) {
+            return value(*quote);
+        }
+        if (auto blob = any_cast<Blob>(&any)) {
+            return value(*blob);
+        }
+        return 0;
+    }
+
+    std::uint64_t visit(const std::any& any) {
+        return visitAny(any);
+    }
+
+    std::uint64_t visit(const SmallAny& any) {
+        return visitAny(any);
+    }
+
+    std::uint64_t visit(const Variant& variant) {
+        return std::visit([](const auto& payload) { return value(payload); }, variant);
+    }
+
+    void setCounters(benchmark::State& state) {
+        state.counters["payloads"] = benchmark::Counter(state.iterations() * PAYLOADS, benchmark::Counter::kIsRate);
+    }
+
+    template <typename Payload>
+    void BM_Store(benchmark::State& state) {
+        std::vector<Payload> payloads;
+        payloads.reserve(PAYLOADS);
+        for (auto _: state) {
+            store(payloads);
+            benchmark::DoNotOptimize(payloads.data());
+        }
+        setCounters(state);
+    }
+
+    template <typename Payload>
+    void BM_Visit(benchmark::State& state) {
+        std::vector<Payload> payloads;
+        store(payloads);
+        for (auto _: state) {
+            std::uint64_t sum = 0;
+            for (const auto& payload: payloads) {
+                sum += visit(payload);
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        setCounters(state);
+    }
+
+    template <typename Payload>
+    void BM_Copy(benchmark::State& state) {
+        std::vector<Payload> payloads;
+        store(payloads);
+        for (auto _: state) {
+            auto copy = payloads;
+            benchmark::DoNotOptimize(copy.data());
+        }
+        setCounters(state);
+    }
+}
+
+BENCHMARK(BM_Store<std::any>);
+BENCHMARK(BM_Store<SmallAny>);
+BENCHMARK(BM_Store<Variant>);
+BENCHMARK(BM_Visit<std::any>);
+BENCHMARK(BM_Visit<SmallAny>);
+BENCHMARK(BM_Visit<Variant>);
+BENCHMARK(BM_Copy<std::any>);
+BENCHMARK(BM_Copy<SmallAny>);
+BENCHMARK(BM_Copy<Variant>);
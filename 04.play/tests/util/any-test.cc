@@ -0,0 +1,173 @@
+#include <util/any.h>
+#include <util/allocation_counter.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using util::any::SmallAny;
+using util::any::UniqueAny;
+
+namespace {
+    /** Counts live instances to check that every value gets destroyed exactly once */
+    struct Tracked {
+        static inline int alive = 0;
+        int value;
+
+        explicit Tracked(int value): value(value) {
+            ++alive;
+        }
+
+        Tracked(const Tracked& other): value(other.value) {
+            ++alive;
+        }
+
+        Tracked(Tracked&& other) noexcept: value(other.value) {
+            ++alive;
+        }
+
+        ~Tracked() {
+            --alive;
+        }
+    };
+
+    struct alignas(64) Overaligned {
+        int value;
+    };
+
+    using Array = std::array<char, 128>;
+}
+
+TEST(any, emptyAndReset) {
+    SmallAny<> any;
+    EXPECT_FALSE(any.has_value());
+    EXPECT_EQ(util::any::any_cast<int>(&any), nullptr);
+    EXPECT_THROW(util::any::any_cast<int>(any), std::bad_any_cast);
+
+    any = 42;
+    EXPECT_TRUE(any.has_value());
+    EXPECT_TRUE(any.holds<int>());
+    EXPECT_FALSE(any.holds<long>());
+    any.reset();
+    EXPECT_FALSE(any.has_value());
+}
+
+TEST(any, anyCastForms) {
+    SmallAny<> any{std::string("foo")};
+    EXPECT_EQ(any_cast<std::string>(any), "foo");
+    EXPECT_EQ(any_cast<const std::string&>(any), "foo");
+    any_cast<std::string&>(any) += "bar";
+    EXPECT_EQ(*any_cast<std::string>(&any), "foobar");
+    EXPECT_EQ(any_cast<std::string>(std::as_const(any)), "foobar");
+    EXPECT_EQ(any_cast<int>(&any), nullptr);
+    EXPECT_THROW(any_cast<int>(any), std::bad_any_cast);
+
+    auto moved = any_cast<std::string>(std::move(any));
+    EXPECT_EQ(moved, "foobar");
+}
+
+TEST(any, inlineOrHeap) {
+    EXPECT_TRUE(SmallAny<128>{Array{}}.isInline());
+    EXPECT_FALSE(SmallAny<64>{Array{}}.isInline());
+    EXPECT_FALSE(SmallAny<128>{Overaligned{}}.isInline());
+    EXPECT_TRUE(SmallAny<8>{1}.isInline());
+    EXPECT_FALSE(SmallAny<>{}.isInline());
+
+    SmallAny<> overaligned{Overaligned{7}};
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(any_cast<Overaligned>(&overaligned)) % 64, 0u);
+    EXPECT_EQ(any_cast<Overaligned&>(overaligned).value, 7);
+}
+
+TEST(any, inlineDoesNotAllocate) {
+    Array array{};
+    array[0] = 'z';
+    EXPECT_NO_ALLOCATIONS({
+        SmallAny<128> any{array};
+        SmallAny<128> copy{any};
+        SmallAny<128> moved{std::move(copy)};
+        any = moved;
+        EXPECT_EQ(any_cast<Array&>(any)[0], 'z');
+    });
+}
+
+TEST(any, referenceWrapper) {
+    Array array{};
+    SmallAny<> any{std::ref(array)};
+    EXPECT_TRUE(any.isInline());
+    any_cast<std::reference_wrapper<Array>>(any).get()[0] = 'c';
+    EXPECT_EQ(array[0], 'c');
+
+    /* a copy of the any refers to the same array */
+    auto copy = any;
+    any_cast<std::reference_wrapper<Array>&>(copy).get()[1] = 'd';
+    EXPECT_EQ(array[1], 'd');
+    EXPECT_EQ(any_cast<Array>(&copy), nullptr);
+}
+
+TEST(any, copyAndMove) {
+    for (auto value: {1, 2}) {
+        SmallAny<16> inlined{Tracked{value}};
+        SmallAny<16> heap{std::vector<Tracked>(3, Tracked{value})};
+        EXPECT_EQ(Tracked::alive, 4);
+
+        auto inlinedCopy = inlined;
+        auto heapCopy = heap;
+        EXPECT_EQ(Tracked::alive, 8);
+        EXPECT_EQ(any_cast<Tracked&>(inlinedCopy).value, value);
+        EXPECT_EQ(any_cast<std::vector<Tracked>&>(heapCopy)[2].value, value);
+
+        SmallAny<16> moved{std::move(inlined)};
+        EXPECT_FALSE(inlined.has_value());
+        EXPECT_EQ(Tracked::alive, 8);
+
+        heap = std::move(moved);
+        EXPECT_EQ(Tracked::alive, 5);
+        EXPECT_TRUE(heap.holds<Tracked>());
+
+        swap(heap, heapCopy);
+        EXPECT_TRUE(heap.holds<std::vector<Tracked>>());
+        EXPECT_TRUE(heapCopy.holds<Tracked>());
+
+        auto& alias = heap;
+        heap = alias;
+        inlinedCopy = std::string("replaced");
+        EXPECT_EQ(Tracked::alive, 4);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(any, emplace) {
+    SmallAny<> any{std::in_place_type<std::string>, 3, 'x'};
+    EXPECT_EQ(any_cast<std::string&>(any), "xxx");
+    auto& vector = any.emplace<std::vector<int>>({1, 2, 3});
+    EXPECT_EQ(vector.size(), 3u);
+    EXPECT_EQ(any_cast<std::vector<int>&>(any).data(), vector.data());
+}
+
+TEST(any, unique) {
+    static_assert(!std::is_copy_constructible_v<UniqueAny<>>);
+    static_assert(!std::is_constructible_v<SmallAny<>, std::unique_ptr<int>>);
+
+    UniqueAny<> any{std::make_unique<int>(5)};
+    EXPECT_TRUE(any.isInline());
+    UniqueAny<> moved{std::move(any)};
+    EXPECT_FALSE(any.has_value());
+    EXPECT_EQ(*any_cast<std::unique_ptr<int>&>(moved), 5);
+
+    auto taken = any_cast<std::unique_ptr<int>>(std::move(moved));
+    EXPECT_EQ(*taken, 5);
+    EXPECT_EQ(any_cast<std::unique_ptr<int>&>(moved), nullptr);
+}
+
+TEST(any, sameTypeDifferentAnys) {
+    /* the vtable depends on the size, holds<>() must still work for each */
+    SmallAny<4> small{std::string("heap")};
+    SmallAny<64> big{std::string("inline")};
+    EXPECT_TRUE(small.holds<std::string>());
+    EXPECT_TRUE(big.holds<std::string>());
+    EXPECT_FALSE(small.isInline());
+    EXPECT_TRUE(big.isInline());
+}
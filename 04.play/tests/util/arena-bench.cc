@@ -0,0 +1,129 @@
+#include <util/arena.h>
+#include <benchmark/benchmark.h>
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+/*
+ * A request-like workload: a few hundred strings and small vectors get built, looked at and all thrown away
+ *
+ * BM_Default uses the global allocator, BM_Monotonic std::pmr::monotonic_buffer_resource created per request
+ * on top of the default resource, BM_Arena pmr containers on an ArenaResource reset after each request;
+ * BM_ArenaRaw skips pmr altogether and bump-allocates the same sizes directly
+ *
+ * Results are reported in requests/s; range(0) is the number of objects per request
+ */
+
+namespace {
+    template <typename String, typename Vector, typename... Resource>
+    std::size_t processRequest(int objects, Resource*... resource) {
+        std::vector<String> strings;
+        std::vector<Vector> vectors;
+        strings.reserve(objects);
+        vectors.reserve(objects);
+        for (int i = 0; i < objects; ++i) {
+            auto& string = strings.emplace_back(resource...);
+            string.append("key-").append(std::to_string(i)).append(" with a value long enough to skip SSO");
+            auto& vector = vectors.emplace_back(resource...);
+            for (int j = 0; j < i % 16 + 1; ++j) {
+                vector.push_back(j * i);
+            }
+        }
+        std::size_t total = 0;
+        for (int i = 0; i < objects; ++i) {
+            total += strings[i].size() + vectors[i].size();
+        }
+        return total;
+    }
+
+    void setCounters(benchmark::State& state) {
+        state.counters["requests"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    void BM_Default(benchmark::State& state) {
+        for (auto _: state) {
+            benchmark::DoNotOptimize(processRequest<std::string, std::vector<int>>(state.range(0)));
+        }
+        setCounters(state);
+    }
+
+    void BM_Monotonic(benchmark::State& state) {
+        for (auto _: state) {
+            std::pmr::monotonic_buffer_resource resource;
+            benchmark::DoNotOptimize(processRequest<std::pmr::string, std::pmr::vector<int>>(
+                    state.range(0), &resource));
+        }
+        setCounters(state);
+    }
+
+    void BM_Arena(benchmark::State& state) {
+        util::arena::Arena arena;
+        util::arena::ArenaResource resource{arena};
+        for (auto _: state) {
+            benchmark::DoNotOptimize(processRequest<std::pmr::string, std::pmr::vector<int>>(
+                    state.range(0), &resource));
+            arena.reset();
+        }
+        setCounters(state);
+    }
+
+    void BM_ArenaHugePages(benchmark::State& state) {
+        util::arena::Arena arena{{.hugePages = true}};
+        util::arena::ArenaResource resource{arena};
+        for (auto _: state) {
+            benchmark::DoNotOptimize(processRequest<std::pmr::string, std::pmr::vector<int>>(
+                    state.range(0), &resource));
+            arena.reset();
+        }
+        setCounters(state);
+    }
+
+    /** An arena per request: blocks come from the thread cache */
+    void BM_ArenaPerRequest(benchmark::State& state) {
+        for (auto _: state) {
+            util::arena::Arena arena;
+            util::arena::ArenaResource resource{arena};
+            benchmark::DoNotOptimize(processRequest<std::pmr::string, std::pmr::vector<int>>(
+                    state.range(0), &resource));
+        }
+        setCounters(state);
+    }
+
+    /** The allocator's own cost: as many allocations of similar sizes with nothing built in them */
+    void BM_ArenaRaw(benchmark::State& state) {
+        util::arena::Arena arena;
+        for (auto _: state) {
+            for (int i = 0; i < state.range(0); ++i) {
+                benchmark::DoNotOptimize(arena.allocate(48, 1));
+                benchmark::DoNotOptimize(arena.allocateArray<int>(i % 16 + 1));
+            }
+            arena.reset();
+        }
+        setCounters(state);
+    }
+
+    void BM_DefaultRaw(benchmark::State& state) {
+        std::vector<void*> allocations(2 * state.range(0));
+        for (auto _: state) {
+            for (int i = 0; i < state.range(0); ++i) {
+                allocations[2 * i] = ::operator new(48);
+                allocations[2 * i + 1] = ::operator new((i % 16 + 1) * sizeof(int));
+                benchmark::DoNotOptimize(allocations[2 * i]);
+                benchmark::DoNotOptimize(allocations[2 * i + 1]);
+            }
+            for (auto allocation: allocations) {
+                ::operator delete(allocation);
+            }
+        }
+        setCounters(state);
+    }
+}
+
+BENCHMARK(BM_Default)->Range(16, 4096);
+BENCHMARK(BM_Monotonic)->Range(16, 4096);
+BENCHMARK(BM_Arena)->Range(16, 4096);
+BENCHMARK(BM_ArenaHugePages)->Range(16, 4096);
+BENCHMARK(BM_ArenaPerRequest)->Range(16, 4096);
+BENCHMARK(BM_ArenaRaw)->Range(16, 4096);
+BENCHMARK(BM_DefaultRaw)->Range(16, 4096);
@@ -0,0 +1,145 @@
+#include <util/arena.h>
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+using util::arena::Arena;
+using util::arena::ArenaResource;
+using util::arena::Options;
+
+namespace {
+    bool isAligned(void* ptr, std::size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+}
+
+TEST(arena, alignment) {
+    Arena arena;
+    for (std::size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        arena.allocate(1, 1);
+        auto ptr = arena.allocate(3, alignment);
+        EXPECT_TRUE(isAligned(ptr, alignment)) << alignment;
+    }
+    EXPECT_TRUE(isAligned(arena.allocateArray<double>(3), alignof(double)));
+}
+
+TEST(arena, allocationsDontOverlap) {
+    Arena arena{{.blockSize = 4096}};
+    std::vector<unsigned char*> allocations;
+    for (int i = 0; i < 1000; ++i) {
+        auto ptr = static_cast<unsigned char*>(arena.allocate(i % 100 + 1, 8));
+        std::memset(ptr, i & 0xff, i % 100 + 1);
+        allocations.push_back(ptr);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        for (int j = 0; j < i % 100 + 1; ++j) {
+            ASSERT_EQ(allocations[i][j], i & 0xff);
+        }
+    }
+}
+
+TEST(arena, zeroBytes) {
+    Arena arena;
+    EXPECT_NE(arena.allocate(0), nullptr);
+}
+
+TEST(arena, resetReusesBlocks) {
+    Arena arena{{.blockSize = 4096}};
+    auto fill = [&arena] {
+        for (int i = 0; i < 100; ++i) {
+            arena.allocate(200);
+        }
+    };
+    auto first = arena.allocate(1);
+    fill();
+    auto reserved = arena.bytesReserved();
+    EXPECT_GE(arena.bytesUsed(), 100u * 200);
+    EXPECT_GE(reserved, arena.bytesUsed());
+
+    arena.reset();
+    EXPECT_EQ(arena.bytesUsed(), 0u);
+    for (int round = 0; round < 5; ++round) {
+        arena.reset();
+        fill();
+        EXPECT_EQ(arena.bytesReserved(), reserved);
+    }
+    arena.reset();
+    EXPECT_EQ(arena.allocate(1), first);
+}
+
+TEST(arena, largeAllocations) {
+    Arena arena{{.blockSize = 4096}};
+    auto small = arena.allocate(16);
+    auto large = static_cast<char*>(arena.allocate(100'000, 64));
+    EXPECT_TRUE(isAligned(large, 64));
+    std::memset(large, 1, 100'000);
+    EXPECT_GE(arena.bytesReserved(), 100'000u + 4096);
+
+    /* the large allocation doesn't disturb the current block */
+    EXPECT_EQ(static_cast<char*>(arena.allocate(16)), static_cast<char*>(small) + 16);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytesReserved(), 4096u);
+}
+
+TEST(arena, release) {
+    Arena arena;
+    arena.allocate(1000);
+    arena.release();
+    EXPECT_EQ(arena.bytesReserved(), 0u);
+    EXPECT_EQ(arena.bytesUsed(), 0u);
+    EXPECT_NE(arena.allocate(1000), nullptr);
+}
+
+TEST(arena, threadCache) {
+    void* block;
+    {
+        Arena arena;
+        block = arena.allocate(1);
+    }
+    {
+        /* the block of the previous arena went to this thread's cache */
+        Arena arena;
+        EXPECT_EQ(arena.allocate(1), block);
+    }
+    std::thread{[block] {
+        Arena arena;
+        EXPECT_NE(arena.allocate(1), block);
+    }}.join();
+}
+
+TEST(arena, hugePages) {
+    Arena arena{{.blockSize = 4096, .hugePages = true}};
+    auto ptr = static_cast<char*>(arena.allocate(1000));
+    std::memset(ptr, 1, 1000);
+    EXPECT_EQ(arena.bytesReserved(), 2u * 1024 * 1024);
+}
+
+TEST(arena, pmrContainers) {
+    Arena arena;
+    ArenaResource resource{arena};
+    std::pmr::vector<std::pmr::string> strings{&resource};
+    for (int i = 0; i < 100; ++i) {
+        strings.emplace_back(fmt::format("a string long enough not to fit into SSO #{}", i));
+    }
+    EXPECT_EQ(strings[42], "a string long enough not to fit into SSO #42");
+    EXPECT_GT(arena.bytesUsed(), 100u * 40);
+    EXPECT_TRUE(resource.is_equal(resource));
+    EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST(arena, formatBuffer) {
+    Arena arena;
+    ArenaResource resource{arena};
+    using Allocator = std::pmr::polymorphic_allocator<char>;
+    fmt::basic_memory_buffer<char, 16, Allocator> buffer{Allocator{&resource}};
+    fmt::format_to(std::back_inserter(buffer), "{} and {}", std::string(100, 'x'), 42);
+    EXPECT_EQ(std::string_view(buffer.data(), buffer.size()), std::string(100, 'x') + " and 42");
+    EXPECT_GE(arena.bytesUsed(), 100u);
+}
@@ -0,0 +1,192 @@
+#include <util/coro.h>
+#include <util/log.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <boost/log/sinks.hpp>
+
+using util::coro::Task;
+using util::coro::ThreadPool;
+using util::coro::syncWait;
+using util::coro::whenAll;
+
+namespace testexc {
+    class TestException: public std::logic_error {
+        using logic_error::logic_error;
+    };
+}
+
+namespace {
+    Task<int> answer() {
+        co_return 42;
+    }
+
+    Task<std::string> twice() {
+        auto a = co_await answer();
+        auto b = co_await answer();
+        co_return std::to_string(a + b);
+    }
+
+    Task<> nothing(int& counter) {
+        ++counter;
+        co_return;
+    }
+
+    const std::exception* thrown = nullptr;
+
+    __attribute__((noinline))
+    void c_a() {
+        testexc::TestException e{"thrown in a task"};
+        throw e;
+    }
+
+    Task<int> failing(ThreadPool& pool) {
+        co_await pool.schedule();
+        try {
+            c_a();
+        } catch (const std::exception& e) {
+            thrown = &e;
+            throw;
+        }
+        co_return 0;
+    }
+
+    Task<int> awaitFailing(ThreadPool& pool) {
+        co_return co_await failing(pool) + 1;
+    }
+}
+
+TEST(coro, chain) {
+    EXPECT_EQ(syncWait(twice()), "84");
+
+    int counter = 0;
+    syncWait(nothing(counter));
+    EXPECT_EQ(counter, 1);
+
+    /* a loop of tasks completing synchronously; kept modest since sanitizer builds don't get tail calls */
+    auto loop = [](int& counter) -> Task<> {
+        for (int i = 0; i < 1'000; ++i) {
+            co_await nothing(counter);
+        }
+    };
+    syncWait(loop(counter));
+    EXPECT_EQ(counter, 1'001);
+}
+
+TEST(coro, lazy) {
+    int counter = 0;
+    {
+        auto task = nothing(counter);
+        EXPECT_FALSE(task.isReady());
+    }
+    EXPECT_EQ(counter, 0);
+}
+
+TEST(coro, exceptionIsTheSameObject) {
+    ThreadPool pool{2};
+    try {
+        syncWait(awaitFailing(pool));
+        FAIL() << "should have thrown";
+    } catch (const testexc::TestException& e) {
+        EXPECT_EQ(&e, thrown);
+        EXPECT_STREQ(e.what(), "thrown in a task");
+    }
+}
+
+TEST(coro, pool) {
+    constexpr int TASKS = 10'000;
+    ThreadPool pool{4};
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> inFlight = 0;
+    std::atomic<int> maxInFlight = 0;
+
+    auto work = [&](int i) -> Task<long> {
+        co_await pool.schedule();
+        {
+            std::lock_guard lock{mutex};
+            threads.insert(std::this_thread::get_id());
+        }
+        auto now = ++inFlight;
+        for (auto max = maxInFlight.load(); now > max && !maxInFlight.compare_exchange_weak(max, now);) {}
+
+        /* hop onto the pool again as if waiting for some I/O */
+        co_await pool.schedule();
+        --inFlight;
+        co_return i;
+    };
+
+    std::vector<Task<long>> tasks;
+    for (int i = 0; i < TASKS; ++i) {
+        tasks.push_back(work(i));
+    }
+    auto results = syncWait(whenAll(std::move(tasks)));
+
+    ASSERT_EQ(results.size(), TASKS);
+    EXPECT_EQ(std::accumulate(results.begin(), results.end(), 0L), long{TASKS} * (TASKS - 1) / 2);
+    EXPECT_TRUE(std::ranges::is_sorted(results));
+    EXPECT_FALSE(threads.contains(std::this_thread::get_id()));
+    EXPECT_LE(threads.size(), pool.size());
+
+    /* far more operations were started than there are threads */
+    EXPECT_GT(maxInFlight.load(), static_cast<int>(pool.size()));
+}
+
+TEST(coro, whenAllTuple) {
+    ThreadPool pool{2};
+    int counter = 0;
+
+    auto onPool = [&pool]() -> Task<int> {
+        co_await pool.schedule();
+        co_return 7;
+    };
+
+    auto [a, b, c] = syncWait(whenAll(answer(), nothing(counter), onPool()));
+    EXPECT_EQ(a, 42);
+    EXPECT_EQ(b, std::monostate{});
+    EXPECT_EQ(c, 7);
+    EXPECT_EQ(counter, 1);
+
+    EXPECT_THROW(syncWait(whenAll(answer(), failing(pool), onPool())), testexc::TestException);
+
+    std::vector<Task<>> none;
+    syncWait(whenAll(std::move(none)));
+}
+
+namespace sinks = boost::log::sinks;
+using text_sink = sinks::synchronous_sink<sinks::text_ostream_backend>;
+
+struct test{};
+
+/** Exception thrown on a pool thread and logged by the awaiter still has its stack trace */
+TEST(coro, loggedWithStackTrace) {
+    auto output = boost::make_shared<std::ostringstream>();
+    auto sink = boost::make_shared<text_sink>();
+    sink->locked_backend()->add_stream(output);
+    util::log::setStandardLogFormat(sink);
+    boost::log::core::get()->add_sink(sink);
+    util::log::commonLoggingSetup();
+
+    ThreadPool pool{1};
+    try {
+        syncWait(awaitFailing(pool));
+    } catch (const std::exception& e) {
+        util::log::getLogger<test>().error("Task failed", e);
+    }
+    sink->flush();
+    boost::log::core::get()->remove_sink(sink);
+
+    auto result = output->str();
+    EXPECT_NE(result.find(" #ERROR [test] Task failed: testexc::TestException(thrown in a task)"), std::string::npos)
+            << " but it is " << result;
+    EXPECT_NE(result.find("\n\t@ "), std::string::npos) << " but it is " << result;
+}
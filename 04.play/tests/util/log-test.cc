@@ -1,11 +1,13 @@
 #include <util/log.h>
+#include <util/pool.h>
 #include <util/str_split.h>
+#include <util/allocation_counter.h>
 #include <gtest/gtest.h>
 
 #include <iostream>
 #include <exception>
-#include <future>
 
+#include <boost/log/expressions.hpp>
 #include <boost/log/sinks.hpp>
 
 #include <fmt/std.h>
@@ -210,9 +212,11 @@ TEST_F(LogTests, nestedWithCurrent) {
     doTestNestedException(extractResult());
 }
 
+/** Future::get() rethrows the very exception object the task has thrown so its stack trace is still there */
 TEST_F(LogTests, fromAnotherThread) {
     auto& logger = util::log::getLogger<test>();
-    auto future = std::async(std::launch::async, a_c);
+    util::pool::Pool pool{1};
+    auto future = pool.submit(a_c);
     try {
         future.get();
     } catch (std::exception& e) {
@@ -221,3 +225,19 @@ TEST_F(LogTests, fromAnotherThread) {
 
     doTestSimpleException(extractResult());
 }
+
+/** Debug logging left in hot paths must cost next to nothing once filtered out: no formatting and no allocations */
+TEST_F(LogTests, filteredOutDoesNotAllocate) {
+    auto& logger = util::log::getLogger<test>();
+    logger.debug("creates the logger and whatever Boost sets up on 1st use");
+
+    logging::core::get()->set_filter(
+            logging::expressions::attr<util::log::severity_level>("Severity") > util::log::DEBUG);
+    EXPECT_NO_ALLOCATIONS(logger.debug("Not interesting: {} {}", 42, std::string_view{"abc"}));
+    /* constructed outside of the check since std::logic_error allocates a copy of its message */
+    std::logic_error error{"test"};
+    EXPECT_NO_ALLOCATIONS(logger.debug("Not interesting either", error));
+    logging::core::get()->reset_filter();
+
+    extractResult();
+}
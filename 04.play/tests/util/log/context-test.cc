@@ -0,0 +1,182 @@
+#include <util/log/context.h>
+#include <util/allocation_counter.h>
+#include <util/coro.h>
+#include <util/log.h>
+#include <util/pool.h>
+#include <gtest/gtest.h>
+
+#include <boost/log/core.hpp>
+#include <boost/make_shared.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+using util::log::context::Adopt;
+using util::log::context::Context;
+using util::log::context::MAX_ATTRIBUTES;
+using util::log::context::Scope;
+using util::log::context::VALUE_CAPACITY;
+using util::log::context::current;
+
+namespace {
+    /** "key=value key=value" of the current thread's context */
+    std::string describe(const Context& context = current()) {
+        std::string result;
+        for (auto& attribute: context.attributes()) {
+            if (!result.empty()) {
+                result += ' ';
+            }
+            result.append(attribute.key).append("=").append(attribute.view());
+        }
+        return result;
+    }
+
+    struct test_marker {};
+}
+
+TEST(context, scopes) {
+    EXPECT_TRUE(current().empty());
+    {
+        Scope requestId{"requestId", 42};
+        Scope tenant{"tenant", "acme"};
+        EXPECT_EQ(describe(), "requestId=42 tenant=acme");
+        {
+            Scope inner{"tenant", std::string{"other"}};
+            Scope negative{"offset", -7L};
+            EXPECT_EQ(current().find("tenant"), "other");
+            EXPECT_EQ(describe(), "requestId=42 tenant=acme tenant=other offset=-7");
+        }
+        EXPECT_EQ(current().find("tenant"), "acme");
+        EXPECT_EQ(current().find("nonexistent"), "");
+    }
+    EXPECT_TRUE(current().empty());
+}
+
+TEST(context, fixedSlots) {
+    std::string longValue(VALUE_CAPACITY + 10, 'x');
+    EXPECT_NO_ALLOCATIONS({
+        Scope first{"long", longValue};
+        EXPECT_EQ(current().find("long"), std::string_view{longValue}.substr(0, VALUE_CAPACITY));
+
+        Scope s1{"k", 1}, s2{"k", 2}, s3{"k", 3}, s4{"k", 4}, s5{"k", 5}, s6{"k", 6}, s7{"k", 7};
+        EXPECT_EQ(current().size(), MAX_ATTRIBUTES);
+        {
+            Scope ignored{"ignored", "value"};
+            EXPECT_EQ(current().size(), MAX_ATTRIBUTES);
+            EXPECT_EQ(current().find("ignored"), "");
+        }
+        EXPECT_EQ(current().find("k"), "7");
+    });
+    EXPECT_TRUE(current().empty());
+}
+
+TEST(context, adopt) {
+    Context carried;
+    {
+        Scope requestId{"requestId", 1};
+        carried = current();
+    }
+    Scope mine{"thread", "main"};
+    {
+        Adopt adopt{carried};
+        EXPECT_EQ(describe(), "requestId=1");
+        Scope more{"step", 2};
+        EXPECT_EQ(describe(), "requestId=1 step=2");
+    }
+    EXPECT_EQ(describe(), "thread=main");
+}
+
+TEST(context, capture) {
+    EXPECT_EQ(util::log::context::capture(), nullptr);
+
+    std::unique_ptr<Context> carried;
+    {
+        Scope requestId{"requestId", 1};
+        carried = util::log::context::capture();
+    }
+    ASSERT_NE(carried, nullptr);
+    EXPECT_EQ(describe(*carried), "requestId=1");
+
+    Scope mine{"thread", "main"};
+    {
+        Adopt adopt{carried.get()};
+        EXPECT_EQ(describe(), "requestId=1");
+    }
+    {
+        Adopt nothing{static_cast<const Context*>(nullptr)};
+        EXPECT_TRUE(current().empty());
+    }
+    EXPECT_EQ(describe(), "thread=main");
+}
+
+TEST(context, carriedIntoPoolTasks) {
+    util::pool::Pool pool{2};
+    Scope requestId{"requestId", 7};
+
+    auto future = pool.submit([&pool] {
+        auto outer = describe();
+        Scope nested{"nested", "yes"};
+        /* subtasks get the context of the task submitting them */
+        auto inner = pool.submit([] { return describe(); }).get();
+        return outer + " / " + inner;
+    });
+    EXPECT_EQ(future.get(), "requestId=7 / requestId=7 nested=yes");
+
+    /* pool threads don't keep the context of the tasks they've run */
+    {
+        Adopt nothing{Context{}};
+        EXPECT_EQ(pool.submit([] { return describe(); }).get(), "");
+    }
+    EXPECT_EQ(describe(), "requestId=7");
+}
+
+TEST(context, carriedAcrossCoroutineHops) {
+    using util::coro::Task;
+    util::coro::ThreadPool pool{2};
+
+    auto work = [&](int i) -> Task<std::string> {
+        Scope requestId{"requestId", i};
+        co_await pool.schedule();
+        auto afterHop = describe();
+        {
+            Scope step{"step", "io"};
+            co_await pool.schedule();
+            afterHop += " / " + describe();
+        }
+        co_return afterHop + " / " + describe();
+    };
+
+    Scope mine{"thread", "main"};
+    auto [first, second] = util::coro::syncWait(util::coro::whenAll(work(1), work(2)));
+    EXPECT_EQ(first, "thread=main requestId=1 / thread=main requestId=1 step=io / thread=main requestId=1");
+    EXPECT_EQ(second, "thread=main requestId=2 / thread=main requestId=2 step=io / thread=main requestId=2");
+
+    /* the tasks have left their scopes on pool threads, this thread's context is as it was */
+    EXPECT_EQ(describe(), "thread=main");
+}
+
+TEST(context, formatted) {
+    using text_sink = boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>;
+    auto output = boost::make_shared<std::ostringstream>();
+    auto sink = boost::make_shared<text_sink>();
+    sink->locked_backend()->add_stream(output);
+    util::log::setStandardLogFormat(sink);
+    boost::log::core::get()->add_sink(sink);
+    util::log::commonLoggingSetup();
+
+    auto& logger = util::log::getLogger<test_marker>();
+    logger.info("without");
+    {
+        Scope requestId{"requestId", 42};
+        Scope tenant{"tenant", "acme"};
+        logger.info("with {}", "context");
+    }
+    sink->flush();
+    boost::log::core::get()->remove_sink(sink);
+
+    auto text = output->str();
+    EXPECT_NE(text.find("test_marker] without\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("test_marker] {requestId=42, tenant=acme} with context\n"), std::string::npos) << text;
+}
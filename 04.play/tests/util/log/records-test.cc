@@ -0,0 +1,107 @@
+#include <util/log/records.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using util::log::records::RecordsView;
+using util::log::records::Severity;
+using util::log::records::findRecordStart;
+using util::log::records::isHeader;
+using util::log::records::parseHeader;
+using util::log::records::parseTimestamp;
+using namespace std::string_view_literals;
+
+namespace {
+    std::vector<std::string> texts(std::string_view input) {
+        std::vector<std::string> result;
+        for (auto& record: RecordsView{input}) {
+            result.emplace_back(record.text);
+        }
+        return result;
+    }
+
+    constexpr auto LOG = "2025-01-31 12:00:00.000001 #INFO  [main] starting\n"
+            "2025-01-31 12:00:01.500000 #ERROR [util::pool::Pool] Exception: some::TestException: test\n"
+            "\t@ 0# f5() at exceptions.cc:32\n"
+            "\t--stacktrace-converges-with-this-thread--\n"
+            "\t@ 1# main at exceptions.cc:80\n"
+            "\tcaused by some::Other: nested\n"
+            "\t\t@ 0# f6() at exceptions.cc:40\n"
+            "2025-01-31 12:00:02.000000 #WARN  [main] two\nlines\n"sv;
+}
+
+TEST(records, timestamps) {
+    EXPECT_EQ(parseTimestamp("1970-01-01 00:00:00.000000"), 0);
+    EXPECT_EQ(parseTimestamp("1970-01-02 00:00:01.5"), 86'401'500'000);
+    EXPECT_EQ(parseTimestamp("2025-01-31 12:00:00.000001 #INFO"), 1'738'324'800'000'001);
+    EXPECT_EQ(parseTimestamp("1969-12-31 23:59:59.999999"), -1);
+    EXPECT_EQ(parseTimestamp("2025-01-31 12:00:00."), std::nullopt);
+    EXPECT_EQ(parseTimestamp("2025-01-31T12:00:00.000000"), std::nullopt);
+    EXPECT_EQ(parseTimestamp("\t@ 0# main"), std::nullopt);
+
+    static_assert(isHeader("2025-01-31 12:00:00.123456 #INFO  [main] x"));
+    static_assert(!isHeader("2025-01-31 12:00"));
+}
+
+TEST(records, headers) {
+    auto header = parseHeader("2025-01-31 12:00:00.000001 #INFO  [main] starting up");
+    ASSERT_TRUE(header);
+    EXPECT_EQ(header->timestamp, "2025-01-31 12:00:00.000001");
+    EXPECT_EQ(header->severity, Severity::INFO);
+    EXPECT_EQ(header->channel, "main");
+    EXPECT_EQ(header->message, "starting up");
+
+    header = parseHeader("2025-01-31 12:00:00.000001 #ERROR [std::array<int, 3>] ");
+    ASSERT_TRUE(header);
+    EXPECT_EQ(header->severity, Severity::ERROR);
+    EXPECT_EQ(header->channel, "std::array<int, 3>");
+    EXPECT_EQ(header->message, "");
+
+    header = parseHeader("2025-01-31 12:00:00.000001 #UKNWN [a[b]] x");
+    ASSERT_TRUE(header);
+    EXPECT_EQ(header->severity, Severity::UNKNOWN);
+    EXPECT_EQ(header->channel, "a[b]");
+
+    EXPECT_FALSE(parseHeader("2025-01-31 12:00:00.000001 INFO [main] x"));
+    EXPECT_FALSE(parseHeader("2025-01-31 12:00:00.000001 #INFO main"));
+}
+
+TEST(records, continuationLines) {
+    EXPECT_EQ(texts(LOG), (std::vector<std::string>{
+            "2025-01-31 12:00:00.000001 #INFO  [main] starting",
+            "2025-01-31 12:00:01.500000 #ERROR [util::pool::Pool] Exception: some::TestException: test\n"
+            "\t@ 0# f5() at exceptions.cc:32\n"
+            "\t--stacktrace-converges-with-this-thread--\n"
+            "\t@ 1# main at exceptions.cc:80\n"
+            "\tcaused by some::Other: nested\n"
+            "\t\t@ 0# f6() at exceptions.cc:40",
+            "2025-01-31 12:00:02.000000 #WARN  [main] two\nlines"}));
+
+    auto crlf = "2025-01-31 12:00:00.1 #INFO  [a] x\r\n\t@ y\r\n2025-01-31 12:00:00.2 #INFO  [a] z\r\n"sv;
+    EXPECT_EQ(texts(crlf), (std::vector<std::string>{"2025-01-31 12:00:00.1 #INFO  [a] x\r\n\t@ y",
+            "2025-01-31 12:00:00.2 #INFO  [a] z"}));
+}
+
+TEST(records, headless) {
+    auto input = "\t@ 3# tail of a trace\n2025-01-31 12:00:00.1 #INFO  [a] x\n"sv;
+    std::vector<bool> hasHeader;
+    for (auto& record: RecordsView{input}) {
+        hasHeader.push_back(record.hasHeader);
+    }
+    EXPECT_EQ(hasHeader, (std::vector<bool>{false, true}));
+    EXPECT_EQ(texts(""), std::vector<std::string>{});
+}
+
+TEST(records, findRecordStart) {
+    auto second = LOG.find("2025-01-31 12:00:01");
+    auto third = LOG.find("2025-01-31 12:00:02");
+    EXPECT_EQ(findRecordStart(LOG, 0), 0);
+    EXPECT_EQ(findRecordStart(LOG, 1), second);
+    EXPECT_EQ(findRecordStart(LOG, second), second);
+    /* from anywhere inside the stack trace */
+    EXPECT_EQ(findRecordStart(LOG, second + 100), third);
+    EXPECT_EQ(findRecordStart(LOG, third + 1), LOG.size());
+    EXPECT_EQ(findRecordStart(LOG, LOG.size() + 10), LOG.size());
+}
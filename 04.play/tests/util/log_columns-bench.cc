@@ -0,0 +1,202 @@
+#include <util/log_columns.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Kernels of util::log_columns over 16M records, about a minute of a busy service; items/s tells how far
+ * we are from aggregating 100M records in well under a second on a single core
+ *
+ * Query is what a dashboard does: WARN and above of one channel in an hour, counted per minute
+ * Structs does the same over a std::vector of structs with std::string fields, which is what we had before
+ *
+ * Append fills the store from 64MB of log text
+ */
+
+namespace {
+    using namespace util::log_columns;
+
+    constexpr std::size_t RECORDS = 16 << 20;
+    constexpr std::int64_t MINUTE = 60'000'000;
+
+    const RecordStore& theStore() {
+        static const RecordStore store = [] {
+            std::mt19937 gen{42};
+            RecordStore result;
+            result.reserve(RECORDS, 0);
+            std::int64_t time = 0;
+            std::array<std::string, 20> channels;
+            for (std::size_t i = 0; i < channels.size(); ++i) {
+                channels[i] = fmt::format("channel{}", i);
+            }
+            for (std::size_t i = 0; i < RECORDS; ++i) {
+                time += gen() % 500;
+                auto severity = gen() % 100 == 0 ? Severity::ERROR : gen() % 10 == 0 ? Severity::WARN : Severity::INFO;
+                result.push(time, severity, channels[gen() % channels.size()], {});
+            }
+            return result;
+        }();
+        return store;
+    }
+
+    void SelectTime(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            selectTime(store.timestamps(), MINUTE, 2 * MINUTE, mask);
+            benchmark::DoNotOptimize(mask.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void SelectSeverities(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        Severities wanted;
+        wanted.set(static_cast<std::size_t>(Severity::WARN)).set(static_cast<std::size_t>(Severity::ERROR));
+        for (auto _: state) {
+            selectSeverities(store.severities(), wanted, mask);
+            benchmark::DoNotOptimize(mask.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void SelectChannel(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            selectChannel(store.channels(), 7, mask);
+            benchmark::DoNotOptimize(mask.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void Count(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            benchmark::DoNotOptimize(count(mask));
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void CountBySeverity(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            std::array<std::size_t, SEVERITY_COUNT> counts{};
+            countBySeverity(store.severities(), mask, counts);
+            benchmark::DoNotOptimize(counts.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void CountByChannel(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            std::vector<std::size_t> counts(store.channelNames().size());
+            countByChannel(store.channels(), mask, counts);
+            benchmark::DoNotOptimize(counts.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void CountByInterval(benchmark::State& state) {
+        auto& store = theStore();
+        auto mask = store.selectAll();
+        for (auto _: state) {
+            std::vector<std::size_t> counts(60);
+            countByInterval(store.timestamps(), mask, 0, MINUTE / 60, counts);
+            benchmark::DoNotOptimize(counts.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void Query(benchmark::State& state) {
+        auto& store = theStore();
+        Severities wanted;
+        wanted.set(static_cast<std::size_t>(Severity::WARN)).set(static_cast<std::size_t>(Severity::ERROR));
+        /* a piece at a time, so what one kernel has read is still in cache for the next one */
+        constexpr std::size_t PIECE = 16 << 10;
+        for (auto _: state) {
+            std::vector<std::size_t> counts(60);
+            Mask mask(PIECE);
+            for (std::size_t begin = 0; begin < store.size(); begin += PIECE) {
+                auto size = std::min(PIECE, store.size() - begin);
+                auto timestamps = store.timestamps().subspan(begin, size);
+                auto piece = std::span(mask).first(size);
+                std::ranges::fill(piece, 1);
+                selectTime(timestamps, 0, 60 * MINUTE, piece);
+                selectSeverities(store.severities().subspan(begin, size), wanted, piece);
+                selectChannel(store.channels().subspan(begin, size), 7, piece);
+                countByInterval(timestamps, piece, 0, MINUTE, counts);
+            }
+            benchmark::DoNotOptimize(counts.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void Structs(benchmark::State& state) {
+        struct Parsed {
+            std::int64_t timestamp;
+            Severity severity;
+            std::string channel;
+            std::string message;
+        };
+        auto& store = theStore();
+        std::vector<Parsed> parsed;
+        for (std::size_t i = 0; i < store.size(); ++i) {
+            parsed.push_back({store.timestamps()[i], static_cast<Severity>(store.severities()[i]),
+                    std::string{store.channelNames().name(store.channels()[i])}, std::string{store.message(i)}});
+        }
+        for (auto _: state) {
+            std::vector<std::size_t> counts(60);
+            for (auto& record: parsed) {
+                if (record.timestamp >= 0 && record.timestamp < 60 * MINUTE && record.severity >= Severity::WARN
+                        && record.severity <= Severity::ERROR && record.channel == "channel7") {
+                    ++counts[record.timestamp / MINUTE];
+                }
+            }
+            benchmark::DoNotOptimize(counts.data());
+        }
+        state.SetItemsProcessed(state.iterations() * store.size());
+    }
+
+    void Append(benchmark::State& state) {
+        std::mt19937 gen{42};
+        std::string text;
+        std::int64_t time = 0;
+        while (text.size() < (64 << 20)) {
+            time += gen() % 60'000;
+            text += fmt::format("2025-01-31 {:02}:{:02}:{:02}.{:06} #INFO  [channel{}] request handled in {} ms\n",
+                    time / 3'600'000'000 % 24, time / MINUTE % 60, time / 1'000'000 % 60, time % 1'000'000,
+                    gen() % 20, gen() % 100);
+        }
+        for (auto _: state) {
+            RecordStore store;
+            store.append(text);
+            benchmark::DoNotOptimize(store.size());
+        }
+        state.SetBytesProcessed(state.iterations() * text.size());
+    }
+}
+
+BENCHMARK(SelectTime)->Unit(benchmark::kMillisecond);
+BENCHMARK(SelectSeverities)->Unit(benchmark::kMillisecond);
+BENCHMARK(SelectChannel)->Unit(benchmark::kMillisecond);
+BENCHMARK(Count)->Unit(benchmark::kMillisecond);
+BENCHMARK(CountBySeverity)->Unit(benchmark::kMillisecond);
+BENCHMARK(CountByChannel)->Unit(benchmark::kMillisecond);
+BENCHMARK(CountByInterval)->Unit(benchmark::kMillisecond);
+BENCHMARK(Query)->Unit(benchmark::kMillisecond);
+BENCHMARK(Structs)->Unit(benchmark::kMillisecond);
+BENCHMARK(Append)->Unit(benchmark::kMillisecond);
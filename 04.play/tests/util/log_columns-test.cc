@@ -0,0 +1,166 @@
+#include <util/log_columns.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+using util::log_columns::ChannelId;
+using util::log_columns::Mask;
+using util::log_columns::RecordStore;
+using util::log_columns::Severities;
+using util::log_columns::Severity;
+using util::log_columns::SEVERITY_COUNT;
+using util::log::records::parseTimestamp;
+
+namespace {
+    struct Columns {
+        std::vector<std::int64_t> timestamps;
+        std::vector<std::uint8_t> severities;
+        std::vector<ChannelId> channels;
+        Mask mask;
+    };
+
+    /** Sizes which aren't multiples of 16 so that the scalar tails get their share */
+    Columns randomColumns(std::mt19937& gen, std::size_t size) {
+        Columns result;
+        std::int64_t time = 1'000'000;
+        for (std::size_t i = 0; i < size; ++i) {
+            /* mostly forward, sometimes back */
+            time += static_cast<std::int64_t>(gen() % 1000) - 100;
+            result.timestamps.push_back(time);
+            result.severities.push_back(static_cast<std::uint8_t>(gen() % SEVERITY_COUNT));
+            result.channels.push_back(gen() % 7);
+            result.mask.push_back(gen() % 3 != 0);
+        }
+        return result;
+    }
+}
+
+TEST(log_columns, append) {
+    RecordStore store;
+    auto added = store.append(
+            "\t@ 1# cut() - no header, skipped\n"
+            "2025-01-31 12:00:00.000001 #INFO  [main] starting\n"
+            "2025-01-31 12:00:01.500000 #ERROR [util::pool::Pool] Exception: test\n"
+            "\t@ 0# f5() at exceptions.cc:32\n"
+            "2025-01-31 12:00:02.000000 #WARN  [main] crlf\r\n"
+            "2025-01-31 12:00:03.000000 #NOTE  [worker] unknown severity");
+    EXPECT_EQ(added, 4);
+    ASSERT_EQ(store.size(), 4);
+
+    EXPECT_EQ(store.timestamps()[0], parseTimestamp("2025-01-31 12:00:00.000001"));
+    EXPECT_EQ(store.timestamps()[1], parseTimestamp("2025-01-31 12:00:01.5"));
+    EXPECT_EQ(store.severities()[1], static_cast<std::uint8_t>(Severity::ERROR));
+    EXPECT_EQ(store.severities()[3], static_cast<std::uint8_t>(Severity::UNKNOWN));
+
+    EXPECT_EQ(store.channels()[0], store.channels()[2]);
+    EXPECT_EQ(store.channelNames().size(), 3);
+    EXPECT_EQ(store.channelNames().name(store.channels()[1]), "util::pool::Pool");
+    EXPECT_EQ(store.channelNames().find("worker"), store.channels()[3]);
+    EXPECT_FALSE(store.channelNames().find("nope"));
+
+    /* line breaks between lines of a record are kept, the one ending it is not */
+    EXPECT_EQ(store.message(0), "starting");
+    EXPECT_EQ(store.message(1), "Exception: test\n\t@ 0# f5() at exceptions.cc:32");
+    EXPECT_EQ(store.message(2), "crlf");
+    EXPECT_EQ(store.message(3), "unknown severity");
+
+    /* appending more keeps the ids */
+    store.push(7, Severity::DEBUG, "main", "pushed");
+    EXPECT_EQ(store.channels()[4], store.channels()[0]);
+    EXPECT_EQ(store.message(4), "pushed");
+    EXPECT_EQ(store.message(3), "unknown severity");
+}
+
+TEST(log_columns, select) {
+    std::mt19937 gen{1};
+    for (std::size_t size: {0, 1, 15, 16, 17, 100, 1001}) {
+        auto columns = randomColumns(gen, size);
+        auto since = columns.timestamps.empty() ? 0 : columns.timestamps[size / 3];
+        auto until = since + 20'000;
+        Severities wanted;
+        wanted.set(static_cast<std::size_t>(Severity::WARN)).set(static_cast<std::size_t>(Severity::UNKNOWN));
+
+        Mask expected = columns.mask;
+        for (std::size_t i = 0; i < size; ++i) {
+            auto t = columns.timestamps[i];
+            expected[i] &= t >= since && t < until && wanted[columns.severities[i]] && columns.channels[i] == 3;
+        }
+
+        auto mask = columns.mask;
+        util::log_columns::selectTime(columns.timestamps, since, until, mask);
+        util::log_columns::selectSeverities(columns.severities, wanted, mask);
+        util::log_columns::selectChannel(columns.channels, 3, mask);
+        EXPECT_EQ(mask, expected) << size;
+
+        std::size_t expectedCount = 0;
+        for (auto selected: expected) {
+            expectedCount += selected;
+        }
+        EXPECT_EQ(util::log_columns::count(mask), expectedCount);
+    }
+}
+
+TEST(log_columns, selectTimeExtremes) {
+    /* enough of them for the SIMD loop to see each value in every position */
+    constexpr std::int64_t BIG = std::int64_t{1} << 32;
+    std::vector<std::int64_t> values{INT64_MIN, -1, 0, 1, INT64_MAX, INT64_MIN + 1, BIG, BIG - 1, -BIG};
+    std::vector<std::int64_t> timestamps;
+    for (std::size_t i = 0; i < 17; ++i) {
+        timestamps.insert(timestamps.end(), values.begin(), values.end());
+    }
+    using Range = std::pair<std::int64_t, std::int64_t>;
+    for (auto [since, until]: {Range{INT64_MIN, 1}, Range{0, INT64_MAX}, Range{-BIG, BIG}, Range{1, 1}}) {
+        Mask expected;
+        for (auto t: timestamps) {
+            expected.push_back(t >= since && t < until);
+        }
+        Mask mask(timestamps.size(), 1);
+        util::log_columns::selectTime(timestamps, since, until, mask);
+        EXPECT_EQ(mask, expected) << since << " " << until;
+    }
+}
+
+TEST(log_columns, groupBy) {
+    std::mt19937 gen{2};
+    auto columns = randomColumns(gen, 5003);
+
+    std::array<std::size_t, SEVERITY_COUNT> severityCounts{};
+    std::array<std::size_t, SEVERITY_COUNT> expectedSeverityCounts{};
+    std::vector<std::size_t> channelCounts(7);
+    std::vector<std::size_t> expectedChannelCounts(7);
+    std::int64_t origin = columns.timestamps[100];
+    std::int64_t width = 10'000;
+    std::vector<std::size_t> intervalCounts(50);
+    std::vector<std::size_t> expectedIntervalCounts(50);
+    for (std::size_t i = 0; i < columns.mask.size(); ++i) {
+        if (columns.mask[i]) {
+            ++expectedSeverityCounts[columns.severities[i]];
+            ++expectedChannelCounts[columns.channels[i]];
+            auto t = columns.timestamps[i];
+            if (t >= origin && t < origin + 50 * width) {
+                ++expectedIntervalCounts[(t - origin) / width];
+            }
+        }
+    }
+
+    /* in two pieces, the counts add up */
+    auto cut = columns.mask.size() / 3;
+    for (auto [begin, end]: {std::pair{std::size_t{0}, cut}, std::pair{cut, columns.mask.size()}}) {
+        auto mask = std::span(columns.mask).subspan(begin, end - begin);
+        util::log_columns::countBySeverity(std::span(columns.severities).subspan(begin, end - begin), mask,
+                severityCounts);
+        util::log_columns::countByChannel(std::span(columns.channels).subspan(begin, end - begin), mask,
+                channelCounts);
+        util::log_columns::countByInterval(std::span(columns.timestamps).subspan(begin, end - begin), mask,
+                origin, width, intervalCounts);
+    }
+    EXPECT_EQ(severityCounts, expectedSeverityCounts);
+    EXPECT_EQ(channelCounts, expectedChannelCounts);
+    EXPECT_EQ(intervalCounts, expectedIntervalCounts);
+}
@@ -0,0 +1,58 @@
+#include <util/log_follow.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Latency from write() of a line to the Follower delivering it on another thread: each iteration writes a line
+ * and waits for it to come out, so the time per iteration is the whole round trip through inotify and pread()
+ */
+
+namespace {
+    void Latency(benchmark::State& state) {
+        auto path = std::filesystem::temp_directory_path() / fmt::format("log_follow-bench-{}.log", ::getpid());
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            state.SkipWithError("Cannot create the log");
+            return;
+        }
+
+        std::atomic<std::uint64_t> delivered = 0;
+        util::log_follow::Follower follower{path};
+        std::jthread thread{[&](std::stop_token stopToken) {
+            follower.run(stopToken, [&delivered](std::string_view) {
+                delivered.fetch_add(1);
+                delivered.notify_one();
+            });
+        }};
+
+        constexpr std::string_view LINE = "2025-01-31 12:00:00.000000 #INFO  [main] request handled in 3 ms\n";
+        std::uint64_t written = 0;
+        for (auto _: state) {
+            if (::write(fd, LINE.data(), LINE.size()) != static_cast<ssize_t>(LINE.size())) {
+                state.SkipWithError("Cannot write the log");
+                break;
+            }
+            ++written;
+            for (auto seen = delivered.load(); seen != written; seen = delivered.load()) {
+                delivered.wait(seen);
+            }
+        }
+
+        thread.request_stop();
+        thread.join();
+        ::close(fd);
+        std::filesystem::remove(path);
+    }
+}
+
+BENCHMARK(Latency)->UseRealTime()->Unit(benchmark::kMicrosecond);
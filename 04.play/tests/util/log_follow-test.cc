@@ -0,0 +1,161 @@
+#include <util/log_follow.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+using util::log_follow::Change;
+using util::log_follow::Follower;
+using util::log_follow::Options;
+
+namespace {
+    /** Generous since the test machine may be busy; the bench measures the actual latency */
+    constexpr auto PROMPTLY = 2s;
+
+    class TempDir {
+        std::filesystem::path _path;
+    public:
+        TempDir(): _path(std::filesystem::temp_directory_path() / fmt::format("log_follow-test-{}", ::getpid())) {
+            std::filesystem::remove_all(_path);
+            std::filesystem::create_directory(_path);
+        }
+
+        ~TempDir() {
+            std::filesystem::remove_all(_path);
+        }
+
+        const std::filesystem::path& path() const {
+            return _path;
+        }
+    };
+
+    void append(const std::filesystem::path& path, std::string_view text) {
+        std::ofstream out{path, std::ios::app | std::ios::binary};
+        out << text;
+    }
+
+    /** Runs a Follower on a thread of its own and collects what it delivers, changes as "<TRUNCATED>" etc */
+    class Collector {
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::vector<std::string> _seen;
+        Follower _follower;
+        std::jthread _thread;
+    public:
+        explicit Collector(const std::filesystem::path& path, Options options = {}): _follower(path, options),
+                _thread([this](std::stop_token stopToken) {
+                    _follower.run(stopToken, [this](std::string_view line) { add(std::string{line}); },
+                            [this](Change change) {
+                                add(change == Change::TRUNCATED ? "<TRUNCATED>" : "<ROTATED>");
+                            });
+                }) {}
+
+        void add(std::string item) {
+            std::lock_guard lock{_mutex};
+            _seen.push_back(std::move(item));
+            _cv.notify_all();
+        }
+
+        /** Waits for 'count' items in all and returns them */
+        std::vector<std::string> waitFor(std::size_t count) {
+            std::unique_lock lock{_mutex};
+            _cv.wait_for(lock, PROMPTLY, [&] { return _seen.size() >= count; });
+            return _seen;
+        }
+
+        std::jthread& thread() {
+            return _thread;
+        }
+    };
+}
+
+TEST(log_follow, partialLines) {
+    TempDir dir;
+    auto path = dir.path() / "app.log";
+    append(path, "old\n");
+
+    Collector collector{path};
+    append(path, "one\ntw");
+    EXPECT_EQ(collector.waitFor(1), (std::vector<std::string>{"one"}));
+    append(path, "o\r");
+    append(path, "\nthree\r\n");
+    EXPECT_EQ(collector.waitFor(3), (std::vector<std::string>{"one", "two", "three"}));
+}
+
+TEST(log_follow, fromStartAndLateFile) {
+    TempDir dir;
+    auto path = dir.path() / "app.log";
+    append(path, "old\n");
+    {
+        Collector collector{path, Options{.fromStart = true}};
+        EXPECT_EQ(collector.waitFor(1), (std::vector<std::string>{"old"}));
+    }
+
+    auto late = dir.path() / "late.log";
+    Collector collector{late};
+    append(late, "first\n");
+    EXPECT_EQ(collector.waitFor(1), (std::vector<std::string>{"first"}));
+}
+
+TEST(log_follow, truncation) {
+    TempDir dir;
+    auto path = dir.path() / "app.log";
+    append(path, "0123456789\n");
+
+    Collector collector{path};
+    append(path, "a\nunfinished");
+    collector.waitFor(1);
+    std::filesystem::resize_file(path, 0);
+    append(path, "b\n");
+    EXPECT_EQ(collector.waitFor(4), (std::vector<std::string>{"a", "unfinished", "<TRUNCATED>", "b"}));
+}
+
+TEST(log_follow, rotation) {
+    TempDir dir;
+    auto path = dir.path() / "app.log";
+    append(path, "");
+
+    Collector collector{path};
+    append(path, "a\n");
+    collector.waitFor(1);
+
+    /* the writer may still append to the old file after it's been renamed, until it reopens the name */
+    std::filesystem::rename(path, dir.path() / "app.log.1");
+    append(dir.path() / "app.log.1", "b\nlast");
+    EXPECT_EQ(collector.waitFor(2), (std::vector<std::string>{"a", "b"}));
+
+    append(path, "c\n");
+    EXPECT_EQ(collector.waitFor(5), (std::vector<std::string>{"a", "b", "last", "<ROTATED>", "c"}));
+
+    /* deleted and created anew */
+    std::filesystem::remove(path);
+    append(path, "d\n");
+    EXPECT_EQ(collector.waitFor(7), (std::vector<std::string>{"a", "b", "last", "<ROTATED>", "c", "<ROTATED>", "d"}));
+}
+
+TEST(log_follow, stopsPromptly) {
+    TempDir dir;
+    Collector collector{dir.path() / "app.log"};
+    std::this_thread::sleep_for(10ms);
+    auto start = std::chrono::steady_clock::now();
+    collector.thread().request_stop();
+    collector.thread().join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, PROMPTLY);
+}
+
+TEST(log_follow, missingDirectory) {
+    EXPECT_THROW(Follower{"/nonexistent/directory/app.log"}, std::system_error);
+}
@@ -0,0 +1,133 @@
+#include <util/log_grep.h>
+#include <util/str_split.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/*
+ * log-grep throughput over an in-memory util::log-like log, i.e. the file is already in the page cache
+ *
+ * 1 record in 10 has a stack trace; 1 in 1000 carries the needle
+ * Memchr counts the lines with memchr, the lower bound for anything touching every byte
+ * Needle, Severity and Channel jump from hit to hit, of the needle, of "#ERROR [" and of " [channel] " respectively;
+ * Walk has got two channels to look for so it walks all records and parses their headers
+ * range(0) is the number of threads, results are counted but not written anywhere
+ */
+
+namespace {
+    constexpr std::size_t INPUT_SIZE = 32 << 20;
+
+    const std::string& input() {
+        static const std::string result = [] {
+            constexpr std::string_view severities[] = {"DEBUG", "INFO ", "INFO ", "WARN ", "ERROR"};
+            constexpr std::string_view channels[] = {"main", "util::pool::Pool", "worker", "http::Server"};
+            constexpr std::string_view words[] = {"request", "handled", "in", "ms", "user", "session", "cache",
+                    "miss", "for", "key", "connection", "reset", "retrying", "queue", "size"};
+            std::mt19937 gen{42};
+            std::string text;
+            text.reserve(INPUT_SIZE + 4096);
+            for (std::size_t i = 0; text.size() < INPUT_SIZE; ++i) {
+                text += fmt::format("2025-01-31 12:{:02}:{:02}.{:06} #{} [{}]", i / 60'000'000 % 60,
+                        i / 1'000'000 % 60, i % 1'000'000, severities[gen() % 5], channels[gen() % 4]);
+                for (auto n = 5 + gen() % 15; n > 0; --n) {
+                    text += ' ';
+                    text += words[gen() % std::size(words)];
+                }
+                if (i % 1000 == 999) {
+                    text += " connection reset by peer";
+                }
+                text += '\n';
+                if (i % 10 == 9) {
+                    for (auto frames = 3 + gen() % 10; frames > 0; --frames) {
+                        text += fmt::format("\t@ {}# handler::process(Request const&) at handler.cc:{}\n", frames,
+                                gen() % 1000);
+                    }
+                }
+            }
+            return text;
+        }();
+        return result;
+    }
+
+    void runGrep(benchmark::State& state, const util::log_grep::Filter& filter) {
+        util::pool::Pool pool{static_cast<std::size_t>(state.range(0))};
+        util::log_grep::Matcher matcher{filter};
+        auto& text = input();
+        std::size_t matched = 0;
+        for (auto _: state) {
+            std::size_t bytes = 0;
+            auto count = [&bytes](std::string_view out) {
+                bytes += out.size();
+            };
+            matched = util::log_grep::grep(pool, text, matcher, count);
+            benchmark::DoNotOptimize(bytes);
+        }
+        state.counters["matched"] = static_cast<double>(matched);
+        state.SetBytesProcessed(state.iterations() * text.size());
+    }
+
+    void Memchr(benchmark::State& state) {
+        auto& text = input();
+        for (auto _: state) {
+            std::size_t lines = 0;
+            auto end = text.data() + text.size();
+            for (auto p = text.data(); (p = static_cast<const char*>(std::memchr(p, '\n', end - p))); ++p) {
+                ++lines;
+            }
+            benchmark::DoNotOptimize(lines);
+        }
+        state.SetBytesProcessed(state.iterations() * text.size());
+    }
+
+    void LinesSplitView(benchmark::State& state) {
+        auto& text = input();
+        for (auto _: state) {
+            std::size_t lines = 0;
+            for (auto line: util::str_split::LinesSplitView{std::string_view{text}}) {
+                lines += !line.empty();
+            }
+            benchmark::DoNotOptimize(lines);
+        }
+        state.SetBytesProcessed(state.iterations() * text.size());
+    }
+
+    void Needle(benchmark::State& state) {
+        util::log_grep::Filter filter;
+        filter.substrings = {"connection reset by peer"};
+        runGrep(state, filter);
+    }
+
+    void Severity(benchmark::State& state) {
+        util::log_grep::Filter filter;
+        filter.severities.reset().set(static_cast<std::size_t>(util::log_grep::Severity::ERROR));
+        runGrep(state, filter);
+    }
+
+    void Channel(benchmark::State& state) {
+        util::log_grep::Filter filter;
+        filter.channels = {"http::Server"};
+        runGrep(state, filter);
+    }
+
+    void Walk(benchmark::State& state) {
+        util::log_grep::Filter filter;
+        filter.channels = {"http::Server", "worker"};
+        runGrep(state, filter);
+    }
+
+    auto threads = static_cast<long>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+BENCHMARK(Memchr)->Unit(benchmark::kMillisecond);
+BENCHMARK(LinesSplitView)->Unit(benchmark::kMillisecond);
+BENCHMARK(Needle)->RangeMultiplier(2)->Range(1, threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(Severity)->RangeMultiplier(2)->Range(1, threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(Channel)->RangeMultiplier(2)->Range(1, threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(Walk)->RangeMultiplier(2)->Range(1, threads)->Unit(benchmark::kMillisecond)->UseRealTime();
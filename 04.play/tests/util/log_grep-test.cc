@@ -0,0 +1,188 @@
+#include <util/log_grep.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using util::log_grep::Filter;
+using util::log_grep::Matcher;
+using util::log_grep::Severities;
+using util::log_grep::grep;
+using util::log_grep::grepChunk;
+using util::log::records::RecordsView;
+using util::log::records::parseTimestamp;
+
+namespace {
+    constexpr std::string_view LOG =
+            "2025-01-31 12:00:00.000001 #INFO  [main] starting\n"
+            "2025-01-31 12:00:01.500000 #ERROR [util::pool::Pool] Exception: some::TestException: test\n"
+            "\t@ 0# f5() at exceptions.cc:32\n"
+            "\tcaused by some::Other: nested\n"
+            "\t\t@ 0# f6() at exceptions.cc:40\n"
+            "2025-01-31 12:00:02.000000 #WARN  [main] two\r\nlines\r\n"
+            "2025-01-31 12:00:03.000000 #DEBUG [worker] f6() again\n";
+
+    std::string grepAll(std::string_view text, Filter filter) {
+        std::string out;
+        grepChunk(text, Matcher{std::move(filter)}, out);
+        return out;
+    }
+
+    Severities only(util::log_grep::Severity severity) {
+        return Severities{}.set(static_cast<std::size_t>(severity));
+    }
+
+    /** Log of records of all kinds, some with stack traces, some with CRLF */
+    std::string randomLog(std::mt19937& gen, std::size_t records) {
+        constexpr std::string_view severities[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+        constexpr std::string_view channels[] = {"main", "util::pool::Pool", "worker"};
+        /* messages mentioning what a header has can't fool us */
+        constexpr std::string_view words[] = {"alpha", "beta", "#ERROR [main]", " [worker] ", "needle"};
+        std::string result;
+        for (std::size_t i = 0; i < records; ++i) {
+            auto eol = gen() % 8 == 0 ? "\r\n" : "\n";
+            result += fmt::format("2025-01-31 12:{:02}:{:02}.{:06} #{} [{}] {} {}{}", i / 60000 % 60, i / 1000 % 60,
+                    i % 1000 * 1000, severities[gen() % 4], channels[gen() % 3], words[gen() % 5], i, eol);
+            for (auto frames = gen() % 4 == 0 ? gen() % 5 : 0; frames > 0; --frames) {
+                result += fmt::format("\t@ {}# {}()\n", frames, words[gen() % 5]);
+            }
+        }
+        return result;
+    }
+}
+
+TEST(log_grep, severityAndChannel) {
+    Filter errors;
+    errors.severities = only(util::log_grep::Severity::ERROR);
+    EXPECT_EQ(grepAll(LOG, errors),
+            "2025-01-31 12:00:01.500000 #ERROR [util::pool::Pool] Exception: some::TestException: test\n"
+            "\t@ 0# f5() at exceptions.cc:32\n"
+            "\tcaused by some::Other: nested\n"
+            "\t\t@ 0# f6() at exceptions.cc:40\n");
+
+    Filter main;
+    main.channels = {"main"};
+    EXPECT_EQ(grepAll(LOG, main),
+            "2025-01-31 12:00:00.000001 #INFO  [main] starting\n"
+            "2025-01-31 12:00:02.000000 #WARN  [main] two\r\nlines\n");
+}
+
+TEST(log_grep, timeRange) {
+    Filter filter;
+    filter.since = parseTimestamp("2025-01-31 12:00:01.500000");
+    filter.until = parseTimestamp("2025-01-31 12:00:03.000000");
+    auto out = grepAll(LOG, filter);
+    std::vector<std::string> headers;
+    for (auto& record: RecordsView{out}) {
+        headers.emplace_back(record.firstLine.substr(0, 26));
+    }
+    EXPECT_EQ(headers, (std::vector<std::string>{"2025-01-31 12:00:01.500000", "2025-01-31 12:00:02.000000"}));
+}
+
+TEST(log_grep, substrings) {
+    Filter filter;
+    /* found in a continuation line of one record and in the header of another */
+    filter.substrings = {"f6()"};
+    auto out = grepAll(LOG, filter);
+    EXPECT_TRUE(out.starts_with("2025-01-31 12:00:01.500000 #ERROR"));
+    EXPECT_TRUE(out.ends_with("\t\t@ 0# f6() at exceptions.cc:40\n"
+            "2025-01-31 12:00:03.000000 #DEBUG [worker] f6() again\n"));
+
+    filter.severities = only(util::log_grep::Severity::DEBUG);
+    EXPECT_EQ(grepAll(LOG, filter), "2025-01-31 12:00:03.000000 #DEBUG [worker] f6() again\n");
+
+    /* a hit spanning two records is not a hit */
+    Filter spanning;
+    spanning.substrings = {"exceptions.cc:40\n2025"};
+    EXPECT_EQ(grepAll(LOG, spanning), "");
+
+    Filter several;
+    several.substrings = {"starting", "lines"};
+    EXPECT_EQ(grepAll(LOG, several),
+            "2025-01-31 12:00:00.000001 #INFO  [main] starting\n"
+            "2025-01-31 12:00:02.000000 #WARN  [main] two\r\nlines\n");
+}
+
+TEST(log_grep, headless) {
+    auto text = "\t@ 3# tail of a trace\n2025-01-31 12:00:00.1 #INFO  [a] trace\n";
+    Filter filter;
+    filter.substrings = {"trace"};
+    EXPECT_EQ(grepAll(text, filter), text);
+
+    /* records without a header can't tell their severity */
+    filter.severities = only(util::log_grep::Severity::INFO);
+    EXPECT_EQ(grepAll(text, filter), "2025-01-31 12:00:00.1 #INFO  [a] trace\n");
+}
+
+/** Jumping from hit to hit has to give the same as walking all records, and so has grepping in parallel chunks */
+TEST(log_grep, parallelMatchesSequential) {
+    std::mt19937 gen{42};
+    auto text = randomLog(gen, 20'000);
+    util::pool::Pool pool{3};
+
+    std::vector<Filter> filters(7);
+    filters[0].substrings = {"needle"};
+    filters[1].substrings = {"needle 1", "beta 2", "()\n"};
+    filters[1].severities = only(util::log_grep::Severity::WARN);
+    filters[2].channels = {"worker", "main"};
+    filters[3].since = parseTimestamp("2025-01-31 12:00:05.0");
+    filters[3].until = parseTimestamp("2025-01-31 12:00:07.5");
+    filters[4].substrings = {"alpha"};
+    filters[4].channels = {"util::pool::Pool"};
+    filters[5].severities = only(util::log_grep::Severity::ERROR);
+    filters[6].channels = {"worker"};
+
+    for (auto& filter: filters) {
+        Matcher matcher{filter};
+        std::string expected;
+        std::size_t expectedCount = 0;
+        for (auto& record: RecordsView{text}) {
+            if (matcher.matches(record)) {
+                expected.append(record.text).push_back('\n');
+                ++expectedCount;
+            }
+        }
+        ASSERT_GT(expectedCount, 0);
+        EXPECT_EQ(matcher.jumps(), &filter != &filters[2] && &filter != &filters[3]);
+
+        for (std::size_t chunkSize: {1, 1000, 100'000, 1 << 30}) {
+            std::string out;
+            auto count = grep(pool, text, matcher, [&out](std::string_view part) { out += part; }, chunkSize);
+            EXPECT_EQ(count, expectedCount);
+            EXPECT_EQ(out, expected) << "chunk size " << chunkSize;
+        }
+    }
+}
+
+TEST(log_grep, writeThrows) {
+    std::mt19937 gen{1};
+    auto text = randomLog(gen, 1000);
+    util::pool::Pool pool{2};
+    Matcher matcher{Filter{}};
+    int calls = 0;
+    EXPECT_THROW(grep(pool, text, matcher, [&calls](std::string_view) {
+        if (++calls == 3) {
+            throw std::runtime_error("disk full");
+        }
+    }, 1000), std::runtime_error);
+    EXPECT_EQ(calls, 3);
+}
+
+TEST(log_grep, parseOptions) {
+    using util::log_grep::Severity;
+    EXPECT_EQ(util::log_grep::parseSeverities("WARN,DEBUG"), only(Severity::WARN) | only(Severity::DEBUG));
+    EXPECT_EQ(util::log_grep::parseSeverities("WARN+"), only(Severity::WARN) | only(Severity::ERROR)
+            | only(Severity::UNKNOWN));
+    EXPECT_THROW(util::log_grep::parseSeverities("WARNING"), std::invalid_argument);
+
+    EXPECT_EQ(util::log_grep::parseTime("2025-01-31 12:00"), parseTimestamp("2025-01-31 12:00:00.000000"));
+    EXPECT_EQ(util::log_grep::parseTime("2025-01-31"), parseTimestamp("2025-01-31 00:00:00.0"));
+    EXPECT_EQ(util::log_grep::parseTime("2025-01-31 12:00:00.5"), parseTimestamp("2025-01-31 12:00:00.500000"));
+    EXPECT_THROW(util::log_grep::parseTime("2025-01-31 12:00:00.5x"), std::invalid_argument);
+    EXPECT_THROW(util::log_grep::parseTime("yesterday"), std::invalid_argument);
+}
@@ -0,0 +1,108 @@
+#include <util/log_index.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+/*
+ * Queries over a 64MB util::log-like log spanning some 5 hours: through the index against log_grep::grepChunk()
+ * over all of it; range(0) picks the filter - a minute of the log, rare ERROR records, a rare channel among
+ * 20 busy ones and a substring which the index can't help with
+ *
+ * Build measures indexing the whole log from scratch
+ */
+
+namespace {
+    using util::log_grep::Filter;
+    using util::log_grep::Matcher;
+
+    const std::string& theLog() {
+        static const std::string log = [] {
+            std::mt19937 gen{42};
+            std::string result;
+            std::int64_t time = 0;
+            while (result.size() < (64 << 20)) {
+                time += gen() % 60'000;
+                auto severity = gen() % 1000 == 0 ? "ERROR" : gen() % 10 == 0 ? "WARN " : "INFO ";
+                auto channel = gen() % 5000 == 0 ? std::string{"audit"} : fmt::format("channel{}", gen() % 20);
+                result += fmt::format("2025-01-31 {:02}:{:02}:{:02}.{:06} #{} [{}] request handled in {} ms\n",
+                        time / 3'600'000'000 % 24, time / 60'000'000 % 60, time / 1'000'000 % 60, time % 1'000'000,
+                        severity, channel, gen() % 100);
+                if (gen() % 20 == 0) {
+                    result += "\t@ 0# handler::process(Request const&) at handler.cc:42\n";
+                }
+            }
+            return result;
+        }();
+        return log;
+    }
+
+    Filter filterFor(std::int64_t which) {
+        Filter filter;
+        switch (which) {
+        case 0:
+            filter.since = util::log_grep::parseTime("2025-01-31 02:00");
+            filter.until = util::log_grep::parseTime("2025-01-31 02:01");
+            break;
+        case 1:
+            filter.severities = util::log_grep::parseSeverities("ERROR");
+            break;
+        case 2:
+            filter.channels = {"audit"};
+            break;
+        default:
+            filter.substrings = {"in 99 ms"};
+        }
+        return filter;
+    }
+
+    void Indexed(benchmark::State& state) {
+        auto& log = theLog();
+        util::log_index::Index index;
+        index.update(log);
+        Matcher matcher{filterFor(state.range(0))};
+        std::size_t read = 0;
+        for (auto [begin, end]: index.candidates(log, matcher.filter())) {
+            read += end - begin;
+        }
+        state.counters["read"] = static_cast<double>(read) / log.size();
+
+        for (auto _: state) {
+            std::size_t bytes = 0;
+            auto count = util::log_index::query(log, index, matcher, [&bytes](std::string_view out) {
+                bytes += out.size();
+            });
+            benchmark::DoNotOptimize(count);
+        }
+        state.SetBytesProcessed(state.iterations() * log.size());
+    }
+
+    void FullScan(benchmark::State& state) {
+        auto& log = theLog();
+        Matcher matcher{filterFor(state.range(0))};
+        for (auto _: state) {
+            std::string out;
+            auto count = util::log_grep::grepChunk(log, matcher, out);
+            benchmark::DoNotOptimize(count);
+        }
+        state.SetBytesProcessed(state.iterations() * log.size());
+    }
+
+    void Build(benchmark::State& state) {
+        auto& log = theLog();
+        for (auto _: state) {
+            util::log_index::Index index;
+            index.update(log);
+            benchmark::DoNotOptimize(index.blocks().data());
+        }
+        state.SetBytesProcessed(state.iterations() * log.size());
+    }
+}
+
+BENCHMARK(Indexed)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+BENCHMARK(FullScan)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+BENCHMARK(Build)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,244 @@
+#include <util/log_index.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+using util::log_grep::Filter;
+using util::log_grep::Matcher;
+using util::log_grep::Severities;
+using util::log_grep::Severity;
+using util::log_index::Index;
+using util::log_index::Options;
+using util::log_index::Range;
+using util::log::records::parseTimestamp;
+
+namespace {
+    /** Time goes forward with occasional steps back, as with several threads writing */
+    std::string randomLog(std::mt19937& gen, std::size_t records, std::size_t first = 0) {
+        constexpr std::string_view severities[] = {"DEBUG", "INFO ", "INFO ", "INFO ", "WARN ", "ERROR", "UKNWN"};
+        constexpr std::string_view channels[] = {"main", "util::pool::Pool", "worker", "db", "http"};
+        std::string result;
+        for (auto i = first; i < first + records; ++i) {
+            auto second = i / 10 - gen() % 2;
+            result += fmt::format("2025-01-31 12:{:02}:{:02}.{:06} #{} [{}] message {}\n", second / 60 % 60,
+                    second % 60, gen() % 1'000'000, severities[gen() % 7], channels[gen() % 5], i);
+            for (auto frames = gen() % 6 == 0 ? gen() % 4 : 0; frames > 0; --frames) {
+                result += fmt::format("\t@ {}# f()\n", frames);
+            }
+        }
+        return result;
+    }
+
+    std::string fullScan(std::string_view log, const Matcher& matcher) {
+        std::string out;
+        util::log_grep::grepChunk(log, matcher, out);
+        return out;
+    }
+
+    std::string query(std::string_view log, const Index& index, const Matcher& matcher) {
+        std::string out;
+        util::log_index::query(log, index, matcher, [&out](std::string_view part) { out += part; });
+        return out;
+    }
+
+    std::size_t bytes(const std::vector<Range>& ranges) {
+        std::size_t result = 0;
+        for (auto [begin, end]: ranges) {
+            result += end - begin;
+        }
+        return result;
+    }
+
+    std::vector<Filter> someFilters() {
+        std::vector<Filter> result(8);
+        result[1].severities = Severities{}.set(static_cast<std::size_t>(Severity::ERROR));
+        result[2].channels = {"db"};
+        result[3].channels = {"worker", "http"};
+        result[4].since = parseTimestamp("2025-01-31 12:00:30.000000");
+        result[4].until = parseTimestamp("2025-01-31 12:00:31.000000");
+        result[5] = result[4];
+        result[5].severities = result[1].severities;
+        result[5].substrings = {"message"};
+        result[6].substrings = {"message 1"};
+        result[7].channels = {"nonexistent"};
+        return result;
+    }
+
+    void expectSameBlocks(const Index& a, const Index& b) {
+        ASSERT_EQ(a.blocks().size(), b.blocks().size());
+        for (std::size_t i = 0; i < a.blocks().size(); ++i) {
+            auto& x = a.blocks()[i];
+            auto& y = b.blocks()[i];
+            EXPECT_EQ(x.begin, y.begin) << i;
+            EXPECT_EQ(x.end, y.end) << i;
+            EXPECT_EQ(x.minTime, y.minTime) << i;
+            EXPECT_EQ(x.maxTime, y.maxTime) << i;
+            EXPECT_EQ(x.records, y.records) << i;
+            EXPECT_EQ(x.severities, y.severities) << i;
+            EXPECT_EQ(x.channels, y.channels) << i;
+        }
+        EXPECT_EQ(a.indexedSize(), b.indexedSize());
+    }
+}
+
+TEST(log_index, blocks) {
+    std::mt19937 gen{1};
+    auto log = randomLog(gen, 3000);
+    Index index{Options{4096}};
+    index.update(log);
+
+    ASSERT_GT(index.blocks().size(), 10);
+    std::size_t records = 0;
+    std::uint64_t expectedBegin = 0;
+    for (auto& block: index.blocks()) {
+        EXPECT_EQ(block.begin, expectedBegin);
+        EXPECT_TRUE(log.substr(block.begin).starts_with("2025-01-31 "));
+        EXPECT_LE(block.minTime, block.maxTime);
+        records += block.records;
+        expectedBegin = block.end;
+    }
+    /* all but the last record */
+    EXPECT_EQ(records, 2999);
+    EXPECT_EQ(index.indexedSize(), expectedBegin);
+    EXPECT_EQ(log.rfind("2025-01-31 "), index.indexedSize());
+}
+
+TEST(log_index, queryMatchesFullScan) {
+    std::mt19937 gen{2};
+    auto log = randomLog(gen, 5000);
+    /* a headless start as in a log cut by rotation */
+    log.insert(0, "\t@ 3# cut()\n");
+    Index index{Options{2048}};
+    index.update(log);
+
+    for (auto& filter: someFilters()) {
+        Matcher matcher{filter};
+        auto expected = fullScan(log, matcher);
+        EXPECT_EQ(query(log, index, matcher), expected);
+
+        auto candidates = index.candidates(log, filter);
+        ASSERT_FALSE(candidates.empty());
+        EXPECT_EQ(candidates.back().second, log.size());
+        for (std::size_t i = 1; i < candidates.size(); ++i) {
+            EXPECT_LT(candidates[i - 1].second, candidates[i].first);
+        }
+    }
+
+    auto filters = someFilters();
+    /* blocks are actually skipped */
+    EXPECT_LT(bytes(index.candidates(log, filters[4])), log.size() / 10);
+    EXPECT_LT(bytes(index.candidates(log, filters[7])), log.size() / 10);
+    EXPECT_EQ(bytes(index.candidates(log, filters[6])), log.size());
+}
+
+TEST(log_index, incremental) {
+    std::mt19937 gen{3};
+    std::string log;
+    Index incremental{Options{1024}};
+    for (std::size_t step = 0; step < 30; ++step) {
+        log += randomLog(gen, gen() % 200, step * 200);
+        if (gen() % 3 == 0) {
+            /* a record written half way */
+            log += "2025-01-31 13:00:00.000000 #INFO  [main] half";
+        }
+        incremental.update(log);
+
+        Index fresh{Options{1024}};
+        fresh.update(log);
+        expectSameBlocks(incremental, fresh);
+
+        Filter filter;
+        filter.channels = {"db"};
+        Matcher matcher{filter};
+        EXPECT_EQ(query(log, incremental, matcher), fullScan(log, matcher));
+
+        if (log.ends_with("half")) {
+            log += " done\n";
+        }
+    }
+}
+
+TEST(log_index, rotation) {
+    std::mt19937 gen{4};
+    auto log = randomLog(gen, 2000);
+    Index index{Options{1024}};
+    index.update(log);
+    EXPECT_TRUE(index.covers(log));
+    EXPECT_TRUE(index.covers(log + randomLog(gen, 10)));
+
+    /* truncated */
+    auto truncated = log.substr(0, index.indexedSize() / 2);
+    EXPECT_FALSE(index.covers(truncated));
+    Filter filter;
+    filter.severities = Severities{}.set(static_cast<std::size_t>(Severity::ERROR));
+    EXPECT_EQ(index.candidates(truncated, filter), (std::vector<Range>{Range{0, truncated.size()}}));
+    Matcher matcher{filter};
+    EXPECT_EQ(query(truncated, index, matcher), fullScan(truncated, matcher));
+
+    /* rotated: another log at least as long */
+    auto rotated = randomLog(gen, 2500);
+    EXPECT_FALSE(index.covers(rotated));
+    EXPECT_EQ(query(rotated, index, matcher), fullScan(rotated, matcher));
+    index.update(rotated);
+    Index fresh{Options{1024}};
+    fresh.update(rotated);
+    expectSameBlocks(index, fresh);
+}
+
+TEST(log_index, saveLoad) {
+    std::mt19937 gen{5};
+    auto log = randomLog(gen, 1000);
+    Index index{Options{512}};
+    index.update(log);
+
+    auto path = std::filesystem::temp_directory_path() / fmt::format("log_index-test-{}.idx", ::getpid());
+    index.save(path);
+    auto loaded = Index::load(path);
+    expectSameBlocks(loaded, index);
+    EXPECT_TRUE(loaded.covers(log));
+
+    /* the block size comes along: updates go on the same way */
+    log += randomLog(gen, 500, 1000);
+    loaded.update(log);
+    index.update(log);
+    expectSameBlocks(loaded, index);
+
+    std::ofstream{path} << "not an index at all, but long enough to hold a header of one";
+    EXPECT_THROW(Index::load(path), std::runtime_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(Index::load(path), std::runtime_error);
+
+    EXPECT_EQ(Index::pathFor("/var/log/app.log"), "/var/log/app.log.idx");
+}
+
+TEST(log_index, edgeCases) {
+    Index index;
+    index.update("");
+    EXPECT_TRUE(index.blocks().empty());
+    EXPECT_EQ(index.indexedSize(), 0);
+
+    /* a single record stays unindexed */
+    std::string log = "2025-01-31 12:00:00.000000 #INFO  [main] one\n";
+    index.update(log);
+    EXPECT_TRUE(index.blocks().empty());
+    Filter filter;
+    filter.channels = {"main"};
+    Matcher matcher{filter};
+    EXPECT_EQ(query(log, index, matcher), log);
+
+    log += "2025-01-31 12:00:01.000000 #INFO  [main] two\n";
+    index.update(log);
+    ASSERT_EQ(index.blocks().size(), 1);
+    EXPECT_EQ(index.blocks()[0].records, 1);
+    EXPECT_EQ(query(log, index, matcher), log);
+}
@@ -0,0 +1,120 @@
+#include <util/log_merge.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * k-way merge: picking the next of k sorted runs with LoserTree against std::priority_queue
+ * on plain int64 keys, so that the selection itself is what is measured; range(0) is k
+ *
+ * Merger then merges k util::log-like logs of 16MB altogether, record boundaries and timestamps included
+ */
+
+namespace {
+    constexpr std::size_t TOTAL = 1 << 20;
+
+    std::vector<std::vector<std::int64_t>> makeRuns(std::size_t k) {
+        std::mt19937 gen{42};
+        std::vector<std::vector<std::int64_t>> runs(k);
+        for (auto& run: runs) {
+            std::int64_t time = 0;
+            run.resize(TOTAL / k);
+            for (auto& value: run) {
+                value = time += gen() % 1000;
+            }
+        }
+        return runs;
+    }
+
+    void LoserTree(benchmark::State& state) {
+        auto k = static_cast<std::size_t>(state.range(0));
+        auto runs = makeRuns(k);
+        for (auto _: state) {
+            std::vector<std::optional<std::int64_t>> firsts;
+            for (auto& run: runs) {
+                firsts.emplace_back(run.front());
+            }
+            util::log_merge::LoserTree<std::int64_t> tree{firsts};
+            std::vector<std::size_t> positions(k);
+            std::int64_t sum = 0;
+            while (!tree.done()) {
+                auto i = tree.winner();
+                sum += tree.winnerKey();
+                if (++positions[i] == runs[i].size()) {
+                    tree.retire();
+                } else {
+                    tree.replay(runs[i][positions[i]]);
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * (TOTAL / k * k));
+    }
+
+    void PriorityQueue(benchmark::State& state) {
+        auto k = static_cast<std::size_t>(state.range(0));
+        auto runs = makeRuns(k);
+        for (auto _: state) {
+            std::vector<std::size_t> positions(k);
+            using Entry = std::pair<std::int64_t, std::size_t>;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+            for (std::size_t i = 0; i < k; ++i) {
+                queue.emplace(runs[i][0], i);
+            }
+            std::int64_t sum = 0;
+            while (!queue.empty()) {
+                auto [value, i] = queue.top();
+                queue.pop();
+                sum += value;
+                if (++positions[i] != runs[i].size()) {
+                    queue.emplace(runs[i][positions[i]], i);
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * (TOTAL / k * k));
+    }
+
+    void Merger(benchmark::State& state) {
+        auto k = static_cast<std::size_t>(state.range(0));
+        std::mt19937 gen{42};
+        std::vector<std::string> logs(k);
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < k; ++i) {
+            std::int64_t time = 0;
+            while (logs[i].size() < (16 << 20) / k) {
+                time += gen() % 1000;
+                logs[i] += fmt::format("2025-01-31 12:{:02}:{:02}.{:06} #INFO  [worker] request handled in {} ms\n",
+                        time / 60'000'000 % 60, time / 1'000'000 % 60, time % 1'000'000, gen() % 100);
+                if (gen() % 20 == 0) {
+                    logs[i] += "\t@ 0# handler::process(Request const&) at handler.cc:42\n";
+                }
+            }
+            bytes += logs[i].size();
+        }
+        std::vector<std::string_view> inputs{logs.begin(), logs.end()};
+
+        for (auto _: state) {
+            util::log_merge::Merger merger{inputs};
+            std::size_t records = 0;
+            while (auto record = merger.next()) {
+                ++records;
+            }
+            benchmark::DoNotOptimize(records);
+        }
+        state.SetBytesProcessed(state.iterations() * bytes);
+    }
+}
+
+BENCHMARK(LoserTree)->RangeMultiplier(4)->Range(2, 512)->Unit(benchmark::kMillisecond);
+BENCHMARK(PriorityQueue)->RangeMultiplier(4)->Range(2, 512)->Unit(benchmark::kMillisecond);
+BENCHMARK(Merger)->RangeMultiplier(4)->Range(2, 128)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,159 @@
+#include <util/log_merge.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using util::log_merge::LoserTree;
+using util::log_merge::Merger;
+
+namespace {
+    std::vector<std::string> mergeAll(std::vector<std::string_view> inputs,
+            std::vector<std::size_t>* order = nullptr) {
+        Merger merger{inputs};
+        std::vector<std::string> result;
+        while (auto record = merger.next()) {
+            result.emplace_back(record->text);
+            if (order) {
+                order->push_back(record->input);
+            }
+        }
+        return result;
+    }
+
+    std::string header(int second, std::string_view message) {
+        return fmt::format("2025-01-31 12:00:{:02}.000000 #INFO  [main] {}\n", second, message);
+    }
+}
+
+TEST(log_merge, loserTree) {
+    std::mt19937 gen{7};
+    for (std::size_t k: {1, 2, 3, 5, 8, 13, 64}) {
+        std::vector<std::vector<int>> runs(k);
+        std::vector<std::tuple<int, std::size_t>> expected;
+        for (std::size_t i = 0; i < k; ++i) {
+            runs[i].resize(gen() % 50);
+            for (auto& value: runs[i]) {
+                value = static_cast<int>(gen() % 100);
+            }
+            std::ranges::sort(runs[i]);
+            for (auto value: runs[i]) {
+                expected.emplace_back(value, i);
+            }
+        }
+        /* stable by run index */
+        std::ranges::sort(expected);
+
+        std::vector<std::optional<int>> firsts;
+        for (auto& run: runs) {
+            firsts.push_back(run.empty() ? std::nullopt : std::optional(run.front()));
+        }
+        LoserTree<int> tree{firsts};
+        std::vector<std::size_t> positions(k);
+
+        std::vector<std::tuple<int, std::size_t>> merged;
+        while (!tree.done()) {
+            auto i = tree.winner();
+            merged.emplace_back(tree.winnerKey(), i);
+            if (++positions[i] == runs[i].size()) {
+                tree.retire();
+            } else {
+                tree.replay(runs[i][positions[i]]);
+            }
+        }
+        EXPECT_EQ(merged, expected) << k << " runs";
+    }
+}
+
+TEST(log_merge, loserTreeOrder) {
+    /* keys are compared with 'less' alone, here the longer strings go 1st */
+    std::vector<std::optional<std::string>> keys{"bb", std::nullopt, "a", "ccc"};
+    auto longer = [](const std::string& a, const std::string& b) { return a.size() > b.size(); };
+    LoserTree<std::string, decltype(longer)> tree{keys, longer};
+    EXPECT_EQ(tree.winner(), 3);
+    tree.replay("z");
+    EXPECT_EQ(tree.winner(), 0);
+    tree.retire();
+    /* "z" and "a" tie, the smaller index wins */
+    EXPECT_EQ(tree.winner(), 2);
+    tree.retire();
+    EXPECT_EQ(tree.winnerKey(), "z");
+    tree.retire();
+    EXPECT_TRUE(tree.done());
+}
+
+TEST(log_merge, records) {
+    auto a = header(1, "a1") + "\t@ 0# f()\n\tcaused by x\n" + header(3, "a3") + header(3, "a3 again");
+    auto b = header(0, "b0") + header(2, "b2") + "\t@ 0# g()\n" + header(3, "b3") + "\t@ 1# h()";
+    std::vector<std::size_t> order;
+    EXPECT_EQ(mergeAll({a, b}, &order), (std::vector<std::string>{
+            header(0, "b0"),
+            header(1, "a1") + "\t@ 0# f()\n\tcaused by x\n",
+            header(2, "b2") + "\t@ 0# g()\n",
+            header(3, "a3"),
+            header(3, "a3 again"),
+            header(3, "b3") + "\t@ 1# h()"}));
+    EXPECT_EQ(order, (std::vector<std::size_t>{1, 0, 1, 0, 0, 1}));
+}
+
+TEST(log_merge, edgeCases) {
+    EXPECT_TRUE(mergeAll({}).empty());
+    EXPECT_TRUE(mergeAll({"", ""}).empty());
+
+    auto only = header(5, "x") + header(4, "out of order") + header(6, "y");
+    EXPECT_EQ(mergeAll({only}).size(), 3);
+
+    /* an input cut in the middle of a trace: the tail goes 1st */
+    auto cut = "\t@ 7# tail()\n" + header(2, "c2");
+    EXPECT_EQ(mergeAll({header(1, "d1"), cut}), (std::vector<std::string>{"\t@ 7# tail()\n", header(1, "d1"),
+            header(2, "c2")}));
+}
+
+TEST(log_merge, consumed) {
+    auto a = header(1, "a1") + header(3, "a3");
+    auto b = header(2, "b2");
+    std::vector<std::string_view> inputs{a, b};
+    Merger merger{inputs};
+    EXPECT_EQ(merger.consumed(0), 0);
+    merger.next();
+    EXPECT_EQ(merger.consumed(0), header(1, "a1").size());
+    merger.next();
+    merger.next();
+    EXPECT_EQ(merger.consumed(0), a.size());
+    EXPECT_EQ(merger.consumed(1), b.size());
+    EXPECT_FALSE(merger.next());
+}
+
+TEST(log_merge, randomInputs) {
+    std::mt19937 gen{42};
+    constexpr std::size_t INPUTS = 7;
+    std::vector<std::string> inputs(INPUTS);
+    std::vector<std::tuple<std::int64_t, std::size_t, std::string>> expected;
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        std::int64_t time = 0;
+        for (auto n = gen() % 300; n > 0; --n) {
+            time += gen() % 3 * 500'000;
+            auto record = fmt::format("2025-01-31 12:{:02}:{:02}.{:06} #WARN  [in{}] record\n", time / 60'000'000,
+                    time / 1'000'000 % 60, time % 1'000'000, i);
+            for (auto frames = gen() % 3; frames > 0; --frames) {
+                record += "\t@ frame\n";
+            }
+            inputs[i] += record;
+            expected.emplace_back(time, i, record);
+        }
+    }
+    std::ranges::stable_sort(expected, {}, [](auto& t) { return std::tuple(std::get<0>(t), std::get<1>(t)); });
+
+    std::vector<std::string> expectedTexts;
+    for (auto& t: expected) {
+        expectedTexts.push_back(std::get<2>(t));
+    }
+    EXPECT_EQ(mergeAll({inputs.begin(), inputs.end()}), expectedTexts);
+}
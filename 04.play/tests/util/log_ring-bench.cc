@@ -0,0 +1,73 @@
+#include <util/log_ring.h>
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * What logging to the ring costs a worker: Write is the producer side alone, the ring is drained
+ * with the timer paused whenever it gets full; WriteCollected drains it on the same thread into /dev/null,
+ * so it is the cost of a record end to end, short of the disk
+ * WriteToFile is the alternative of each worker write()-ing its records itself, for comparison
+ */
+
+namespace {
+    constexpr std::string_view RECORD = "2025-01-31 12:00:00.000000 #INFO  [main] request handled in 3 ms";
+
+    constexpr std::size_t CAPACITY = 16 << 20;
+
+    void Write(benchmark::State& state) {
+        auto ring = util::log_ring::Ring::anonymous(CAPACITY);
+        util::log_ring::Collector collector{ring};
+        auto ignore = [](std::string_view) {};
+        for (auto _: state) {
+            if (!ring.write(RECORD)) {
+                state.PauseTiming();
+                collector.drain(ignore, std::chrono::milliseconds::zero());
+                state.ResumeTiming();
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void WriteCollected(benchmark::State& state) {
+        auto ring = util::log_ring::Ring::anonymous(CAPACITY);
+        util::log_ring::Collector collector{ring};
+        std::string buffer;
+        int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        auto onRecord = [&](std::string_view record) {
+            buffer.append(record);
+            buffer.push_back('\n');
+        };
+        std::size_t written = 0;
+        for (auto _: state) {
+            ring.write(RECORD);
+            if (++written % 1024 == 0) {
+                collector.drain(onRecord, std::chrono::milliseconds::zero());
+                benchmark::DoNotOptimize(::write(fd, buffer.data(), buffer.size()));
+                buffer.clear();
+            }
+        }
+        ::close(fd);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void WriteToFile(benchmark::State& state) {
+        int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        std::string line{RECORD};
+        line.push_back('\n');
+        for (auto _: state) {
+            benchmark::DoNotOptimize(::write(fd, line.data(), line.size()));
+        }
+        ::close(fd);
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK(Write);
+BENCHMARK(WriteCollected);
+BENCHMARK(WriteToFile);
@@ -0,0 +1,260 @@
+#include <util/log_ring.h>
+#include <util/log.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+using util::log_ring::Collector;
+using util::log_ring::Options;
+using util::log_ring::Ring;
+
+namespace {
+    std::vector<std::string> drainAll(Collector& collector) {
+        std::vector<std::string> records;
+        while (collector.drain([&](std::string_view record) { records.emplace_back(record); }, 0ms) > 0) {
+        }
+        return records;
+    }
+
+    /** "<writer> <sequence number>" */
+    std::pair<int, int> parse(const std::string& record) {
+        int writer = 0, number = 0;
+        std::sscanf(record.c_str(), "%d %d", &writer, &number);
+        return {writer, number};
+    }
+}
+
+TEST(log_ring, inOrder) {
+    auto ring = Ring::anonymous(4096);
+    Collector collector{ring};
+    EXPECT_TRUE(ring.write("one"));
+    EXPECT_TRUE(ring.write(""));
+    EXPECT_TRUE(ring.write("three\nlines\nlong"));
+    EXPECT_EQ(drainAll(collector), (std::vector<std::string>{"one", "", "three\nlines\nlong"}));
+    EXPECT_EQ(drainAll(collector), std::vector<std::string>{});
+}
+
+TEST(log_ring, fullAndWrapping) {
+    auto ring = Ring::anonymous(4096);
+    Collector collector{ring};
+
+    std::string text(100, 'x');
+    std::size_t written = 0;
+    while (ring.write(fmt::format("{} {}", 0, written))) {
+        ++written;
+    }
+    EXPECT_EQ(ring.dropped(), 1);
+    EXPECT_EQ(drainAll(collector).size(), written);
+
+    /* around the end of the ring a few times, records of varying length */
+    int next = 0;
+    for (int round = 0; round < 50; ++round) {
+        std::vector<std::string> expected;
+        for (int i = 0; i < 7; ++i, ++next) {
+            expected.push_back(fmt::format("1 {} {}", next, text.substr(0, next % 97)));
+            ASSERT_TRUE(ring.write(expected.back()));
+        }
+        ASSERT_EQ(drainAll(collector), expected);
+    }
+
+    /* too long for the ring, cut short */
+    ASSERT_TRUE(ring.write(std::string(10000, 'y')));
+    auto records = drainAll(collector);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_LT(records[0].size(), 2048);
+    EXPECT_EQ(records[0], std::string(records[0].size(), 'y'));
+}
+
+TEST(log_ring, threads) {
+    constexpr int WRITERS = 4;
+    constexpr int RECORDS = 20000;
+
+    auto ring = Ring::anonymous(1 << 16);
+    std::vector<std::string> records;
+    std::atomic<bool> done = false;
+    std::jthread collectorThread{[&] {
+        Collector collector{ring};
+        auto onRecord = [&](std::string_view record) { records.emplace_back(record); };
+        while (!done) {
+            collector.drain(onRecord, 10ms);
+        }
+        while (collector.drain(onRecord, 0ms) > 0) {
+        }
+    }};
+
+    {
+        std::vector<std::jthread> writers;
+        for (int writer = 0; writer < WRITERS; ++writer) {
+            writers.emplace_back([&ring, writer] {
+                for (int i = 0; i < RECORDS; ++i) {
+                    /* retrying rather than losing records keeps the check below simple */
+                    while (!ring.write(fmt::format("{} {}", writer, i))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+    }
+    done = true;
+    collectorThread.join();
+
+    ASSERT_EQ(records.size(), WRITERS * RECORDS);
+    std::map<int, int> expected;
+    for (auto& record: records) {
+        auto [writer, number] = parse(record);
+        ASSERT_EQ(number, expected[writer]++) << record;
+    }
+}
+
+TEST(log_ring, processesAndCrash) {
+    constexpr int WRITERS = 3;
+    constexpr int RECORDS = 1000;
+
+    auto ring = Ring::anonymous(1 << 20);
+    std::vector<pid_t> children;
+    for (int writer = 0; writer < WRITERS; ++writer) {
+        auto pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            /* a ring of our own over the inherited descriptor, as a worker which was exec()-ed would do */
+            auto attached = Ring::attach(::dup(ring.fd()));
+            for (int i = 0; i < RECORDS; ++i) {
+                attached.write(fmt::format("{} {}", writer, i));
+            }
+            if (writer == 0) {
+                /* crashing loses nothing already written */
+                std::signal(SIGABRT, SIG_DFL);
+                std::abort();
+            }
+            ::_exit(0);
+        }
+        children.push_back(pid);
+    }
+    for (auto pid: children) {
+        ::waitpid(pid, nullptr, 0);
+    }
+
+    Collector collector{ring};
+    std::map<int, int> expected;
+    for (auto& record: drainAll(collector)) {
+        auto [writer, number] = parse(record);
+        ASSERT_EQ(number, expected[writer]++) << record;
+    }
+    EXPECT_EQ(expected, (std::map<int, int>{{0, RECORDS}, {1, RECORDS}, {2, RECORDS}}));
+}
+
+TEST(log_ring, abandonedRecords) {
+    auto ring = Ring::anonymous(4096);
+    Collector collector{ring, Options{.stallTimeout = 20ms}};
+
+    /*
+     * We play a writer which died halfway by poking at the segment: the head is at offset 64 of it
+     * and record headers are {ticket, state, size, length, pid}, 16-aligned
+     */
+    auto segment = static_cast<char*>(::mmap(nullptr, 4096 + 4096, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd(), 0));
+    ASSERT_NE(segment, MAP_FAILED);
+    auto& head = *reinterpret_cast<std::atomic<std::uint64_t>*>(segment + 64);
+    char* records = segment + 4096;
+
+    /* a child which has exited, its pid is gone */
+    auto child = ::fork();
+    if (child == 0) {
+        ::_exit(0);
+    }
+    ::waitpid(child, nullptr, 0);
+
+    ring.write("before");
+    std::uint64_t position = head.load();
+    head += 64;
+    struct {
+        std::uint64_t ticket;
+        std::uint32_t state, size, length;
+        std::int32_t pid;
+    } header{position + 1, 0, 64, 10, child};
+    std::memcpy(records + position, &header, sizeof(header));
+    ring.write("after dead writer");
+
+    /* reserved but not even a header */
+    head += 32;
+    ring.write("after no header");
+
+    std::vector<std::string> seen;
+    auto start = std::chrono::steady_clock::now();
+    while (seen.size() < 3 && std::chrono::steady_clock::now() - start < 2s) {
+        collector.drain([&](std::string_view record) { seen.emplace_back(record); }, 5ms);
+    }
+    EXPECT_EQ(seen, (std::vector<std::string>{"before", "after dead writer", "after no header"}));
+    EXPECT_EQ(ring.lost(), 2);
+    ::munmap(segment, 4096 + 4096);
+}
+
+TEST(log_ring, namedAndWakeup) {
+    auto name = fmt::format("/log_ring-test-{}", ::getpid());
+    auto ring = Ring::create(name, 1 << 16);
+    EXPECT_THROW(Ring::create("/log_ring-test-bad", 1000), std::invalid_argument);
+
+    std::vector<std::string> records;
+    {
+        std::jthread collectorThread{[&](std::stop_token stopToken) {
+            Collector collector{ring};
+            std::stop_callback wake{stopToken, [&] { ring.wake(); }};
+            while (!stopToken.stop_requested()) {
+                collector.drain([&](std::string_view record) { records.emplace_back(record); }, 10s);
+            }
+        }};
+
+        auto worker = Ring::open(name);
+        worker.write("from a worker");
+        std::this_thread::sleep_for(50ms);
+
+        /* the collector is asleep for 10s unless woken up */
+        auto start = std::chrono::steady_clock::now();
+        collectorThread.request_stop();
+        collectorThread.join();
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+    }
+    EXPECT_EQ(records, std::vector<std::string>{"from a worker"});
+
+    /* a collector started anew finds what was left */
+    ring.write("left over");
+    auto again = Ring::create(name, 1 << 12);
+    EXPECT_EQ(again.capacity(), 1 << 16);
+    Collector collector{again};
+    EXPECT_EQ(drainAll(collector), std::vector<std::string>{"left over"});
+
+    Ring::unlink(name);
+    EXPECT_THROW(Ring::open(name), std::system_error);
+}
+
+struct log_ring_test {};
+
+TEST(log_ring, logToRing) {
+    auto ring = std::make_shared<Ring>(Ring::anonymous(1 << 16));
+    util::log::commonLoggingSetup();
+    util::log_ring::logToRing(ring);
+    util::log::getLogger<log_ring_test>().info("hello {}", 42);
+
+    Collector collector{*ring};
+    auto records = drainAll(collector);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_TRUE(records[0].find(" #INFO  [") != std::string::npos) << records[0];
+    EXPECT_TRUE(records[0].ends_with("] hello 42")) << records[0];
+}
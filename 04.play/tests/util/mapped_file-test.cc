@@ -0,0 +1,75 @@
+#include <util/mapped_file.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+using util::mapped_file::Access;
+using util::mapped_file::MappedFile;
+
+namespace {
+    std::filesystem::path tempFile(const std::string& contents) {
+        auto path = std::filesystem::temp_directory_path()
+                / ("mapped_file-test-" + std::to_string(::getpid()) + "-" + std::to_string(contents.size()));
+        std::ofstream{path, std::ios::binary} << contents;
+        return path;
+    }
+}
+
+TEST(mapped_file, contents) {
+    std::string contents(100'000, 'x');
+    contents.back() = '\n';
+    auto path = tempFile(contents);
+    {
+        MappedFile file{path, Access::RANDOM};
+        EXPECT_EQ(file.size(), contents.size());
+        EXPECT_EQ(file.view(), contents);
+
+        MappedFile moved{std::move(file)};
+        EXPECT_TRUE(file.view().empty());
+        EXPECT_EQ(moved.view(), contents);
+
+        file = std::move(moved);
+        EXPECT_EQ(file.view(), contents);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(mapped_file, dropBefore) {
+    std::string contents;
+    for (int i = 0; contents.size() < 100'000; ++i) {
+        contents += std::to_string(i) + '\n';
+    }
+    auto path = tempFile(contents);
+    {
+        MappedFile file{path};
+        file.dropBefore(50'000);
+        EXPECT_EQ(file.view(), contents);
+        file.dropBefore(1'000'000);
+        EXPECT_EQ(file.view(), contents);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(mapped_file, empty) {
+    auto path = tempFile("");
+    MappedFile file{path};
+    EXPECT_EQ(file.size(), 0);
+    EXPECT_TRUE(file.view().empty());
+    std::filesystem::remove(path);
+}
+
+TEST(mapped_file, missing) {
+    try {
+        MappedFile file{"/no/such/file"};
+        FAIL() << "expected an exception";
+    } catch (const std::system_error& e) {
+        EXPECT_EQ(e.code(), std::errc::no_such_file_or_directory);
+        EXPECT_NE(std::string(e.what()).find("/no/such/file"), std::string::npos);
+    }
+}
@@ -0,0 +1,41 @@
+#include <util/metrics.h>
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+/*
+ * Cost of a Timer on the recording thread, two clock reads and three relaxed atomic updates of the thread's shard;
+ * with several threads the shards keep them from contending, so the time per iteration should stay flat
+ * Under virtualization the clock reads may well dominate
+ */
+
+namespace {
+    void Record(benchmark::State& state) {
+        static util::metrics::Site site{"bench-record"};
+        std::chrono::nanoseconds duration{1};
+        for (auto _: state) {
+            site.record(duration);
+            duration = std::chrono::nanoseconds{(duration.count() * 7 + 1) % 100'000};
+        }
+    }
+
+    void TimerScope(benchmark::State& state) {
+        static util::metrics::Site site{"bench-timer"};
+        for (auto _: state) {
+            util::metrics::Timer timer{site};
+            benchmark::ClobberMemory();
+        }
+    }
+
+    void Snapshot(benchmark::State& state) {
+        static util::metrics::Site site{"bench-snapshot"};
+        site.record(std::chrono::microseconds{1});
+        for (auto _: state) {
+            benchmark::DoNotOptimize(util::metrics::snapshot());
+        }
+    }
+}
+
+BENCHMARK(Record);
+BENCHMARK(TimerScope)->ThreadRange(1, 8);
+BENCHMARK(Snapshot);
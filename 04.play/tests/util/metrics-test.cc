@@ -0,0 +1,135 @@
+#include <util/metrics.h>
+#include <util/log.h>
+#include <gtest/gtest.h>
+
+#include <boost/log/core.hpp>
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using util::metrics::BUCKETS;
+using util::metrics::Histogram;
+using util::metrics::Site;
+using util::metrics::SiteStats;
+using util::metrics::Timer;
+using util::metrics::_detail::bucketOf;
+using util::metrics::_detail::bucketUpperBound;
+
+namespace {
+    SiteStats find(std::string_view name) {
+        auto stats = util::metrics::snapshot();
+        auto it = std::ranges::find(stats, name, &SiteStats::name);
+        if (it == stats.end()) {
+            throw std::runtime_error("no such site");
+        }
+        return *it;
+    }
+}
+
+TEST(metrics, buckets) {
+    EXPECT_EQ(BUCKETS, 1152);
+    EXPECT_EQ(bucketOf(0), 0);
+    EXPECT_EQ(bucketOf(63), 63);
+    EXPECT_EQ(bucketOf(64), 64);
+    EXPECT_EQ(bucketOf(65), 64);
+    EXPECT_EQ(bucketOf(66), 65);
+    EXPECT_EQ(bucketOf(~std::uint64_t{0}), BUCKETS - 1);
+
+    std::size_t previous = 0;
+    for (std::uint64_t v = 1; v < (std::uint64_t{1} << 40); v += v / 7 + 1) {
+        auto bucket = bucketOf(v);
+        ASSERT_GE(bucket, previous);
+        ASSERT_GE(bucketUpperBound(bucket), v);
+        /* the bucket below ends below v, and the bucket is no wider than 1/32 of its values */
+        ASSERT_LT(bucketUpperBound(bucket - 1), v);
+        ASSERT_LE(bucketUpperBound(bucket) - bucketUpperBound(bucket - 1), std::max<std::uint64_t>(1, v / 32));
+        previous = bucket;
+    }
+}
+
+TEST(metrics, quantile) {
+    Histogram histogram{};
+    EXPECT_EQ(util::metrics::quantile(histogram, 0.5), 0ns);
+
+    histogram[bucketOf(10)] = 50;
+    histogram[bucketOf(1000)] = 49;
+    histogram[bucketOf(1'000'000)] = 1;
+    EXPECT_EQ(util::metrics::quantile(histogram, 0.0), 10ns);
+    EXPECT_EQ(util::metrics::quantile(histogram, 0.5), 10ns);
+    EXPECT_EQ(util::metrics::quantile(histogram, 0.6), 1007ns);
+    EXPECT_EQ(util::metrics::quantile(histogram, 1.0), 1'015'807ns);
+}
+
+TEST(metrics, timer) {
+    static Site site{"test-timer"};
+    {
+        Timer timer{site};
+        std::this_thread::sleep_for(2ms);
+    }
+    auto stats = find("test-timer");
+    EXPECT_EQ(stats.count, 1);
+    EXPECT_GE(stats.max, 2ms);
+    EXPECT_EQ(stats.total, stats.max);
+    EXPECT_GE(util::metrics::quantile(stats.histogram, 0.5), 2ms);
+}
+
+TEST(metrics, threadsAndSharedNames) {
+    constexpr int THREADS = 8;
+    constexpr int RECORDS = 10000;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([] {
+                /* each thread has a Site of its own, they all count towards one name */
+                Site site{"test-threads"};
+                for (int i = 1; i <= RECORDS; ++i) {
+                    site.record(std::chrono::nanoseconds{i});
+                }
+            });
+        }
+    }
+    auto stats = find("test-threads");
+    EXPECT_EQ(stats.count, THREADS * RECORDS);
+    EXPECT_EQ(stats.total.count(), std::int64_t{THREADS} * RECORDS * (RECORDS + 1) / 2);
+    EXPECT_EQ(stats.max, std::chrono::nanoseconds{RECORDS});
+    auto p50 = util::metrics::quantile(stats.histogram, 0.5).count();
+    EXPECT_GE(p50, RECORDS / 2);
+    EXPECT_LE(p50, RECORDS / 2 * 33 / 32);
+}
+
+TEST(metrics, reportSinceLastReport) {
+    using text_sink = boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>;
+    auto output = boost::make_shared<std::ostringstream>();
+    auto sink = boost::make_shared<text_sink>();
+    sink->locked_backend()->add_stream(output);
+    util::log::setStandardLogFormat(sink);
+    boost::log::core::get()->add_sink(sink);
+    util::log::commonLoggingSetup();
+
+    Site site{"test-report"};
+    util::metrics::report();
+    for (int i = 0; i < 100; ++i) {
+        site.record(1ms);
+    }
+    output->str("");
+    util::metrics::report();
+    sink->flush();
+    auto first = output->str();
+    EXPECT_NE(first.find("[util::metrics::metrics] test-report: 100 timed, p50/p90/p99/p999/max "), std::string::npos)
+            << first;
+
+    output->str("");
+    util::metrics::report();
+    sink->flush();
+    auto second = output->str();
+    EXPECT_NE(second.find("Nothing timed since the last report"), std::string::npos) << second;
+    boost::log::core::get()->remove_sink(sink);
+}
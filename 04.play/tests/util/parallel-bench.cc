@@ -0,0 +1,146 @@
+#include <util/parallel.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <vector>
+
+/*
+ * parallelFor/parallelReduce against std::execution::par and a plain serial loop
+ *
+ * Cheap: one multiply-add per float over range(0) elements, mostly memory bound
+ * Uneven: the work per element grows with its index, a static split into equal parts would leave
+ * the threads with the first parts idle for most of the time
+ * Sum: a reduction over range(0) doubles
+ *
+ * libstdc++ runs std::execution::par algorithms on TBB, hence the dependency on it
+ *
+ * Results are reported in elements/s
+ */
+
+namespace {
+    void setCounters(benchmark::State& state, std::size_t elements) {
+        state.counters["elements"] = benchmark::Counter(static_cast<double>(state.iterations() * elements),
+                benchmark::Counter::kIsRate);
+    }
+
+    void cheap(float& x) {
+        x = x * 1.0001f + 1.0f;
+    }
+
+    /* the index is smuggled in the value so that the per-element work varies */
+    void uneven(double& x) {
+        auto iterations = static_cast<int>(x) % 4096;
+        double result = x;
+        for (int i = 0; i < iterations; ++i) {
+            result = std::sqrt(result + i);
+        }
+        x = result;
+    }
+
+    std::vector<double> unevenInput(std::size_t size) {
+        std::vector<double> data(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<double>(i * 4096 / size);
+        }
+        return data;
+    }
+
+    void BM_CheapSerial(benchmark::State& state) {
+        std::vector<float> data(state.range(0), 1.0f);
+        for (auto _: state) {
+            std::for_each(data.begin(), data.end(), cheap);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, data.size());
+    }
+
+    void BM_CheapStdPar(benchmark::State& state) {
+        std::vector<float> data(state.range(0), 1.0f);
+        for (auto _: state) {
+            std::for_each(std::execution::par, data.begin(), data.end(), cheap);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, data.size());
+    }
+
+    void BM_CheapParallelFor(benchmark::State& state) {
+        std::vector<float> data(state.range(0), 1.0f);
+        for (auto _: state) {
+            util::parallel::parallelFor(std::span{data}, 0, cheap);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, data.size());
+    }
+
+    void BM_UnevenSerial(benchmark::State& state) {
+        for (auto _: state) {
+            state.PauseTiming();
+            auto data = unevenInput(state.range(0));
+            state.ResumeTiming();
+            std::for_each(data.begin(), data.end(), uneven);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, state.range(0));
+    }
+
+    void BM_UnevenStdPar(benchmark::State& state) {
+        for (auto _: state) {
+            state.PauseTiming();
+            auto data = unevenInput(state.range(0));
+            state.ResumeTiming();
+            std::for_each(std::execution::par, data.begin(), data.end(), uneven);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, state.range(0));
+    }
+
+    void BM_UnevenParallelFor(benchmark::State& state) {
+        for (auto _: state) {
+            state.PauseTiming();
+            auto data = unevenInput(state.range(0));
+            state.ResumeTiming();
+            util::parallel::parallelFor(std::span{data}, 16, uneven);
+            benchmark::DoNotOptimize(data.data());
+        }
+        setCounters(state, state.range(0));
+    }
+
+    void BM_SumSerial(benchmark::State& state) {
+        std::vector<double> data(state.range(0), 1.0);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(std::accumulate(data.begin(), data.end(), 0.0));
+        }
+        setCounters(state, data.size());
+    }
+
+    void BM_SumStdPar(benchmark::State& state) {
+        std::vector<double> data(state.range(0), 1.0);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(std::reduce(std::execution::par, data.begin(), data.end(), 0.0));
+        }
+        setCounters(state, data.size());
+    }
+
+    void BM_SumParallelReduce(benchmark::State& state) {
+        std::vector<double> data(state.range(0), 1.0);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(util::parallel::parallelReduce(std::span{data}, 0, 0.0, std::plus<>{}));
+        }
+        setCounters(state, data.size());
+    }
+}
+
+BENCHMARK(BM_CheapSerial)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(BM_CheapStdPar)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(BM_CheapParallelFor)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(BM_UnevenSerial)->Arg(1 << 14)->UseRealTime();
+BENCHMARK(BM_UnevenStdPar)->Arg(1 << 14)->UseRealTime();
+BENCHMARK(BM_UnevenParallelFor)->Arg(1 << 14)->UseRealTime();
+BENCHMARK(BM_SumSerial)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(BM_SumStdPar)->Range(1 << 10, 1 << 24)->UseRealTime();
+BENCHMARK(BM_SumParallelReduce)->Range(1 << 10, 1 << 24)->UseRealTime();
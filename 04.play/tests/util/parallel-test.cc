@@ -0,0 +1,124 @@
+#include <util/parallel.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using util::parallel::parallelFor;
+using util::parallel::parallelReduce;
+using util::parallel::parallelTransform;
+using util::pool::Pool;
+
+TEST(parallel, forEachElement) {
+    std::vector<int> numbers(100'000);
+    std::iota(numbers.begin(), numbers.end(), 0);
+    parallelFor(std::span{numbers}, 1000, [](int& n) { n *= 2; });
+    for (int i = 0; i < 100'000; ++i) {
+        ASSERT_EQ(numbers[i], 2 * i);
+    }
+}
+
+TEST(parallel, chunksCoverEverythingOnce) {
+    Pool pool{4};
+    for (std::size_t size: {0, 1, 7, 63, 64, 1000, 12345}) {
+        for (std::size_t grain: {0, 1, 16, 100, 100'000}) {
+            std::vector<char> bytes(size);
+            std::mutex mutex;
+            std::vector<std::span<char>> chunks;
+            parallelFor(pool, std::span{bytes}, grain, [&](std::span<char> chunk) {
+                for (auto& byte: chunk) {
+                    ++byte;
+                }
+                std::lock_guard lock{mutex};
+                chunks.push_back(chunk);
+            });
+            for (auto byte: bytes) {
+                ASSERT_EQ(byte, 1) << size << ' ' << grain;
+            }
+
+            /* chunks other than the last one are at least 'grain' long and all but the 1st start on a cache line */
+            for (auto chunk: chunks) {
+                if (chunk.data() + chunk.size() != bytes.data() + bytes.size() && grain != 0) {
+                    EXPECT_GE(chunk.size(), grain);
+                }
+                if (chunk.data() != bytes.data()) {
+                    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(chunk.data()) % 64, 0u);
+                }
+            }
+        }
+    }
+}
+
+TEST(parallel, usesPoolThreads) {
+    Pool pool{3};
+    std::vector<int> numbers(10'000);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    parallelFor(pool, std::span{numbers}, 1, [&](int&) {
+        std::lock_guard lock{mutex};
+        threads.insert(std::this_thread::get_id());
+        std::this_thread::yield();
+    });
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(parallel, transform) {
+    std::vector<int> in(50'000);
+    std::iota(in.begin(), in.end(), 0);
+    std::vector<std::string> out(in.size());
+    parallelTransform(std::span{std::as_const(in)}, std::span{out}, 0, [](int n) { return std::to_string(n); });
+    EXPECT_EQ(out[0], "0");
+    EXPECT_EQ(out[49'999], "49999");
+
+    std::vector<int> shorter(10);
+    EXPECT_THROW(parallelTransform(std::span{in}, std::span{shorter}, 0, [](int n) { return n; }),
+            std::invalid_argument);
+}
+
+TEST(parallel, reduce) {
+    std::vector<long> numbers(1'000'000);
+    std::iota(numbers.begin(), numbers.end(), 1);
+    EXPECT_EQ(parallelReduce(std::span{numbers}, 0, 0L, std::plus<>{}), 500'000'500'000L);
+
+    std::vector<std::string> words{"a", "bb", "ccc", "dddd"};
+    auto totalLength = parallelReduce(std::span{words}, 1, std::size_t{0},
+            [](std::size_t sum, const std::string& word) { return sum + word.size(); }, std::plus<>{});
+    EXPECT_EQ(totalLength, 10u);
+
+    std::vector<int> empty;
+    EXPECT_EQ(parallelReduce(std::span{empty}, 0, 42, std::plus<>{}), 42);
+}
+
+TEST(parallel, exceptions) {
+    Pool pool{2};
+    std::vector<int> numbers(100'000);
+    std::atomic<int> calls = 0;
+    EXPECT_THROW(parallelFor(pool, std::span{numbers}, 10, [&calls](int& n) {
+        ++calls;
+        if (++n, calls.load() == 50) {
+            throw std::runtime_error("failed");
+        }
+    }), std::runtime_error);
+    /* the remaining chunks got skipped */
+    EXPECT_LT(calls.load(), 100'000);
+}
+
+TEST(parallel, nestedInPoolTasks) {
+    Pool pool{2};
+    std::vector<std::vector<int>> rows(8, std::vector<int>(1000, 1));
+    std::vector<int> sums(rows.size());
+    parallelFor(pool, std::span{rows}, 1, [&](std::vector<int>& row) {
+        sums[&row - rows.data()] = parallelReduce(pool, std::span{row}, 100, 0, std::plus<>{}, std::plus<>{});
+    });
+    for (auto sum: sums) {
+        EXPECT_EQ(sum, 1000);
+    }
+}
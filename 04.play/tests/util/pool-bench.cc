@@ -0,0 +1,79 @@
+#include <util/pool.h>
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+/*
+ * Fan-out of a batch of tasks and waiting for all of them: Pool::submit() against std::async(std::launch::async)
+ * Tasks spin for 1us to 1ms; for short tasks std::async is dominated by creating a thread per call
+ *
+ * Results are reported in tasks/s
+ */
+
+namespace {
+    constexpr int BATCH = 64;
+
+    void spinFor(std::chrono::nanoseconds duration) {
+        auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+
+    template <typename Submit>
+    void runBatches(benchmark::State& state, Submit&& submit) {
+        std::chrono::microseconds duration{state.range(0)};
+        for (auto _: state) {
+            std::vector<decltype(submit(duration))> futures;
+            futures.reserve(BATCH);
+            for (int i = 0; i < BATCH; ++i) {
+                futures.push_back(submit(duration));
+            }
+            for (auto& future: futures) {
+                future.get();
+            }
+        }
+        state.counters["tasks"] = benchmark::Counter(state.iterations() * BATCH, benchmark::Counter::kIsRate);
+    }
+
+    void BM_PoolSubmit(benchmark::State& state) {
+        util::pool::Pool pool;
+        runBatches(state, [&pool](auto duration) {
+            return pool.submit([duration] { spinFor(duration); });
+        });
+    }
+
+    void BM_StdAsync(benchmark::State& state) {
+        runBatches(state, [](auto duration) {
+            return std::async(std::launch::async, [duration] { spinFor(duration); });
+        });
+    }
+
+    /** Each task submits subtasks and waits for them: tree of 1 + 8 + 64 tasks per batch item */
+    void BM_PoolNested(benchmark::State& state) {
+        util::pool::Pool pool;
+        std::chrono::microseconds duration{state.range(0)};
+        auto subtasks = [&pool, duration](int depth, auto& self) -> void {
+            spinFor(duration);
+            if (depth == 0) {
+                return;
+            }
+            std::vector<util::pool::Future<void>> futures;
+            for (int i = 0; i < 8; ++i) {
+                futures.push_back(pool.submit([depth, &self] { self(depth - 1, self); }));
+            }
+            for (auto& future: futures) {
+                future.get();
+            }
+        };
+        for (auto _: state) {
+            pool.submit([&subtasks] { subtasks(2, subtasks); }).get();
+        }
+        state.counters["tasks"] = benchmark::Counter(state.iterations() * 73, benchmark::Counter::kIsRate);
+    }
+}
+
+/* argument is task duration in microseconds */
+BENCHMARK(BM_PoolSubmit)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
+BENCHMARK(BM_StdAsync)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
+BENCHMARK(BM_PoolNested)->Arg(1)->Arg(10)->Arg(100)->UseRealTime();
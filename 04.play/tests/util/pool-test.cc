@@ -0,0 +1,193 @@
+#include <util/pool.h>
+#include <util/log.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/log/sinks.hpp>
+
+using util::pool::Future;
+using util::pool::Pool;
+
+namespace testexc {
+    class TestException: public std::logic_error {
+        using logic_error::logic_error;
+    };
+}
+
+namespace {
+    const std::exception* thrown = nullptr;
+
+    __attribute__((noinline))
+    int d_a() {
+        throw testexc::TestException("thrown in a pool task");
+    }
+
+    int failing() {
+        try {
+            return d_a();
+        } catch (const std::exception& e) {
+            thrown = &e;
+            throw;
+        }
+    }
+
+    long fib(Pool& pool, int n) {
+        if (n < 15) {
+            return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+        }
+        auto left = pool.submit([&pool, n] { return fib(pool, n - 1); });
+        auto right = fib(pool, n - 2);
+        return left.get() + right;
+    }
+}
+
+TEST(pool, values) {
+    Pool pool{2};
+    auto answer = pool.submit([] { return 42; });
+    auto text = pool.submit([s = std::string{"abc"}] { return s + s; });
+
+    int counter = 0;
+    auto nothing = pool.submit([&counter] { ++counter; });
+
+    EXPECT_EQ(answer.get(), 42);
+    EXPECT_EQ(text.get(), "abcabc");
+    nothing.get();
+    EXPECT_EQ(counter, 1);
+    EXPECT_FALSE(answer.valid());
+    EXPECT_THROW(answer.get(), std::logic_error);
+}
+
+TEST(pool, exceptionIsTheSameObject) {
+    Pool pool{2};
+    auto future = pool.submit(failing);
+    try {
+        future.get();
+        FAIL() << "should have thrown";
+    } catch (const testexc::TestException& e) {
+        EXPECT_EQ(&e, thrown);
+    }
+}
+
+TEST(pool, manyFromOutside) {
+    constexpr int TASKS = 100'000;
+    Pool pool{4};
+
+    std::vector<Future<int>> futures;
+    futures.reserve(TASKS);
+    for (int i = 0; i < TASKS; ++i) {
+        futures.push_back(pool.submit([i] { return i % 7; }));
+    }
+
+    long total = 0;
+    for (auto& future: futures) {
+        total += future.get();
+    }
+
+    long expected = 0;
+    for (int i = 0; i < TASKS; ++i) {
+        expected += i % 7;
+    }
+    EXPECT_EQ(total, expected);
+}
+
+/** Tasks waiting for their subtasks don't deadlock even if there are way more of them than threads */
+TEST(pool, nested) {
+    Pool pool{2};
+    EXPECT_EQ(pool.submit([&pool] { return fib(pool, 25); }).get(), 75025);
+}
+
+TEST(pool, destructorRunsEverything) {
+    std::atomic<int> counter = 0;
+    {
+        Pool pool{3};
+        for (int i = 0; i < 1000; ++i) {
+            (void) pool.submit([&counter, &pool] {
+                /* and subtasks submitted while the pool is shutting down get run as well */
+                (void) pool.submit([&counter] { ++counter; });
+                ++counter;
+            });
+        }
+    }
+    EXPECT_EQ(counter.load(), 2000);
+}
+
+TEST(pool, workDeque) {
+    constexpr int ITEMS = 200'000;
+    constexpr int THIEVES = 3;
+
+    util::pool::_detail::WorkDeque<int*> deque{4};
+    std::vector<int> items(ITEMS);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done = false;
+
+    auto take = [&](int* item) {
+        taken[item - items.data()].fetch_add(1, std::memory_order_relaxed);
+    };
+
+    std::vector<std::jthread> thieves;
+    for (int i = 0; i < THIEVES; ++i) {
+        thieves.emplace_back([&] {
+            while (!done.load()) {
+                if (auto item = deque.steal()) {
+                    take(*item);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < ITEMS; ++i) {
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            if (auto item = deque.pop()) {
+                take(*item);
+            }
+        }
+    }
+    while (auto item = deque.pop()) {
+        take(*item);
+    }
+    done = true;
+    thieves.clear();
+
+    while (auto item = deque.steal()) {
+        take(*item);
+    }
+    for (int i = 0; i < ITEMS; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "item " << i;
+    }
+}
+
+namespace sinks = boost::log::sinks;
+using text_sink = sinks::synchronous_sink<sinks::text_ostream_backend>;
+
+struct test{};
+
+/** Exception thrown on a pool thread and logged by the caller of get() still has its stack trace */
+TEST(pool, loggedWithStackTrace) {
+    auto output = boost::make_shared<std::ostringstream>();
+    auto sink = boost::make_shared<text_sink>();
+    sink->locked_backend()->add_stream(output);
+    util::log::setStandardLogFormat(sink);
+    boost::log::core::get()->add_sink(sink);
+    util::log::commonLoggingSetup();
+
+    Pool pool{1};
+    try {
+        pool.submit(failing).get();
+    } catch (const std::exception& e) {
+        util::log::getLogger<test>().error("Task failed", e);
+    }
+    sink->flush();
+    boost::log::core::get()->remove_sink(sink);
+
+    auto result = output->str();
+    EXPECT_NE(result.find(" #ERROR [test] Task failed: testexc::TestException(thrown in a pool task)"),
+            std::string::npos) << " but it is " << result;
+    EXPECT_NE(result.find("\n\t@ "), std::string::npos) << " but it is " << result;
+}
@@ -0,0 +1,153 @@
+#include <util/profiled_mutex.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using util::profiled_mutex::Histogram;
+using util::profiled_mutex::ProfiledMutex;
+using util::profiled_mutex::SiteStats;
+
+namespace {
+    const SiteStats& find(const std::vector<SiteStats>& stats, std::string_view name) {
+        auto it = std::ranges::find(stats, name, &SiteStats::name);
+        if (it == stats.end()) {
+            throw std::runtime_error("no such site");
+        }
+        return *it;
+    }
+
+    std::uint64_t total(const Histogram& histogram) {
+        return std::accumulate(histogram.begin(), histogram.end(), std::uint64_t{0});
+    }
+
+    struct Guarded {
+        ProfiledMutex mutex;
+        int value = 0;
+    };
+}
+
+TEST(profiled_mutex, quantile) {
+    Histogram histogram{};
+    EXPECT_EQ(util::profiled_mutex::quantile(histogram, 0.5), 0ns);
+
+    histogram[3] = 50;  // 4..7ns
+    histogram[10] = 49; // 512..1023ns
+    histogram[20] = 1;
+    EXPECT_EQ(util::profiled_mutex::quantile(histogram, 0.0), 7ns);
+    EXPECT_EQ(util::profiled_mutex::quantile(histogram, 0.5), 7ns);
+    EXPECT_EQ(util::profiled_mutex::quantile(histogram, 0.6), 1023ns);
+    EXPECT_EQ(util::profiled_mutex::quantile(histogram, 1.0), 1'048'575ns);
+}
+
+TEST(profiled_mutex, uncontended) {
+    ProfiledMutex mutex{"test-uncontended"};
+    for (int i = 0; i < 100; ++i) {
+        std::lock_guard lock{mutex};
+    }
+    {
+        std::unique_lock lock{mutex, std::try_to_lock};
+        EXPECT_TRUE(lock.owns_lock());
+        EXPECT_FALSE(mutex.try_lock());
+    }
+
+    auto stats = util::profiled_mutex::snapshot();
+    auto& site = find(stats, "test-uncontended");
+    EXPECT_EQ(site.acquisitions, 101u);
+    EXPECT_EQ(site.contended, 0u);
+    EXPECT_EQ(site.totalWait, 0ns);
+    EXPECT_EQ(total(site.waits), 101u);
+    EXPECT_EQ(total(site.holds), 101u);
+    EXPECT_NE(site.location.find("profiled_mutex-test.cc:"), std::string::npos);
+}
+
+TEST(profiled_mutex, contended) {
+    ProfiledMutex mutex{"test-contended"};
+    std::unique_lock held{mutex};
+
+    std::jthread waiter{[&mutex] {
+        std::lock_guard lock{mutex};
+    }};
+    std::this_thread::sleep_for(20ms);
+    held.unlock();
+    waiter.join();
+
+    auto stats = util::profiled_mutex::snapshot();
+    auto& site = find(stats, "test-contended");
+    EXPECT_EQ(site.acquisitions, 2u);
+    EXPECT_EQ(site.contended, 1u);
+    EXPECT_GE(site.maxWait, 10ms);
+    EXPECT_GE(site.totalHold, 10ms);
+    EXPECT_GE(util::profiled_mutex::quantile(site.waits, 1.0), 10ms);
+}
+
+/** All instances constructed at the same place share one site */
+TEST(profiled_mutex, sitePerLocation) {
+    std::vector<Guarded> guarded(10);
+    for (auto& g: guarded) {
+        std::lock_guard lock{g.mutex};
+        ++g.value;
+    }
+
+    auto stats = util::profiled_mutex::snapshot();
+    auto members = std::ranges::count_if(stats, [](const SiteStats& site) {
+        return site.function.find("Guarded") != std::string::npos;
+    });
+    EXPECT_EQ(members, 1);
+}
+
+TEST(profiled_mutex, withConditionVariable) {
+    ProfiledMutex mutex{"test-cv"};
+    std::condition_variable_any cv;
+    bool ready = false;
+
+    std::jthread notifier{[&] {
+        std::lock_guard lock{mutex};
+        ready = true;
+        cv.notify_one();
+    }};
+    std::unique_lock lock{mutex};
+    cv.wait(lock, [&ready] { return ready; });
+}
+
+TEST(profiled_mutex, stress) {
+    constexpr int THREADS = 4;
+    constexpr int ITERATIONS = 10'000;
+
+    ProfiledMutex mutex{"test-stress"};
+    long counter = 0;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < ITERATIONS; ++i) {
+                    std::lock_guard lock{mutex};
+                    ++counter;
+                }
+            });
+        }
+    }
+    EXPECT_EQ(counter, THREADS * ITERATIONS);
+
+    auto stats = util::profiled_mutex::snapshot();
+    auto& site = find(stats, "test-stress");
+    EXPECT_EQ(site.acquisitions, std::uint64_t{THREADS * ITERATIONS});
+    EXPECT_EQ(total(site.waits), site.acquisitions);
+    EXPECT_EQ(total(site.holds), site.acquisitions);
+
+    util::profiled_mutex::report(3);
+    util::profiled_mutex::reset();
+    EXPECT_THROW(find(util::profiled_mutex::snapshot(), "test-stress"), std::runtime_error);
+}
+
+TEST(profiled_mutex, reportPeriodically) {
+    auto reporter = util::profiled_mutex::reportPeriodically(1ms);
+    std::this_thread::sleep_for(5ms);
+}
@@ -0,0 +1,148 @@
+#include <util/queue.h>
+#include <benchmark/benchmark.h>
+#include <folly/MPMCQueue.h>
+#include <folly/ProducerConsumerQueue.h>
+
+#include <array>
+#include <thread>
+
+/*
+ * Throughput of handing ints between threads: util::queue against folly::ProducerConsumerQueue and folly::MPMCQueue
+ *
+ * Even-numbered benchmark threads produce and odd-numbered ones consume, each moving ITEMS items per iteration;
+ * a thread that finds the queue full or empty yields, which matters when there are more threads than cores
+ *
+ * Results are reported in items/s
+ */
+
+namespace {
+    constexpr std::size_t CAPACITY = 1024;
+    constexpr int ITEMS = 256;
+    constexpr std::size_t BATCH = 32;
+
+    /* uniform interface over the queues: push() and pop() don't block */
+
+    template <typename Queue>
+    struct Util {
+        Queue queue{CAPACITY};
+
+        bool push(int value) {
+            return queue.tryPush(value);
+        }
+
+        bool pop(int& value) {
+            auto popped = queue.tryPop();
+            if (popped) {
+                value = *popped;
+            }
+            return popped.has_value();
+        }
+    };
+
+    struct FollySpsc {
+        /* folly keeps one slot empty */
+        folly::ProducerConsumerQueue<int> queue{CAPACITY + 1};
+
+        bool push(int value) {
+            return queue.write(value);
+        }
+
+        bool pop(int& value) {
+            return queue.read(value);
+        }
+    };
+
+    struct FollyMpmc {
+        folly::MPMCQueue<int> queue{CAPACITY};
+
+        bool push(int value) {
+            return queue.write(value);
+        }
+
+        bool pop(int& value) {
+            return queue.read(value);
+        }
+    };
+
+    void setItemsRate(benchmark::State& state) {
+        /* every item is counted once by its producer and once by its consumer */
+        state.counters["items"] = benchmark::Counter(state.iterations() * ITEMS / 2, benchmark::Counter::kIsRate);
+    }
+
+    template <typename Queue>
+    void BM_PingPong(benchmark::State& state) {
+        static Queue queue;
+        bool producer = state.thread_index() % 2 == 0;
+        for (auto _: state) {
+            for (int i = 0; i < ITEMS; ++i) {
+                int value = i;
+                while (!(producer ? queue.push(value) : queue.pop(value))) {
+                    std::this_thread::yield();
+                }
+                benchmark::DoNotOptimize(value);
+            }
+        }
+        setItemsRate(state);
+    }
+
+    template <typename Queue>
+    void BM_Batches(benchmark::State& state) {
+        static Queue queue{CAPACITY};
+        bool producer = state.thread_index() % 2 == 0;
+        std::array<int, BATCH> batch{};
+        for (auto _: state) {
+            for (std::size_t done = 0; done < ITEMS;) {
+                auto count = producer ? queue.tryPushBatch(batch) : queue.tryPopBatch(batch.begin(), BATCH);
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+                done += count;
+                benchmark::DoNotOptimize(batch);
+            }
+        }
+        setItemsRate(state);
+    }
+
+    void BM_BlockingUtil(benchmark::State& state) {
+        static util::queue::BlockingMpmcQueue<int> queue{CAPACITY};
+        bool producer = state.thread_index() % 2 == 0;
+        for (auto _: state) {
+            for (int i = 0; i < ITEMS; ++i) {
+                if (producer) {
+                    queue.push(i);
+                } else {
+                    benchmark::DoNotOptimize(queue.pop());
+                }
+            }
+        }
+        setItemsRate(state);
+    }
+
+    void BM_BlockingFolly(benchmark::State& state) {
+        static folly::MPMCQueue<int> queue{CAPACITY};
+        bool producer = state.thread_index() % 2 == 0;
+        for (auto _: state) {
+            for (int i = 0; i < ITEMS; ++i) {
+                int value = i;
+                if (producer) {
+                    queue.blockingWrite(value);
+                } else {
+                    queue.blockingRead(value);
+                }
+                benchmark::DoNotOptimize(value);
+            }
+        }
+        setItemsRate(state);
+    }
+}
+
+BENCHMARK(BM_PingPong<Util<util::queue::SpscQueue<int>>>)->Threads(2)->UseRealTime();
+BENCHMARK(BM_PingPong<FollySpsc>)->Threads(2)->UseRealTime();
+BENCHMARK(BM_Batches<util::queue::SpscQueue<int>>)->Threads(2)->UseRealTime();
+
+BENCHMARK(BM_PingPong<Util<util::queue::MpmcQueue<int>>>)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_PingPong<FollyMpmc>)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_Batches<util::queue::MpmcQueue<int>>)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+BENCHMARK(BM_BlockingUtil)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_BlockingFolly)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
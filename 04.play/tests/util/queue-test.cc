@@ -0,0 +1,317 @@
+#include <util/queue.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using util::queue::BlockingMpmcQueue;
+using util::queue::BlockingSpscQueue;
+using util::queue::MpmcQueue;
+using util::queue::SpscQueue;
+
+/*
+ * The stress tests are meant to be run under ThreadSanitizer as well:
+ * they are short enough and exercise wrap-around, full and empty queues from all sides
+ *
+ * Spinning threads yield when the queue is full or empty so that the tests don't crawl on machines with few cores
+ */
+
+namespace {
+    constexpr std::size_t CAPACITY = 64;
+    constexpr int ITEMS = 100'000;
+
+    template <typename Queue>
+    class queue_test: public testing::Test {};
+
+    using Queues = testing::Types<SpscQueue<int>, MpmcQueue<int>>;
+    TYPED_TEST_SUITE(queue_test, Queues);
+
+    /** Every value from 0 to count-1 popped exactly once */
+    void expectPermutation(std::vector<int> values, int count) {
+        ASSERT_EQ(values.size(), static_cast<std::size_t>(count));
+        std::ranges::sort(values);
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(values[i], i);
+        }
+    }
+}
+
+TEST(queue, capacity) {
+    EXPECT_EQ(SpscQueue<int>{5}.capacity(), 8u);
+    EXPECT_EQ(MpmcQueue<int>{64}.capacity(), 64u);
+    EXPECT_EQ(MpmcQueue<int>{1}.capacity(), 2u);
+    EXPECT_THROW(SpscQueue<int>{0}, std::invalid_argument);
+    EXPECT_THROW(MpmcQueue<int>{0}, std::invalid_argument);
+}
+
+TYPED_TEST(queue_test, fifo) {
+    TypeParam queue{4};
+    EXPECT_FALSE(queue.tryPop());
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(queue.tryPush(i));
+        }
+        EXPECT_FALSE(queue.tryPush(4));
+        EXPECT_EQ(queue.sizeApprox(), 4u);
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(queue.tryPop(), i);
+        }
+        EXPECT_FALSE(queue.tryPop());
+    }
+}
+
+TYPED_TEST(queue_test, batches) {
+    TypeParam queue{8};
+    std::vector<int> in(12);
+    std::iota(in.begin(), in.end(), 0);
+
+    EXPECT_EQ(queue.tryPushBatch(in), 8u);
+    EXPECT_EQ(queue.tryPushBatch(std::span{in}.subspan(8)), 0u);
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.tryPopBatch(std::back_inserter(out), 3), 3u);
+    EXPECT_EQ(queue.tryPushBatch(std::span{in}.subspan(8)), 3u);
+    EXPECT_EQ(queue.tryPopBatch(std::back_inserter(out), 100), 8u);
+    EXPECT_EQ(queue.tryPopBatch(std::back_inserter(out), 100), 0u);
+
+    std::vector<int> expected(11);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(out, expected);
+}
+
+/** A failed push leaves the value alone; whatever is left in the queue gets destroyed with it */
+TEST(queue, ownership) {
+    auto tracked = std::make_shared<int>(42);
+    {
+        MpmcQueue<std::shared_ptr<int>> mpmc{2};
+        SpscQueue<std::shared_ptr<int>> spsc{1};
+        EXPECT_TRUE(mpmc.tryPush(tracked));
+        EXPECT_TRUE(mpmc.tryPush(tracked));
+        EXPECT_TRUE(spsc.tryPush(tracked));
+
+        auto extra = tracked;
+        EXPECT_FALSE(mpmc.tryPush(std::move(extra)));
+        EXPECT_FALSE(spsc.tryPush(std::move(extra)));
+        EXPECT_EQ(extra, tracked);
+        EXPECT_EQ(tracked.use_count(), 5);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+
+    SpscQueue<std::string> strings{2};
+    EXPECT_TRUE(strings.tryEmplace(3, 'x'));
+    EXPECT_EQ(strings.tryPop(), "xxx");
+}
+
+TEST(queue, spscStress) {
+    SpscQueue<int> queue{CAPACITY};
+    std::jthread producer{[&queue] {
+        for (int i = 0; i < ITEMS;) {
+            if (i % 3 == 0) {
+                std::vector<int> batch;
+                for (int j = i; j < std::min(i + 7, ITEMS); ++j) {
+                    batch.push_back(j);
+                }
+                auto pushed = static_cast<int>(queue.tryPushBatch(batch));
+                i += pushed;
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+            } else if (queue.tryPush(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    std::vector<int> out;
+    while (out.size() < ITEMS) {
+        if (out.size() % 2 == 0) {
+            if (queue.tryPopBatch(std::back_inserter(out), 5) == 0) {
+                std::this_thread::yield();
+            }
+        } else if (auto value = queue.tryPop()) {
+            out.push_back(*value);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    /* a single producer and consumer keep the order */
+    for (int i = 0; i < ITEMS; ++i) {
+        ASSERT_EQ(out[i], i);
+    }
+}
+
+TEST(queue, mpmcStress) {
+    constexpr int PRODUCERS = 4;
+    constexpr int CONSUMERS = 4;
+    constexpr int PER_PRODUCER = ITEMS / PRODUCERS;
+
+    MpmcQueue<int> queue{CAPACITY};
+    std::atomic<int> consumed = 0;
+    std::vector<std::vector<int>> outs(CONSUMERS);
+    {
+        std::vector<std::jthread> threads;
+        for (int p = 0; p < PRODUCERS; ++p) {
+            threads.emplace_back([&queue, p] {
+                for (int i = p * PER_PRODUCER; i < (p + 1) * PER_PRODUCER;) {
+                    if (p % 2 == 0) {
+                        std::vector<int> batch;
+                        for (int j = i; j < std::min(i + 5, (p + 1) * PER_PRODUCER); ++j) {
+                            batch.push_back(j);
+                        }
+                        auto pushed = static_cast<int>(queue.tryPushBatch(batch));
+                        i += pushed;
+                        if (pushed == 0) {
+                            std::this_thread::yield();
+                        }
+                    } else if (queue.tryPush(i)) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < CONSUMERS; ++c) {
+            threads.emplace_back([&, c] {
+                auto& out = outs[c];
+                while (consumed.load(std::memory_order_relaxed) < ITEMS) {
+                    std::size_t popped = 0;
+                    if (c % 2 == 0) {
+                        popped = queue.tryPopBatch(std::back_inserter(out), 4);
+                    } else if (auto value = queue.tryPop()) {
+                        out.push_back(*value);
+                        popped = 1;
+                    }
+                    if (popped == 0) {
+                        std::this_thread::yield();
+                    }
+                    consumed.fetch_add(static_cast<int>(popped), std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    std::vector<int> all;
+    for (auto& out: outs) {
+        /* each producer's items come out in order as seen by any one consumer */
+        std::vector<int> last(PRODUCERS, -1);
+        for (auto value: out) {
+            ASSERT_GT(value, last[value / PER_PRODUCER]);
+            last[value / PER_PRODUCER] = value;
+        }
+        all.insert(all.end(), out.begin(), out.end());
+    }
+    expectPermutation(std::move(all), ITEMS);
+}
+
+TEST(queue, blockingMpmc) {
+    constexpr int PRODUCERS = 3;
+    constexpr int CONSUMERS = 3;
+    constexpr int PER_PRODUCER = 10'000;
+
+    /* tiny capacity so that both producers and consumers keep blocking */
+    BlockingMpmcQueue<int> queue{2};
+    std::vector<std::vector<int>> outs(CONSUMERS);
+    {
+        std::vector<std::jthread> consumers;
+        for (int c = 0; c < CONSUMERS; ++c) {
+            consumers.emplace_back([&queue, &out = outs[c], c](std::stop_token stopToken) {
+                std::vector<int> batch;
+                for (;;) {
+                    if (c == 0) {
+                        batch.clear();
+                        if (queue.popBatch(std::back_inserter(batch), 3, stopToken) == 0) {
+                            return;
+                        }
+                        out.insert(out.end(), batch.begin(), batch.end());
+                    } else if (auto value = queue.pop(stopToken)) {
+                        out.push_back(*value);
+                    } else {
+                        return;
+                    }
+                }
+            });
+        }
+        {
+            std::vector<std::jthread> producers;
+            for (int p = 0; p < PRODUCERS; ++p) {
+                producers.emplace_back([&queue, p] {
+                    if (p == 0) {
+                        std::vector<int> values(PER_PRODUCER);
+                        std::iota(values.begin(), values.end(), 0);
+                        EXPECT_EQ(queue.pushBatch(values), values.size());
+                        return;
+                    }
+                    for (int i = p * PER_PRODUCER; i < (p + 1) * PER_PRODUCER; ++i) {
+                        EXPECT_TRUE(queue.push(i));
+                    }
+                });
+            }
+        }
+
+        /* producers are done; let consumers drain the queue before stopping them */
+        while (queue.queue().sizeApprox() != 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    std::vector<int> all;
+    for (auto& out: outs) {
+        all.insert(all.end(), out.begin(), out.end());
+    }
+    expectPermutation(std::move(all), PRODUCERS * PER_PRODUCER);
+}
+
+TEST(queue, blockingSpsc) {
+    BlockingSpscQueue<std::unique_ptr<int>> queue{4};
+    std::jthread producer{[&queue] {
+        for (int i = 0; i < ITEMS / 10; ++i) {
+            queue.push(std::make_unique<int>(i));
+        }
+    }};
+    for (int i = 0; i < ITEMS / 10; ++i) {
+        auto value = queue.pop();
+        ASSERT_TRUE(value);
+        ASSERT_EQ(**value, i);
+    }
+}
+
+TEST(queue, stopWakesWaiters) {
+    BlockingMpmcQueue<int> queue{2};
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(1));
+
+    std::stop_source stop;
+    std::atomic<bool> pushed = true;
+    std::jthread producer{[&] {
+        pushed = queue.push(2, stop.get_token());
+    }};
+
+    BlockingSpscQueue<int> empty{1};
+    std::optional<int> popped = 0;
+    std::jthread consumer{[&] {
+        popped = empty.pop(stop.get_token());
+    }};
+
+    std::this_thread::sleep_for(20ms);
+    stop.request_stop();
+    producer.join();
+    consumer.join();
+    EXPECT_FALSE(pushed.load());
+    EXPECT_FALSE(popped);
+
+    /* already stopped: returns right away */
+    EXPECT_FALSE(empty.pop(stop.get_token()));
+    EXPECT_EQ(queue.tryPop(), 1);
+}
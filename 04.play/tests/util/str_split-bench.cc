@@ -0,0 +1,313 @@
+#include <util/str_split.h>
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * 1st part: LinesSplitView against the usual alternatives for splitting text into lines
+ * - LinesSplitView over a string_view and over an owning std::string (owning_view)
+ * - std::views::split on '\n'
+ * - std::getline on an std::istringstream
+ * - a memchr loop and a plain byte-by-byte loop implementing same rules as LinesSplitView
+ *
+ * Each of these gets run on
+ * - 3 line length distributions: short (0..16), log-like (mostly 60..160 with some stack trace lines), very long (4..64K)
+ * - LF or CRLF line endings
+ * - warm cache (same input scanned again and again) or cold cache (input flushed from caches before each pass)
+ *
+ * Results are reported in bytes/s and lines/s; variants implementing LinesSplitView rules
+ * also check that they agree on the number of lines, and report an error if they don't
+ *
+ * 2nd part: SplitView against std::views::split for splitting on \t , | etc
+ */
+
+namespace {
+    constexpr std::size_t INPUT_SIZE = 8 << 20;
+
+    enum Distribution { SHORT, LOG_LIKE, VERY_LONG };
+
+    std::string makeLines(Distribution distribution, bool crlf) {
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<int> letter{'a', 'z'};
+        std::uniform_int_distribution<std::size_t> shortLength{0, 16};
+        std::normal_distribution<double> logLength{110, 25};
+        std::uniform_int_distribution<std::size_t> traceLength{40, 120};
+        std::uniform_int_distribution<std::size_t> longLength{4 << 10, 64 << 10};
+
+        std::string result;
+        result.reserve(INPUT_SIZE + (64 << 10) + 2);
+        for (std::size_t line = 0; result.size() < INPUT_SIZE; ++line) {
+            std::size_t length = 0;
+            switch (distribution) {
+                case SHORT:
+                    length = shortLength(gen);
+                    break;
+                case LOG_LIKE:
+                    /* every 10th record comes with a handful of "\t@ frame" lines */
+                    length = line % 10 < 6 ? static_cast<std::size_t>(std::clamp(logLength(gen), 30.0, 400.0))
+                            : traceLength(gen);
+                    break;
+                case VERY_LONG:
+                    length = longLength(gen);
+                    break;
+            }
+            for (; length > 0; --length) {
+                result += static_cast<char>(letter(gen));
+            }
+            result += crlf ? "\r\n" : "\n";
+        }
+        return result;
+    }
+
+    /** Flushes input out of all cache levels so that the next pass has to go to memory */
+    void evictFromCache(std::string_view input) {
+#if defined(__SSE2__)
+        for (std::size_t offset = 0; offset < input.size(); offset += 64) {
+            _mm_clflush(input.data() + offset);
+        }
+        _mm_mfence();
+#else
+        static std::string evictor(64 << 20, 'x');
+        for (std::size_t offset = 0; offset < evictor.size(); offset += 64) {
+            benchmark::DoNotOptimize(evictor[offset] += 1);
+        }
+#endif
+    }
+
+    /** Runs 'splitter' over 'bytes' for each iteration, 'splitter' returns the number of lines it has seen */
+    template <typename Splitter>
+    void runLines(benchmark::State& state, std::string_view bytes, Splitter&& splitter, bool checkCount = true) {
+        bool cold = state.range(2);
+
+        std::size_t lines = 0;
+        std::size_t linesPerPass = 0;
+        for (auto _: state) {
+            if (cold) {
+                state.PauseTiming();
+                evictFromCache(bytes);
+                state.ResumeTiming();
+            }
+            linesPerPass = splitter();
+            lines += linesPerPass;
+        }
+
+        if (checkCount) {
+            /* every line in our inputs is terminated and there are no dangling \r so this is easy to count */
+            auto expected = static_cast<std::size_t>(std::ranges::count(bytes, '\n'));
+            if (linesPerPass != expected) {
+                state.SkipWithError("wrong number of lines");
+                return;
+            }
+        }
+
+        state.SetBytesProcessed(state.iterations() * bytes.size());
+        state.counters["lines"] = benchmark::Counter(lines, benchmark::Counter::kIsRate);
+    }
+
+    std::string linesFor(const benchmark::State& state) {
+        return makeLines(static_cast<Distribution>(state.range(0)), state.range(1));
+    }
+
+    std::size_t countLines(const auto& view) {
+        std::size_t count = 0;
+        for (auto line: view) {
+            benchmark::DoNotOptimize(line.data());
+            ++count;
+        }
+        return count;
+    }
+
+    void BM_LinesSplitView(benchmark::State& state) {
+        auto input = linesFor(state);
+        runLines(state, input, [&] {
+            return countLines(util::str_split::LinesSplitView{std::string_view{input}});
+        });
+    }
+
+    /** View is constructed once outside of timing loop, we only want to see the cost of iterating via owning_view */
+    void BM_LinesSplitViewOwning(benchmark::State& state) {
+        auto input = linesFor(state);
+        /* moving a heap-allocated string keeps its buffer so 'bytes' still points at what the view owns */
+        std::string_view bytes{input};
+        util::str_split::LinesSplitView view{std::move(input)};
+        runLines(state, bytes, [&] {
+            return countLines(view);
+        });
+    }
+
+    /** Doesn't know about \r\n, it's here as the baseline we're trying to beat */
+    void BM_StdViewsSplit(benchmark::State& state) {
+        auto input = linesFor(state);
+        runLines(state, input, [&] {
+            std::size_t count = 0;
+            for (auto line: std::views::split(std::string_view{input}, '\n')) {
+                benchmark::DoNotOptimize(std::ranges::data(line));
+                ++count;
+            }
+            return count;
+        }, false);
+    }
+
+    /** Copies every line into a std::string and doesn't know about \r\n either */
+    void BM_Getline(benchmark::State& state) {
+        auto input = linesFor(state);
+        runLines(state, input, [&] {
+            std::istringstream is{input};
+            std::string line;
+            std::size_t count = 0;
+            while (std::getline(is, line)) {
+                benchmark::DoNotOptimize(line.data());
+                ++count;
+            }
+            return count;
+        });
+    }
+
+    /** Same rules as LinesSplitView, uses memchr to find '\n' and then looks back for '\r' */
+    void BM_MemchrLoop(benchmark::State& state) {
+        auto input = linesFor(state);
+        runLines(state, input, [&] {
+            const char* p = input.data();
+            const char* stop = p + input.size();
+            std::size_t count = 0;
+            while (p != stop) {
+                auto nl = static_cast<const char*>(std::memchr(p, '\n', stop - p));
+                const char* lineEnd = nl ? nl : stop;
+                if (lineEnd != p && lineEnd[-1] == '\r') {
+                    --lineEnd;
+                }
+                benchmark::DoNotOptimize(std::string_view(p, lineEnd - p));
+                ++count;
+                if (!nl) {
+                    break;
+                }
+                p = nl + 1;
+            }
+            return count;
+        });
+    }
+
+    /** Byte-by-byte loop, pretty much what LinesSplitIterator used to do before it got its SIMD scanner */
+    void BM_ByteLoop(benchmark::State& state) {
+        auto input = linesFor(state);
+        runLines(state, input, [&] {
+            std::string_view sv{input};
+            std::size_t count = 0;
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < sv.size(); ++i) {
+                if (sv[i] == '\n') {
+                    std::size_t stop = i != start && sv[i - 1] == '\r' ? i - 1 : i;
+                    benchmark::DoNotOptimize(sv.substr(start, stop - start));
+                    ++count;
+                    start = i + 1;
+                }
+            }
+            return count;
+        });
+    }
+
+    /* distribution: 0 - short, 1 - log-like, 2 - very long */
+    void linesArgs(benchmark::internal::Benchmark* b) {
+        b->ArgNames({"dist", "crlf", "cold"})->ArgsProduct({{SHORT, LOG_LIKE, VERY_LONG}, {0, 1}, {0, 1}});
+    }
+}
+
+BENCHMARK(BM_LinesSplitView)->Apply(linesArgs);
+BENCHMARK(BM_LinesSplitViewOwning)->Apply(linesArgs);
+BENCHMARK(BM_StdViewsSplit)->Apply(linesArgs);
+BENCHMARK(BM_Getline)->Apply(linesArgs);
+BENCHMARK(BM_MemchrLoop)->Apply(linesArgs);
+BENCHMARK(BM_ByteLoop)->Apply(linesArgs);
+
+namespace {
+    std::string makeFields(std::size_t size, std::size_t maxField) {
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<std::size_t> fieldLength{0, maxField};
+        std::uniform_int_distribution<int> letter{'a', 'z'};
+
+        std::string result;
+        result.reserve(size + maxField + 1);
+        for (int field = 0; result.size() < size; ++field) {
+            for (auto n = fieldLength(gen); n > 0; --n) {
+                result += static_cast<char>(letter(gen));
+            }
+            result += field % 8 == 7 ? '\n' : '\t';
+        }
+        return result;
+    }
+
+    constexpr std::size_t FIELDS_INPUT_SIZE = 1 << 20;
+
+    void setCounters(benchmark::State& state, std::size_t fragments) {
+        state.SetBytesProcessed(state.iterations() * FIELDS_INPUT_SIZE);
+        state.counters["fragments"] = benchmark::Counter(fragments, benchmark::Counter::kIsRate);
+    }
+
+    /* we split the whole chunk on both delimiters at once since this is where compile-time delimiter set shines */
+    void BM_SplitView(benchmark::State& state) {
+        auto input = makeFields(FIELDS_INPUT_SIZE, state.range(0));
+        std::size_t fragments = 0;
+        for (auto _: state) {
+            for (auto field: util::str_split::split<'\t', '\n'>(std::string_view{input})) {
+                benchmark::DoNotOptimize(field.data());
+                ++fragments;
+            }
+        }
+        setCounters(state, fragments);
+    }
+
+    /** views::split only takes a single delimiter so to be fair we only split on \t here */
+    void BM_SplitViewSingle(benchmark::State& state) {
+        auto input = makeFields(FIELDS_INPUT_SIZE, state.range(0));
+        std::size_t fragments = 0;
+        for (auto _: state) {
+            for (auto field: util::str_split::split<'\t'>(std::string_view{input})) {
+                benchmark::DoNotOptimize(field.data());
+                ++fragments;
+            }
+        }
+        setCounters(state, fragments);
+    }
+
+    void BM_StdViewsSplitFields(benchmark::State& state) {
+        auto input = makeFields(FIELDS_INPUT_SIZE, state.range(0));
+        std::size_t fragments = 0;
+        for (auto _: state) {
+            for (auto field: std::views::split(std::string_view{input}, '\t')) {
+                benchmark::DoNotOptimize(std::ranges::data(field));
+                ++fragments;
+            }
+        }
+        setCounters(state, fragments);
+    }
+
+    /** Same as above but splitting on \t and \n at the same time, the way it'd be done without SplitView */
+    void BM_StdViewsSplitNested(benchmark::State& state) {
+        auto input = makeFields(FIELDS_INPUT_SIZE, state.range(0));
+        std::size_t fragments = 0;
+        for (auto _: state) {
+            for (auto line: std::views::split(std::string_view{input}, '\n')) {
+                for (auto field: std::views::split(std::string_view{line.begin(), line.end()}, '\t')) {
+                    benchmark::DoNotOptimize(std::ranges::data(field));
+                    ++fragments;
+                }
+            }
+        }
+        setCounters(state, fragments);
+    }
+}
+
+/* argument is max field length, average is half of that */
+BENCHMARK(BM_SplitView)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK(BM_SplitViewSingle)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK(BM_StdViewsSplitFields)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK(BM_StdViewsSplitNested)->Arg(8)->Arg(64)->Arg(512);
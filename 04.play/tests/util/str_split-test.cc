@@ -7,6 +7,7 @@
 #include <random>
 
 #include <util/memory_counter.h>
+#include <util/allocation_counter.h>
 #include <boost/config.hpp>
 
 using util::str_split::LinesSplitView;
@@ -62,6 +63,150 @@ TEST(str_split, sentinelWorks) {
     EXPECT_TRUE(std::default_sentinel != start);
 }
 
+/** Walking backwards must yield exactly the same fragments as walking forwards, just in reverse order */
+std::string runReverseTest(std::string_view input) {
+    std::vector<std::string_view> forward;
+    std::ranges::copy(LinesSplitView{input}, std::back_inserter(forward));
+
+    std::vector<std::string_view> backward;
+    std::ranges::copy(std::views::reverse(LinesSplitView{input}), std::back_inserter(backward));
+    std::ranges::reverse(backward);
+
+    std::ostringstream s;
+    if (forward != backward) {
+        s << "Forward: ";
+        std::ranges::copy(forward, std::ostream_iterator<std::string_view>(s, ", "));
+        s << "Backward: ";
+        std::ranges::copy(backward, std::ostream_iterator<std::string_view>(s, ", "));
+    }
+    return (std::move(s)).str();
+}
+
+TEST(str_split, reverse) {
+    for (auto input: {""sv, "abc"sv, "abc\ncde"sv, "abc\ncde\n"sv, "abc\r\ncde"sv, "abc\r\ncde\r\n"sv,
+            "abc\r\ncde\r"sv, "abc\rcde\r"sv, "abc\ncde\r\n\n"sv, "\r\r\n"sv, "abc\n\r\n\ncde\r\r\n"sv,
+            "\n"sv, "\r"sv, "\r\n"sv, "\n\n"sv, "\r\r"sv, "\n\rx"sv}) {
+        EXPECT_EQ(runReverseTest(input), "") << " for input of size " << input.size();
+    }
+}
+
+TEST(str_split, tail) {
+    LinesSplitView view{"first\nsecond\r\nthird\nfourth\r\n"sv};
+    std::vector<std::string_view> last2;
+    std::ranges::copy(std::views::reverse(view) | std::views::take(2), std::back_inserter(last2));
+    EXPECT_EQ(last2, (std::vector{"fourth"sv, "third"sv}));
+
+    auto iter = view.end();
+    EXPECT_EQ(*--iter, "fourth");
+    EXPECT_EQ(*iter--, "fourth");
+    EXPECT_EQ(*iter, "third");
+    ++iter;
+    EXPECT_TRUE(++iter == view.end());
+}
+
+/** With Plain policy we expect exactly what std::views::split produces, in both directions */
+template <char... Chars>
+std::string runPlainTest(std::string_view input, std::string_view delims) {
+    std::vector<std::string_view> expected;
+    std::string_view rest = input;
+    if (!input.empty()) {
+        for (;;) {
+            auto pos = rest.find_first_of(delims);
+            expected.push_back(rest.substr(0, pos));
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(pos + 1);
+        }
+    }
+
+    std::vector<std::string_view> forward;
+    std::ranges::copy(util::str_split::split<Chars...>(input), std::back_inserter(forward));
+
+    std::vector<std::string_view> backward;
+    std::ranges::copy(std::views::reverse(util::str_split::split<Chars...>(input)), std::back_inserter(backward));
+    std::ranges::reverse(backward);
+
+    std::ostringstream s;
+    if (forward != expected || backward != expected) {
+        s << "Forward: ";
+        std::ranges::copy(forward, std::ostream_iterator<std::string_view>(s, "|"));
+        s << " Backward: ";
+        std::ranges::copy(backward, std::ostream_iterator<std::string_view>(s, "|"));
+    }
+    return (std::move(s)).str();
+}
+
+TEST(str_split, plainSingleDelimiter) {
+    for (auto input: {""sv, "a"sv, "a,"sv, ","sv, ",a"sv, ",,"sv, "abc,def,,ghi\r\n,"sv,
+            "a rather long field which does not fit into 16 bytes,and another one which doesn't either,"sv}) {
+        EXPECT_EQ(runPlainTest<','>(input, ","), "") << " for input " << input;
+    }
+}
+
+TEST(str_split, plainManyDelimiters) {
+    std::string longInput;
+    for (int i = 0; i < 50; ++i) {
+        longInput += "field number ";
+        longInput += "\t,|;:"[i % 5];
+        longInput += std::string(i % 7, 'x');
+        longInput += '\0';
+    }
+    for (auto input: {""sv, "a\tb,c|d"sv, "\t\t"sv, std::string_view{longInput}}) {
+        EXPECT_EQ((runPlainTest<'\t', ',', '|'>(input, "\t,|"sv)), "") << " for input " << input;
+        EXPECT_EQ((runPlainTest<'\t', ',', '|', ';', ':', '\0'>(input, "\t,|;:\0"sv)), "") << " for input " << input;
+    }
+}
+
+/** The build doesn't enable SSSE3 so the nibble lookup for sets of 4 to 8 chars is picked at runtime */
+TEST(str_split, nibbleLookupInUse) {
+    using util::str_split::_detail::CharSet;
+#if defined(__x86_64__)
+    if (!__builtin_cpu_supports("ssse3")) {
+        GTEST_SKIP() << "CPU without SSSE3";
+    }
+    EXPECT_TRUE((CharSet<'\t', ',', '|', ';', ':', '\0'>::nibbleLookup()));
+    EXPECT_FALSE((CharSet<'\t', ',', '|'>::nibbleLookup()));
+
+    auto input = "no delimiters in the first chunk, then one;"sv;
+    EXPECT_EQ((CharSet<'\t', '|', ';', ':', '\0'>::find(input.begin(), input.end())), input.end() - 1);
+#else
+    EXPECT_FALSE((CharSet<'\t', ',', '|', ';', ':', '\0'>::nibbleLookup()));
+#endif
+}
+
+TEST(str_split, longLines) {
+    std::string input;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 40; ++i) {
+        expected.push_back(std::string(i * 3, 'a' + i % 26) + (i % 6 == 0 ? "\r" : ""));
+        input += expected.back();
+        input += i % 3 == 0 ? "\r\n" : "\n";
+    }
+    EXPECT_TRUE(std::ranges::equal(LinesSplitView{input}, expected));
+    EXPECT_EQ(runReverseTest(input), "");
+}
+
+/** Iterating over lines, forwards or backwards, never allocates */
+TEST(str_split, iterationDoesNotAllocate) {
+    std::string input;
+    for (int i = 0; i < 100; ++i) {
+        input += std::string(i, 'x') + (i % 2 ? "\r\n" : "\n");
+    }
+
+    std::size_t total = 0;
+    EXPECT_NO_ALLOCATIONS({
+        LinesSplitView view{input};
+        for (auto line: view) {
+            total += line.size();
+        }
+        for (auto line: view | std::views::reverse) {
+            total += line.size();
+        }
+    });
+    EXPECT_EQ(total, 2 * 99 * 100 / 2);
+}
+
 class TracedString: public std::string, util::memory_counter::MemoryCounter {
 public:
     TracedString(const char* s, util::memory_counter::MemoryCounts& counts): std::string(s), MemoryCounter(counts) {}
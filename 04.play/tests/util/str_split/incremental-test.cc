@@ -0,0 +1,85 @@
+#include <util/str_split/incremental.h>
+#include <util/str_split.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using util::str_split::LinesSplitView;
+using util::str_split::incremental::IncrementalLines;
+
+namespace {
+    /** Feeds 'input' cut at 'cuts' */
+    std::vector<std::string> split(std::string_view input, const std::vector<std::size_t>& cuts) {
+        std::vector<std::string> result;
+        auto collect = [&result](std::string_view line) { result.emplace_back(line); };
+        IncrementalLines lines;
+        std::size_t pos = 0;
+        for (auto cut: cuts) {
+            lines.feed(input.substr(pos, cut - pos), collect);
+            pos = cut;
+        }
+        lines.feed(input.substr(pos), collect);
+        lines.finish(collect);
+        return result;
+    }
+
+    std::vector<std::string> reference(std::string_view input) {
+        std::vector<std::string> result;
+        for (auto line: LinesSplitView{input}) {
+            result.emplace_back(line);
+        }
+        return result;
+    }
+}
+
+TEST(str_split_incremental, partialLine) {
+    IncrementalLines lines;
+    std::vector<std::string> out;
+    auto collect = [&out](std::string_view line) { out.emplace_back(line); };
+
+    lines.feed("one\ntw", collect);
+    EXPECT_EQ(out, (std::vector<std::string>{"one"}));
+    EXPECT_EQ(lines.partial(), "tw");
+
+    lines.feed("o\r", collect);
+    /* can't tell yet whether the '\r' is part of "\r\n" */
+    EXPECT_EQ(out.size(), 1);
+    EXPECT_EQ(lines.partial(), "two\r");
+
+    lines.feed("\nthree\r", collect);
+    EXPECT_EQ(out, (std::vector<std::string>{"one", "two"}));
+
+    lines.feed("x\n", collect);
+    /* a '\r' followed by something else stays in the line */
+    EXPECT_EQ(out.back(), "three\rx");
+    EXPECT_TRUE(lines.partial().empty());
+
+    lines.feed("last\r", collect);
+    lines.finish(collect);
+    EXPECT_EQ(out.back(), "last");
+    EXPECT_EQ(out.size(), 4);
+
+    lines.feed("gone", collect);
+    lines.reset();
+    lines.finish(collect);
+    EXPECT_EQ(out.size(), 4);
+}
+
+TEST(str_split_incremental, sameAsLinesSplitView) {
+    std::mt19937 gen{1};
+    constexpr std::string_view alphabet = "ab\r\n\n";
+    for (int round = 0; round < 2000; ++round) {
+        std::string input;
+        for (auto n = gen() % 30; n > 0; --n) {
+            input += alphabet[gen() % alphabet.size()];
+        }
+        std::vector<std::size_t> cuts;
+        for (std::size_t pos = 0; pos < input.size(); pos += gen() % 4) {
+            cuts.push_back(pos);
+        }
+        EXPECT_EQ(split(input, cuts), reference(input)) << testing::PrintToString(input);
+    }
+}
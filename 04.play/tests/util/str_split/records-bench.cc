@@ -0,0 +1,56 @@
+#include <util/str_split/records.h>
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+/*
+ * Target for unquoted data is at least 1 GB/s on a single core
+ * Quoted input has got every 4th field quoted, some of them with doubled quotes and line breaks inside
+ */
+
+namespace {
+    std::string makeInput(std::size_t size, std::size_t maxField, bool quoted) {
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<std::size_t> fieldLength{0, maxField};
+        std::uniform_int_distribution<int> letter{'a', 'z'};
+
+        std::string result;
+        result.reserve(size + 2 * maxField + 4);
+        for (int field = 0; result.size() < size; ++field) {
+            bool quote = quoted && field % 4 == 0;
+            if (quote) {
+                result += '"';
+            }
+            for (auto n = fieldLength(gen); n > 0; --n) {
+                result += static_cast<char>(letter(gen));
+                if (quote && n % 16 == 0) {
+                    result += n % 32 == 0 ? "\"\"" : "\r\n";
+                }
+            }
+            if (quote) {
+                result += '"';
+            }
+            result += field % 8 == 7 ? "\r\n" : ",";
+        }
+        return result;
+    }
+
+    constexpr std::size_t INPUT_SIZE = 1 << 22;
+
+    void BM_CsvReader(benchmark::State& state) {
+        auto input = makeInput(INPUT_SIZE, state.range(0), state.range(1));
+        std::size_t records = 0;
+        for (auto _: state) {
+            for (auto record: util::str_split::records::CsvReader<>{input}) {
+                benchmark::DoNotOptimize(record.data());
+                ++records;
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * input.size());
+        state.counters["records"] = benchmark::Counter(records, benchmark::Counter::kIsRate);
+    }
+}
+
+/* 1st argument is max field length, average is half of that; 2nd argument tells if some fields are quoted */
+BENCHMARK(BM_CsvReader)->ArgsProduct({{8, 32, 128}, {0, 1}});
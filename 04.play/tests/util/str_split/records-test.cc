@@ -0,0 +1,70 @@
+#include <util/str_split/records.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using util::str_split::records::CsvReader;
+using util::str_split::records::TsvReader;
+using util::str_split::records::MalformedRecord;
+using namespace std::string_view_literals;
+
+using Rows = std::vector<std::vector<std::string>>;
+
+template <typename Reader>
+Rows parse(std::string_view input) {
+    Rows rows;
+    Reader reader{input};
+    for (auto record: reader) {
+        auto& row = rows.emplace_back();
+        for (auto& field: record) {
+            row.push_back(field.str());
+        }
+    }
+    return rows;
+}
+
+TEST(records, unquoted) {
+    EXPECT_EQ(parse<CsvReader<>>(""), Rows{});
+    EXPECT_EQ(parse<CsvReader<>>("a,b,c\r\n1,2,3\r\n"), (Rows{{"a", "b", "c"}, {"1", "2", "3"}}));
+    EXPECT_EQ(parse<CsvReader<>>("a,,\n\n,x"), (Rows{{"a", "", ""}, {""}, {"", "x"}}));
+    EXPECT_EQ(parse<TsvReader<>>("a\tb,c\nd\te"), (Rows{{"a", "b,c"}, {"d", "e"}}));
+    EXPECT_EQ(parse<CsvReader<>>("ab\"c,d"), (Rows{{"ab\"c", "d"}}));
+}
+
+TEST(records, quoted) {
+    EXPECT_EQ(parse<CsvReader<>>("\"a,b\",c\n\"\",\"x\"\"y\"\"\""),
+            (Rows{{"a,b", "c"}, {"", "x\"y\""}}));
+    EXPECT_EQ(parse<CsvReader<>>("\"multi\r\nline\nfield\",2\r\n3,\"\"\"\"\r\n"),
+            (Rows{{"multi\r\nline\nfield", "2"}, {"3", "\""}}));
+    EXPECT_EQ(parse<CsvReader<>>("\"a\",\n\"\n\""), (Rows{{"a", ""}, {"\n"}}));
+}
+
+TEST(records, zeroCopy) {
+    auto input = "plain,\"quoted\",\"es\"\"caped\""sv;
+    CsvReader<> reader{input};
+    ASSERT_TRUE(reader.next());
+    auto fields = reader.fields();
+    ASSERT_EQ(fields.size(), 3);
+
+    std::string buffer;
+    for (auto& field: fields.first(2)) {
+        EXPECT_FALSE(field.needsUnescaping());
+        auto value = field.value(buffer);
+        EXPECT_TRUE(value.data() >= input.data() && value.data() + value.size() <= input.data() + input.size());
+    }
+    EXPECT_TRUE(buffer.empty());
+
+    EXPECT_TRUE(fields[2].needsUnescaping());
+    EXPECT_EQ(fields[2].raw(), "es\"\"caped");
+    EXPECT_EQ(fields[2].value(buffer), "es\"caped");
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.recordNo(), 1);
+}
+
+TEST(records, malformed) {
+    EXPECT_THROW(parse<CsvReader<>>("a,\"unterminated\nb,c"), MalformedRecord);
+    EXPECT_THROW(parse<CsvReader<>>("\"quoted\"x,b"), MalformedRecord);
+}
@@ -0,0 +1,81 @@
+#include <util/str_split/utf8.h>
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+
+/*
+ * Fused split + validate against splitting with LinesSplitView and then validating each line separately
+ * Input is log-like lines, either pure ASCII or with every 4th line carrying some Cyrillic
+ */
+
+namespace {
+    constexpr std::size_t INPUT_SIZE = 8 << 20;
+
+    std::string makeInput(bool nonAscii) {
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<int> letter{'a', 'z'};
+        std::uniform_int_distribution<std::size_t> length{30, 190};
+
+        std::string result;
+        result.reserve(INPUT_SIZE + 256);
+        for (std::size_t line = 0; result.size() < INPUT_SIZE; ++line) {
+            for (auto n = length(gen); n > 0; --n) {
+                if (nonAscii && line % 4 == 0 && n % 3 == 0) {
+                    result += "\xD0\x96";
+                } else {
+                    result += static_cast<char>(letter(gen));
+                }
+            }
+            result += '\n';
+        }
+        return result;
+    }
+
+    void setCounters(benchmark::State& state, std::size_t lines) {
+        state.SetBytesProcessed(state.iterations() * INPUT_SIZE);
+        state.counters["lines"] = benchmark::Counter(lines, benchmark::Counter::kIsRate);
+    }
+
+    void BM_ValidatingLinesView(benchmark::State& state) {
+        auto input = makeInput(state.range(0));
+        std::size_t lines = 0;
+        for (auto _: state) {
+            for (auto line: util::str_split::utf8::ValidatingLinesView{input}) {
+                benchmark::DoNotOptimize(line.invalidAt);
+                ++lines;
+            }
+        }
+        setCounters(state, lines);
+    }
+
+    void BM_SplitThenValidate(benchmark::State& state) {
+        auto input = makeInput(state.range(0));
+        std::size_t lines = 0;
+        for (auto _: state) {
+            for (auto line: util::str_split::LinesSplitView{std::string_view{input}}) {
+                benchmark::DoNotOptimize(util::str_split::utf8::validate(line));
+                ++lines;
+            }
+        }
+        setCounters(state, lines);
+    }
+
+    void BM_SplitOnly(benchmark::State& state) {
+        auto input = makeInput(state.range(0));
+        std::size_t lines = 0;
+        for (auto _: state) {
+            for (auto line: util::str_split::LinesSplitView{std::string_view{input}}) {
+                benchmark::DoNotOptimize(line.data());
+                ++lines;
+            }
+        }
+        setCounters(state, lines);
+    }
+}
+
+/* argument: 0 - pure ASCII, 1 - some non-ASCII */
+BENCHMARK(BM_ValidatingLinesView)->ArgName("nonAscii")->Arg(0)->Arg(1);
+BENCHMARK(BM_SplitThenValidate)->ArgName("nonAscii")->Arg(0)->Arg(1);
+BENCHMARK(BM_SplitOnly)->ArgName("nonAscii")->Arg(0)->Arg(1);
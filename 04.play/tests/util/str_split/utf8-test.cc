@@ -0,0 +1,109 @@
+#include <util/str_split/utf8.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using util::str_split::LinesSplitView;
+using util::str_split::utf8::ValidatedLine;
+using util::str_split::utf8::ValidatingLinesView;
+using util::str_split::utf8::npos;
+using util::str_split::utf8::validate;
+using namespace std::string_view_literals;
+
+namespace {
+    std::vector<ValidatedLine> lines(std::string_view input) {
+        std::vector<ValidatedLine> result;
+        for (auto line: ValidatingLinesView{input}) {
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    /** Splits with LinesSplitView and validates each line on its own */
+    std::vector<ValidatedLine> reference(std::string_view input) {
+        std::vector<ValidatedLine> result;
+        for (auto line: LinesSplitView{input}) {
+            result.push_back({line, validate(line)});
+        }
+        return result;
+    }
+}
+
+TEST(utf8, validate) {
+    EXPECT_EQ(validate(""), npos);
+    EXPECT_EQ(validate("plain ascii"), npos);
+    EXPECT_EQ(validate("\xD0\x9F\xD1\x80\xD0\xB8"), npos);        // Cyrillic
+    EXPECT_EQ(validate("\xE2\x82\xAC \xF0\x9F\x98\x80"), npos);    // euro sign, emoji
+    EXPECT_EQ(validate("\xED\x9F\xBF \xEE\x80\x80 \xF4\x8F\xBF\xBF"), npos); // right below/above the limits
+
+    EXPECT_EQ(validate("ab\x80"), 2u);              // stray continuation
+    EXPECT_EQ(validate("ab\xC0\x80"), 2u);          // overlong 2-byte
+    EXPECT_EQ(validate("a\xE0\x9F\xBF"), 1u);       // overlong 3-byte
+    EXPECT_EQ(validate("a\xF0\x8F\xBF\xBF"), 1u);   // overlong 4-byte
+    EXPECT_EQ(validate("a\xED\xA0\x80"), 1u);       // surrogate
+    EXPECT_EQ(validate("a\xF4\x90\x80\x80"), 1u);   // above U+10FFFF
+    EXPECT_EQ(validate("a\xF5\x80\x80\x80"), 1u);
+    EXPECT_EQ(validate("a\xFF"), 1u);
+    EXPECT_EQ(validate("ok\xE2\x82"), 2u);          // truncated
+    EXPECT_EQ(validate("\xE2\x82x"), 0u);
+    EXPECT_EQ(validate("\xF0\x9F\x98z"), 0u);
+}
+
+TEST(utf8, lines) {
+    EXPECT_EQ(lines(""), std::vector<ValidatedLine>{});
+    EXPECT_EQ(lines("a\r\n\xD0\x9F\n\xC3\n\nb\r"), (std::vector<ValidatedLine>{
+            {"a"sv}, {"\xD0\x9F"sv}, {"\xC3"sv, 0}, {""sv}, {"b"sv}}));
+
+    /* sequence cut by the line break is an error in its line and not in the next one */
+    EXPECT_EQ(lines("x\xE2\x82\n\xAC"), (std::vector<ValidatedLine>{{"x\xE2\x82"sv, 1}, {"\xAC"sv, 0}}));
+    EXPECT_EQ(lines("x\xE2\r\ny"), (std::vector<ValidatedLine>{{"x\xE2"sv, 1}, {"y"sv}}));
+    EXPECT_EQ(lines("\xE2\nab\n"), (std::vector<ValidatedLine>{{"\xE2"sv, 0}, {"ab"sv}}));
+
+    /* error past the 1st chunk, and truncated sequence right at the end of input */
+    std::string longLine(40, 'z');
+    EXPECT_EQ(lines(longLine + "\xFF" + longLine + "\n" + longLine + "\xF0\x9F"), (std::vector<ValidatedLine>{
+            {longLine + "\xFF" + longLine, 40}, {longLine + "\xF0\x9F", 40}}));
+}
+
+/** Random mix of ASCII, valid and broken sequences and line breaks in various positions against chunk boundaries */
+TEST(utf8, random) {
+    static constexpr std::string_view pieces[] = {"a", "bcdefgh", "\n", "\r\n", "\r", "\xD0\x9F", "\xE2\x82\xAC",
+            "\xF0\x9F\x98\x80", "\x80", "\xC0\x80", "\xE2\x82", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF0\x9F\x98",
+            "\xE0\x9F\xBF", "\xFE"};
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<std::size_t> piece{0, std::size(pieces) - 1};
+    std::uniform_int_distribution<int> asciiRun{0, 40};
+
+    for (int round = 0; round < 2000; ++round) {
+        std::string input;
+        for (int n = round % 50; n > 0; --n) {
+            input += pieces[piece(gen)];
+            input.append(asciiRun(gen) < 30 ? 0 : asciiRun(gen), 'q');
+        }
+        ASSERT_EQ(lines(input), reference(input)) << "round " << round;
+    }
+}
+
+/** The build doesn't enable SSSE3 so the validator is picked at runtime; valid non-ASCII lines must need no 2nd pass */
+TEST(utf8, vectorValidatorInUse) {
+#if defined(__x86_64__)
+    if (!__builtin_cpu_supports("ssse3")) {
+        GTEST_SKIP() << "CPU without SSSE3";
+    }
+    EXPECT_TRUE(util::str_split::utf8::vectorValidation());
+
+    auto text = "h\xC3\xA9llo, \xE2\x82\xAC and \xF0\x9F\x98\x80, long enough for a couple of chunks\nnext"sv;
+    auto [lineBreak, suspicious] = util::str_split::utf8::_detail::scanLine(text.data(), text.data() + text.size());
+    EXPECT_EQ(lineBreak, text.data() + text.find('\n'));
+    EXPECT_FALSE(suspicious);
+
+    auto invalid = "valid so far, then \xC3 cut short\n"sv;
+    EXPECT_TRUE(util::str_split::utf8::_detail::scanLine(invalid.data(), invalid.data() + invalid.size()).suspicious);
+#else
+    GTEST_SKIP() << "no SIMD validator on this architecture";
+#endif
+}
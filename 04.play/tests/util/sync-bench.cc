@@ -0,0 +1,64 @@
+#include <util/sync.h>
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+/*
+ * Contention on a tiny critical section: util::sync locks against std::mutex and std::shared_mutex
+ * from 1 to 64 threads all hammering the same lock
+ *
+ * BM_Counter* increment a shared counter; BM_Map* look up a small map under a shared lock
+ * and update it under an exclusive one every WRITE_EVERY iterations
+ *
+ * Beware of the threads:1 numbers for std::mutex: glibc skips atomic instructions altogether
+ * while the process only has one thread, which is never the case in a program that actually needs a lock
+ */
+
+namespace {
+    constexpr int WRITE_EVERY = 16;
+    constexpr int KEYS = 64;
+
+    template <typename M>
+    void BM_Counter(benchmark::State& state) {
+        static M mutex;
+        static long counter = 0;
+        for (auto _: state) {
+            std::lock_guard lock{mutex};
+            benchmark::DoNotOptimize(++counter);
+        }
+        state.counters["locks"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    template <typename M>
+    void BM_Map(benchmark::State& state) {
+        static M mutex;
+        static std::map<int, long> map = [] {
+            std::map<int, long> result;
+            for (int i = 0; i < KEYS; ++i) {
+                result[i] = 0;
+            }
+            return result;
+        }();
+
+        int i = state.thread_index();
+        for (auto _: state) {
+            auto key = ++i % KEYS;
+            if (i % WRITE_EVERY == 0) {
+                std::unique_lock lock{mutex};
+                ++map[key];
+            } else {
+                std::shared_lock lock{mutex};
+                benchmark::DoNotOptimize(map.find(key)->second);
+            }
+        }
+        state.counters["ops"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+    }
+}
+
+BENCHMARK(BM_Counter<std::mutex>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Counter<util::sync::Mutex>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Counter<util::sync::SharedMutex>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Map<std::shared_mutex>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_Map<util::sync::SharedMutex>)->ThreadRange(1, 64)->UseRealTime();
@@ -0,0 +1,197 @@
+#include <util/sync.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using util::sync::Mutex;
+using util::sync::SharedMutex;
+
+namespace {
+    /** More threads than cores so that some of them end up parked while holding their turn */
+    constexpr int THREADS = 8;
+    constexpr int ITERATIONS = 20'000;
+
+    template <typename F>
+    void onThreads(int count, F&& f) {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < count; ++t) {
+            threads.emplace_back([&f, t] { f(t); });
+        }
+    }
+}
+
+/** Once it's time to park it stays so: a thread woken up from the futex goes back to sleep rather than spin */
+TEST(sync, backoffStaysExhausted) {
+    util::sync::_detail::Backoff backoff;
+    int spins = 0;
+    while (backoff.spin()) {
+        ++spins;
+    }
+    EXPECT_EQ(spins, util::sync::_detail::spinRounds());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_FALSE(backoff.spin());
+    }
+}
+
+TEST(sync, mutexTryLock) {
+    Mutex mutex;
+    EXPECT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+
+    std::unique_lock lock{mutex, std::try_to_lock};
+    EXPECT_TRUE(lock.owns_lock());
+}
+
+TEST(sync, mutexExcludes) {
+    Mutex mutex;
+    long counter = 0;
+    std::atomic<int> inside = 0;
+    std::atomic<int> overlaps = 0;
+
+    onThreads(THREADS, [&](int) {
+        for (int i = 0; i < ITERATIONS; ++i) {
+            std::lock_guard lock{mutex};
+            if (inside.fetch_add(1, std::memory_order_relaxed) != 0) {
+                ++overlaps;
+            }
+            ++counter;
+            inside.fetch_sub(1, std::memory_order_relaxed);
+        }
+    });
+    EXPECT_EQ(counter, long{THREADS} * ITERATIONS);
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+/** Holding the lock for long enough that waiters give up spinning and park */
+TEST(sync, mutexParks) {
+    Mutex mutex;
+    int counter = 0;
+    onThreads(4, [&](int) {
+        for (int i = 0; i < 20; ++i) {
+            std::lock_guard lock{mutex};
+            std::this_thread::sleep_for(100us);
+            ++counter;
+        }
+    });
+    EXPECT_EQ(counter, 80);
+}
+
+TEST(sync, mutexWithConditionVariable) {
+    Mutex mutex;
+    std::condition_variable_any cv;
+    int produced = 0;
+
+    std::jthread producer{[&] {
+        for (int i = 0; i < 100; ++i) {
+            std::lock_guard lock{mutex};
+            ++produced;
+            cv.notify_one();
+        }
+    }};
+    std::unique_lock lock{mutex};
+    cv.wait(lock, [&produced] { return produced == 100; });
+}
+
+TEST(sync, sharedTryLock) {
+    SharedMutex mutex;
+    {
+        std::shared_lock reader1{mutex};
+        std::shared_lock reader2{mutex, std::try_to_lock};
+        EXPECT_TRUE(reader2.owns_lock());
+        EXPECT_FALSE(mutex.try_lock());
+    }
+    {
+        std::unique_lock writer{mutex};
+        EXPECT_FALSE(mutex.try_lock_shared());
+        EXPECT_FALSE(mutex.try_lock());
+    }
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+/** Once a writer is waiting, new readers are held back even though a reader is still inside */
+TEST(sync, sharedPrefersWriters) {
+    SharedMutex mutex;
+    std::shared_lock reader{mutex};
+
+    std::atomic<bool> written = false;
+    std::jthread writer{[&] {
+        std::lock_guard lock{mutex};
+        written = true;
+    }};
+
+    while (mutex.try_lock_shared()) {
+        mutex.unlock_shared();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(written.load());
+
+    reader.unlock();
+    writer.join();
+    EXPECT_TRUE(written.load());
+    EXPECT_TRUE(mutex.try_lock_shared());
+    mutex.unlock_shared();
+}
+
+TEST(sync, sharedExcludes) {
+    SharedMutex mutex;
+    long value = 0;
+    std::atomic<int> readers = 0;
+    std::atomic<int> violations = 0;
+
+    onThreads(THREADS, [&](int t) {
+        for (int i = 0; i < ITERATIONS / 4; ++i) {
+            if ((i + t) % 8 == 0) {
+                std::lock_guard lock{mutex};
+                if (readers.load(std::memory_order_relaxed) != 0) {
+                    ++violations;
+                }
+                value += 2;
+            } else {
+                std::shared_lock lock{mutex};
+                readers.fetch_add(1, std::memory_order_relaxed);
+                if (value % 2 != 0) {
+                    ++violations;
+                }
+                readers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    long writes = 0;
+    for (int t = 0; t < THREADS; ++t) {
+        for (int i = 0; i < ITERATIONS / 4; ++i) {
+            writes += (i + t) % 8 == 0;
+        }
+    }
+    EXPECT_EQ(value, writes * 2);
+    EXPECT_EQ(violations.load(), 0);
+}
+
+/** Writers and readers that hold the lock for a while, forcing everyone through the parking paths */
+TEST(sync, sharedParks) {
+    SharedMutex mutex;
+    int value = 0;
+    onThreads(6, [&](int t) {
+        for (int i = 0; i < 20; ++i) {
+            if (t % 3 == 0) {
+                std::lock_guard lock{mutex};
+                std::this_thread::sleep_for(50us);
+                ++value;
+            } else {
+                std::shared_lock lock{mutex};
+                std::this_thread::sleep_for(50us);
+            }
+        }
+    });
+    EXPECT_EQ(value, 40);
+}
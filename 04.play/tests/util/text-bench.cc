@@ -0,0 +1,132 @@
+#include <util/text.h>
+#include <util/str_split.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Log triage: which lines of a log mention a needle, or any of a set of error signatures
+ *
+ * The input is util::log-like lines of random words; 1 line in 1000 carries the needle or a signature
+ * Lines come from LinesSplitView; strstr gets a NUL-terminated copy of each line as it would have to in real life,
+ * the copying is not timed separately
+ *
+ * Single needle: Searcher against string_view::find, std::boyer_moore_horspool_searcher and strstr
+ * Many needles: MultiSearcher against a string_view::find per signature per line;
+ * range(0) is the number of signatures, up to 16 of them go to Teddy when the CPU has SSSE3
+ */
+
+namespace {
+    constexpr std::size_t INPUT_SIZE = 8 << 20;
+    constexpr std::string_view NEEDLE = "connection reset by peer";
+
+    std::vector<std::string> makeSignatures(std::size_t count) {
+        static const std::vector<std::string> known{"NullPointerException", "OutOfMemoryError", "connection refused",
+                "deadlock detected", "timed out waiting", "Segmentation fault", "No space left on device",
+                "Permission denied", "Broken pipe", "Too many open files", "StackOverflowError", "assertion failed",
+                "corrupted checksum", "lease expired", "quorum lost", "invalid token"};
+        std::vector<std::string> result;
+        for (std::size_t i = 0; i < count; ++i) {
+            result.push_back(i < known.size() ? known[i] : known[i % known.size()] + " #" + std::to_string(i));
+        }
+        return result;
+    }
+
+    std::string makeInput(const std::vector<std::string>& signatures) {
+        static const std::vector<std::string> words{"request", "handled", "in", "ms", "user", "session", "cache",
+                "miss", "for", "key", "connection", "reset", "timeout", "retrying", "queue", "size", "ERROR", "peer"};
+        std::mt19937 gen{42};
+        std::uniform_int_distribution<std::size_t> word{0, words.size() - 1};
+        std::uniform_int_distribution<int> wordCount{5, 25};
+
+        std::string result;
+        result.reserve(INPUT_SIZE + 256);
+        for (std::size_t line = 0; result.size() < INPUT_SIZE; ++line) {
+            result += "2024-05-01 12:34:56.789012 #INFO [worker] ";
+            for (auto n = wordCount(gen); n > 0; --n) {
+                result += words[word(gen)];
+                result += ' ';
+            }
+            if (line % 1000 == 0) {
+                result += signatures.empty() ? std::string{NEEDLE} : signatures[line / 1000 % signatures.size()];
+            }
+            result += '\n';
+        }
+        return result;
+    }
+
+    template <typename Contains>
+    void countLines(benchmark::State& state, const std::string& input, Contains&& contains) {
+        std::size_t matched = 0;
+        for (auto _: state) {
+            matched = 0;
+            for (auto line: util::str_split::LinesSplitView{std::string_view{input}}) {
+                matched += contains(line);
+            }
+            benchmark::DoNotOptimize(matched);
+        }
+        state.SetBytesProcessed(state.iterations() * input.size());
+        state.counters["matched"] = static_cast<double>(matched);
+    }
+
+    const std::string& singleInput() {
+        static const std::string input = makeInput({});
+        return input;
+    }
+
+    void BM_SingleSearcher(benchmark::State& state) {
+        util::text::Searcher searcher{NEEDLE};
+        countLines(state, singleInput(), [&searcher](std::string_view line) { return searcher.contains(line); });
+    }
+
+    void BM_SingleStringViewFind(benchmark::State& state) {
+        countLines(state, singleInput(), [](std::string_view line) { return line.find(NEEDLE) != line.npos; });
+    }
+
+    void BM_SingleBoyerMooreHorspool(benchmark::State& state) {
+        std::boyer_moore_horspool_searcher searcher{NEEDLE.begin(), NEEDLE.end()};
+        countLines(state, singleInput(), [&searcher](std::string_view line) {
+            return std::search(line.begin(), line.end(), searcher) != line.end();
+        });
+    }
+
+    void BM_SingleStrstr(benchmark::State& state) {
+        std::string needle{NEEDLE};
+        std::string copy;
+        countLines(state, singleInput(), [&needle, &copy](std::string_view line) {
+            copy.assign(line);
+            return std::strstr(copy.c_str(), needle.c_str()) != nullptr;
+        });
+    }
+
+    void BM_MultiSearcher(benchmark::State& state) {
+        auto signatures = makeSignatures(state.range(0));
+        auto input = makeInput(signatures);
+        util::text::MultiSearcher searcher{std::span<const std::string>{signatures}};
+        state.SetLabel(searcher.usesTeddy() ? "teddy" : "aho-corasick");
+        countLines(state, input, [&searcher](std::string_view line) { return searcher.contains(line); });
+    }
+
+    void BM_MultiStringViewFind(benchmark::State& state) {
+        auto signatures = makeSignatures(state.range(0));
+        auto input = makeInput(signatures);
+        countLines(state, input, [&signatures](std::string_view line) {
+            return std::any_of(signatures.begin(), signatures.end(), [line](const std::string& signature) {
+                return line.find(signature) != line.npos;
+            });
+        });
+    }
+}
+
+BENCHMARK(BM_SingleSearcher);
+BENCHMARK(BM_SingleStringViewFind);
+BENCHMARK(BM_SingleBoyerMooreHorspool);
+BENCHMARK(BM_SingleStrstr);
+BENCHMARK(BM_MultiSearcher)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_MultiStringViewFind)->Arg(4)->Arg(16)->Arg(64);
@@ -0,0 +1,199 @@
+#include <util/text.h>
+#include <util/str_split.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using util::text::Match;
+using util::text::MultiSearcher;
+using util::text::Searcher;
+using util::text::npos;
+
+namespace {
+    /** Small alphabet so that there are lots of partial matches */
+    std::string randomText(std::mt19937& gen, std::size_t length, std::string_view alphabet = "abc") {
+        std::uniform_int_distribution<std::size_t> pick{0, alphabet.size() - 1};
+        std::string result(length, ' ');
+        for (auto& c: result) {
+            c = alphabet[pick(gen)];
+        }
+        return result;
+    }
+
+    std::optional<Match> naiveFind(const std::vector<std::string>& patterns, std::string_view haystack,
+            std::size_t from) {
+        for (auto position = from; position < haystack.size(); ++position) {
+            std::optional<Match> best;
+            for (std::size_t i = 0; i < patterns.size(); ++i) {
+                if (haystack.substr(position).starts_with(patterns[i]) && (!best || patterns[i].size() > best->length)) {
+                    best = Match{i, position, patterns[i].size()};
+                }
+            }
+            if (best) {
+                return best;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::set<std::tuple<std::size_t, std::size_t>> allMatches(const MultiSearcher& searcher, std::string_view haystack) {
+        std::set<std::tuple<std::size_t, std::size_t>> result;
+        searcher.forEachMatch(haystack, [&result](const Match& match) {
+            EXPECT_TRUE(result.emplace(match.pattern, match.position).second);
+        });
+        return result;
+    }
+
+    std::set<std::tuple<std::size_t, std::size_t>> naiveAllMatches(const std::vector<std::string>& patterns,
+            std::string_view haystack) {
+        std::set<std::tuple<std::size_t, std::size_t>> result;
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            for (auto position = haystack.find(patterns[i]); position != npos;
+                    position = haystack.find(patterns[i], position + 1)) {
+                result.emplace(i, position);
+            }
+        }
+        return result;
+    }
+}
+
+TEST(text, searcherBasics) {
+    Searcher searcher{"ERROR"};
+    EXPECT_EQ(searcher.find("2024-01-01 #ERROR [main] boom"), 12u);
+    EXPECT_EQ(searcher.find("ERROR"), 0u);
+    EXPECT_EQ(searcher.find("ERRO"), npos);
+    EXPECT_EQ(searcher.find(""), npos);
+    EXPECT_EQ(searcher.find("ERROR ERROR", 1), 6u);
+    EXPECT_EQ(searcher.find("ERROR", 6), npos);
+    EXPECT_TRUE(searcher.contains(std::string(1000, 'x') + "ERROR"));
+
+    EXPECT_EQ(Searcher{""}.find("abc", 2), 2u);
+    EXPECT_EQ(Searcher{"c"}.find("abcabc", 3), 5u);
+}
+
+TEST(text, searcherAgainstStringView) {
+    std::mt19937 gen{7};
+    for (int round = 0; round < 2000; ++round) {
+        auto haystack = randomText(gen, gen() % 100);
+        auto needle = randomText(gen, 1 + gen() % 6);
+        Searcher searcher{needle};
+        for (std::size_t from = 0; from <= haystack.size(); from += 1 + gen() % 20) {
+            ASSERT_EQ(searcher.find(haystack, from), std::string_view{haystack}.find(needle, from))
+                    << haystack << ' ' << needle << ' ' << from;
+        }
+    }
+}
+
+TEST(text, searcherDoesNotReadPastTheEnd) {
+    /* the haystack ends right before an unrelated match; SIMD loads must not see it */
+    std::string buffer = std::string(40, 'x') + "needle";
+    Searcher searcher{"needle"};
+    for (std::size_t cut = 0; cut <= 40; ++cut) {
+        EXPECT_EQ(searcher.find(std::string_view{buffer}.substr(0, 40 + cut % 6)), npos);
+    }
+}
+
+TEST(text, multiSearcherBasics) {
+    MultiSearcher searcher{"NullPointerException", "OutOfMemoryError", "timeout", "time"};
+    auto match = searcher.find("request timeout after 5s");
+    ASSERT_TRUE(match);
+    EXPECT_EQ(*match, (Match{2, 8, 7}));    // the longest at the leftmost position
+
+    match = searcher.find("java.lang.OutOfMemoryError: heap; NullPointerException");
+    ASSERT_TRUE(match);
+    EXPECT_EQ(match->pattern, 1u);
+    EXPECT_FALSE(searcher.contains("all good"));
+    EXPECT_FALSE(searcher.contains(""));
+
+    EXPECT_THROW(MultiSearcher({"a", ""}), std::invalid_argument);
+    EXPECT_FALSE(MultiSearcher(std::vector<std::string>{}).contains("anything"));
+}
+
+/** The build doesn't enable SSSE3 so Teddy is picked at runtime */
+TEST(text, teddyForSmallSets) {
+#if defined(__x86_64__)
+    if (!__builtin_cpu_supports("ssse3")) {
+        GTEST_SKIP() << "CPU without SSSE3";
+    }
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 16; ++i) {
+        patterns.push_back("signature-" + std::to_string(i));
+    }
+    MultiSearcher small{std::span<const std::string>{patterns}};
+    EXPECT_TRUE(small.usesTeddy());
+    auto match = small.find("a line with signature-7 in it, long enough for more than one chunk");
+    ASSERT_TRUE(match);
+    EXPECT_EQ(match->pattern, 7u);
+
+    patterns.push_back("signature-16");
+    EXPECT_FALSE(MultiSearcher{std::span<const std::string>{patterns}}.usesTeddy());
+#else
+    GTEST_SKIP() << "no Teddy on this architecture";
+#endif
+}
+
+TEST(text, leftmostBeatsShorterEarlierEnd) {
+    /* "bc" ends first but "abcd" starts first */
+    for (auto patterns: {std::vector<std::string>{"bc", "abcd"}, std::vector<std::string>(20, "zz")}) {
+        if (patterns[0] == "zz") {
+            patterns.push_back("bc");
+            patterns.push_back("abcd");
+        }
+        MultiSearcher searcher{std::span<const std::string>{patterns}};
+        auto match = searcher.find("xabcd");
+        ASSERT_TRUE(match);
+        EXPECT_EQ(match->position, 1u);
+        EXPECT_EQ(match->length, 4u);
+    }
+}
+
+TEST(text, multiSearcherAgainstNaive) {
+    std::mt19937 gen{11};
+    /* up to 16 patterns go to Teddy if the CPU has SSSE3, more to Aho-Corasick */
+    for (std::size_t count: {1, 2, 5, 8, 9, 16, 17, 40}) {
+        for (int round = 0; round < 300; ++round) {
+            std::vector<std::string> patterns;
+            for (std::size_t i = 0; i < count; ++i) {
+                patterns.push_back(randomText(gen, 1 + gen() % 5, "abcd"));
+            }
+            MultiSearcher searcher{std::span<const std::string>{patterns}};
+            auto haystack = randomText(gen, gen() % 80, "abcde");
+            for (std::size_t from = 0; from <= haystack.size(); from += 1 + gen() % 30) {
+                auto expected = naiveFind(patterns, haystack, from);
+                auto actual = searcher.find(haystack, from);
+                ASSERT_EQ(actual.has_value(), expected.has_value()) << haystack << " from " << from;
+                if (expected) {
+                    ASSERT_EQ(actual->position, expected->position) << haystack;
+                    ASSERT_EQ(actual->length, expected->length) << haystack;
+                    ASSERT_EQ(patterns[actual->pattern], patterns[expected->pattern]);
+                }
+            }
+            ASSERT_EQ(allMatches(searcher, haystack), naiveAllMatches(patterns, haystack)) << haystack;
+        }
+    }
+}
+
+TEST(text, onSplitLines) {
+    std::string log = "2024-01-01 10:00:00.000 #INFO [main] started\n"
+            "2024-01-01 10:00:01.000 #ERROR [db] connection refused\n"
+            "\t@ connect at db.cc:42\n"
+            "2024-01-01 10:00:02.000 #WARNING [http] slow request\n";
+    MultiSearcher signatures{"connection refused", "slow request"};
+    Searcher error{"#ERROR"};
+    std::vector<std::string_view> matched;
+    int errors = 0;
+    for (auto line: util::str_split::LinesSplitView{std::string_view{log}}) {
+        if (signatures.contains(line)) {
+            matched.push_back(line);
+        }
+        errors += error.contains(line);
+    }
+    EXPECT_EQ(matched.size(), 2u);
+    EXPECT_EQ(errors, 1);
+}
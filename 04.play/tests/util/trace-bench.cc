@@ -0,0 +1,60 @@
+#include <util/trace.h>
+#include <benchmark/benchmark.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+#include <unistd.h>
+
+/*
+ * Cost of instrumentation on the recording thread, see CPU time; the flush runs on its own thread every 10ms
+ * Recording flat out produces events faster than the flush writes them out as JSON, unless it has a core
+ * of its own, so 'dropped' shows how many took the cheaper path of being dropped
+ * Under virtualization reading the TSC may cost 20ns rather than a few
+ */
+
+namespace {
+    auto tracePath() {
+        return std::filesystem::temp_directory_path() / fmt::format("trace-bench-{}.json", ::getpid());
+    }
+
+    constexpr util::trace::Options OPTIONS{.flushPeriod = std::chrono::milliseconds{10}, .bufferEvents = 1 << 20};
+
+    void SpanDisabled(benchmark::State& state) {
+        for (auto _: state) {
+            util::trace::Span span{"request"};
+            benchmark::ClobberMemory();
+        }
+    }
+
+    void SpanEnabled(benchmark::State& state) {
+        {
+            util::trace::Session session{tracePath(), OPTIONS};
+            for (auto _: state) {
+                util::trace::Span span{"request"};
+                benchmark::ClobberMemory();
+            }
+            state.counters["dropped"] = static_cast<double>(session.dropped());
+        }
+        std::filesystem::remove(tracePath());
+    }
+
+    void Counter(benchmark::State& state) {
+        {
+            util::trace::Session session{tracePath(), OPTIONS};
+            std::int64_t value = 0;
+            for (auto _: state) {
+                util::trace::counter("depth", ++value);
+            }
+            state.counters["dropped"] = static_cast<double>(session.dropped());
+        }
+        std::filesystem::remove(tracePath());
+    }
+}
+
+BENCHMARK(SpanDisabled);
+BENCHMARK(SpanEnabled);
+BENCHMARK(Counter);
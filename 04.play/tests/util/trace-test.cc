@@ -0,0 +1,181 @@
+#include <util/trace.h>
+#include <util/worker.h>
+#include <gtest/gtest.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+using util::trace::Options;
+using util::trace::Session;
+using util::trace::Span;
+
+namespace {
+    class TraceFile {
+        std::filesystem::path _path;
+    public:
+        TraceFile(): _path(std::filesystem::temp_directory_path() / fmt::format("trace-test-{}.json", ::getpid())) {}
+
+        ~TraceFile() {
+            std::filesystem::remove(_path);
+        }
+
+        const std::filesystem::path& path() const {
+            return _path;
+        }
+
+        std::string read() const {
+            std::ifstream in{_path};
+            std::stringstream text;
+            text << in.rdbuf();
+            return text.str();
+        }
+    };
+
+    std::size_t occurrences(std::string_view text, std::string_view what) {
+        std::size_t count = 0;
+        for (auto pos = text.find(what); pos != std::string_view::npos; pos = text.find(what, pos + 1)) {
+            ++count;
+        }
+        return count;
+    }
+
+    /** "dur" of the event named 'name' */
+    double duration(std::string_view text, std::string_view name) {
+        auto pos = text.find(fmt::format(R"("name":"{}","ph":"X")", name));
+        if (pos == std::string_view::npos) {
+            return -1;
+        }
+        pos = text.find(R"("dur":)", pos);
+        return std::stod(std::string{text.substr(pos + 6, 20)});
+    }
+
+    /** Constructed before the thread's first event, so destroyed after the trace's own thread_local */
+    struct LateRecorder {
+        ~LateRecorder() {
+            util::trace::instant("late");
+        }
+    };
+}
+
+TEST(trace, spansInstantsCounters) {
+    TraceFile file;
+    {
+        Span before{"before"};
+        Session session{file.path()};
+        {
+            Span outer{"outer"};
+            std::this_thread::sleep_for(2ms);
+            {
+                Span inner{"inner \"quoted\""};
+                std::this_thread::sleep_for(1ms);
+            }
+            util::trace::instant("checkpoint");
+            util::trace::counter("queue depth", 42);
+        }
+    }
+    Span after{"after"};
+
+    auto text = file.read();
+    EXPECT_TRUE(text.starts_with("[\n")) << text;
+    EXPECT_TRUE(text.ends_with("\n]\n")) << text;
+    EXPECT_EQ(occurrences(text, R"("ph":"X")"), 2) << text;
+    EXPECT_EQ(occurrences(text, R"("name":"inner \"quoted\"")"), 1) << text;
+    EXPECT_EQ(occurrences(text, R"("name":"checkpoint","ph":"i")"), 1) << text;
+    EXPECT_EQ(occurrences(text, R"("name":"queue depth","ph":"C")"), 1) << text;
+    EXPECT_EQ(occurrences(text, R"("args":{"value":42})"), 1) << text;
+    EXPECT_EQ(occurrences(text, "before"), 0);
+    EXPECT_EQ(occurrences(text, "after"), 0);
+
+    /* timestamps come from the TSC, their conversion to microseconds should be about right */
+    auto outer = duration(text, "outer");
+    auto inner = duration(text, R"(inner \"quoted\")");
+    EXPECT_GE(outer, 2900);
+    EXPECT_LT(outer, 1e6);
+    EXPECT_GE(inner, 900);
+    EXPECT_LT(inner, outer);
+}
+
+TEST(trace, threadNames) {
+    TraceFile file;
+    {
+        Session session{file.path(), Options{.flushPeriod = 1ms}};
+        {
+            util::worker::PeriodicWorker worker{"trace-test", 1ms, [] { Span span{"periodic"}; }};
+            std::this_thread::sleep_for(20ms);
+        }
+
+        /* a thread which is gone by the time we flush */
+        std::thread{[] {
+            pthread_setname_np(pthread_self(), "short-lived");
+            Span span{"once"};
+        }}.join();
+    }
+
+    auto text = file.read();
+    EXPECT_EQ(occurrences(text, R"("name":"thread_name","ph":"M")"), 2) << text;
+    EXPECT_EQ(occurrences(text, R"("args":{"name":"trace-test"})"), 1) << text;
+    EXPECT_EQ(occurrences(text, R"("args":{"name":"short-lived"})"), 1) << text;
+    EXPECT_GT(occurrences(text, R"("name":"periodic")"), 2) << text;
+    EXPECT_EQ(occurrences(text, R"("name":"once")"), 1) << text;
+}
+
+TEST(trace, droppedAfterThreadExit) {
+    TraceFile file;
+    {
+        Session session{file.path(), Options{.flushPeriod = 1ms}};
+        std::thread{[] {
+            thread_local LateRecorder late;
+            util::trace::instant("early");
+        }}.join();
+        /* for the flush to drain and free the buffer of the thread */
+        std::this_thread::sleep_for(10ms);
+    }
+    auto text = file.read();
+    EXPECT_EQ(occurrences(text, R"("name":"early")"), 1) << text;
+    EXPECT_EQ(occurrences(text, R"("name":"late")"), 0) << text;
+}
+
+TEST(trace, droppedWhenFull) {
+    TraceFile file;
+    {
+        /* a thread of its own so that its buffer is created with the small size */
+        std::thread{[&] {
+            Session session{file.path(), Options{.flushPeriod = 1h, .bufferEvents = 16}};
+            for (int i = 0; i < 100; ++i) {
+                util::trace::instant("tick");
+            }
+            EXPECT_EQ(session.dropped(), 84);
+            session.flush();
+            util::trace::instant("tock");
+            EXPECT_EQ(session.dropped(), 84);
+        }}.join();
+    }
+    auto text = file.read();
+    EXPECT_EQ(occurrences(text, R"("name":"tick")"), 16);
+    EXPECT_EQ(occurrences(text, R"("name":"tock")"), 1);
+}
+
+TEST(trace, oneSessionAtATime) {
+    TraceFile file;
+    {
+        Session session{file.path()};
+        EXPECT_THROW(Session{file.path()}, std::logic_error);
+    }
+    EXPECT_THROW(Session{"/nonexistent/directory/trace.json"}, std::system_error);
+    Session again{file.path()};
+}
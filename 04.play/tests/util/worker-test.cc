@@ -0,0 +1,223 @@
+#include <util/worker.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using util::worker::Clock;
+using util::worker::EventWorker;
+using util::worker::PeriodicWorker;
+using util::worker::TimerWheel;
+using util::worker::_detail::Wheel;
+
+namespace {
+    /** Generous since the test machine may be busy; what we check is that we don't wait for a whole period */
+    constexpr auto PROMPTLY = 200ms;
+
+    template <typename F>
+    Clock::duration timed(F&& f) {
+        auto start = Clock::now();
+        f();
+        return Clock::now() - start;
+    }
+}
+
+/** Every timer fires exactly at its tick, on all levels and beyond the range of the wheel */
+TEST(worker, wheel) {
+    constexpr std::uint64_t RANGE = std::uint64_t{1} << (Wheel::BITS * Wheel::LEVELS);
+
+    Wheel wheel;
+    std::mt19937_64 gen{42};
+    std::map<std::uint64_t, std::uint64_t> expected;
+    std::uint64_t id = 0;
+
+    auto add = [&](std::uint64_t expiry) {
+        wheel.insert(++id, expiry);
+        expected[id] = expiry;
+    };
+    for (std::uint64_t delta: {1, 2, 63, 64, 65, 4095, 4096, 4097, 262'143, 262'144}) {
+        add(delta);
+    }
+    add(RANGE - 1);
+    add(RANGE);
+    add(RANGE * 2 + 12345);
+    for (int i = 0; i < 3000; ++i) {
+        add(1 + gen() % (i % 3 == 0 ? 5000 : RANGE));
+    }
+
+    /* jump from event to event like the timer thread does: nothing may expire before the tick nextEvent() names */
+    std::size_t fired = 0;
+    auto onExpired = [&](const Wheel::Entry& entry) {
+        ASSERT_EQ(entry.expiry, wheel.now()) << "timer " << entry.id;
+        ASSERT_EQ(expected.at(entry.id), entry.expiry);
+        expected.erase(entry.id);
+        ++fired;
+
+        /* re-arm some of the timers from inside like periodic ones would be */
+        if (entry.id % 7 == 0 && fired < 5000) {
+            add(entry.expiry + 1 + entry.id % 300);
+        }
+    };
+    std::vector<Wheel::Entry> rearmed;
+    while (auto next = wheel.nextEvent()) {
+        ASSERT_GT(*next, wheel.now());
+        wheel.advance(*next - 1, [&](const Wheel::Entry& entry) {
+            FAIL() << "timer " << entry.id << " expired at " << wheel.now() << " before " << *next;
+        });
+        wheel.advance(*next, onExpired);
+    }
+    EXPECT_TRUE(expected.empty());
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(worker, periodic) {
+    std::atomic<int> runs = 0;
+    {
+        PeriodicWorker worker{"test-periodic", 5ms, [&runs] { ++runs; }};
+        while (runs < 3) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    EXPECT_GE(runs.load(), 3);
+}
+
+TEST(worker, stopsPromptly) {
+    std::atomic<int> runs = 0;
+    PeriodicWorker periodic{"test-slow", 1h, [&runs] { ++runs; }};
+    EventWorker event{"test-event", [] {}};
+    TimerWheel wheel;
+    wheel.schedulePeriodic(1h, [] {});
+
+    std::this_thread::sleep_for(10ms);
+    EXPECT_LT(timed([&] { periodic.stop(); }), PROMPTLY);
+    EXPECT_LT(timed([&] { event.stop(); }), PROMPTLY);
+    EXPECT_EQ(runs.load(), 0);
+}
+
+TEST(worker, trigger) {
+    std::latch ran{1};
+    PeriodicWorker worker{"test-trigger", 1h, [&ran] { ran.count_down(); }};
+    EXPECT_LT(timed([&] {
+        worker.trigger();
+        ran.wait();
+    }), PROMPTLY);
+}
+
+TEST(worker, event) {
+    std::mutex mutex;
+    int runs = 0;
+    int seen = 0;
+    int notified = 0;
+    EventWorker worker{"test-event", [&] {
+        std::lock_guard lock{mutex};
+        ++runs;
+        seen = notified;
+    }};
+
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard lock{mutex};
+            ++notified;
+        }
+        worker.notify();
+    }
+
+    /* the job runs at least once after the last notification, but not necessarily once per notification */
+    for (;;) {
+        std::this_thread::sleep_for(1ms);
+        std::lock_guard lock{mutex};
+        if (seen == 100) {
+            break;
+        }
+    }
+    std::lock_guard lock{mutex};
+    EXPECT_LE(runs, 100);
+}
+
+TEST(worker, throwingJobKeepsRunning) {
+    std::atomic<int> runs = 0;
+    PeriodicWorker worker{"test-throwing", 1ms, [&runs] {
+        ++runs;
+        throw std::runtime_error("from a periodic job");
+    }};
+    while (runs < 3) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+TEST(worker, timers) {
+    constexpr int TIMERS = 300;
+    TimerWheel wheel;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> delayMs{0, 150};
+
+    std::atomic<int> early = 0;
+    std::latch fired{TIMERS};
+    for (int i = 0; i < TIMERS; ++i) {
+        auto delay = std::chrono::milliseconds{delayMs(gen)};
+        auto due = Clock::now() + delay;
+        wheel.schedule(delay, [&, due] {
+            if (Clock::now() < due) {
+                ++early;
+            }
+            fired.count_down();
+        });
+    }
+
+    std::atomic<int> cancelledRuns = 0;
+    auto cancelled = wheel.schedule(50ms, [&cancelledRuns] { ++cancelledRuns; });
+    EXPECT_TRUE(wheel.cancel(cancelled));
+    EXPECT_FALSE(wheel.cancel(cancelled));
+
+    std::atomic<int> ticks = 0;
+    auto periodic = wheel.schedulePeriodic(5ms, [&ticks] { ++ticks; });
+
+    fired.wait();
+    EXPECT_EQ(early.load(), 0);
+
+    while (ticks < 5) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_TRUE(wheel.cancel(periodic));
+    EXPECT_EQ(cancelledRuns.load(), 0);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+/** Callbacks may schedule and cancel timers themselves */
+TEST(worker, timersFromCallbacks) {
+    TimerWheel wheel;
+    std::latch done{1};
+    std::atomic<int> chain = 0;
+    std::function<void()> next = [&] {
+        if (++chain == 10) {
+            done.count_down();
+        } else {
+            wheel.schedule(1ms, next);
+        }
+    };
+    wheel.schedule(1ms, next);
+
+    TimerWheel::TimerId self = 0;
+    std::atomic<int> selfRuns = 0;
+    std::mutex mutex;
+    {
+        std::lock_guard lock{mutex};
+        self = wheel.schedulePeriodic(1ms, [&] {
+            ++selfRuns;
+            std::lock_guard lock{mutex};
+            wheel.cancel(self);
+        });
+    }
+
+    done.wait();
+    EXPECT_EQ(selfRuns.load(), 1);
+}